@@ -5,7 +5,9 @@ import androidx.appcompat.app.AppCompatActivity;
 
 import android.content.DialogInterface;
 import android.hardware.display.DisplayManager;
+import android.os.Build;
 import android.os.Bundle;
+import android.os.PowerManager;
 import android.view.GestureDetector;
 import android.view.MotionEvent;
 import android.view.View;
@@ -24,6 +26,8 @@ public class ARCoreActivity extends AppCompatActivity implements DisplayManager.
 
     private ARSurfaceView surfaceView;
     private GestureDetector gestureDetector;
+    // Lowers the rendering quality as the device heats up, API 29 and above.
+    private PowerManager.OnThermalStatusChangedListener thermalStatusListener;
 
     @Override
     protected void onCreate(Bundle savedInstanceState) {
@@ -46,8 +50,7 @@ public class ARCoreActivity extends AppCompatActivity implements DisplayManager.
                                 // depth-based occlusion. This dialog needs to be spawned on the UI thread.
                                 ARCoreActivity.this.runOnUiThread(() -> showOcclusionDialogIfNeeded());
 
-                                surfaceView.queueEvent(
-                                        () -> JniInterface.onTouched(e.getX(), e.getY()));
+                                JniInterface.onTouched(e.getX(), e.getY());
                                 return true;
                             }
 
@@ -57,7 +60,28 @@ public class ARCoreActivity extends AppCompatActivity implements DisplayManager.
                             }
                         });
         surfaceView.setOnTouchListener(
-                (View v, MotionEvent event) -> gestureDetector.onTouchEvent(event));
+                (View v, MotionEvent event) -> {
+                    forwardDrag(event);
+                    return gestureDetector.onTouchEvent(event);
+                });
+    }
+
+    /** Lets a placed model be dragged to a new place with the first finger. */
+    private static void forwardDrag(MotionEvent event) {
+        switch (event.getActionMasked()) {
+            case MotionEvent.ACTION_DOWN:
+                JniInterface.onPressed(event.getX(), event.getY());
+                break;
+            case MotionEvent.ACTION_MOVE:
+                JniInterface.onDragged(event.getX(), event.getY());
+                break;
+            case MotionEvent.ACTION_UP:
+            case MotionEvent.ACTION_CANCEL:
+                JniInterface.onReleased(event.getX(), event.getY());
+                break;
+            default:
+                break;
+        }
     }
 
     @Override
@@ -75,6 +99,12 @@ public class ARCoreActivity extends AppCompatActivity implements DisplayManager.
         JniInterface.onResume(getApplicationContext(), this);
         surfaceView.onResume();
         getSystemService(DisplayManager.class).registerDisplayListener(this, null);
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) {
+            PowerManager powerManager = getSystemService(PowerManager.class);
+            thermalStatusListener = JniInterface::setThermalStatus;
+            JniInterface.setThermalStatus(powerManager.getCurrentThermalStatus());
+            powerManager.addThermalStatusListener(thermalStatusListener);
+        }
     }
 
     @Override
@@ -84,6 +114,10 @@ public class ARCoreActivity extends AppCompatActivity implements DisplayManager.
         JniInterface.onPause();
 
         getSystemService(DisplayManager.class).unregisterDisplayListener(this);
+        if (thermalStatusListener != null) {
+            getSystemService(PowerManager.class).removeThermalStatusListener(thermalStatusListener);
+            thermalStatusListener = null;
+        }
     }
 
     @Override
@@ -165,6 +199,6 @@ public class ARCoreActivity extends AppCompatActivity implements DisplayManager.
 
     @Override
     public void onDisplayChanged(int i) {
-        surfaceView.viewportChanged = true;
+        surfaceView.onDisplayChanged();
     }
 }
\ No newline at end of file
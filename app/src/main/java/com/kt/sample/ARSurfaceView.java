@@ -2,86 +2,81 @@ package com.kt.sample;
 
 import android.app.Activity;
 import android.content.Context;
-import android.opengl.GLES20;
-import android.opengl.GLSurfaceView;
 import android.util.AttributeSet;
+import android.view.Choreographer;
 import android.view.SurfaceHolder;
+import android.view.SurfaceView;
 
 import com.kt.helloAR.JniInterface;
 
-import javax.microedition.khronos.egl.EGLConfig;
-import javax.microedition.khronos.opengles.GL10;
-
-public class ARSurfaceView extends GLSurfaceView {
+/**
+ * Hands its surface to the native render thread, which owns the OpenGL context and draws every
+ * frame. This view only forwards the surface lifecycle and the vsyncs.
+ */
+public class ARSurfaceView extends SurfaceView implements SurfaceHolder.Callback {
     private static final String TAG = ARSurfaceView.class.getSimpleName();
-    public static boolean viewportChanged = false;
     private Activity mActivity;
+    private int mSurfaceWidth = 0;
+    private int mSurfaceHeight = 0;
+    private boolean mHasSurface = false;
 
-    private void setSurface() {
-        setPreserveEGLContextOnPause(true);
-        setEGLContextClientVersion(2);
-        setEGLConfigChooser(8, 8, 8, 8, 16, 0); // Alpha used for plane bl
-        setRenderer(new glRenderer());
-        setRenderMode(GLSurfaceView.RENDERMODE_CONTINUOUSLY);
-        setWillNotDraw(false);
-    }
+    // Frames are rendered on demand, on the vsyncs the native frame scheduler picks.
+    private final Choreographer.FrameCallback mFrameCallback = new Choreographer.FrameCallback() {
+        @Override
+        public void doFrame(long frameTimeNanos) {
+            JniInterface.onVsync(frameTimeNanos);
+            Choreographer.getInstance().postFrameCallback(this);
+        }
+    };
 
     public ARSurfaceView(Context context) {
         super(context);
-        setSurface();
+        getHolder().addCallback(this);
         mActivity = (Activity)context;
     }
 
     public ARSurfaceView(Context context, AttributeSet attrs) {
         super(context, attrs);
-        setSurface();
+        getHolder().addCallback(this);
         mActivity = (Activity)context;
     }
 
-    @Override
     public void onResume() {
-        super.onResume();
+        Choreographer.getInstance().postFrameCallback(mFrameCallback);
     }
 
-    @Override
     public void onPause() {
-        super.onPause();
+        Choreographer.getInstance().removeFrameCallback(mFrameCallback);
     }
 
-    @Override
-    public void surfaceDestroyed(SurfaceHolder holder) {
-        super.surfaceDestroyed(holder);
+    /** Passes the new display rotation on to the native side. */
+    public void onDisplayChanged() {
+        if (mHasSurface) {
+            JniInterface.onSurfaceChanged(getDisplayRotation(), mSurfaceWidth, mSurfaceHeight);
+        }
     }
 
-    private class glRenderer implements Renderer {
-        private int viewportWidth = 0;
-        private int viewportHeight = 0;
+    @Override
+    public void surfaceCreated(SurfaceHolder holder) {
+        JniInterface.onSurfaceCreated(holder.getSurface());
+        mHasSurface = true;
+    }
 
-        @Override
-        public void onSurfaceCreated(GL10 gl10, EGLConfig eglConfig) {
-            GLES20.glClearColor(0.5f, 0.5f, 0.5f, 1.0f);    // gray
-            JniInterface.onGlSurfaceCreated();
-        }
+    @Override
+    public void surfaceChanged(SurfaceHolder holder, int format, int width, int height) {
+        mSurfaceWidth = width;
+        mSurfaceHeight = height;
+        JniInterface.onSurfaceChanged(getDisplayRotation(), width, height);
+    }
 
-        @Override
-        public void onSurfaceChanged(GL10 gl10, int width, int height) {
-            viewportWidth = width;
-            viewportHeight = height;
-            viewportChanged = true;
-        }
+    @Override
+    public void surfaceDestroyed(SurfaceHolder holder) {
+        mHasSurface = false;
+        // Blocks until the native render thread let go of the surface.
+        JniInterface.onSurfaceDestroyed();
+    }
 
-        @Override
-        public void onDrawFrame(GL10 gl10) {
-            GLES20.glClear(GLES20.GL_COLOR_BUFFER_BIT | GLES20.GL_DEPTH_BUFFER_BIT);
-            // Synchronized to avoid racing onDestroy.
-            synchronized (this) {
-                if (viewportChanged) {
-                    int displayRotation = mActivity.getWindowManager().getDefaultDisplay().getRotation();
-                    JniInterface.onDisplayGeometryChanged(displayRotation, viewportWidth, viewportHeight);
-                    viewportChanged = false;
-                }
-                JniInterface.onGlSurfaceDrawFrame(false, false);
-            }
-        }
+    private int getDisplayRotation() {
+        return mActivity.getWindowManager().getDefaultDisplay().getRotation();
     }
 }
@@ -28,6 +28,16 @@ uniform mat3 u_DepthUvTransform;
 uniform float u_DepthAspectRatio;
 #endif // USE_DEPTH_FOR_OCCLUSION
 
+#if USE_ENVIRONMENTAL_HDR
+// Irradiance spherical harmonics, scaled by the cosine lobe convolution.
+uniform vec3 u_SphericalHarmonics[9];
+// Direction towards the main light in world space, and its linear intensity.
+uniform vec3 u_MainLightDirection;
+uniform vec3 u_MainLightIntensity;
+uniform samplerCube u_Cubemap;
+uniform mat3 u_ViewToWorld;
+#endif // USE_ENVIRONMENTAL_HDR
+
 varying vec3 v_ViewPosition;
 varying vec3 v_ViewNormal;
 varying vec2 v_TexCoord;
@@ -134,6 +144,24 @@ float DepthGetBlurredVisibilityAroundUV(in sampler2D depth_texture, in vec2 uv,
 
 #endif // USE_DEPTH_FOR_OCCLUSION
 
+#if USE_ENVIRONMENTAL_HDR
+
+// Evaluates the ambient irradiance arriving at a surface with the given
+// world space normal.
+vec3 SampleSphericalHarmonics(in vec3 n) {
+  return max(u_SphericalHarmonics[0]
+      + u_SphericalHarmonics[1] * n.y
+      + u_SphericalHarmonics[2] * n.z
+      + u_SphericalHarmonics[3] * n.x
+      + u_SphericalHarmonics[4] * (n.y * n.x)
+      + u_SphericalHarmonics[5] * (n.y * n.z)
+      + u_SphericalHarmonics[6] * (3.0 * n.z * n.z - 1.0)
+      + u_SphericalHarmonics[7] * (n.z * n.x)
+      + u_SphericalHarmonics[8] * (n.x * n.x - n.y * n.y), 0.0);
+}
+
+#endif // USE_ENVIRONMENTAL_HDR
+
 void main() {
     // We support approximate sRGB gamma.
     const float kGamma = 0.4545454;
@@ -165,6 +193,26 @@ void main() {
     // Apply inverse SRGB gamma to the texture before making lighting calculations.
     objectColor.rgb = pow(objectColor.rgb, vec3(kInverseGamma));
 
+#if USE_ENVIRONMENTAL_HDR
+    // Light in linear space from the estimated environment, in world space.
+    vec3 worldNormal = u_ViewToWorld * viewNormal;
+    vec3 worldFragmentDirection = u_ViewToWorld * viewFragmentDirection;
+    vec3 worldReflection = reflect(worldFragmentDirection, worldNormal);
+
+    vec3 irradiance = SampleSphericalHarmonics(worldNormal) +
+            u_MainLightIntensity * max(0.0, dot(worldNormal, u_MainLightDirection));
+    float mainSpecularStrength = max(0.0, dot(worldReflection, u_MainLightDirection));
+    vec3 specularLight = u_MainLightIntensity *
+            pow(mainSpecularStrength, materialSpecularPower) +
+            textureCube(u_Cubemap, worldReflection).rgb;
+
+    vec3 color = objectColor.rgb * (materialAmbient + irradiance) +
+            objectColor.a * materialSpecular * specularLight;
+    // Apply SRGB gamma before writing the fragment color. The estimate
+    // already matches the scene's brightness, so no color correction.
+    gl_FragColor.rgb = pow(color, vec3(kGamma));
+    gl_FragColor.a = objectColor.a;
+#else
     // Ambient light is unaffected by the light intensity.
     float ambient = materialAmbient;
 
@@ -187,6 +235,7 @@ void main() {
     color *= colorShift * (averagePixelIntensity / kMiddleGrayGamma);
     gl_FragColor.rgb = color;
     gl_FragColor.a = objectColor.a;
+#endif // USE_ENVIRONMENTAL_HDR
 
 #if USE_DEPTH_FOR_OCCLUSION
     const float kMetersToMillimeters = 1000.0;
@@ -194,9 +243,12 @@ void main() {
     // Computes the texture coordinates to sample from the depth image.
     vec2 depth_uvs = (u_DepthUvTransform * vec3(v_ScreenSpacePosition.xy, 1)).xy;
 
-    // The following step is very costly. Replace the last line with the
-    // commented line if it's too expensive.
-    // gl_FragColor *= DepthGetVisibility(u_DepthTexture, depth_uvs, asset_depth_mm);
+    // The blurred visibility takes 25 depth samples per fragment, cheaper
+    // profiles take a single one.
+#if USE_OCCLUSION_BLUR
     gl_FragColor *= DepthGetBlurredVisibilityAroundUV(u_DepthTexture, depth_uvs, asset_depth_mm);
+#else
+    gl_FragColor *= DepthGetVisibility(u_DepthTexture, depth_uvs, asset_depth_mm);
+#endif // USE_OCCLUSION_BLUR
 #endif // USE_DEPTH_FOR_OCCLUSION
 }
@@ -7,8 +7,12 @@ import android.graphics.Bitmap;
 import android.graphics.BitmapFactory;
 import android.opengl.GLUtils;
 import android.util.Log;
+import android.view.Surface;
 
 import java.io.IOException;
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.FloatBuffer;
 
 public class JniInterface {
     private static final String TAG = JniInterface.class.getSimpleName();
@@ -17,8 +21,89 @@ public class JniInterface {
         System.loadLibrary("native-lib");
     }
 
+    /** Indices into the array returned by {@link #getGlFrameStats()}. */
+    public static final int GL_FRAME_STATS_DRAW_CALLS = 0;
+    public static final int GL_FRAME_STATS_STATE_CHANGES = 1;
+    public static final int GL_FRAME_STATS_PROGRAM_BINDS = 2;
+    public static final int GL_FRAME_STATS_TEXTURE_BINDS = 3;
+    public static final int GL_FRAME_STATS_BYTES_UPLOADED = 4;
+
+    /**
+     * Layout of the native AppStatus struct, see status_block.h. Bump STATUS_VERSION together with
+     * kAppStatusVersion whenever it changes.
+     */
+    private static final int STATUS_VERSION = 2;
+    private static final int STATUS_SIZE_BYTES = 56;
+    private static final int STATUS_SEQUENCE_OFFSET = 0;
+    private static final int STATUS_VERSION_OFFSET = 4;
+    private static final int STATUS_PLANE_COUNT_OFFSET = 8;
+    private static final int STATUS_TRACKING_STATE_OFFSET = 12;
+    private static final int STATUS_DEPTH_SUPPORTED_OFFSET = 16;
+    private static final int STATUS_ANCHOR_COUNT_OFFSET = 20;
+    private static final int STATUS_FRAME_TIMESTAMP_OFFSET = 24;
+    private static final int STATUS_FRAME_TIME_OFFSET = 32;
+    private static final int STATUS_RETICLE_HIT_OFFSET = 40;
+    private static final int STATUS_RETICLE_POSITION_OFFSET = 44;
+    // Consistent snapshots are retried this many times while a frame is being published.
+    private static final int STATUS_MAX_READ_ATTEMPTS = 8;
+    // Only written and read by statusLoadFence().
+    private static volatile int statusFence;
+
+    /** Per-frame state published by the native side, see {@link #readStatus(Status)}. */
+    public static final class Status {
+        public int planeCount;
+        /** An ArTrackingState value: 0 tracking, 1 paused, 2 stopped. */
+        public int trackingState;
+        public boolean depthSupported;
+        public int anchorCount;
+        public long frameTimestampNanos;
+        /** Native time spent rendering the frame. */
+        public long frameTimeNanos;
+        /** Whether the ray through the screen center hits a plane, at reticlePosition. */
+        public boolean reticleHit;
+        /** World space x, y, z of the placement reticle. */
+        public final float[] reticlePosition = new float[3];
+    }
+
+    /**
+     * Layout of the results written by {@link #hitTestBatch}, see hit_tester.h. Each input gets
+     * HIT_TEST_RESULT_FLOATS floats: one of the HIT_TEST_TRACKABLE_* codes for what was hit,
+     * HIT_TEST_TRACKABLE_NONE if nothing, the distance in meters and the hit pose as qx, qy, qz,
+     * qw, tx, ty, tz.
+     */
+    public static final int HIT_TEST_RESULT_FLOATS = 9;
+    public static final int HIT_TEST_RESULT_TRACKABLE_TYPE = 0;
+    public static final int HIT_TEST_RESULT_DISTANCE = 1;
+    public static final int HIT_TEST_RESULT_POSE = 2;
+
+    /** Trackable codes of a hit test result, see HitTestTrackable in hit_tester.h. */
+    public static final int HIT_TEST_TRACKABLE_NONE = 0;
+    public static final int HIT_TEST_TRACKABLE_PLANE = 1;
+    public static final int HIT_TEST_TRACKABLE_POINT = 2;
+    public static final int HIT_TEST_TRACKABLE_INSTANT_PLACEMENT_POINT = 3;
+    public static final int HIT_TEST_TRACKABLE_OTHER = 4;
+
+    /** Which placed model makes room for a new one, see AnchorEvictionPolicy in anchor_store.h. */
+    public static final int ANCHOR_EVICTION_OLDEST = 0;
+    public static final int ANCHOR_EVICTION_FARTHEST_FROM_CAMERA = 1;
+    public static final int ANCHOR_EVICTION_LEAST_RECENTLY_VISIBLE = 2;
+
+    /** Whether ArSession_update waits for a new camera image, see ArUpdateMode in ARCore. */
+    public static final int UPDATE_MODE_BLOCKING = 0;
+    public static final int UPDATE_MODE_LATEST_CAMERA_IMAGE = 1;
+
+    /** Camera config and feature set, see PerformanceProfile in performance_profile.h. */
+    public static final int PERFORMANCE_PROFILE_LOW_POWER = 0;
+    public static final int PERFORMANCE_PROFILE_BALANCED = 1;
+    public static final int PERFORMANCE_PROFILE_HIGH_FIDELITY = 2;
+
+    /** Target frame rate of setTargetFrameRate that renders each camera image once. */
+    public static final int FRAME_RATE_CAMERA = 0;
+
     private static long nativeApplication = 0;
     private static AssetManager assetManager;
+    // Written by the render thread after every frame, null if registration failed.
+    private static ByteBuffer statusBuffer;
 
     /**
      * [private static native] Native Methods
@@ -28,16 +113,37 @@ public class JniInterface {
     private static native void onPause(long nativeApplication);
     private static native void onResume(long nativeApplication, Context context, Activity activity);
     private static native void destroyNativeApplication(long nativeApplication);
-    private static native void onGlSurfaceCreated(long nativeApplication);
-    private static native void onDisplayGeometryChanged(
+    private static native void onSurfaceCreated(long nativeApplication, Surface surface);
+    private static native void onSurfaceChanged(
             long nativeApplication, int displayRotation, int width, int height);
-    private static native void onGlSurfaceDrawFrame(
-            long nativeApplication, boolean depthColorVisualizationEnabled, boolean useDepthForOcclusion);
+    private static native void onSurfaceDestroyed(long nativeApplication);
+    private static native void queueEvent(long nativeApplication, Runnable runnable);
+    private static native void setMaxFramesInFlight(long nativeApplication, int count);
+    private static native void setDepthRendering(
+            long nativeApplication, boolean depthColorVisualizationEnabled,
+            boolean useDepthForOcclusion);
+    private static native boolean onVsync(long nativeApplication, long frameTimeNanos);
+    private static native void setTargetFrameRate(long nativeApplication, int framesPerSecond);
+    private static native void setAnimating(long nativeApplication, boolean animating);
     private static native void onTouched(long nativeApplication, float x, float y);
-    private static native boolean hasDetectedPlanes(long nativeApplication);
-    private static native boolean isDepthSupported(long nativeApplication);
+    private static native void onPressed(long nativeApplication, float x, float y);
+    private static native void onDragged(long nativeApplication, float x, float y);
+    private static native void onReleased(long nativeApplication, float x, float y);
+    private static native boolean registerStatusBuffer(long nativeApplication, ByteBuffer buffer);
+    private static native int hitTestBatch(
+            long nativeApplication, FloatBuffer coordinates, int count, boolean rays,
+            FloatBuffer results);
     private static native void onSettingsChange(
             long nativeApplication, boolean isInstantPlacementEnabled);
+    private static native void setAnchorEvictionPolicy(long nativeApplication, int policy);
+    private static native void setUpdateMode(long nativeApplication, int updateMode);
+    private static native void setPerformanceProfile(long nativeApplication, int profile);
+    private static native void setRenderScale(long nativeApplication, float scale);
+    private static native void setThermalStatus(long nativeApplication, int thermalStatus);
+    private static native boolean startFrameRecording(long nativeApplication, String path);
+    private static native void stopFrameRecording(long nativeApplication);
+    private static native String dumpTrace();
+    private static native long[] getGlFrameStats();
 
 
     /**
@@ -46,6 +152,15 @@ public class JniInterface {
     public static void onCreate(Context context) {
         assetManager = context.getAssets();
         nativeApplication = createNativeApplication(assetManager);
+
+        ByteBuffer buffer =
+                ByteBuffer.allocateDirect(STATUS_SIZE_BYTES).order(ByteOrder.nativeOrder());
+        if (registerStatusBuffer(nativeApplication, buffer)) {
+            statusBuffer = buffer;
+        } else {
+            Log.e(TAG, "Cannot register the native status buffer");
+            statusBuffer = null;
+        }
     }
 
     public static void onPause() {
@@ -62,63 +177,310 @@ public class JniInterface {
 
     public static void onDestroy() {
         if (nativeApplication != 0) {
+            statusBuffer = null;
             destroyNativeApplication(nativeApplication);
             nativeApplication = 0;
         }
     }
 
-    /** Allocate OpenGL resources for rendering. */
-    public static void onGlSurfaceCreated() {
+    /**
+     * Renders into surface on the native render thread, called on the UI thread from
+     * SurfaceHolder.Callback.surfaceCreated. The native side owns the OpenGL context, draws the
+     * frames onVsync picks and pauses with onPause.
+     */
+    public static void onSurfaceCreated(Surface surface) {
+        if (nativeApplication != 0) {
+            onSurfaceCreated(nativeApplication, surface);
+        }
+    }
+
+    /**
+     * Called on the UI thread from SurfaceHolder.Callback.surfaceChanged, and whenever the display
+     * rotation changes, when rendering on the native render thread.
+     */
+    public static void onSurfaceChanged(int displayRotation, int width, int height) {
+        if (nativeApplication != 0) {
+            onSurfaceChanged(nativeApplication, displayRotation, width, height);
+        }
+    }
+
+    /**
+     * Called on the UI thread from SurfaceHolder.Callback.surfaceDestroyed. Returns once the native
+     * render thread no longer uses the surface.
+     */
+    public static void onSurfaceDestroyed() {
+        if (nativeApplication != 0) {
+            onSurfaceDestroyed(nativeApplication);
+        }
+    }
+
+    /**
+     * Runs runnable on the native render thread before its next frame. The methods documented as
+     * called on the render thread must be called from such a runnable.
+     */
+    public static void queueEvent(Runnable runnable) {
+        if (nativeApplication != 0) {
+            queueEvent(nativeApplication, runnable);
+        }
+    }
+
+    /**
+     * Bounds how many frames the native render thread submits before the GPU finished them, from
+     * 1 to 3. With 1 every frame starts from the freshest camera image, for the lowest latency;
+     * the default of 2 lets the CPU work on a frame while the GPU draws the previous one.
+     */
+    public static void setMaxFramesInFlight(int count) {
+        if (nativeApplication != 0) {
+            setMaxFramesInFlight(nativeApplication, count);
+        }
+    }
+
+    /** Depth visualization and occlusion of the frames drawn by the native render thread. */
+    public static void setDepthRendering(
+            boolean depthColorVisualizationEnabled, boolean useDepthForOcclusion) {
         if (nativeApplication != 0) {
-            onGlSurfaceCreated(nativeApplication);
+            setDepthRendering(
+                    nativeApplication, depthColorVisualizationEnabled, useDepthForOcclusion);
         }
     }
 
     /**
-     * Called on the OpenGL thread before onGlSurfaceDrawFrame when the view port width, height, or
-     * display rotation may have changed.
+     * Called on the UI thread from a Choreographer frame callback when rendering on demand. Returns
+     * true if a frame should be rendered for this vsync.
      */
-    public static void onDisplayGeometryChanged(int displayRotation, int width, int height) {
+    public static boolean onVsync(long frameTimeNanos) {
         if (nativeApplication != 0) {
-            onDisplayGeometryChanged(nativeApplication, displayRotation, width, height);
+            return onVsync(nativeApplication, frameTimeNanos);
         }
+        return false;
     }
 
-    /** Main render loop, called on the OpenGL thread. */
-    public static void onGlSurfaceDrawFrame(boolean depthColorVisualizationEnabled, boolean useDepthForOcclusion) {
+    /**
+     * Paces on demand rendering to framesPerSecond, rounded to whole vsyncs, or to the camera with
+     * FRAME_RATE_CAMERA.
+     */
+    public static void setTargetFrameRate(int framesPerSecond) {
         if (nativeApplication != 0) {
-            onGlSurfaceDrawFrame(nativeApplication, depthColorVisualizationEnabled, useDepthForOcclusion);
+            setTargetFrameRate(nativeApplication, framesPerSecond);
         }
     }
 
-    /** OnTouch event, called on the OpenGL thread. */
+    /**
+     * While animating, frames are rendered up to the display rate even when the camera image does
+     * not change.
+     */
+    public static void setAnimating(boolean animating) {
+        if (nativeApplication != 0) {
+            setAnimating(nativeApplication, animating);
+        }
+    }
+
+    /** Tap event, called on the UI thread. Handled on the render thread with the next frame. */
     public static void onTouched(float x, float y) {
         if (nativeApplication != 0) {
             onTouched(nativeApplication, x, y);
         }
     }
 
+    /**
+     * Finger down, called on the UI thread. A placed model under the finger is picked up and
+     * follows the drag.
+     */
+    public static void onPressed(float x, float y) {
+        if (nativeApplication != 0) {
+            onPressed(nativeApplication, x, y);
+        }
+    }
+
+    /** Finger up, called on the UI thread. A dragged model is anchored where it is dropped. */
+    public static void onReleased(float x, float y) {
+        if (nativeApplication != 0) {
+            onReleased(nativeApplication, x, y);
+        }
+    }
+
+    /**
+     * Drag event, called on the UI thread for every finger move. Only the latest sample before
+     * each frame is handled.
+     */
+    public static void onDragged(float x, float y) {
+        if (nativeApplication != 0) {
+            onDragged(nativeApplication, x, y);
+        }
+    }
+
+    /**
+     * Enables or disables instant placement. Applied on the render thread before its next frame,
+     * safe to call from any thread.
+     */
     public static void onSettingsChange(boolean instantPlacementEnabled) {
         if (nativeApplication != 0) {
             onSettingsChange(nativeApplication, instantPlacementEnabled);
         }
     }
 
-    public static boolean isDepthSupported() {
+    /**
+     * Selects which placed model is removed when placing one more would exceed the limit, one of
+     * the ANCHOR_EVICTION_* constants. Applied on the render thread before its next frame, safe to
+     * call from any thread.
+     */
+    public static void setAnchorEvictionPolicy(int policy) {
+        if (nativeApplication != 0) {
+            setAnchorEvictionPolicy(nativeApplication, policy);
+        }
+    }
+
+    /**
+     * Selects the camera config and the features drawn, one of the PERFORMANCE_PROFILE_*
+     * constants. Pauses the session briefly when the camera config changes, which drops the placed
+     * models. Applied on the render thread before its next frame, safe to call from any thread.
+     */
+    public static void setPerformanceProfile(int profile) {
+        if (nativeApplication != 0) {
+            setPerformanceProfile(nativeApplication, profile);
+        }
+    }
+
+    /**
+     * Draws the virtual content at scale times the surface resolution, between 0.5 and 1, and
+     * composites it over the full resolution camera image. Lower scales relieve fill-rate-bound
+     * devices. Applied on the render thread before its next frame, safe to call from any thread.
+     */
+    public static void setRenderScale(float scale) {
         if (nativeApplication != 0) {
-            return isDepthSupported(nativeApplication);
+            setRenderScale(nativeApplication, scale);
+        }
+    }
+
+    /**
+     * Passes on the device's thermal status, one of the PowerManager.THERMAL_STATUS_* constants.
+     * The hotter the device, the lower the rendering quality the native side may choose. Safe to
+     * call from any thread.
+     */
+    public static void setThermalStatus(int thermalStatus) {
+        if (nativeApplication != 0) {
+            setThermalStatus(nativeApplication, thermalStatus);
+        }
+    }
+
+    /**
+     * Selects whether each frame waits for a new camera image or reuses the last one, one of the
+     * UPDATE_MODE_* constants. In UPDATE_MODE_LATEST_CAMERA_IMAGE, frames drawn faster than the
+     * camera rate redraw the scene cached for the last image. Applied on the render thread before
+     * its next frame, safe to call from any thread.
+     */
+    public static void setUpdateMode(int updateMode) {
+        if (nativeApplication != 0) {
+            setUpdateMode(nativeApplication, updateMode);
+        }
+    }
+
+    /**
+     * Starts recording every ARCore frame and touch to a log file at path, for off-device replay.
+     * Called on the render thread, see queueEvent. Returns false if the file could not be created.
+     */
+    public static boolean startFrameRecording(String path) {
+        if (nativeApplication != 0) {
+            return startFrameRecording(nativeApplication, path);
         }
         return false;
     }
 
-    /** Get plane count in current session. Used to disable the "searching for surfaces" snackbar. */
-    public static boolean hasDetectedPlanes() {
+    /** Stops the frame recording in progress, called on the render thread, see queueEvent. */
+    public static void stopFrameRecording() {
+        if (nativeApplication != 0) {
+            stopFrameRecording(nativeApplication);
+        }
+    }
+
+    /**
+     * Returns the recent native trace events in the Chrome trace_event JSON format, to be saved
+     * and opened in chrome://tracing or Perfetto. The trace is empty in release builds.
+     */
+    public static String dumpTraceJson() {
+        return dumpTrace();
+    }
+
+    /**
+     * Returns the GL calls made while rendering the last frame, indexed by the GL_FRAME_STATS_*
+     * constants. All zero unless the native library is built with HELLOAR_GL_STATS.
+     */
+    public static long[] getLastGlFrameStats() {
+        return getGlFrameStats();
+    }
+
+    /**
+     * Hit tests count inputs against the current frame in a single native call. With rays false
+     * each input is a screen point x, y in pixels; with rays true it is a world space ray given as
+     * origin x, y, z and direction x, y, z. Both buffers must be direct FloatBuffers in native byte
+     * order, and results must hold count * HIT_TEST_RESULT_FLOATS floats. Called on the render
+     * thread between frames, see queueEvent. Returns the number of inputs that hit, or -1 if a
+     * buffer is unusable.
+     */
+    public static int hitTestBatch(
+            FloatBuffer coordinates, int count, boolean rays, FloatBuffer results) {
         if (nativeApplication != 0) {
-            return hasDetectedPlanes(nativeApplication);
+            return hitTestBatch(nativeApplication, coordinates, count, rays, results);
+        }
+        return 0;
+    }
+
+    /**
+     * Copies the status of the last rendered frame into out without calling into native code.
+     * Safe to call from any thread. Returns false if no consistent status is available.
+     */
+    public static boolean readStatus(Status out) {
+        ByteBuffer buffer = statusBuffer;
+        if (buffer == null || buffer.getInt(STATUS_VERSION_OFFSET) != STATUS_VERSION) {
+            return false;
+        }
+        for (int attempt = 0; attempt < STATUS_MAX_READ_ATTEMPTS; ++attempt) {
+            int sequence = buffer.getInt(STATUS_SEQUENCE_OFFSET);
+            if ((sequence & 1) != 0) {
+                continue;
+            }
+            statusLoadFence();
+            out.planeCount = buffer.getInt(STATUS_PLANE_COUNT_OFFSET);
+            out.trackingState = buffer.getInt(STATUS_TRACKING_STATE_OFFSET);
+            out.depthSupported = buffer.getInt(STATUS_DEPTH_SUPPORTED_OFFSET) != 0;
+            out.anchorCount = buffer.getInt(STATUS_ANCHOR_COUNT_OFFSET);
+            out.frameTimestampNanos = buffer.getLong(STATUS_FRAME_TIMESTAMP_OFFSET);
+            out.frameTimeNanos = buffer.getLong(STATUS_FRAME_TIME_OFFSET);
+            out.reticleHit = buffer.getInt(STATUS_RETICLE_HIT_OFFSET) != 0;
+            for (int i = 0; i < 3; ++i) {
+                out.reticlePosition[i] =
+                        buffer.getFloat(STATUS_RETICLE_POSITION_OFFSET + 4 * i);
+            }
+            statusLoadFence();
+            if (buffer.getInt(STATUS_SEQUENCE_OFFSET) == sequence) {
+                return true;
+            }
         }
         return false;
     }
 
+    /**
+     * Keeps the plain ByteBuffer reads of readStatus from being reordered across it, which is what
+     * makes the sequence check meaningful. Stands in for VarHandle.acquireFence(), which needs API
+     * 33: earlier loads can't move below the volatile write, later loads can't move above the
+     * volatile read, and the two are ordered with each other.
+     */
+    private static int statusLoadFence() {
+        statusFence = 0;
+        return statusFence;
+    }
+
+    public static boolean isDepthSupported() {
+        ByteBuffer buffer = statusBuffer;
+        return buffer != null && buffer.getInt(STATUS_DEPTH_SUPPORTED_OFFSET) != 0;
+    }
+
+    /** Get plane count in current session. Used to disable the "searching for surfaces" snackbar. */
+    public static boolean hasDetectedPlanes() {
+        ByteBuffer buffer = statusBuffer;
+        return buffer != null && buffer.getInt(STATUS_PLANE_COUNT_OFFSET) > 0;
+    }
+
     public static Bitmap loadImage(String imageName) {
         try {
             return BitmapFactory.decodeStream(assetManager.open(imageName));
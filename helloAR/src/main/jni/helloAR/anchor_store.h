@@ -0,0 +1,381 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_ANCHOR_STORE_H_
+#define C_ARCORE_ANCHOR_STORE_H_
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "glm.h"
+#include "util.h"
+
+namespace hello_ar {
+
+// Which entry AnchorStore::Insert evicts when the store is full.
+enum class AnchorEvictionPolicy : int32_t {
+  kOldest = 0,
+  kFarthestFromCamera = 1,
+  kLeastRecentlyVisible = 2,
+};
+
+// Stable reference to an AnchorStore entry. Stays invalid once the entry is
+// removed, even if its slot is reused.
+struct AnchorHandle {
+  int32_t index = -1;
+  uint32_t generation = 0;
+
+  bool IsValid() const { return index >= 0; }
+  bool operator==(const AnchorHandle& other) const {
+    return index == other.index && generation == other.generation;
+  }
+  bool operator!=(const AnchorHandle& other) const { return !(*this == other); }
+};
+
+// Fixed capacity store of placed anchors with their payload. Entries live in
+// a slot array recycled through a free list, so insertion, removal and
+// lookup by handle are O(1) and never move other entries. Intrusive lists
+// keep the insertion and visibility order, which makes the oldest and least
+// recently visible evictions O(1); farthest from camera eviction scans the
+// entries. A uniform grid over the entries' positions answers nearest
+// neighbor queries by looking at nearby cells only.
+//
+// T must be default constructible and movable. Removed entries are reset to
+// T(), which releases any ARCore handles they own.
+template <typename T>
+class AnchorStore {
+ public:
+  explicit AnchorStore(int32_t capacity, float cell_size_meters = 0.5f)
+      : slots_(capacity), cell_size_(cell_size_meters) {
+    // A full store evicts before inserting, so it needs at least one slot.
+    CHECK(capacity > 0);
+    Clear();
+  }
+
+  int32_t GetSize() const { return size_; }
+  int32_t GetCapacity() const { return static_cast<int32_t>(slots_.size()); }
+
+  AnchorEvictionPolicy GetEvictionPolicy() const { return eviction_policy_; }
+  void SetEvictionPolicy(AnchorEvictionPolicy policy) {
+    eviction_policy_ = policy;
+  }
+
+  // Adds value at position, first evicting an entry chosen by the eviction
+  // policy if the store is full. The new entry counts as visible now.
+  AnchorHandle Insert(T&& value, const glm::vec3& position,
+                      const glm::vec3& camera_position) {
+    if (free_head_ < 0) {
+      Remove(HandleOf(SelectVictim(camera_position)));
+    }
+    const int32_t index = free_head_;
+    Slot& slot = slots_[index];
+    free_head_ = slot.next_free;
+    slot.live = true;
+    slot.value = std::move(value);
+    slot.position = position;
+    slot.cell = GetCellKey(position);
+    grid_[slot.cell].push_back(index);
+    PushBack(&inserted_, &Slot::inserted, index);
+    PushBack(&visible_, &Slot::visible, index);
+    ++size_;
+    return HandleOf(index);
+  }
+
+  // Removes the entry. Returns false if the handle is stale.
+  bool Remove(AnchorHandle handle) {
+    if (!IsLive(handle)) {
+      return false;
+    }
+    const int32_t index = handle.index;
+    Slot& slot = slots_[index];
+    RemoveFromCell(slot.cell, index);
+    Unlink(&inserted_, &Slot::inserted, index);
+    Unlink(&visible_, &Slot::visible, index);
+    slot.value = T();
+    slot.live = false;
+    ++slot.generation;
+    slot.next_free = free_head_;
+    free_head_ = index;
+    --size_;
+    return true;
+  }
+
+  // Returns the entry, or nullptr if the handle is stale.
+  T* Get(AnchorHandle handle) {
+    return IsLive(handle) ? &slots_[handle.index].value : nullptr;
+  }
+  const T* Get(AnchorHandle handle) const {
+    return IsLive(handle) ? &slots_[handle.index].value : nullptr;
+  }
+
+  // Moves the entry in the spatial index, after its anchor moved.
+  void UpdatePosition(AnchorHandle handle, const glm::vec3& position) {
+    if (!IsLive(handle)) {
+      return;
+    }
+    Slot& slot = slots_[handle.index];
+    slot.position = position;
+    const int64_t cell = GetCellKey(position);
+    if (cell != slot.cell) {
+      RemoveFromCell(slot.cell, handle.index);
+      slot.cell = cell;
+      grid_[cell].push_back(handle.index);
+    }
+  }
+
+  // Records that the entry was drawn, making it the last to be evicted by
+  // kLeastRecentlyVisible.
+  void MarkVisible(AnchorHandle handle) {
+    if (!IsLive(handle) || visible_.tail == handle.index) {
+      return;
+    }
+    Unlink(&visible_, &Slot::visible, handle.index);
+    PushBack(&visible_, &Slot::visible, handle.index);
+  }
+
+  // Returns the entry nearest to position within max_distance meters, or an
+  // invalid handle.
+  AnchorHandle FindNearest(const glm::vec3& position,
+                           float max_distance) const {
+    float best_distance_squared = max_distance * max_distance;
+    int32_t best_index = -1;
+    const auto consider = [&](int32_t index) {
+      const glm::vec3 offset = slots_[index].position - position;
+      const float distance_squared = glm::dot(offset, offset);
+      if (distance_squared <= best_distance_squared) {
+        best_distance_squared = distance_squared;
+        best_index = index;
+      }
+    };
+
+    const int32_t max_ring =
+        static_cast<int32_t>(std::ceil(max_distance / cell_size_)) + 1;
+    const int64_t ring_cells = static_cast<int64_t>(2 * max_ring + 1) *
+                               (2 * max_ring + 1) * (2 * max_ring + 1);
+    if (ring_cells > size_) {
+      // Fewer entries than cells to visit: checking them all is cheaper.
+      for (int32_t index = inserted_.head; index >= 0;
+           index = slots_[index].inserted.next) {
+        consider(index);
+      }
+      return best_index >= 0 ? HandleOf(best_index) : AnchorHandle();
+    }
+
+    // Visit shells of cells around the query's cell. Entries in shell r are
+    // at least (r - 1) cells away, so the search ends once the best entry is
+    // closer than that.
+    const glm::ivec3 center = GetCell(position);
+    for (int32_t ring = 0; ring <= max_ring; ++ring) {
+      if (ring > 0 && best_index >= 0) {
+        const float reach = (ring - 1) * cell_size_;
+        if (best_distance_squared <= reach * reach) {
+          break;
+        }
+      }
+      for (int32_t x = -ring; x <= ring; ++x) {
+        for (int32_t y = -ring; y <= ring; ++y) {
+          for (int32_t z = -ring; z <= ring; ++z) {
+            if (std::abs(x) != ring && std::abs(y) != ring &&
+                std::abs(z) != ring) {
+              continue;
+            }
+            const auto cell =
+                grid_.find(PackCell(center + glm::ivec3(x, y, z)));
+            if (cell == grid_.end()) {
+              continue;
+            }
+            for (int32_t index : cell->second) {
+              consider(index);
+            }
+          }
+        }
+      }
+    }
+    return best_index >= 0 ? HandleOf(best_index) : AnchorHandle();
+  }
+
+  // Calls f(handle, value) for every entry, oldest first. f must not insert
+  // or remove entries.
+  template <typename F>
+  void ForEach(F f) {
+    for (int32_t index = inserted_.head; index >= 0;
+         index = slots_[index].inserted.next) {
+      f(HandleOf(index), slots_[index].value);
+    }
+  }
+
+  template <typename F>
+  void ForEach(F f) const {
+    for (int32_t index = inserted_.head; index >= 0;
+         index = slots_[index].inserted.next) {
+      f(HandleOf(index), slots_[index].value);
+    }
+  }
+
+  void Clear() {
+    for (int32_t index = 0; index < GetCapacity(); ++index) {
+      Slot& slot = slots_[index];
+      if (slot.live) {
+        slot.value = T();
+        slot.live = false;
+        ++slot.generation;
+      }
+      slot.next_free = index + 1 < GetCapacity() ? index + 1 : -1;
+    }
+    free_head_ = GetCapacity() > 0 ? 0 : -1;
+    inserted_ = List();
+    visible_ = List();
+    grid_.clear();
+    size_ = 0;
+  }
+
+ private:
+  struct Links {
+    int32_t previous = -1;
+    int32_t next = -1;
+  };
+
+  struct List {
+    int32_t head = -1;
+    int32_t tail = -1;
+  };
+
+  struct Slot {
+    T value;
+    bool live = false;
+    uint32_t generation = 0;
+    glm::vec3 position = glm::vec3(0.f);
+    int64_t cell = 0;
+    Links inserted;
+    Links visible;
+    int32_t next_free = -1;
+  };
+
+  bool IsLive(AnchorHandle handle) const {
+    return handle.index >= 0 && handle.index < GetCapacity() &&
+           slots_[handle.index].live &&
+           slots_[handle.index].generation == handle.generation;
+  }
+
+  AnchorHandle HandleOf(int32_t index) const {
+    AnchorHandle handle;
+    handle.index = index;
+    handle.generation = slots_[index].generation;
+    return handle;
+  }
+
+  int32_t SelectVictim(const glm::vec3& camera_position) const {
+    switch (eviction_policy_) {
+      case AnchorEvictionPolicy::kLeastRecentlyVisible:
+        return visible_.head;
+      case AnchorEvictionPolicy::kFarthestFromCamera: {
+        int32_t farthest = inserted_.head;
+        float farthest_distance_squared = -1.f;
+        for (int32_t index = inserted_.head; index >= 0;
+             index = slots_[index].inserted.next) {
+          const glm::vec3 offset = slots_[index].position - camera_position;
+          const float distance_squared = glm::dot(offset, offset);
+          if (distance_squared > farthest_distance_squared) {
+            farthest_distance_squared = distance_squared;
+            farthest = index;
+          }
+        }
+        return farthest;
+      }
+      case AnchorEvictionPolicy::kOldest:
+      default:
+        return inserted_.head;
+    }
+  }
+
+  void PushBack(List* list, Links Slot::*links, int32_t index) {
+    Links& node = slots_[index].*links;
+    node.previous = list->tail;
+    node.next = -1;
+    if (list->tail >= 0) {
+      (slots_[list->tail].*links).next = index;
+    } else {
+      list->head = index;
+    }
+    list->tail = index;
+  }
+
+  void Unlink(List* list, Links Slot::*links, int32_t index) {
+    Links& node = slots_[index].*links;
+    if (node.previous >= 0) {
+      (slots_[node.previous].*links).next = node.next;
+    } else {
+      list->head = node.next;
+    }
+    if (node.next >= 0) {
+      (slots_[node.next].*links).previous = node.previous;
+    } else {
+      list->tail = node.previous;
+    }
+    node = Links();
+  }
+
+  glm::ivec3 GetCell(const glm::vec3& position) const {
+    return glm::ivec3(glm::floor(position / cell_size_));
+  }
+
+  // Packs a cell's coordinates, 21 bits each, into a grid key.
+  static int64_t PackCell(const glm::ivec3& cell) {
+    constexpr int64_t kMask = (int64_t{1} << 21) - 1;
+    return ((cell.x & kMask) << 42) | ((cell.y & kMask) << 21) |
+           (cell.z & kMask);
+  }
+
+  int64_t GetCellKey(const glm::vec3& position) const {
+    return PackCell(GetCell(position));
+  }
+
+  void RemoveFromCell(int64_t cell, int32_t index) {
+    auto entry = grid_.find(cell);
+    if (entry == grid_.end()) {
+      return;
+    }
+    std::vector<int32_t>& indices = entry->second;
+    for (size_t i = 0; i < indices.size(); ++i) {
+      if (indices[i] == index) {
+        indices[i] = indices.back();
+        indices.pop_back();
+        break;
+      }
+    }
+    if (indices.empty()) {
+      grid_.erase(entry);
+    }
+  }
+
+  std::vector<Slot> slots_;
+  const float cell_size_;
+  AnchorEvictionPolicy eviction_policy_ = AnchorEvictionPolicy::kOldest;
+  int32_t free_head_ = -1;
+  int32_t size_ = 0;
+  List inserted_;
+  List visible_;
+  // Indices of the entries in each occupied cell.
+  std::unordered_map<int64_t, std::vector<int32_t>> grid_;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_ANCHOR_STORE_H_
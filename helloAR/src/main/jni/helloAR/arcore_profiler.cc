@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "arcore_profiler.h"
+
+#ifdef HELLOAR_PROFILE_ARCORE
+#include <algorithm>
+#include <vector>
+
+#include "util.h"
+#endif  // HELLOAR_PROFILE_ARCORE
+
+namespace hello_ar {
+namespace arcore_profiler {
+
+#ifdef HELLOAR_PROFILE_ARCORE
+namespace {
+// Number of frames summarized by each report.
+constexpr int64_t kReportIntervalFrames = 600;
+
+// Every FunctionStats ever created, pushed on first call of the function.
+std::atomic<FunctionStats*> g_function_stats{nullptr};
+
+int64_t g_interval_frames = 0;
+
+void LogReport() {
+  std::vector<const FunctionStats*> ranked;
+  int64_t interval_ns = 0;
+  for (const FunctionStats* stats =
+           g_function_stats.load(std::memory_order_acquire);
+       stats != nullptr; stats = stats->next) {
+    if (stats->interval_calls > 0) {
+      ranked.push_back(stats);
+      interval_ns += stats->interval_ns;
+    }
+  }
+  std::sort(ranked.begin(), ranked.end(),
+            [](const FunctionStats* a, const FunctionStats* b) {
+              return a->interval_ns > b->interval_ns;
+            });
+
+  const double frames = static_cast<double>(g_interval_frames);
+  HELLOAR_LOG_UNLIMITED(
+      ANDROID_LOG_INFO,
+      "ARCore calls over %lld frames: %.1f us/frame, ranked by time",
+      static_cast<long long>(g_interval_frames), interval_ns / frames / 1e3);
+  for (const FunctionStats* stats : ranked) {
+    HELLOAR_LOG_UNLIMITED(
+        ANDROID_LOG_INFO,
+        "  %5.1f%% %-44s %7.1f calls/frame %8.1f us/frame %7.0f ns/call "
+        "%8.1f us max/frame",
+        interval_ns > 0 ? 100.0 * stats->interval_ns / interval_ns : 0.0,
+        stats->name, stats->interval_calls / frames,
+        stats->interval_ns / frames / 1e3,
+        static_cast<double>(stats->interval_ns) / stats->interval_calls,
+        stats->max_frame_ns / 1e3);
+  }
+}
+}  // namespace
+
+FunctionStats::FunctionStats(const char* function_name) : name(function_name) {
+  next = g_function_stats.load(std::memory_order_relaxed);
+  while (!g_function_stats.compare_exchange_weak(next, this,
+                                                 std::memory_order_release,
+                                                 std::memory_order_relaxed)) {
+  }
+}
+#endif  // HELLOAR_PROFILE_ARCORE
+
+void BeginFrame() {
+#ifdef HELLOAR_PROFILE_ARCORE
+  for (FunctionStats* stats = g_function_stats.load(std::memory_order_acquire);
+       stats != nullptr; stats = stats->next) {
+    const int64_t calls = stats->calls.load(std::memory_order_relaxed);
+    const int64_t total_ns = stats->total_ns.load(std::memory_order_relaxed);
+    const int64_t frame_ns = total_ns - stats->previous_total_ns;
+    stats->interval_calls += calls - stats->previous_calls;
+    stats->interval_ns += frame_ns;
+    stats->max_frame_ns = std::max(stats->max_frame_ns, frame_ns);
+    stats->previous_calls = calls;
+    stats->previous_total_ns = total_ns;
+  }
+
+  if (++g_interval_frames < kReportIntervalFrames) {
+    return;
+  }
+  LogReport();
+  for (FunctionStats* stats = g_function_stats.load(std::memory_order_acquire);
+       stats != nullptr; stats = stats->next) {
+    stats->interval_calls = 0;
+    stats->interval_ns = 0;
+    stats->max_frame_ns = 0;
+  }
+  g_interval_frames = 0;
+#endif  // HELLOAR_PROFILE_ARCORE
+}
+
+}  // namespace arcore_profiler
+}  // namespace hello_ar
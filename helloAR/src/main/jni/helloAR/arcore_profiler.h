@@ -0,0 +1,358 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_ARCORE_PROFILER_H_
+#define C_ARCORE_ARCORE_PROFILER_H_
+
+#include "arcore_c_api.h"
+
+#ifdef HELLOAR_PROFILE_ARCORE
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#endif  // HELLOAR_PROFILE_ARCORE
+
+// Profiler for the ARCore C API calls made by the app.
+//
+// When built with HELLOAR_PROFILE_ARCORE, every ARCore function listed at the
+// end of this file is replaced by a function-like macro that times the call
+// and adds it to the function's FunctionStats. Headers that name these
+// functions without calling them, like the release functions passed to
+// util::ScopedArHandle, are unaffected. arcore_profiler::BeginFrame() turns
+// the totals into per-frame numbers and periodically logs the functions
+// ranked by the time spent in them.
+//
+// This header must be included after any other header that declares the
+// ARCore functions, which util.h takes care of for the app sources.
+namespace hello_ar {
+namespace arcore_profiler {
+
+// Closes the per-frame totals of every ARCore function and logs the ranked
+// report once every report interval. Called on the OpenGL thread at the
+// start of every frame. Does nothing without HELLOAR_PROFILE_ARCORE.
+void BeginFrame();
+
+#ifdef HELLOAR_PROFILE_ARCORE
+// Call totals of one ARCore function. Instances are created on first call
+// and live for the rest of the process.
+struct FunctionStats {
+  explicit FunctionStats(const char* function_name);
+
+  const char* const name;
+  // Updated by any thread calling the function.
+  std::atomic<int64_t> calls{0};
+  std::atomic<int64_t> total_ns{0};
+
+  // Owned by BeginFrame.
+  int64_t previous_calls = 0;
+  int64_t previous_total_ns = 0;
+  int64_t interval_calls = 0;
+  int64_t interval_ns = 0;
+  int64_t max_frame_ns = 0;
+  FunctionStats* next = nullptr;
+};
+
+// Returns the stats of Function, creating them on first use.
+template <typename FunctionPointer, FunctionPointer Function>
+FunctionStats* GetFunctionStats(const char* name) {
+  static FunctionStats stats(name);
+  return &stats;
+}
+
+class ScopedCallTimer {
+ public:
+  explicit ScopedCallTimer(FunctionStats* stats)
+      : stats_(stats), begin_(std::chrono::steady_clock::now()) {}
+  ~ScopedCallTimer() {
+    const int64_t elapsed_ns =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin_)
+            .count();
+    stats_->calls.fetch_add(1, std::memory_order_relaxed);
+    stats_->total_ns.fetch_add(elapsed_ns, std::memory_order_relaxed);
+  }
+
+  // Delete copy constructors.
+  ScopedCallTimer(const ScopedCallTimer&) = delete;
+  void operator=(const ScopedCallTimer&) = delete;
+
+ private:
+  FunctionStats* const stats_;
+  const std::chrono::steady_clock::time_point begin_;
+};
+
+// Every ARCore argument is a pointer or a scalar, so arguments are taken by
+// value. Forwarding references would bind to, and so ODR-use, static
+// constexpr members passed as arguments, which C++11 leaves undefined.
+template <typename Result, typename... Parameters, typename... Arguments>
+Result Call(FunctionStats* stats, Result (*function)(Parameters...),
+            Arguments... arguments) {
+  ScopedCallTimer timer(stats);
+  return function(arguments...);
+}
+#endif  // HELLOAR_PROFILE_ARCORE
+
+}  // namespace arcore_profiler
+}  // namespace hello_ar
+
+#ifdef HELLOAR_PROFILE_ARCORE
+// The function name is not expanded again inside its own macro, so the
+// address taken here is the real ARCore entry point.
+#define HELLOAR_PROFILED_AR_CALL(function, ...)                        \
+  ::hello_ar::arcore_profiler::Call(                                   \
+      ::hello_ar::arcore_profiler::GetFunctionStats<                   \
+          decltype(&function), &function>(#function),                  \
+      &function, __VA_ARGS__)
+
+// ARCore functions called by the app.
+#define ArAnchor_getPose(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAnchor_getPose, __VA_ARGS__)
+#define ArAnchor_getTrackingState(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAnchor_getTrackingState, __VA_ARGS__)
+#define ArAnchor_release(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAnchor_release, __VA_ARGS__)
+#define ArAugmentedFace_getMeshNormals(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedFace_getMeshNormals, __VA_ARGS__)
+#define ArAugmentedFace_getMeshTextureCoordinates(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedFace_getMeshTextureCoordinates, __VA_ARGS__)
+#define ArAugmentedFace_getMeshTriangleIndices(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedFace_getMeshTriangleIndices, __VA_ARGS__)
+#define ArAugmentedFace_getMeshVertices(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedFace_getMeshVertices, __VA_ARGS__)
+#define ArAugmentedFace_getRegionPose(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedFace_getRegionPose, __VA_ARGS__)
+#define ArAugmentedImageDatabase_addImage(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedImageDatabase_addImage, __VA_ARGS__)
+#define ArAugmentedImageDatabase_create(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedImageDatabase_create, __VA_ARGS__)
+#define ArAugmentedImageDatabase_deserialize(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedImageDatabase_deserialize, __VA_ARGS__)
+#define ArAugmentedImageDatabase_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedImageDatabase_destroy, __VA_ARGS__)
+#define ArAugmentedImage_getCenterPose(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedImage_getCenterPose, __VA_ARGS__)
+#define ArAugmentedImage_getExtentX(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedImage_getExtentX, __VA_ARGS__)
+#define ArAugmentedImage_getExtentZ(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedImage_getExtentZ, __VA_ARGS__)
+#define ArAugmentedImage_getIndex(...) \
+  HELLOAR_PROFILED_AR_CALL(ArAugmentedImage_getIndex, __VA_ARGS__)
+#define ArCameraConfigFilter_create(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfigFilter_create, __VA_ARGS__)
+#define ArCameraConfigFilter_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfigFilter_destroy, __VA_ARGS__)
+#define ArCameraConfigFilter_setDepthSensorUsage(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfigFilter_setDepthSensorUsage, __VA_ARGS__)
+#define ArCameraConfigFilter_setTargetFps(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfigFilter_setTargetFps, __VA_ARGS__)
+#define ArCameraConfigList_create(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfigList_create, __VA_ARGS__)
+#define ArCameraConfigList_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfigList_destroy, __VA_ARGS__)
+#define ArCameraConfigList_getItem(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfigList_getItem, __VA_ARGS__)
+#define ArCameraConfigList_getSize(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfigList_getSize, __VA_ARGS__)
+#define ArCameraConfig_create(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfig_create, __VA_ARGS__)
+#define ArCameraConfig_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfig_destroy, __VA_ARGS__)
+#define ArCameraConfig_getDepthSensorUsage(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfig_getDepthSensorUsage, __VA_ARGS__)
+#define ArCameraConfig_getFpsRange(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfig_getFpsRange, __VA_ARGS__)
+#define ArCameraConfig_getTextureDimensions(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCameraConfig_getTextureDimensions, __VA_ARGS__)
+#define ArCamera_getPose(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCamera_getPose, __VA_ARGS__)
+#define ArCamera_getProjectionMatrix(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCamera_getProjectionMatrix, __VA_ARGS__)
+#define ArCamera_getTrackingState(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCamera_getTrackingState, __VA_ARGS__)
+#define ArCamera_getViewMatrix(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCamera_getViewMatrix, __VA_ARGS__)
+#define ArCamera_release(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCamera_release, __VA_ARGS__)
+#define ArConfig_create(...) \
+  HELLOAR_PROFILED_AR_CALL(ArConfig_create, __VA_ARGS__)
+#define ArConfig_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArConfig_destroy, __VA_ARGS__)
+#define ArConfig_setAugmentedImageDatabase(...) \
+  HELLOAR_PROFILED_AR_CALL(ArConfig_setAugmentedImageDatabase, __VA_ARGS__)
+#define ArConfig_setDepthMode(...) \
+  HELLOAR_PROFILED_AR_CALL(ArConfig_setDepthMode, __VA_ARGS__)
+#define ArConfig_setFocusMode(...) \
+  HELLOAR_PROFILED_AR_CALL(ArConfig_setFocusMode, __VA_ARGS__)
+#define ArConfig_setInstantPlacementMode(...) \
+  HELLOAR_PROFILED_AR_CALL(ArConfig_setInstantPlacementMode, __VA_ARGS__)
+#define ArConfig_setLightEstimationMode(...) \
+  HELLOAR_PROFILED_AR_CALL(ArConfig_setLightEstimationMode, __VA_ARGS__)
+#define ArConfig_setPlaneFindingMode(...) \
+  HELLOAR_PROFILED_AR_CALL(ArConfig_setPlaneFindingMode, __VA_ARGS__)
+#define ArConfig_setUpdateMode(...) \
+  HELLOAR_PROFILED_AR_CALL(ArConfig_setUpdateMode, __VA_ARGS__)
+#define ArCoreApk_requestInstall(...) \
+  HELLOAR_PROFILED_AR_CALL(ArCoreApk_requestInstall, __VA_ARGS__)
+#define ArFrame_acquireCamera(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_acquireCamera, __VA_ARGS__)
+#define ArFrame_acquireDepthImage(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_acquireDepthImage, __VA_ARGS__)
+#define ArFrame_acquirePointCloud(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_acquirePointCloud, __VA_ARGS__)
+#define ArFrame_create(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_create, __VA_ARGS__)
+#define ArFrame_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_destroy, __VA_ARGS__)
+#define ArFrame_getDisplayGeometryChanged(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_getDisplayGeometryChanged, __VA_ARGS__)
+#define ArFrame_getLightEstimate(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_getLightEstimate, __VA_ARGS__)
+#define ArFrame_getTimestamp(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_getTimestamp, __VA_ARGS__)
+#define ArFrame_getUpdatedTrackables(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_getUpdatedTrackables, __VA_ARGS__)
+#define ArFrame_hitTest(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_hitTest, __VA_ARGS__)
+#define ArFrame_hitTestInstantPlacement(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_hitTestInstantPlacement, __VA_ARGS__)
+#define ArFrame_hitTestRay(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_hitTestRay, __VA_ARGS__)
+#define ArFrame_transformCoordinates2d(...) \
+  HELLOAR_PROFILED_AR_CALL(ArFrame_transformCoordinates2d, __VA_ARGS__)
+#define ArHitResultList_create(...) \
+  HELLOAR_PROFILED_AR_CALL(ArHitResultList_create, __VA_ARGS__)
+#define ArHitResultList_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArHitResultList_destroy, __VA_ARGS__)
+#define ArHitResultList_getItem(...) \
+  HELLOAR_PROFILED_AR_CALL(ArHitResultList_getItem, __VA_ARGS__)
+#define ArHitResultList_getSize(...) \
+  HELLOAR_PROFILED_AR_CALL(ArHitResultList_getSize, __VA_ARGS__)
+#define ArHitResult_acquireNewAnchor(...) \
+  HELLOAR_PROFILED_AR_CALL(ArHitResult_acquireNewAnchor, __VA_ARGS__)
+#define ArHitResult_acquireTrackable(...) \
+  HELLOAR_PROFILED_AR_CALL(ArHitResult_acquireTrackable, __VA_ARGS__)
+#define ArHitResult_create(...) \
+  HELLOAR_PROFILED_AR_CALL(ArHitResult_create, __VA_ARGS__)
+#define ArHitResult_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArHitResult_destroy, __VA_ARGS__)
+#define ArHitResult_getDistance(...) \
+  HELLOAR_PROFILED_AR_CALL(ArHitResult_getDistance, __VA_ARGS__)
+#define ArHitResult_getHitPose(...) \
+  HELLOAR_PROFILED_AR_CALL(ArHitResult_getHitPose, __VA_ARGS__)
+#define ArImage_getFormat(...) \
+  HELLOAR_PROFILED_AR_CALL(ArImage_getFormat, __VA_ARGS__)
+#define ArImage_getHeight(...) \
+  HELLOAR_PROFILED_AR_CALL(ArImage_getHeight, __VA_ARGS__)
+#define ArImage_getPlaneData(...) \
+  HELLOAR_PROFILED_AR_CALL(ArImage_getPlaneData, __VA_ARGS__)
+#define ArImage_getPlanePixelStride(...) \
+  HELLOAR_PROFILED_AR_CALL(ArImage_getPlanePixelStride, __VA_ARGS__)
+#define ArImage_getPlaneRowStride(...) \
+  HELLOAR_PROFILED_AR_CALL(ArImage_getPlaneRowStride, __VA_ARGS__)
+#define ArImage_getWidth(...) \
+  HELLOAR_PROFILED_AR_CALL(ArImage_getWidth, __VA_ARGS__)
+#define ArImage_release(...) \
+  HELLOAR_PROFILED_AR_CALL(ArImage_release, __VA_ARGS__)
+#define ArInstantPlacementPoint_getTrackingMethod(...) \
+  HELLOAR_PROFILED_AR_CALL(ArInstantPlacementPoint_getTrackingMethod, __VA_ARGS__)
+#define ArLightEstimate_acquireEnvironmentalHdrCubemap(...) \
+  HELLOAR_PROFILED_AR_CALL(ArLightEstimate_acquireEnvironmentalHdrCubemap, __VA_ARGS__)
+#define ArLightEstimate_create(...) \
+  HELLOAR_PROFILED_AR_CALL(ArLightEstimate_create, __VA_ARGS__)
+#define ArLightEstimate_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArLightEstimate_destroy, __VA_ARGS__)
+#define ArLightEstimate_getColorCorrection(...) \
+  HELLOAR_PROFILED_AR_CALL(ArLightEstimate_getColorCorrection, __VA_ARGS__)
+#define ArLightEstimate_getEnvironmentalHdrAmbientSphericalHarmonics(...) \
+  HELLOAR_PROFILED_AR_CALL(ArLightEstimate_getEnvironmentalHdrAmbientSphericalHarmonics, __VA_ARGS__)
+#define ArLightEstimate_getEnvironmentalHdrMainLightDirection(...) \
+  HELLOAR_PROFILED_AR_CALL(ArLightEstimate_getEnvironmentalHdrMainLightDirection, __VA_ARGS__)
+#define ArLightEstimate_getEnvironmentalHdrMainLightIntensity(...) \
+  HELLOAR_PROFILED_AR_CALL(ArLightEstimate_getEnvironmentalHdrMainLightIntensity, __VA_ARGS__)
+#define ArLightEstimate_getState(...) \
+  HELLOAR_PROFILED_AR_CALL(ArLightEstimate_getState, __VA_ARGS__)
+#define ArLightEstimate_getTimestamp(...) \
+  HELLOAR_PROFILED_AR_CALL(ArLightEstimate_getTimestamp, __VA_ARGS__)
+#define ArPlane_acquireSubsumedBy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPlane_acquireSubsumedBy, __VA_ARGS__)
+#define ArPlane_getCenterPose(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPlane_getCenterPose, __VA_ARGS__)
+#define ArPlane_getPolygon(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPlane_getPolygon, __VA_ARGS__)
+#define ArPlane_getPolygonSize(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPlane_getPolygonSize, __VA_ARGS__)
+#define ArPlane_isPoseInPolygon(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPlane_isPoseInPolygon, __VA_ARGS__)
+#define ArPointCloud_getData(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPointCloud_getData, __VA_ARGS__)
+#define ArPointCloud_getNumberOfPoints(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPointCloud_getNumberOfPoints, __VA_ARGS__)
+#define ArPointCloud_release(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPointCloud_release, __VA_ARGS__)
+#define ArPoint_getOrientationMode(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPoint_getOrientationMode, __VA_ARGS__)
+#define ArPose_create(...) HELLOAR_PROFILED_AR_CALL(ArPose_create, __VA_ARGS__)
+#define ArPose_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPose_destroy, __VA_ARGS__)
+#define ArPose_getMatrix(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPose_getMatrix, __VA_ARGS__)
+#define ArPose_getPoseRaw(...) \
+  HELLOAR_PROFILED_AR_CALL(ArPose_getPoseRaw, __VA_ARGS__)
+#define ArSession_configure(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_configure, __VA_ARGS__)
+#define ArSession_create(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_create, __VA_ARGS__)
+#define ArSession_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_destroy, __VA_ARGS__)
+#define ArSession_getAllTrackables(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_getAllTrackables, __VA_ARGS__)
+#define ArSession_getCameraConfig(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_getCameraConfig, __VA_ARGS__)
+#define ArSession_getSupportedCameraConfigsWithFilter(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_getSupportedCameraConfigsWithFilter, __VA_ARGS__)
+#define ArSession_isDepthModeSupported(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_isDepthModeSupported, __VA_ARGS__)
+#define ArSession_pause(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_pause, __VA_ARGS__)
+#define ArSession_resume(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_resume, __VA_ARGS__)
+#define ArSession_setCameraConfig(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_setCameraConfig, __VA_ARGS__)
+#define ArSession_setCameraTextureName(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_setCameraTextureName, __VA_ARGS__)
+#define ArSession_setDisplayGeometry(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_setDisplayGeometry, __VA_ARGS__)
+#define ArSession_update(...) \
+  HELLOAR_PROFILED_AR_CALL(ArSession_update, __VA_ARGS__)
+#define ArTrackableList_acquireItem(...) \
+  HELLOAR_PROFILED_AR_CALL(ArTrackableList_acquireItem, __VA_ARGS__)
+#define ArTrackableList_create(...) \
+  HELLOAR_PROFILED_AR_CALL(ArTrackableList_create, __VA_ARGS__)
+#define ArTrackableList_destroy(...) \
+  HELLOAR_PROFILED_AR_CALL(ArTrackableList_destroy, __VA_ARGS__)
+#define ArTrackableList_getSize(...) \
+  HELLOAR_PROFILED_AR_CALL(ArTrackableList_getSize, __VA_ARGS__)
+#define ArTrackable_acquireNewAnchor(...) \
+  HELLOAR_PROFILED_AR_CALL(ArTrackable_acquireNewAnchor, __VA_ARGS__)
+#define ArTrackable_getTrackingState(...) \
+  HELLOAR_PROFILED_AR_CALL(ArTrackable_getTrackingState, __VA_ARGS__)
+#define ArTrackable_getType(...) \
+  HELLOAR_PROFILED_AR_CALL(ArTrackable_getType, __VA_ARGS__)
+#define ArTrackable_release(...) \
+  HELLOAR_PROFILED_AR_CALL(ArTrackable_release, __VA_ARGS__)
+#endif  // HELLOAR_PROFILE_ARCORE
+
+#endif  // C_ARCORE_ARCORE_PROFILER_H_
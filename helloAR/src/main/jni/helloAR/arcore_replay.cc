@@ -0,0 +1,968 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Replay implementation of the ARCore C API. See arcore_replay.h.
+
+#include "arcore_replay.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+
+#include "glm.h"
+
+using hello_ar::FrameLogReader;
+using hello_ar::LoggedFrame;
+using hello_ar::LoggedPlane;
+using hello_ar::LoggedTouch;
+
+struct ArPose_ {
+  // qx, qy, qz, qw, tx, ty, tz.
+  float raw[7];
+};
+
+struct ArTrackable_ {
+  ArTrackableType type = AR_TRACKABLE_NOT_VALID;
+  ArTrackingState tracking_state = AR_TRACKING_STATE_TRACKING;
+  // Only used for planes.
+  LoggedPlane plane;
+  // Only used for instant placement points.
+  float pose[7] = {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f};
+};
+
+struct ArAnchor_ {
+  float pose[7];
+};
+
+struct ArCamera_ {
+  ArTrackingState tracking_state = AR_TRACKING_STATE_STOPPED;
+  float pose[7] = {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f};
+  float projection_mat[16] = {0.f};
+};
+
+struct ArPointCloud_ {
+  std::vector<float> data;
+};
+
+struct ArImage_ {
+  int32_t width = 0;
+  int32_t height = 0;
+  std::vector<uint16_t> data;
+};
+
+struct ArLightEstimate_ {
+  ArLightEstimateState state = AR_LIGHT_ESTIMATE_STATE_NOT_VALID;
+  float color_correction[4] = {1.f, 1.f, 1.f, 1.f};
+  int64_t timestamp_ns = 0;
+};
+
+struct ArFrame_ {
+  int64_t timestamp_ns = 0;
+  bool display_geometry_changed = false;
+  float ndc_basis_uvs[6] = {0.f};
+  ArLightEstimate_ light_estimate;
+  // Acquired objects are owned by the frame, the release calls are no-ops.
+  ArCamera_ camera;
+  ArPointCloud_ point_cloud;
+  ArImage_ depth_image;
+};
+
+struct ArTrackableList_ {
+  std::vector<ArTrackable_*> items;
+};
+
+struct ArHitResult_ {
+  float pose[7] = {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f};
+  float distance = 0.f;
+  ArTrackable_* trackable = nullptr;
+};
+
+struct ArHitResultList_ {
+  std::vector<ArHitResult_> items;
+};
+
+struct ArConfig_ {
+  ArDepthMode depth_mode = AR_DEPTH_MODE_DISABLED;
+  ArInstantPlacementMode instant_placement_mode =
+      AR_INSTANT_PLACEMENT_MODE_DISABLED;
+  ArLightEstimationMode light_estimation_mode =
+      AR_LIGHT_ESTIMATION_MODE_AMBIENT_INTENSITY;
+};
+
+struct ArAugmentedImageDatabase_ {};
+
+struct ArCameraConfig_ {};
+struct ArCameraConfigFilter_ {};
+struct ArCameraConfigList_ {};
+
+struct ArSession_ {
+  FrameLogReader reader;
+  bool finished = false;
+  ArConfig_ config;
+  int32_t width = 1;
+  int32_t height = 1;
+  bool display_geometry_changed = true;
+  std::vector<LoggedTouch> touches;
+  // Trackables are owned by the session for its whole lifetime so that
+  // pointers stay stable across frames, like ARCore's own handles.
+  std::map<int32_t, std::unique_ptr<ArTrackable_>> planes;
+  mutable std::vector<std::unique_ptr<ArTrackable_>> instant_placement_points;
+};
+
+namespace hello_ar {
+namespace replay {
+
+const std::vector<LoggedTouch>& GetFrameTouches(const ArSession* session) {
+  return session->touches;
+}
+
+bool IsFinished(const ArSession* session) { return session->finished; }
+
+}  // namespace replay
+}  // namespace hello_ar
+
+namespace {
+
+glm::mat4 PoseToMatrix(const float* raw) {
+  const glm::quat rotation(raw[3], raw[0], raw[1], raw[2]);
+  glm::mat4 matrix = glm::mat4_cast(rotation);
+  matrix[3] = glm::vec4(raw[4], raw[5], raw[6], 1.f);
+  return matrix;
+}
+
+void CopyPose(const float* from, float* to) { memcpy(to, from, 7 * sizeof(float)); }
+
+const ArTrackable_* AsReplayTrackable(const ArPlane* plane) {
+  return reinterpret_cast<const ArTrackable_*>(plane);
+}
+
+bool IsPointInPolygon(const std::vector<float>& polygon, float x, float z) {
+  // Even-odd rule over the x, z pairs.
+  bool inside = false;
+  const size_t count = polygon.size() / 2;
+  for (size_t i = 0, j = count - 1; i < count; j = i++) {
+    const float xi = polygon[2 * i], zi = polygon[2 * i + 1];
+    const float xj = polygon[2 * j], zj = polygon[2 * j + 1];
+    if ((zi > z) != (zj > z) && x < (xj - xi) * (z - zi) / (zj - zi) + xi) {
+      inside = !inside;
+    }
+  }
+  return count >= 3 && inside;
+}
+
+// Returns the world space ray through a pixel of the logged camera.
+void GetPixelRay(const ArSession* session, const ArFrame* frame, float pixel_x,
+                 float pixel_y, glm::vec3* out_origin,
+                 glm::vec3* out_direction) {
+  const glm::mat4 camera_mat = PoseToMatrix(frame->camera.pose);
+  const glm::mat4 projection_mat = glm::make_mat4(frame->camera.projection_mat);
+  const glm::mat4 inverse_view_projection =
+      camera_mat * glm::inverse(projection_mat);
+  const float ndc_x = 2.f * pixel_x / session->width - 1.f;
+  const float ndc_y = 1.f - 2.f * pixel_y / session->height;
+  glm::vec4 near_point = inverse_view_projection * glm::vec4(ndc_x, ndc_y, -1.f, 1.f);
+  glm::vec4 far_point = inverse_view_projection * glm::vec4(ndc_x, ndc_y, 1.f, 1.f);
+  near_point /= near_point.w;
+  far_point /= far_point.w;
+  *out_origin = glm::vec3(camera_mat[3]);
+  *out_direction = glm::normalize(glm::vec3(far_point - near_point));
+}
+
+// Intersects the ray with every tracked plane polygon. Results are sorted by
+// distance along the ray, like ARCore's.
+void HitTestPlanes(const ArSession* session, const glm::vec3& origin,
+                   const glm::vec3& direction,
+                   ArHitResultList* hit_result_list) {
+  hit_result_list->items.clear();
+
+  for (const auto& entry : session->planes) {
+    ArTrackable_* trackable = entry.second.get();
+    const LoggedPlane& plane = trackable->plane;
+    if (trackable->tracking_state != AR_TRACKING_STATE_TRACKING ||
+        plane.subsumed_by_id >= 0) {
+      continue;
+    }
+    const glm::mat4 plane_mat = PoseToMatrix(plane.center_pose);
+    const glm::vec3 normal = glm::vec3(plane_mat[1]);
+    const float denominator = glm::dot(normal, direction);
+    if (std::abs(denominator) < 1e-6f) {
+      continue;
+    }
+    const float distance =
+        glm::dot(normal, glm::vec3(plane_mat[3]) - origin) / denominator;
+    if (distance < 0.f) {
+      continue;
+    }
+    const glm::vec3 hit = origin + distance * direction;
+    const glm::vec4 local = glm::inverse(plane_mat) * glm::vec4(hit, 1.f);
+    if (!IsPointInPolygon(plane.polygon, local.x, local.z)) {
+      continue;
+    }
+    ArHitResult_ result;
+    CopyPose(plane.center_pose, result.pose);
+    result.pose[4] = hit.x;
+    result.pose[5] = hit.y;
+    result.pose[6] = hit.z;
+    result.distance = distance;
+    result.trackable = trackable;
+    hit_result_list->items.push_back(result);
+  }
+
+  std::sort(hit_result_list->items.begin(), hit_result_list->items.end(),
+            [](const ArHitResult_& a, const ArHitResult_& b) {
+              return a.distance < b.distance;
+            });
+}
+
+}  // namespace
+
+// Session lifecycle.
+
+ArStatus ArCoreApk_requestInstall(void*, void*, int32_t,
+                                  ArInstallStatus* out_install_status) {
+  *out_install_status = AR_INSTALL_STATUS_INSTALLED;
+  return AR_SUCCESS;
+}
+
+ArStatus ArSession_create(void*, void*, ArSession** out_session_pointer) {
+  *out_session_pointer = nullptr;
+  const char* path = getenv(hello_ar::replay::kReplayLogEnvironmentVariable);
+  std::unique_ptr<ArSession_> session(new ArSession_());
+  if (path == nullptr || !session->reader.Open(path)) {
+    return AR_ERROR_FATAL;
+  }
+  *out_session_pointer = session.release();
+  return AR_SUCCESS;
+}
+
+void ArSession_destroy(ArSession* session) { delete session; }
+
+ArStatus ArSession_pause(ArSession*) { return AR_SUCCESS; }
+
+ArStatus ArSession_resume(ArSession*) { return AR_SUCCESS; }
+
+ArStatus ArSession_configure(ArSession* session, const ArConfig* config) {
+  if (config->light_estimation_mode ==
+      AR_LIGHT_ESTIMATION_MODE_ENVIRONMENTAL_HDR) {
+    // Logs only hold the ambient color correction.
+    return AR_ERROR_UNSUPPORTED_CONFIGURATION;
+  }
+  session->config = *config;
+  return AR_SUCCESS;
+}
+
+void ArSession_isDepthModeSupported(const ArSession*, ArDepthMode,
+                                    int32_t* out_is_supported) {
+  // Frames without a logged depth image fail ArFrame_acquireDepthImage.
+  *out_is_supported = 1;
+}
+
+void ArSession_setCameraTextureName(ArSession*, uint32_t) {}
+
+void ArSession_setDisplayGeometry(ArSession* session, int32_t, int32_t width,
+                                  int32_t height) {
+  session->width = std::max(width, 1);
+  session->height = std::max(height, 1);
+  session->display_geometry_changed = true;
+}
+
+ArStatus ArSession_update(ArSession* session, ArFrame* out_frame) {
+  LoggedFrame logged;
+  if (session->finished || !session->reader.Read(&logged)) {
+    session->finished = true;
+    session->touches.clear();
+    return AR_ERROR_FATAL;
+  }
+
+  out_frame->timestamp_ns = logged.timestamp_ns;
+  out_frame->display_geometry_changed = session->display_geometry_changed;
+  session->display_geometry_changed = false;
+  memcpy(out_frame->ndc_basis_uvs, logged.ndc_basis_uvs,
+         sizeof(logged.ndc_basis_uvs));
+
+  out_frame->camera.tracking_state =
+      static_cast<ArTrackingState>(logged.camera_tracking_state);
+  CopyPose(logged.camera_pose, out_frame->camera.pose);
+  memcpy(out_frame->camera.projection_mat, logged.projection_mat,
+         sizeof(logged.projection_mat));
+
+  out_frame->light_estimate.state =
+      static_cast<ArLightEstimateState>(logged.light_estimate_state);
+  memcpy(out_frame->light_estimate.color_correction, logged.color_correction,
+         sizeof(logged.color_correction));
+  out_frame->light_estimate.timestamp_ns = logged.timestamp_ns;
+
+  out_frame->point_cloud.data = std::move(logged.point_cloud);
+  out_frame->depth_image.width = logged.depth_width;
+  out_frame->depth_image.height = logged.depth_height;
+  out_frame->depth_image.data = std::move(logged.depth);
+
+  for (LoggedPlane& logged_plane : logged.planes) {
+    std::unique_ptr<ArTrackable_>& plane = session->planes[logged_plane.id];
+    if (!plane) {
+      plane.reset(new ArTrackable_());
+      plane->type = AR_TRACKABLE_PLANE;
+    }
+    plane->tracking_state =
+        static_cast<ArTrackingState>(logged_plane.tracking_state);
+    plane->plane = std::move(logged_plane);
+  }
+
+  session->touches = std::move(logged.touches);
+  return AR_SUCCESS;
+}
+
+void ArSession_getAllTrackables(const ArSession* session,
+                                ArTrackableType filter_type,
+                                ArTrackableList* out_trackable_list) {
+  out_trackable_list->items.clear();
+  if (filter_type == AR_TRACKABLE_PLANE ||
+      filter_type == AR_TRACKABLE_BASE_TRACKABLE) {
+    for (const auto& entry : session->planes) {
+      out_trackable_list->items.push_back(entry.second.get());
+    }
+  }
+}
+
+// Camera configs. Logs don't record the camera config, so none is supported
+// and the session keeps the one it was recorded with.
+
+void ArCameraConfigFilter_create(const ArSession*,
+                                 ArCameraConfigFilter** out_filter) {
+  *out_filter = new ArCameraConfigFilter_();
+}
+
+void ArCameraConfigFilter_destroy(ArCameraConfigFilter* filter) {
+  delete filter;
+}
+
+void ArCameraConfigFilter_setTargetFps(const ArSession*,
+                                       ArCameraConfigFilter*, const uint32_t) {}
+
+void ArCameraConfigFilter_setDepthSensorUsage(const ArSession*,
+                                              ArCameraConfigFilter*,
+                                              uint32_t) {}
+
+void ArCameraConfigList_create(const ArSession*,
+                               ArCameraConfigList** out_list) {
+  *out_list = new ArCameraConfigList_();
+}
+
+void ArCameraConfigList_destroy(ArCameraConfigList* list) { delete list; }
+
+void ArCameraConfigList_getSize(const ArSession*, const ArCameraConfigList*,
+                                int32_t* out_size) {
+  *out_size = 0;
+}
+
+void ArCameraConfigList_getItem(const ArSession*, const ArCameraConfigList*,
+                                int32_t, ArCameraConfig*) {}
+
+void ArCameraConfig_create(const ArSession*,
+                           ArCameraConfig** out_camera_config) {
+  *out_camera_config = new ArCameraConfig_();
+}
+
+void ArCameraConfig_destroy(ArCameraConfig* camera_config) {
+  delete camera_config;
+}
+
+void ArCameraConfig_getTextureDimensions(const ArSession*,
+                                         const ArCameraConfig*,
+                                         int32_t* out_width,
+                                         int32_t* out_height) {
+  *out_width = 0;
+  *out_height = 0;
+}
+
+void ArCameraConfig_getFpsRange(const ArSession*, const ArCameraConfig*,
+                                int32_t* out_min_fps, int32_t* out_max_fps) {
+  *out_min_fps = 30;
+  *out_max_fps = 30;
+}
+
+void ArCameraConfig_getDepthSensorUsage(const ArSession*,
+                                        const ArCameraConfig*,
+                                        uint32_t* out_depth_sensor_usage) {
+  *out_depth_sensor_usage = AR_CAMERA_CONFIG_DEPTH_SENSOR_USAGE_DO_NOT_USE;
+}
+
+void ArSession_getSupportedCameraConfigsWithFilter(const ArSession*,
+                                                   const ArCameraConfigFilter*,
+                                                   ArCameraConfigList*) {}
+
+void ArSession_getCameraConfig(const ArSession*, ArCameraConfig*) {}
+
+ArStatus ArSession_setCameraConfig(const ArSession*, const ArCameraConfig*) {
+  return AR_ERROR_INVALID_ARGUMENT;
+}
+
+// Config and augmented image database. Augmented images are not logged, so
+// the database is accepted and never matches anything.
+
+void ArConfig_create(const ArSession*, ArConfig** out_config) {
+  *out_config = new ArConfig_();
+}
+
+void ArConfig_destroy(ArConfig* config) { delete config; }
+
+void ArConfig_setAugmentedImageDatabase(const ArSession*, ArConfig*,
+                                        const ArAugmentedImageDatabase*) {}
+
+void ArConfig_setDepthMode(const ArSession*, ArConfig* config,
+                           ArDepthMode mode) {
+  config->depth_mode = mode;
+}
+
+void ArConfig_setFocusMode(const ArSession*, ArConfig*, ArFocusMode) {}
+
+void ArConfig_setInstantPlacementMode(
+    const ArSession*, ArConfig* config,
+    ArInstantPlacementMode instant_placement_mode) {
+  config->instant_placement_mode = instant_placement_mode;
+}
+
+void ArConfig_setLightEstimationMode(
+    const ArSession*, ArConfig* config,
+    ArLightEstimationMode light_estimation_mode) {
+  config->light_estimation_mode = light_estimation_mode;
+}
+
+void ArConfig_setPlaneFindingMode(const ArSession*, ArConfig*,
+                                  ArPlaneFindingMode) {}
+
+void ArConfig_setUpdateMode(const ArSession*, ArConfig*, ArUpdateMode) {}
+
+void ArAugmentedImageDatabase_create(
+    const ArSession*, ArAugmentedImageDatabase** out_augmented_image_database) {
+  *out_augmented_image_database = new ArAugmentedImageDatabase_();
+}
+
+ArStatus ArAugmentedImageDatabase_deserialize(
+    const ArSession*, const uint8_t*, int64_t,
+    ArAugmentedImageDatabase** out_augmented_image_database) {
+  *out_augmented_image_database = new ArAugmentedImageDatabase_();
+  return AR_SUCCESS;
+}
+
+ArStatus ArAugmentedImageDatabase_addImage(const ArSession*,
+                                           ArAugmentedImageDatabase*,
+                                           const char*, const uint8_t*,
+                                           int32_t, int32_t, int32_t,
+                                           int32_t* out_index) {
+  *out_index = 0;
+  return AR_SUCCESS;
+}
+
+void ArAugmentedImageDatabase_destroy(
+    ArAugmentedImageDatabase* augmented_image_database) {
+  delete augmented_image_database;
+}
+
+void ArAugmentedImage_getCenterPose(const ArSession*, const ArAugmentedImage*,
+                                    ArPose* out_pose) {
+  const ArTrackable_ identity;
+  CopyPose(identity.pose, out_pose->raw);
+}
+
+void ArAugmentedImage_getExtentX(const ArSession*, const ArAugmentedImage*,
+                                 float* out_extent_x) {
+  *out_extent_x = 0.f;
+}
+
+void ArAugmentedImage_getExtentZ(const ArSession*, const ArAugmentedImage*,
+                                 float* out_extent_z) {
+  *out_extent_z = 0.f;
+}
+
+void ArAugmentedImage_getIndex(const ArSession*, const ArAugmentedImage*,
+                               int32_t* out_index) {
+  *out_index = 0;
+}
+
+void ArAugmentedFace_getRegionPose(const ArSession*, const ArAugmentedFace*,
+                                   const ArAugmentedFaceRegionType,
+                                   ArPose* out_pose) {
+  const ArTrackable_ identity;
+  CopyPose(identity.pose, out_pose->raw);
+}
+
+void ArAugmentedFace_getMeshVertices(const ArSession*, const ArAugmentedFace*,
+                                     const float** out_vertices,
+                                     int32_t* out_number_of_vertices) {
+  *out_vertices = nullptr;
+  *out_number_of_vertices = 0;
+}
+
+void ArAugmentedFace_getMeshNormals(const ArSession*, const ArAugmentedFace*,
+                                    const float** out_normals,
+                                    int32_t* out_number_of_normals) {
+  *out_normals = nullptr;
+  *out_number_of_normals = 0;
+}
+
+void ArAugmentedFace_getMeshTextureCoordinates(
+    const ArSession*, const ArAugmentedFace*,
+    const float** out_texture_coordinates,
+    int32_t* out_number_of_texture_coordinates) {
+  *out_texture_coordinates = nullptr;
+  *out_number_of_texture_coordinates = 0;
+}
+
+void ArAugmentedFace_getMeshTriangleIndices(
+    const ArSession*, const ArAugmentedFace*,
+    const uint16_t** out_triangle_indices, int32_t* out_number_of_triangles) {
+  *out_triangle_indices = nullptr;
+  *out_number_of_triangles = 0;
+}
+
+// Pose.
+
+void ArPose_create(const ArSession*, const float* pose_raw,
+                   ArPose** out_pose) {
+  *out_pose = new ArPose_();
+  const ArTrackable_ identity;
+  CopyPose(pose_raw != nullptr ? pose_raw : identity.pose, (*out_pose)->raw);
+}
+
+void ArPose_destroy(ArPose* pose) { delete pose; }
+
+void ArPose_getPoseRaw(const ArSession*, const ArPose* pose,
+                       float* out_pose_raw_7) {
+  CopyPose(pose->raw, out_pose_raw_7);
+}
+
+void ArPose_getMatrix(const ArSession*, const ArPose* pose,
+                      float* out_matrix_col_major_4x4) {
+  const glm::mat4 matrix = PoseToMatrix(pose->raw);
+  memcpy(out_matrix_col_major_4x4, glm::value_ptr(matrix), 16 * sizeof(float));
+}
+
+// Frame.
+
+void ArFrame_create(const ArSession*, ArFrame** out_frame) {
+  *out_frame = new ArFrame_();
+}
+
+void ArFrame_destroy(ArFrame* frame) { delete frame; }
+
+void ArFrame_getTimestamp(const ArSession*, const ArFrame* frame,
+                          int64_t* out_timestamp_ns) {
+  *out_timestamp_ns = frame->timestamp_ns;
+}
+
+void ArFrame_getDisplayGeometryChanged(const ArSession*, const ArFrame* frame,
+                                       int32_t* out_geometry_changed) {
+  *out_geometry_changed = frame->display_geometry_changed ? 1 : 0;
+}
+
+void ArFrame_transformCoordinates2d(const ArSession*, const ArFrame* frame,
+                                    ArCoordinates2dType input_coordinates,
+                                    int32_t number_of_vertices,
+                                    const float* vertices_2d,
+                                    ArCoordinates2dType output_coordinates,
+                                    float* out_vertices_2d) {
+  if (input_coordinates !=
+          AR_COORDINATES_2D_OPENGL_NORMALIZED_DEVICE_COORDINATES ||
+      output_coordinates != AR_COORDINATES_2D_TEXTURE_NORMALIZED) {
+    memmove(out_vertices_2d, vertices_2d,
+            number_of_vertices * 2 * sizeof(float));
+    return;
+  }
+  // The logged basis defines the affine NDC to texture mapping.
+  const float* uvs = frame->ndc_basis_uvs;
+  for (int32_t i = 0; i < number_of_vertices; ++i) {
+    const float x = vertices_2d[2 * i];
+    const float y = vertices_2d[2 * i + 1];
+    out_vertices_2d[2 * i] = uvs[0] + x * (uvs[2] - uvs[0]) + y * (uvs[4] - uvs[0]);
+    out_vertices_2d[2 * i + 1] =
+        uvs[1] + x * (uvs[3] - uvs[1]) + y * (uvs[5] - uvs[1]);
+  }
+}
+
+void ArFrame_getUpdatedTrackables(const ArSession*, const ArFrame*,
+                                  ArTrackableType,
+                                  ArTrackableList* out_trackable_list) {
+  // Trackable updates are not logged.
+  out_trackable_list->items.clear();
+}
+
+// Camera.
+
+void ArFrame_acquireCamera(const ArSession*, const ArFrame* frame,
+                           ArCamera** out_camera) {
+  *out_camera = const_cast<ArCamera_*>(&frame->camera);
+}
+
+void ArCamera_release(ArCamera*) {}
+
+void ArCamera_getPose(const ArSession*, const ArCamera* camera,
+                      ArPose* out_pose) {
+  CopyPose(camera->pose, out_pose->raw);
+}
+
+void ArCamera_getTrackingState(const ArSession*, const ArCamera* camera,
+                               ArTrackingState* out_tracking_state) {
+  *out_tracking_state = camera->tracking_state;
+}
+
+void ArCamera_getViewMatrix(const ArSession*, const ArCamera* camera,
+                            float* out_col_major_4x4) {
+  const glm::mat4 view_mat = glm::inverse(PoseToMatrix(camera->pose));
+  memcpy(out_col_major_4x4, glm::value_ptr(view_mat), 16 * sizeof(float));
+}
+
+void ArCamera_getProjectionMatrix(const ArSession*, const ArCamera* camera,
+                                  float near, float far,
+                                  float* dest_col_major_4x4) {
+  memcpy(dest_col_major_4x4, camera->projection_mat, 16 * sizeof(float));
+  // Only the depth terms depend on the clip planes.
+  dest_col_major_4x4[10] = -(far + near) / (far - near);
+  dest_col_major_4x4[14] = -2.f * far * near / (far - near);
+}
+
+// Light estimate.
+
+void ArLightEstimate_create(const ArSession*,
+                            ArLightEstimate** out_light_estimate) {
+  *out_light_estimate = new ArLightEstimate_();
+}
+
+void ArLightEstimate_destroy(ArLightEstimate* light_estimate) {
+  delete light_estimate;
+}
+
+void ArFrame_getLightEstimate(const ArSession*, const ArFrame* frame,
+                              ArLightEstimate* out_light_estimate) {
+  *out_light_estimate = frame->light_estimate;
+}
+
+void ArLightEstimate_getState(const ArSession*,
+                              const ArLightEstimate* light_estimate,
+                              ArLightEstimateState* out_light_estimate_state) {
+  *out_light_estimate_state = light_estimate->state;
+}
+
+void ArLightEstimate_getColorCorrection(const ArSession*,
+                                        const ArLightEstimate* light_estimate,
+                                        float* out_color_correction_4) {
+  memcpy(out_color_correction_4, light_estimate->color_correction,
+         4 * sizeof(float));
+}
+
+void ArLightEstimate_getTimestamp(const ArSession*,
+                                  const ArLightEstimate* light_estimate,
+                                  int64_t* out_timestamp_ns) {
+  *out_timestamp_ns = light_estimate->timestamp_ns;
+}
+
+// Environmental HDR can't be configured in replay, so these report what
+// ARCore reports outside that mode.
+
+void ArLightEstimate_getEnvironmentalHdrMainLightDirection(
+    const ArSession*, const ArLightEstimate*, float* out_direction_3) {
+  memset(out_direction_3, 0, 3 * sizeof(float));
+}
+
+void ArLightEstimate_getEnvironmentalHdrMainLightIntensity(
+    const ArSession*, const ArLightEstimate*, float* out_intensity_3) {
+  memset(out_intensity_3, 0, 3 * sizeof(float));
+}
+
+void ArLightEstimate_getEnvironmentalHdrAmbientSphericalHarmonics(
+    const ArSession*, const ArLightEstimate*, float* out_coefficients_27) {
+  memset(out_coefficients_27, 0, 27 * sizeof(float));
+}
+
+void ArLightEstimate_acquireEnvironmentalHdrCubemap(
+    const ArSession*, const ArLightEstimate*, ArImageCubemap out_textures_6) {
+  for (int32_t face = 0; face < 6; ++face) {
+    out_textures_6[face] = nullptr;
+  }
+}
+
+// Point cloud.
+
+ArStatus ArFrame_acquirePointCloud(const ArSession*, const ArFrame* frame,
+                                   ArPointCloud** out_point_cloud) {
+  *out_point_cloud = const_cast<ArPointCloud_*>(&frame->point_cloud);
+  return AR_SUCCESS;
+}
+
+void ArPointCloud_release(ArPointCloud*) {}
+
+void ArPointCloud_getNumberOfPoints(const ArSession*,
+                                    const ArPointCloud* point_cloud,
+                                    int32_t* out_number_of_points) {
+  *out_number_of_points = static_cast<int32_t>(point_cloud->data.size() / 4);
+}
+
+void ArPointCloud_getData(const ArSession*, const ArPointCloud* point_cloud,
+                          const float** out_point_cloud_data) {
+  *out_point_cloud_data = point_cloud->data.data();
+}
+
+// Depth image.
+
+ArStatus ArFrame_acquireDepthImage(const ArSession* session,
+                                   const ArFrame* frame,
+                                   ArImage** out_depth_image) {
+  *out_depth_image = nullptr;
+  if (session->config.depth_mode == AR_DEPTH_MODE_DISABLED) {
+    return AR_ERROR_ILLEGAL_STATE;
+  }
+  if (frame->depth_image.data.empty()) {
+    return AR_ERROR_NOT_YET_AVAILABLE;
+  }
+  *out_depth_image = const_cast<ArImage_*>(&frame->depth_image);
+  return AR_SUCCESS;
+}
+
+void ArImage_release(ArImage*) {}
+
+void ArImage_getFormat(const ArSession*, const ArImage*,
+                       ArImageFormat* out_format) {
+  *out_format = AR_IMAGE_FORMAT_DEPTH16;
+}
+
+void ArImage_getWidth(const ArSession*, const ArImage* image,
+                      int32_t* out_width) {
+  *out_width = image->width;
+}
+
+void ArImage_getHeight(const ArSession*, const ArImage* image,
+                       int32_t* out_height) {
+  *out_height = image->height;
+}
+
+void ArImage_getPlaneData(const ArSession*, const ArImage* image, int32_t,
+                          const uint8_t** out_data, int32_t* out_data_length) {
+  *out_data = reinterpret_cast<const uint8_t*>(image->data.data());
+  *out_data_length =
+      static_cast<int32_t>(image->data.size() * sizeof(uint16_t));
+}
+
+void ArImage_getPlanePixelStride(const ArSession*, const ArImage*, int32_t,
+                                 int32_t* out_pixel_stride) {
+  *out_pixel_stride = sizeof(uint16_t);
+}
+
+void ArImage_getPlaneRowStride(const ArSession*, const ArImage* image, int32_t,
+                               int32_t* out_row_stride) {
+  *out_row_stride = image->width * sizeof(uint16_t);
+}
+
+// Trackables.
+
+void ArTrackableList_create(const ArSession*,
+                            ArTrackableList** out_trackable_list) {
+  *out_trackable_list = new ArTrackableList_();
+}
+
+void ArTrackableList_destroy(ArTrackableList* trackable_list) {
+  delete trackable_list;
+}
+
+void ArTrackableList_getSize(const ArSession*,
+                             const ArTrackableList* trackable_list,
+                             int32_t* out_size) {
+  *out_size = static_cast<int32_t>(trackable_list->items.size());
+}
+
+void ArTrackableList_acquireItem(const ArSession*,
+                                 const ArTrackableList* trackable_list,
+                                 int32_t index, ArTrackable** out_trackable) {
+  *out_trackable = trackable_list->items[index];
+}
+
+void ArTrackable_release(ArTrackable*) {}
+
+void ArTrackable_getType(const ArSession*, const ArTrackable* trackable,
+                         ArTrackableType* out_trackable_type) {
+  *out_trackable_type = trackable->type;
+}
+
+void ArTrackable_getTrackingState(const ArSession*,
+                                  const ArTrackable* trackable,
+                                  ArTrackingState* out_tracking_state) {
+  *out_tracking_state = trackable->tracking_state;
+}
+
+ArStatus ArTrackable_acquireNewAnchor(ArSession*, ArTrackable*, ArPose* pose,
+                                      ArAnchor** out_anchor) {
+  *out_anchor = new ArAnchor_();
+  CopyPose(pose->raw, (*out_anchor)->pose);
+  return AR_SUCCESS;
+}
+
+void ArPlane_acquireSubsumedBy(const ArSession* session, const ArPlane* plane,
+                               ArPlane** out_subsumed_by) {
+  *out_subsumed_by = nullptr;
+  const auto it = session->planes.find(AsReplayTrackable(plane)->plane.subsumed_by_id);
+  if (it != session->planes.end()) {
+    *out_subsumed_by = reinterpret_cast<ArPlane*>(it->second.get());
+  }
+}
+
+void ArPlane_getCenterPose(const ArSession*, const ArPlane* plane,
+                           ArPose* out_pose) {
+  CopyPose(AsReplayTrackable(plane)->plane.center_pose, out_pose->raw);
+}
+
+void ArPlane_getPolygonSize(const ArSession*, const ArPlane* plane,
+                            int32_t* out_polygon_size) {
+  *out_polygon_size =
+      static_cast<int32_t>(AsReplayTrackable(plane)->plane.polygon.size());
+}
+
+void ArPlane_getPolygon(const ArSession*, const ArPlane* plane,
+                        float* out_polygon_xz) {
+  const std::vector<float>& polygon = AsReplayTrackable(plane)->plane.polygon;
+  std::copy(polygon.begin(), polygon.end(), out_polygon_xz);
+}
+
+void ArPlane_isPoseInPolygon(const ArSession*, const ArPlane* plane,
+                             const ArPose* pose,
+                             int32_t* out_pose_in_polygon) {
+  const LoggedPlane& logged = AsReplayTrackable(plane)->plane;
+  const glm::vec4 local = glm::inverse(PoseToMatrix(logged.center_pose)) *
+                          glm::vec4(pose->raw[4], pose->raw[5], pose->raw[6], 1.f);
+  *out_pose_in_polygon = IsPointInPolygon(logged.polygon, local.x, local.z);
+}
+
+void ArPoint_getOrientationMode(const ArSession*, const ArPoint*,
+                                ArPointOrientationMode* out_orientation_mode) {
+  *out_orientation_mode = AR_POINT_ORIENTATION_INITIALIZED_TO_IDENTITY;
+}
+
+void ArInstantPlacementPoint_getTrackingMethod(
+    const ArSession*, const ArInstantPlacementPoint*,
+    ArInstantPlacementPointTrackingMethod* out_tracking_method) {
+  *out_tracking_method =
+      AR_INSTANT_PLACEMENT_POINT_TRACKING_METHOD_SCREENSPACE_WITH_APPROXIMATE_DISTANCE;  // NOLINT
+}
+
+// Anchors.
+
+void ArAnchor_release(ArAnchor* anchor) { delete anchor; }
+
+// Replayed anchors are not tracked by the session, so there is nothing to
+// stop.
+void ArAnchor_detach(ArSession*, ArAnchor*) {}
+
+void ArAnchor_getPose(const ArSession*, const ArAnchor* anchor,
+                      ArPose* out_pose) {
+  CopyPose(anchor->pose, out_pose->raw);
+}
+
+void ArAnchor_getTrackingState(const ArSession*, const ArAnchor*,
+                               ArTrackingState* out_tracking_state) {
+  *out_tracking_state = AR_TRACKING_STATE_TRACKING;
+}
+
+// Hit tests.
+
+void ArHitResultList_create(const ArSession*,
+                            ArHitResultList** out_hit_result_list) {
+  *out_hit_result_list = new ArHitResultList_();
+}
+
+void ArHitResultList_destroy(ArHitResultList* hit_result_list) {
+  delete hit_result_list;
+}
+
+void ArHitResultList_getSize(const ArSession*,
+                             const ArHitResultList* hit_result_list,
+                             int32_t* out_size) {
+  *out_size = static_cast<int32_t>(hit_result_list->items.size());
+}
+
+void ArHitResultList_getItem(const ArSession*,
+                             const ArHitResultList* hit_result_list,
+                             int32_t index, ArHitResult* out_hit_result) {
+  *out_hit_result = hit_result_list->items[index];
+}
+
+void ArHitResult_create(const ArSession*, ArHitResult** out_hit_result) {
+  *out_hit_result = new ArHitResult_();
+}
+
+void ArHitResult_destroy(ArHitResult* hit_result) { delete hit_result; }
+
+void ArHitResult_getHitPose(const ArSession*, const ArHitResult* hit_result,
+                            ArPose* out_pose) {
+  CopyPose(hit_result->pose, out_pose->raw);
+}
+
+void ArHitResult_getDistance(const ArSession*, const ArHitResult* hit_result,
+                             float* out_distance) {
+  *out_distance = hit_result->distance;
+}
+
+void ArHitResult_acquireTrackable(const ArSession*,
+                                  const ArHitResult* hit_result,
+                                  ArTrackable** out_trackable) {
+  *out_trackable = hit_result->trackable;
+}
+
+ArStatus ArHitResult_acquireNewAnchor(ArSession*, ArHitResult* hit_result,
+                                      ArAnchor** out_anchor) {
+  *out_anchor = new ArAnchor_();
+  CopyPose(hit_result->pose, (*out_anchor)->pose);
+  return AR_SUCCESS;
+}
+
+void ArFrame_hitTest(const ArSession* session, const ArFrame* frame,
+                     float pixel_x, float pixel_y,
+                     ArHitResultList* hit_result_list) {
+  glm::vec3 origin, direction;
+  GetPixelRay(session, frame, pixel_x, pixel_y, &origin, &direction);
+  HitTestPlanes(session, origin, direction, hit_result_list);
+}
+
+void ArFrame_hitTestRay(const ArSession* session, const ArFrame*,
+                        const float* ray_origin_3, const float* ray_direction_3,
+                        ArHitResultList* hit_result_list) {
+  HitTestPlanes(session, glm::make_vec3(ray_origin_3),
+                glm::normalize(glm::make_vec3(ray_direction_3)),
+                hit_result_list);
+}
+
+void ArFrame_hitTestInstantPlacement(const ArSession* session,
+                                     const ArFrame* frame, float pixel_x,
+                                     float pixel_y,
+                                     float approximate_distance_meters,
+                                     ArHitResultList* hit_result_list) {
+  hit_result_list->items.clear();
+  glm::vec3 origin, direction;
+  GetPixelRay(session, frame, pixel_x, pixel_y, &origin, &direction);
+  const glm::vec3 hit = origin + approximate_distance_meters * direction;
+
+  std::unique_ptr<ArTrackable_> point(new ArTrackable_());
+  point->type = AR_TRACKABLE_INSTANT_PLACEMENT_POINT;
+  point->pose[4] = hit.x;
+  point->pose[5] = hit.y;
+  point->pose[6] = hit.z;
+
+  ArHitResult_ result;
+  CopyPose(point->pose, result.pose);
+  result.distance = approximate_distance_meters;
+  result.trackable = point.get();
+  hit_result_list->items.push_back(result);
+  session->instant_placement_points.push_back(std::move(point));
+}
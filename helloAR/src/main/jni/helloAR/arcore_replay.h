@@ -0,0 +1,52 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_ARCORE_REPLAY_H_
+#define C_ARCORE_ARCORE_REPLAY_H_
+
+#include <vector>
+
+#include "arcore_c_api.h"
+#include "frame_log.h"
+
+// arcore_replay.cc implements the subset of arcore_c_api.h used by
+// HelloArApplication on top of a log written by FrameRecorder. Linking it in
+// place of libarcore_sdk_c.so makes every session deterministic and lets it
+// run as fast as the host can render.
+//
+// ArSession_create opens the log named by the HELLOAR_REPLAY_LOG environment
+// variable, and every ArSession_update advances to the next logged frame.
+// Hit tests are recomputed against the logged planes, so touches replayed
+// through HelloArApplication's tap handling create the same anchors as the
+// recorded session.
+namespace hello_ar {
+namespace replay {
+
+// Environment variable holding the path of the log to replay.
+constexpr char kReplayLogEnvironmentVariable[] = "HELLOAR_REPLAY_LOG";
+
+// Returns the taps recorded with the frame produced by the last
+// ArSession_update. The driver should hit test them in order against that
+// frame.
+const std::vector<LoggedTouch>& GetFrameTouches(const ArSession* session);
+
+// Returns true once ArSession_update has consumed the whole log.
+bool IsFinished(const ArSession* session);
+
+}  // namespace replay
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_ARCORE_REPLAY_H_
@@ -27,22 +27,21 @@ namespace hello_ar {
         left_ear.SetMaterialProperty(0.0f, 1.0f, 0.1f, 6.0f);
     }
 
-    void AugmentedFaceRenderer::Draw(const glm::mat4& projection_mat,
-                                     const glm::mat4& view_mat,
+    void AugmentedFaceRenderer::Draw(const FrameTransforms& transforms,
                                      const glm::mat4& model_mat,
-                                     const float* color_correction4,
+                                     const LightEnvironment& light_environment,
                                      const float* color_tint_rgba,
                                      const ArSession* ar_session,
                                      const ArAugmentedFace_* ar_face) const {
-        face.Draw(projection_mat, view_mat, model_mat, color_correction4, color_tint_rgba, ar_session, ar_face);
+        face.Draw(transforms.projection_mat, transforms.view_mat, model_mat, light_environment.color_correction, color_tint_rgba, ar_session, ar_face);
 
         glm::mat4 nose_mat = util::GetRegionPoseFromFace(ar_session, ar_face, AR_AUGMENTED_FACE_REGION_NOSE_TIP);
-        nose.Draw(projection_mat, view_mat, model_mat*nose_mat, color_correction4, color_tint_rgba);
+        nose.Draw(transforms, model_mat*nose_mat, light_environment, color_tint_rgba);
 
         glm::mat4 left_ear_mat = util::GetRegionPoseFromFace(ar_session, ar_face, AR_AUGMENTED_FACE_REGION_FOREHEAD_LEFT);
-        left_ear.Draw(projection_mat, view_mat, model_mat*left_ear_mat, color_correction4, color_tint_rgba);
+        left_ear.Draw(transforms, model_mat*left_ear_mat, light_environment, color_tint_rgba);
 
         glm::mat4 right_ear_mat = util::GetRegionPoseFromFace(ar_session, ar_face, AR_AUGMENTED_FACE_REGION_FOREHEAD_RIGHT);
-        right_ear.Draw(projection_mat, view_mat, model_mat*right_ear_mat, color_correction4, color_tint_rgba);
+        right_ear.Draw(transforms, model_mat*right_ear_mat, light_environment, color_tint_rgba);
     }
 }  // namespace augmented_image
\ No newline at end of file
@@ -23,11 +23,11 @@ namespace hello_ar {
         // other methods below.
         void InitializeGlContent(AAssetManager* asset_manager);
 
-        // Draws frames
-        void Draw(const glm::mat4& projection_mat,
-                  const glm::mat4& view_mat,
+        // Draws frames. Faces use the front camera, which has no environmental
+        // HDR estimate, so only the color correction is used.
+        void Draw(const FrameTransforms& transforms,
                   const glm::mat4& model_mat,
-                  const float* color_correction4,
+                  const LightEnvironment& light_environment,
                   const float* color_tint_rgba,
                   const ArSession* ar_session,
                   const ArAugmentedFace_* ar_face) const;
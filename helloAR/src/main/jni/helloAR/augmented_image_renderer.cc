@@ -30,9 +30,20 @@ void AugmentedImageRenderer::InitializeGlContent(AAssetManager* asset_manager) {
       asset_manager, "models/frame_lower_right.obj", "models/frame_base.png");
 }
 
-void AugmentedImageRenderer::Draw(const glm::mat4& projection_mat,
-                                  const glm::mat4& view_mat,
-                                  const float* color_correction4,
+void AugmentedImageRenderer::SetUseEnvironmentalHdr(
+    AAssetManager* asset_manager, bool use_environmental_hdr) {
+  image_frame_upper_left.SetUseEnvironmentalHdr(asset_manager,
+                                                use_environmental_hdr);
+  image_frame_upper_right.SetUseEnvironmentalHdr(asset_manager,
+                                                 use_environmental_hdr);
+  image_frame_lower_left.SetUseEnvironmentalHdr(asset_manager,
+                                                use_environmental_hdr);
+  image_frame_lower_right.SetUseEnvironmentalHdr(asset_manager,
+                                                 use_environmental_hdr);
+}
+
+void AugmentedImageRenderer::Draw(const FrameTransforms& transforms,
+                                  const LightEnvironment& light_environment,
                                   const float* color_tint_rgba,
                                   const ArSession* ar_session,
                                   const ArAugmentedImage* ar_image,
@@ -54,18 +65,18 @@ void AugmentedImageRenderer::Draw(const glm::mat4& projection_mat,
   glm::mat4 center_matrix;
   util::GetTransformMatrixFromAnchor(*ar_anchor, ar_session, &center_matrix);
 
-  image_frame_upper_left.Draw(projection_mat, view_mat,
+  image_frame_upper_left.Draw(transforms,
                               center_matrix * local_upper_left_matrix,
-                              color_correction4, color_tint_rgba);
-  image_frame_upper_right.Draw(projection_mat, view_mat,
+                              light_environment, color_tint_rgba);
+  image_frame_upper_right.Draw(transforms,
                                center_matrix * local_upper_right_matrix,
-                               color_correction4, color_tint_rgba);
-  image_frame_lower_left.Draw(projection_mat, view_mat,
+                               light_environment, color_tint_rgba);
+  image_frame_lower_left.Draw(transforms,
                               center_matrix * local_lower_left_matrix,
-                              color_correction4, color_tint_rgba);
-  image_frame_lower_right.Draw(projection_mat, view_mat,
+                              light_environment, color_tint_rgba);
+  image_frame_lower_right.Draw(transforms,
                                center_matrix * local_lower_right_matrix,
-                               color_correction4, color_tint_rgba);
+                               light_environment, color_tint_rgba);
 }
 
 }  // namespace augmented_image
@@ -35,9 +35,14 @@ class AugmentedImageRenderer {
   // other methods below.
   void InitializeGlContent(AAssetManager* asset_manager);
 
+  // See ObjRenderer::SetUseEnvironmentalHdr.
+  void SetUseEnvironmentalHdr(AAssetManager* asset_manager,
+                              bool use_environmental_hdr);
+
   // Draws frames on ArAugmentedImage, with center location at ArAnchor.
-  void Draw(const glm::mat4& projection_mat, const glm::mat4& view_mat,
-            const float* color_correction4, const float* color_tint_rgba,
+  void Draw(const FrameTransforms& transforms,
+            const LightEnvironment& light_environment,
+            const float* color_tint_rgba,
             const ArSession* ar_session, const ArAugmentedImage* ar_image,
             const ArAnchor* ar_anchor) const;
 
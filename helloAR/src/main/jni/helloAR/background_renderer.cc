@@ -21,6 +21,8 @@
 
 #include <type_traits>
 
+#include "gl_wrapper.h"
+
 namespace hello_ar {
 namespace {
 // Positions of the quad vertices in clip space (X, Y).
@@ -41,7 +43,7 @@ constexpr char kDepthVisualizerFragmentShaderFilename[] =
 void BackgroundRenderer::InitializeGlContent(AAssetManager* asset_manager,
                                              int depth_texture_id) {
   glGenTextures(1, &camera_texture_id_);
-  glBindTexture(GL_TEXTURE_EXTERNAL_OES, camera_texture_id_);
+  gl::BindTexture(GL_TEXTURE_EXTERNAL_OES, camera_texture_id_);
   glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
   glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
@@ -101,12 +103,12 @@ void BackgroundRenderer::Draw(const ArSession* session, const ArFrame* frame,
     return;
   }
 
-  glDepthMask(GL_FALSE);
+  gl::DepthMask(GL_FALSE);
 
   if (debug_show_depth_map) {
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, depth_texture_id_);
-    glUseProgram(depth_program_);
+    gl::ActiveTexture(GL_TEXTURE1);
+    gl::BindTexture(GL_TEXTURE_2D, depth_texture_id_);
+    gl::UseProgram(depth_program_);
     glUniform1i(depth_texture_uniform_, 0);
     glUniform1i(camera_texture_uniform_, 1);
 
@@ -118,8 +120,8 @@ void BackgroundRenderer::Draw(const ArSession* session, const ArFrame* frame,
     glEnableVertexAttribArray(depth_position_attrib_);
     glEnableVertexAttribArray(depth_tex_coord_attrib_);
   } else {
-    glBindTexture(GL_TEXTURE_EXTERNAL_OES, camera_texture_id_);
-    glUseProgram(camera_program_);
+    gl::BindTexture(GL_TEXTURE_EXTERNAL_OES, camera_texture_id_);
+    gl::UseProgram(camera_program_);
     glUniform1i(camera_texture_uniform_, 0);
 
     // Set the vertex positions and texture coordinates.
@@ -131,7 +133,7 @@ void BackgroundRenderer::Draw(const ArSession* session, const ArFrame* frame,
     glEnableVertexAttribArray(camera_tex_coord_attrib_);
   }
 
-  glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+  gl::DrawArrays(GL_TRIANGLE_STRIP, 0, 4);
 
   // Disable vertex arrays
   if (debug_show_depth_map) {
@@ -142,8 +144,8 @@ void BackgroundRenderer::Draw(const ArSession* session, const ArFrame* frame,
     glDisableVertexAttribArray(camera_tex_coord_attrib_);
   }
 
-  glUseProgram(0);
-  glDepthMask(GL_TRUE);
+  gl::UseProgram(0);
+  gl::DepthMask(GL_TRUE);
   util::CheckGlError("BackgroundRenderer::Draw() error");
 }
 
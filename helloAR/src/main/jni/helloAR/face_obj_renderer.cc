@@ -3,6 +3,7 @@
 //
 
 #include "face_obj_renderer.h"
+#include "gl_wrapper.h"
 #include "util.h"
 
 namespace hello_ar {
@@ -21,7 +22,7 @@ namespace hello_ar {
 
         // loadTexture
         glGenTextures(1, &texture_id_);
-        glBindTexture(GL_TEXTURE_2D, texture_id_);
+        gl::BindTexture(GL_TEXTURE_2D, texture_id_);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
@@ -32,7 +33,7 @@ namespace hello_ar {
             LOGE("Could not load png texture for planes.");
         }
         glGenerateMipmap(GL_TEXTURE_2D);
-        glBindTexture(GL_TEXTURE_2D, 0);
+        gl::BindTexture(GL_TEXTURE_2D, 0);
 
         util::CheckGlError("obj_renderer::InitializeGlContent()");
     }
@@ -105,11 +106,11 @@ namespace hello_ar {
             return;
         }
 
-        glUseProgram(shader_program_);
+        gl::UseProgram(shader_program_);
 
-        glActiveTexture(GL_TEXTURE0);
+        gl::ActiveTexture(GL_TEXTURE0);
         glUniform1i(texture_uniform_, 0);
-        glBindTexture(GL_TEXTURE_2D, texture_id_);
+        gl::BindTexture(GL_TEXTURE_2D, texture_id_);
 
         glm::mat4 mvp_mat = projection_mat * view_mat * model_mat;
         glm::mat4 mv_mat = view_mat * model_mat;
@@ -139,22 +140,22 @@ namespace hello_ar {
         glVertexAttribPointer(tex_coord_attrib_, 2, GL_FLOAT, GL_FALSE, 0,
                               uvs);
 
-        glDepthMask(GL_TRUE);
-        glEnable(GL_BLEND);
+        gl::DepthMask(GL_TRUE);
+        gl::Enable(GL_BLEND);
 
         // Textures are loaded with premultiplied alpha
         // (https://developer.android.com/reference/android/graphics/BitmapFactory.Options#inPremultiplied),
         // so we use the premultiplied alpha blend factors.
-        glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+        gl::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
-        glDrawElements(GL_TRIANGLES, number_of_indices, GL_UNSIGNED_SHORT, indices);
+        gl::DrawElements(GL_TRIANGLES, number_of_indices, GL_UNSIGNED_SHORT, indices);
 
-        glDisable(GL_BLEND);
+        gl::Disable(GL_BLEND);
         glDisableVertexAttribArray(position_attrib_);
         glDisableVertexAttribArray(tex_coord_attrib_);
         glDisableVertexAttribArray(normal_attrib_);
 
-        glUseProgram(0);
+        gl::UseProgram(0);
         util::CheckGlError("obj_renderer::Draw()");
     }
 }  // namespace hello_ar
@@ -0,0 +1,379 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frame_log.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace hello_ar {
+namespace {
+constexpr char kMagic[4] = {'H', 'A', 'F', 'L'};
+constexpr uint8_t kVersion = 1;
+
+// Quantization steps.
+constexpr float kRotationStep = 1.0f / 16384.0f;
+constexpr float kPositionStep = 1e-4f;
+constexpr float kMatrixStep = 1e-5f;
+constexpr float kColorStep = 1.0f / 4096.0f;
+constexpr float kPointStep = 1e-3f;
+constexpr float kConfidenceStep = 1.0f / 256.0f;
+constexpr float kPolygonStep = 1e-3f;
+constexpr float kTouchStep = 1.0f / 16.0f;
+
+// Upper bound on a single encoded frame, to reject corrupt logs early.
+constexpr uint64_t kMaxFrameBytes = 64u << 20;
+
+int64_t Quantize(float value, float step) {
+  return static_cast<int64_t>(std::llround(value / step));
+}
+
+uint64_t ZigZag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void PutVarint(uint64_t value, std::vector<uint8_t>* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+// Serializes a frame into a byte buffer. The frame is updated in place to the
+// quantized values, which is what the reader will reconstruct.
+class FrameEncoder {
+ public:
+  explicit FrameEncoder(std::vector<uint8_t>* out) : out_(out) {}
+
+  bool Signed(int64_t* value, int64_t previous) {
+    PutVarint(ZigZag(*value - previous), out_);
+    return true;
+  }
+
+  bool Float(float* value, float previous, float step) {
+    const int64_t quantized = Quantize(*value, step);
+    PutVarint(ZigZag(quantized - Quantize(previous, step)), out_);
+    *value = static_cast<float>(quantized) * step;
+    return true;
+  }
+
+  bool Depth(uint16_t* value, uint16_t previous) {
+    PutVarint(ZigZag(static_cast<int64_t>(*value) - previous), out_);
+    return true;
+  }
+
+  template <typename T>
+  bool Length(std::vector<T>* values, size_t group) {
+    PutVarint(values->size() / group, out_);
+    values->resize(values->size() / group * group);
+    return true;
+  }
+
+ private:
+  std::vector<uint8_t>* out_;
+};
+
+// Parses a frame serialized by FrameEncoder.
+class FrameDecoder {
+ public:
+  FrameDecoder(const uint8_t* data, size_t size)
+      : data_(data), end_(data + size) {}
+
+  bool Signed(int64_t* value, int64_t previous) {
+    uint64_t raw;
+    if (!GetVarint(&raw)) return false;
+    *value = previous + UnZigZag(raw);
+    return true;
+  }
+
+  bool Float(float* value, float previous, float step) {
+    uint64_t raw;
+    if (!GetVarint(&raw)) return false;
+    *value = static_cast<float>(Quantize(previous, step) + UnZigZag(raw)) * step;
+    return true;
+  }
+
+  bool Depth(uint16_t* value, uint16_t previous) {
+    uint64_t raw;
+    if (!GetVarint(&raw)) return false;
+    *value = static_cast<uint16_t>(previous + UnZigZag(raw));
+    return true;
+  }
+
+  template <typename T>
+  bool Length(std::vector<T>* values, size_t group) {
+    uint64_t count;
+    if (!GetVarint(&count)) return false;
+    // Every element takes at least one byte.
+    if (count * group > static_cast<uint64_t>(end_ - data_)) return false;
+    values->resize(count * group);
+    return true;
+  }
+
+ private:
+  bool GetVarint(uint64_t* out_value) {
+    uint64_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+      if (data_ == end_) return false;
+      const uint8_t byte = *data_++;
+      value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+      if ((byte & 0x80) == 0) {
+        *out_value = value;
+        return true;
+      }
+    }
+    return false;
+  }
+
+  const uint8_t* data_;
+  const uint8_t* end_;
+};
+
+template <typename Coder>
+bool CodeInt(Coder* coder, int32_t* value, int32_t previous) {
+  int64_t wide = *value;
+  if (!coder->Signed(&wide, previous)) return false;
+  *value = static_cast<int32_t>(wide);
+  return true;
+}
+
+template <typename Coder>
+bool CodePose(Coder* coder, float* pose, const float* previous) {
+  for (int i = 0; i < 7; ++i) {
+    const float step = i < 4 ? kRotationStep : kPositionStep;
+    if (!coder->Float(&pose[i], previous[i], step)) return false;
+  }
+  return true;
+}
+
+template <typename Coder>
+bool CodePlane(Coder* coder, LoggedPlane* plane,
+               const LoggedPlane* previous_plane) {
+  const LoggedPlane identity;
+  const LoggedPlane& reference =
+      previous_plane != nullptr ? *previous_plane : identity;
+  if (!CodeInt(coder, &plane->tracking_state, reference.tracking_state) ||
+      !CodeInt(coder, &plane->subsumed_by_id, reference.subsumed_by_id) ||
+      !CodePose(coder, plane->center_pose, reference.center_pose) ||
+      !coder->Length(&plane->polygon, 2)) {
+    return false;
+  }
+  // Polygons that kept their vertex count are coded against the previous
+  // frame, others against the previous vertex.
+  const bool same_shape = reference.polygon.size() == plane->polygon.size();
+  for (size_t i = 0; i < plane->polygon.size(); ++i) {
+    const float previous =
+        same_shape ? reference.polygon[i] : (i < 2 ? 0.f : plane->polygon[i - 2]);
+    if (!coder->Float(&plane->polygon[i], previous, kPolygonStep)) return false;
+  }
+  return true;
+}
+
+// Serializes or parses one frame, depending on Coder. Both directions share
+// this function so the field order cannot diverge.
+template <typename Coder>
+bool CodeFrame(Coder* coder, LoggedFrame* frame, const LoggedFrame& previous) {
+  if (!coder->Signed(&frame->timestamp_ns, previous.timestamp_ns) ||
+      !CodeInt(coder, &frame->camera_tracking_state,
+               previous.camera_tracking_state) ||
+      !CodePose(coder, frame->camera_pose, previous.camera_pose)) {
+    return false;
+  }
+  for (int i = 0; i < 16; ++i) {
+    if (!coder->Float(&frame->projection_mat[i], previous.projection_mat[i],
+                      kMatrixStep)) {
+      return false;
+    }
+  }
+  for (int i = 0; i < 6; ++i) {
+    if (!coder->Float(&frame->ndc_basis_uvs[i], previous.ndc_basis_uvs[i],
+                      kMatrixStep)) {
+      return false;
+    }
+  }
+  if (!CodeInt(coder, &frame->light_estimate_state,
+               previous.light_estimate_state)) {
+    return false;
+  }
+  for (int i = 0; i < 4; ++i) {
+    if (!coder->Float(&frame->color_correction[i],
+                      previous.color_correction[i], kColorStep)) {
+      return false;
+    }
+  }
+
+  // Point cloud, each point coded against the previous one.
+  if (!coder->Length(&frame->point_cloud, 4)) return false;
+  for (size_t i = 0; i < frame->point_cloud.size(); ++i) {
+    const float reference = i < 4 ? 0.f : frame->point_cloud[i - 4];
+    const float step = i % 4 == 3 ? kConfidenceStep : kPointStep;
+    if (!coder->Float(&frame->point_cloud[i], reference, step)) return false;
+  }
+
+  // Planes, coded against the plane with the same id in the previous frame.
+  if (!coder->Length(&frame->planes, 1)) return false;
+  size_t previous_index = 0;
+  int32_t previous_id = 0;
+  for (LoggedPlane& plane : frame->planes) {
+    if (!CodeInt(coder, &plane.id, previous_id)) return false;
+    previous_id = plane.id;
+    while (previous_index < previous.planes.size() &&
+           previous.planes[previous_index].id < plane.id) {
+      ++previous_index;
+    }
+    const LoggedPlane* previous_plane =
+        previous_index < previous.planes.size() &&
+                previous.planes[previous_index].id == plane.id
+            ? &previous.planes[previous_index]
+            : nullptr;
+    if (!CodePlane(coder, &plane, previous_plane)) return false;
+  }
+
+  // Depth image, each sample coded against its left neighbour, or the sample
+  // above it for the first column.
+  if (!CodeInt(coder, &frame->depth_width, previous.depth_width) ||
+      !CodeInt(coder, &frame->depth_height, previous.depth_height) ||
+      frame->depth_width < 0 || frame->depth_height < 0 ||
+      !coder->Length(&frame->depth, 1) ||
+      frame->depth.size() != static_cast<size_t>(frame->depth_width) *
+                                 static_cast<size_t>(frame->depth_height)) {
+    return false;
+  }
+  const size_t width = frame->depth_width;
+  for (size_t i = 0; i < frame->depth.size(); ++i) {
+    const uint16_t reference =
+        i % width != 0 ? frame->depth[i - 1]
+                       : (i >= width ? frame->depth[i - width] : 0);
+    if (!coder->Depth(&frame->depth[i], reference)) return false;
+  }
+
+  if (!coder->Length(&frame->touches, 1)) return false;
+  for (LoggedTouch& touch : frame->touches) {
+    if (!coder->Float(&touch.x, 0.f, kTouchStep) ||
+        !coder->Float(&touch.y, 0.f, kTouchStep)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+bool FrameLogWriter::Open(const char* path) {
+  Close();
+  file_ = fopen(path, "wb");
+  if (file_ == nullptr) {
+    return false;
+  }
+  previous_ = LoggedFrame();
+  if (fwrite(kMagic, 1, sizeof(kMagic), file_) != sizeof(kMagic) ||
+      fputc(kVersion, file_) == EOF) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void FrameLogWriter::Close() {
+  if (file_ != nullptr) {
+    fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+bool FrameLogWriter::Write(const LoggedFrame& frame) {
+  if (file_ == nullptr) {
+    return false;
+  }
+  LoggedFrame quantized = frame;
+  buffer_.clear();
+  FrameEncoder encoder(&buffer_);
+  if (!CodeFrame(&encoder, &quantized, previous_)) {
+    return false;
+  }
+  std::vector<uint8_t> size_prefix;
+  PutVarint(buffer_.size(), &size_prefix);
+  if (fwrite(size_prefix.data(), 1, size_prefix.size(), file_) !=
+          size_prefix.size() ||
+      fwrite(buffer_.data(), 1, buffer_.size(), file_) != buffer_.size()) {
+    return false;
+  }
+  previous_ = std::move(quantized);
+  return true;
+}
+
+bool FrameLogReader::Open(const char* path) {
+  Close();
+  file_ = fopen(path, "rb");
+  if (file_ == nullptr) {
+    return false;
+  }
+  previous_ = LoggedFrame();
+  char magic[sizeof(kMagic)];
+  if (fread(magic, 1, sizeof(magic), file_) != sizeof(magic) ||
+      memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+      fgetc(file_) != kVersion) {
+    Close();
+    return false;
+  }
+  return true;
+}
+
+void FrameLogReader::Close() {
+  if (file_ != nullptr) {
+    fclose(file_);
+    file_ = nullptr;
+  }
+}
+
+bool FrameLogReader::Read(LoggedFrame* out_frame) {
+  if (file_ == nullptr) {
+    return false;
+  }
+  uint64_t size = 0;
+  for (int shift = 0;; shift += 7) {
+    const int byte = fgetc(file_);
+    if (byte == EOF || shift >= 64) {
+      return false;
+    }
+    size |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+  if (size > kMaxFrameBytes) {
+    return false;
+  }
+  buffer_.resize(size);
+  if (fread(buffer_.data(), 1, size, file_) != size) {
+    return false;
+  }
+  LoggedFrame frame;
+  FrameDecoder decoder(buffer_.data(), buffer_.size());
+  if (!CodeFrame(&decoder, &frame, previous_)) {
+    return false;
+  }
+  previous_ = frame;
+  *out_frame = std::move(frame);
+  return true;
+}
+
+}  // namespace hello_ar
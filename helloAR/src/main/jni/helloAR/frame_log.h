@@ -0,0 +1,132 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_FRAME_LOG_H_
+#define C_ARCORE_FRAME_LOG_H_
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+namespace hello_ar {
+
+// The projection matrix is logged for these clip planes. Replay rebuilds the
+// depth terms of the matrix for whatever planes the caller asks for.
+constexpr float kLoggedProjectionNear = 0.1f;
+constexpr float kLoggedProjectionFar = 100.f;
+
+// A plane as seen in one frame. Planes are identified across frames by id.
+struct LoggedPlane {
+  int32_t id = 0;
+  // ArTrackingState of the plane.
+  int32_t tracking_state = 0;
+  // Id of the plane that subsumed this one, or -1.
+  int32_t subsumed_by_id = -1;
+  // Raw ArPose of the plane center: qx, qy, qz, qw, tx, ty, tz.
+  float center_pose[7] = {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f};
+  // Boundary polygon as x, z pairs in the plane's local frame.
+  std::vector<float> polygon;
+};
+
+struct LoggedTouch {
+  float x = 0.f;
+  float y = 0.f;
+};
+
+// Everything HelloArApplication reads from ARCore for a single frame.
+struct LoggedFrame {
+  int64_t timestamp_ns = 0;
+  int32_t camera_tracking_state = 0;
+  // Raw ArPose of the camera: qx, qy, qz, qw, tx, ty, tz.
+  float camera_pose[7] = {0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f};
+  // Column-major projection matrix for the logged near and far planes.
+  float projection_mat[16] = {0.f};
+  // Texture coordinates of the NDC origin, +X and +Y basis points, as
+  // returned by ArFrame_transformCoordinates2d.
+  float ndc_basis_uvs[6] = {0.f};
+  int32_t light_estimate_state = 0;
+  float color_correction[4] = {1.f, 1.f, 1.f, 1.f};
+  // x, y, z, confidence for each point.
+  std::vector<float> point_cloud;
+  // Sorted by ascending id.
+  std::vector<LoggedPlane> planes;
+  int32_t depth_width = 0;
+  int32_t depth_height = 0;
+  // DEPTH16 samples in millimeters, tightly packed rows.
+  std::vector<uint16_t> depth;
+  // Taps hit tested against this frame, in order.
+  std::vector<LoggedTouch> touches;
+};
+
+// Writes LoggedFrames to a compact binary log.
+//
+// Every float is quantized to a fixed step for its kind (0.1 mm for
+// positions, about 1e-4 for rotations, ...) and written as a zigzag varint
+// delta: against the same value of the previous frame for the camera and for
+// planes that were already present, and against the previous element for point
+// clouds, new polygons and depth rows. Static scenes therefore cost about one
+// byte per value.
+class FrameLogWriter {
+ public:
+  FrameLogWriter() = default;
+  ~FrameLogWriter() { Close(); }
+
+  // Delete copy constructors.
+  FrameLogWriter(const FrameLogWriter&) = delete;
+  void operator=(const FrameLogWriter&) = delete;
+
+  // @return true if the file was created and the header written.
+  bool Open(const char* path);
+  void Close();
+  bool IsOpen() const { return file_ != nullptr; }
+
+  // @return false if the frame could not be written.
+  bool Write(const LoggedFrame& frame);
+
+ private:
+  FILE* file_ = nullptr;
+  // The previous frame as the reader will decode it, i.e. after quantization.
+  LoggedFrame previous_;
+  std::vector<uint8_t> buffer_;
+};
+
+// Reads a log produced by FrameLogWriter, frame by frame.
+class FrameLogReader {
+ public:
+  FrameLogReader() = default;
+  ~FrameLogReader() { Close(); }
+
+  // Delete copy constructors.
+  FrameLogReader(const FrameLogReader&) = delete;
+  void operator=(const FrameLogReader&) = delete;
+
+  // @return true if the file exists and has a valid header.
+  bool Open(const char* path);
+  void Close();
+  bool IsOpen() const { return file_ != nullptr; }
+
+  // @return false at the end of the log or if the log is corrupt.
+  bool Read(LoggedFrame* out_frame);
+
+ private:
+  FILE* file_ = nullptr;
+  LoggedFrame previous_;
+  std::vector<uint8_t> buffer_;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_FRAME_LOG_H_
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frame_recorder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "util.h"
+
+namespace hello_ar {
+namespace {
+// XY pairs of coordinates in NDC space that constitute the origin and points
+// along the two principal axes.
+const float kNdcBasis[6] = {0, 0, 1, 0, 0, 1};
+}  // namespace
+
+bool FrameRecorder::Start(const char* path) {
+  Stop();
+  if (!writer_.Open(path)) {
+    LOGE("FrameRecorder::Start could not open %s", path);
+    return false;
+  }
+  LOGI("FrameRecorder::Start recording to %s", path);
+  return true;
+}
+
+void FrameRecorder::Stop() {
+  if (!writer_.IsOpen()) {
+    return;
+  }
+  FlushPendingFrame();
+  writer_.Close();
+  known_planes_.clear();
+}
+
+void FrameRecorder::AddTouch(float x, float y) {
+  if (!has_pending_frame_) {
+    return;
+  }
+  LoggedTouch touch;
+  touch.x = x;
+  touch.y = y;
+  pending_frame_.touches.push_back(touch);
+}
+
+void FrameRecorder::FlushPendingFrame() {
+  if (!has_pending_frame_) {
+    return;
+  }
+  if (!writer_.Write(pending_frame_)) {
+    LOGE("FrameRecorder could not write frame, stopping.");
+    writer_.Close();
+  }
+  has_pending_frame_ = false;
+}
+
+int32_t FrameRecorder::GetPlaneId(ArTrackable* plane) {
+  for (size_t i = 0; i < known_planes_.size(); ++i) {
+    if (known_planes_[i].Get() == plane) {
+      return static_cast<int32_t>(i);
+    }
+  }
+  return -1;
+}
+
+void FrameRecorder::RecordFrame(const ArSession* session,
+                                const ArFrame* frame) {
+  if (!writer_.IsOpen()) {
+    return;
+  }
+  FlushPendingFrame();
+
+  LoggedFrame& logged = pending_frame_;
+  logged = LoggedFrame();
+  ArFrame_getTimestamp(session, frame, &logged.timestamp_ns);
+
+  util::ScopedArCamera camera;
+  ArFrame_acquireCamera(session, frame, camera.OutPtr());
+  ArTrackingState camera_tracking_state;
+  ArCamera_getTrackingState(session, camera.Get(), &camera_tracking_state);
+  logged.camera_tracking_state = camera_tracking_state;
+  util::ScopedArPose camera_pose(session);
+  ArCamera_getPose(session, camera.Get(), camera_pose.GetArPose());
+  ArPose_getPoseRaw(session, camera_pose.GetArPose(), logged.camera_pose);
+  ArCamera_getProjectionMatrix(session, camera.Get(), kLoggedProjectionNear,
+                               kLoggedProjectionFar, logged.projection_mat);
+  ArFrame_transformCoordinates2d(
+      session, frame, AR_COORDINATES_2D_OPENGL_NORMALIZED_DEVICE_COORDINATES, 3,
+      kNdcBasis, AR_COORDINATES_2D_TEXTURE_NORMALIZED, logged.ndc_basis_uvs);
+
+  util::ScopedArLightEstimate light_estimate;
+  ArLightEstimate_create(session, light_estimate.OutPtr());
+  ArFrame_getLightEstimate(session, frame, light_estimate.Get());
+  ArLightEstimateState light_estimate_state;
+  ArLightEstimate_getState(session, light_estimate.Get(),
+                           &light_estimate_state);
+  logged.light_estimate_state = light_estimate_state;
+  if (light_estimate_state == AR_LIGHT_ESTIMATE_STATE_VALID) {
+    ArLightEstimate_getColorCorrection(session, light_estimate.Get(),
+                                       logged.color_correction);
+  }
+
+  util::ScopedArPointCloud point_cloud;
+  if (ArFrame_acquirePointCloud(session, frame, point_cloud.OutPtr()) ==
+      AR_SUCCESS) {
+    int32_t number_of_points = 0;
+    ArPointCloud_getNumberOfPoints(session, point_cloud.Get(),
+                                   &number_of_points);
+    if (number_of_points > 0) {
+      const float* point_cloud_data = nullptr;
+      ArPointCloud_getData(session, point_cloud.Get(), &point_cloud_data);
+      logged.point_cloud.assign(point_cloud_data,
+                                point_cloud_data + number_of_points * 4);
+    }
+  }
+
+  util::ScopedArTrackableList plane_list;
+  ArTrackableList_create(session, plane_list.OutPtr());
+  ArSession_getAllTrackables(session, AR_TRACKABLE_PLANE, plane_list.Get());
+  int32_t plane_list_size = 0;
+  ArTrackableList_getSize(session, plane_list.Get(), &plane_list_size);
+  for (int32_t i = 0; i < plane_list_size; ++i) {
+    util::ScopedArTrackable trackable;
+    ArTrackableList_acquireItem(session, plane_list.Get(), i,
+                                trackable.OutPtr());
+    LoggedPlane plane;
+    plane.id = GetPlaneId(trackable.Get());
+    if (plane.id < 0) {
+      plane.id = static_cast<int32_t>(known_planes_.size());
+      known_planes_.push_back(std::move(trackable));
+    }
+    ArTrackable* ar_trackable = known_planes_[plane.id].Get();
+    ArPlane* ar_plane = ArAsPlane(ar_trackable);
+
+    ArTrackingState tracking_state;
+    ArTrackable_getTrackingState(session, ar_trackable, &tracking_state);
+    plane.tracking_state = tracking_state;
+
+    ArPlane* subsume_plane = nullptr;
+    ArPlane_acquireSubsumedBy(session, ar_plane, &subsume_plane);
+    util::ScopedArTrackable subsume_trackable(
+        subsume_plane != nullptr ? ArAsTrackable(subsume_plane) : nullptr);
+    if (subsume_trackable) {
+      plane.subsumed_by_id = GetPlaneId(subsume_trackable.Get());
+    }
+
+    util::ScopedArPose center_pose(session);
+    ArPlane_getCenterPose(session, ar_plane, center_pose.GetArPose());
+    ArPose_getPoseRaw(session, center_pose.GetArPose(), plane.center_pose);
+
+    int32_t polygon_length = 0;
+    ArPlane_getPolygonSize(session, ar_plane, &polygon_length);
+    plane.polygon.resize(polygon_length);
+    if (polygon_length > 0) {
+      ArPlane_getPolygon(session, ar_plane, plane.polygon.data());
+    }
+    logged.planes.push_back(std::move(plane));
+  }
+  std::sort(logged.planes.begin(), logged.planes.end(),
+            [](const LoggedPlane& a, const LoggedPlane& b) {
+              return a.id < b.id;
+            });
+
+  util::ScopedArImage depth_image;
+  if (ArFrame_acquireDepthImage(session, frame, depth_image.OutPtr()) ==
+      AR_SUCCESS) {
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t row_stride = 0;
+    int32_t plane_size_bytes = 0;
+    const uint8_t* depth_data = nullptr;
+    ArImage_getWidth(session, depth_image.Get(), &width);
+    ArImage_getHeight(session, depth_image.Get(), &height);
+    ArImage_getPlaneRowStride(session, depth_image.Get(), 0, &row_stride);
+    ArImage_getPlaneData(session, depth_image.Get(), /*plane_index=*/0,
+                         &depth_data, &plane_size_bytes);
+    if (depth_data != nullptr && width > 0 && height > 0) {
+      logged.depth_width = width;
+      logged.depth_height = height;
+      logged.depth.resize(width * height);
+      for (int32_t row = 0; row < height; ++row) {
+        memcpy(&logged.depth[row * width], depth_data + row * row_stride,
+               width * sizeof(uint16_t));
+      }
+    }
+  }
+
+  has_pending_frame_ = true;
+}
+
+}  // namespace hello_ar
@@ -0,0 +1,69 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_FRAME_RECORDER_H_
+#define C_ARCORE_FRAME_RECORDER_H_
+
+#include <vector>
+
+#include "arcore_c_api.h"
+#include "frame_log.h"
+#include "scoped_ar_handle.h"
+
+namespace hello_ar {
+
+// FrameRecorder captures the ARCore outputs HelloArApplication consumes into a
+// FrameLogWriter, so that sessions can be replayed off-device against the
+// replay backend in arcore_replay.cc.
+class FrameRecorder {
+ public:
+  FrameRecorder() = default;
+  ~FrameRecorder() = default;
+
+  // Starts a new log at path. Returns false if the file can't be created.
+  bool Start(const char* path);
+
+  // Flushes the last frame and closes the log. Must be called before the
+  // session is destroyed, since the recorder holds plane references.
+  void Stop();
+
+  bool IsRecording() const { return writer_.IsOpen(); }
+
+  // Captures the state of frame. Must be called on the OpenGL thread right
+  // after ArSession_update.
+  void RecordFrame(const ArSession* session, const ArFrame* frame);
+
+  // Records a tap hit tested against the last recorded frame.
+  void AddTouch(float x, float y);
+
+  // Number of ARCore handles held to keep plane ids stable.
+  size_t GetRetainedHandleCount() const { return known_planes_.size(); }
+
+ private:
+  int32_t GetPlaneId(ArTrackable* plane);
+  void FlushPendingFrame();
+
+  FrameLogWriter writer_;
+  // The latest frame is written once the touches that follow it are known.
+  LoggedFrame pending_frame_;
+  bool has_pending_frame_ = false;
+  // Every plane seen so far, indexed by its logged id. Holding a reference
+  // keeps ARCore from reusing the handle for another plane.
+  std::vector<util::ScopedArTrackable> known_planes_;
+};
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_FRAME_RECORDER_H_
@@ -0,0 +1,129 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frame_scheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hello_ar {
+namespace {
+// Weight of each new sample in the period estimates.
+constexpr double kPeriodSmoothing = 0.1;
+
+// Folds interval_ns into the period estimate. An interval spanning several
+// periods, because vsyncs or camera images were skipped, counts as one
+// period of its average length.
+void UpdatePeriodEstimate(int64_t interval_ns, double* period_ns) {
+  if (interval_ns <= 0) {
+    return;
+  }
+  const double periods =
+      std::max(1.0, std::round(static_cast<double>(interval_ns) / *period_ns));
+  *period_ns += kPeriodSmoothing * (interval_ns / periods - *period_ns);
+}
+}  // namespace
+
+void FrameScheduler::SetTargetFrameRate(int32_t frames_per_second) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  target_frame_rate_ =
+      frames_per_second > 0 ? frames_per_second : kCameraFrameRate;
+}
+
+void FrameScheduler::RequestFrame() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  is_frame_requested_ = true;
+}
+
+void FrameScheduler::SetAnimating(bool animating) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  is_animating_ = animating;
+}
+
+bool FrameScheduler::OnVsync(int64_t vsync_ns) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (last_vsync_ns_ != 0) {
+    UpdatePeriodEstimate(vsync_ns - last_vsync_ns_, &vsync_period_ns_);
+  }
+  last_vsync_ns_ = vsync_ns;
+
+  // Half a vsync of slack absorbs jitter in the callback times.
+  const bool is_interval_elapsed =
+      last_frame_vsync_ns_ == 0 ||
+      vsync_ns - last_frame_vsync_ns_ >=
+          GetFrameIntervalNs() - static_cast<int64_t>(vsync_period_ns_ / 2);
+  if (!is_frame_requested_ && !is_camera_late_ && !is_interval_elapsed) {
+    return false;
+  }
+  is_frame_requested_ = false;
+  is_camera_retry_ = is_camera_late_;
+  is_camera_late_ = false;
+  last_frame_vsync_ns_ = vsync_ns;
+  return true;
+}
+
+void FrameScheduler::OnCameraFrame(int64_t camera_timestamp_ns) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (camera_timestamp_ns == 0) {
+    // The camera has not produced its first image yet.
+    return;
+  }
+  if (camera_timestamp_ns == last_camera_timestamp_ns_) {
+    // The frame came before the camera image it was paced for. Retry on the
+    // next vsync, which brings the cadence in phase with the camera. A retry
+    // that comes back empty as well means the camera stalled, and retrying
+    // every vsync would render at the display rate until it recovers.
+    is_camera_stalled_ = is_camera_stalled_ || is_camera_retry_;
+    is_camera_late_ = target_frame_rate_ == kCameraFrameRate &&
+                      !is_animating_ && !is_camera_stalled_;
+    return;
+  }
+  is_camera_stalled_ = false;
+  if (last_camera_timestamp_ns_ != 0) {
+    UpdatePeriodEstimate(camera_timestamp_ns - last_camera_timestamp_ns_,
+                         &camera_frame_period_ns_);
+  }
+  last_camera_timestamp_ns_ = camera_timestamp_ns;
+}
+
+int64_t FrameScheduler::GetVsyncPeriodNs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int64_t>(vsync_period_ns_);
+}
+
+int64_t FrameScheduler::GetCameraFramePeriodNs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return static_cast<int64_t>(camera_frame_period_ns_);
+}
+
+int64_t FrameScheduler::GetFrameBudgetNs() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return GetFrameIntervalNs();
+}
+
+int64_t FrameScheduler::GetFrameIntervalNs() const {
+  double interval_ns = 0.0;
+  if (target_frame_rate_ != kCameraFrameRate) {
+    interval_ns = 1e9 / target_frame_rate_;
+  } else if (!is_animating_) {
+    interval_ns = camera_frame_period_ns_;
+  }
+  const double vsyncs =
+      std::max(1.0, std::round(interval_ns / vsync_period_ns_));
+  return static_cast<int64_t>(vsyncs * vsync_period_ns_);
+}
+
+}  // namespace hello_ar
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_FRAME_SCHEDULER_H_
+#define C_ARCORE_FRAME_SCHEDULER_H_
+
+#include <cstdint>
+#include <mutex>
+
+namespace hello_ar {
+
+// Decides on which display vsyncs a frame is rendered, so that the view only
+// renders on demand. A frame is due when the camera should have produced a
+// new image, or at a fixed target rate, and right away when input is pending.
+// While an animation runs, frames follow the display up to the target rate.
+//
+// The scheduler keeps no clock of its own. Vsync times, such as choreographer
+// frame times, and camera image timestamps are passed in, and only their
+// differences are used, so the two may come from different clocks. All
+// methods are thread safe.
+class FrameScheduler {
+ public:
+  // Target frame rate that renders each camera image once.
+  static constexpr int32_t kCameraFrameRate = 0;
+
+  FrameScheduler() = default;
+
+  // Paces frames to frames_per_second, rounded to a whole number of vsyncs,
+  // or to the camera with kCameraFrameRate.
+  void SetTargetFrameRate(int32_t frames_per_second);
+
+  // Asks for a frame on the next vsync, for instance to handle input.
+  void RequestFrame();
+
+  // While animating, the scene changes without new camera images, so frames
+  // follow the display when pacing to the camera.
+  void SetAnimating(bool animating);
+
+  // Called once per display vsync at vsync_ns.
+  // @return true if a frame should be rendered for this vsync.
+  bool OnVsync(int64_t vsync_ns);
+
+  // Called by the render thread with the timestamp of the camera image each
+  // frame was rendered with.
+  void OnCameraFrame(int64_t camera_timestamp_ns);
+
+  // Interval between frames as currently paced, the time the render thread
+  // has for each frame.
+  int64_t GetFrameBudgetNs() const;
+
+  // Current estimates, in nanoseconds.
+  int64_t GetVsyncPeriodNs() const;
+  int64_t GetCameraFramePeriodNs() const;
+
+ private:
+  // Interval between frames as currently paced, a whole number of vsyncs.
+  int64_t GetFrameIntervalNs() const;
+
+  mutable std::mutex mutex_;
+  int32_t target_frame_rate_ = kCameraFrameRate;
+  bool is_frame_requested_ = false;
+  bool is_animating_ = false;
+  // Set when a frame found no new camera image, so the next vsync retries.
+  bool is_camera_late_ = false;
+  // Set for a frame that retries a late camera image.
+  bool is_camera_retry_ = false;
+  // Set when a retry found no new camera image either. The camera stalled,
+  // and frames keep to the interval until it produces an image again.
+  bool is_camera_stalled_ = false;
+
+  int64_t last_vsync_ns_ = 0;
+  // Vsync of the last frame the scheduler asked for, 0 before the first.
+  int64_t last_frame_vsync_ns_ = 0;
+  int64_t last_camera_timestamp_ns_ = 0;
+  // Displays run at 60 Hz and ARCore cameras at 30 fps unless measured
+  // otherwise.
+  double vsync_period_ns_ = 1e9 / 60.0;
+  double camera_frame_period_ns_ = 1e9 / 30.0;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_FRAME_SCHEDULER_H_
@@ -0,0 +1,77 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "frame_transforms.h"
+
+namespace hello_ar {
+namespace {
+constexpr float kNearPlaneMeters = 0.1f;
+constexpr float kFarPlaneMeters = 100.f;
+
+// This method returns a transformation matrix that when applied to screen space
+// uvs makes them match correctly with the quad texture coords used to render
+// the camera feed. It takes into account device orientation.
+glm::mat3 GetTextureTransformMatrix(const ArSession* session,
+                                    const ArFrame* frame) {
+  float frameTransform[6];
+  float uvTransform[9];
+  // XY pairs of coordinates in NDC space that constitute the origin and points
+  // along the two principal axes.
+  const float ndcBasis[6] = {0, 0, 1, 0, 0, 1};
+  ArFrame_transformCoordinates2d(
+      session, frame, AR_COORDINATES_2D_OPENGL_NORMALIZED_DEVICE_COORDINATES, 3,
+      ndcBasis, AR_COORDINATES_2D_TEXTURE_NORMALIZED, frameTransform);
+
+  // Convert the transformed points into an affine transform and transpose it.
+  float ndcOriginX = frameTransform[0];
+  float ndcOriginY = frameTransform[1];
+  uvTransform[0] = frameTransform[2] - ndcOriginX;
+  uvTransform[1] = frameTransform[3] - ndcOriginY;
+  uvTransform[2] = 0;
+  uvTransform[3] = frameTransform[4] - ndcOriginX;
+  uvTransform[4] = frameTransform[5] - ndcOriginY;
+  uvTransform[5] = 0;
+  uvTransform[6] = ndcOriginX;
+  uvTransform[7] = ndcOriginY;
+  uvTransform[8] = 1;
+
+  return glm::make_mat3(uvTransform);
+}
+}  // namespace
+
+bool FrameTransformCache::Update(const ArSession* session,
+                                 const ArFrame* frame,
+                                 const ArCamera* camera) {
+  int32_t geometry_changed = 0;
+  ArFrame_getDisplayGeometryChanged(session, frame, &geometry_changed);
+  const bool recompute =
+      is_stale_.exchange(false, std::memory_order_relaxed) ||
+      geometry_changed != 0 || !has_transforms_;
+  if (recompute) {
+    uv_transform_ = GetTextureTransformMatrix(session, frame);
+    ArCamera_getProjectionMatrix(session, camera, kNearPlaneMeters,
+                                 kFarPlaneMeters,
+                                 glm::value_ptr(transforms_.projection_mat));
+  }
+  ArCamera_getViewMatrix(session, camera,
+                         glm::value_ptr(transforms_.view_mat));
+  transforms_.view_projection_mat =
+      transforms_.projection_mat * transforms_.view_mat;
+  has_transforms_ = true;
+  return recompute;
+}
+
+}  // namespace hello_ar
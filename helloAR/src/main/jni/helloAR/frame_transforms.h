@@ -0,0 +1,74 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_FRAME_TRANSFORMS_H_
+#define C_ARCORE_FRAME_TRANSFORMS_H_
+
+#include <atomic>
+
+#include "arcore_c_api.h"
+#include "glm.h"
+
+namespace hello_ar {
+
+// Camera matrices of one frame, computed once and shared by every renderer.
+struct FrameTransforms {
+  glm::mat4 view_mat = glm::mat4(1.0f);
+  glm::mat4 projection_mat = glm::mat4(1.0f);
+  // projection_mat * view_mat.
+  glm::mat4 view_projection_mat = glm::mat4(1.0f);
+};
+
+// Derives the per-frame camera state from ARCore and memoizes the parts that
+// only change with the display geometry or camera configuration: the
+// projection matrix and the screen to camera texture UV transform. Only the
+// view matrix is read every frame. Used on the OpenGL thread, except for
+// Invalidate.
+class FrameTransformCache {
+ public:
+  FrameTransformCache() = default;
+
+  // Reads the frame's camera. Returns true if the projection and UV
+  // transform were recomputed, which happens on the first frame, after
+  // Invalidate and whenever ARCore reports a display geometry change.
+  bool Update(const ArSession* session, const ArFrame* frame,
+              const ArCamera* camera);
+
+  // Forces the next Update to recompute everything, for instance after the
+  // session was reconfigured with another camera. Safe to call from any
+  // thread.
+  void Invalidate() { is_stale_.store(true, std::memory_order_relaxed); }
+
+  // False until the first Update.
+  bool HasTransforms() const { return has_transforms_; }
+
+  // Transforms of the frame passed to the last Update.
+  const FrameTransforms& GetTransforms() const { return transforms_; }
+
+  // Maps normalized screen coordinates to camera texture coordinates,
+  // accounting for the device orientation.
+  const glm::mat3& GetUvTransform() const { return uv_transform_; }
+
+ private:
+  std::atomic<bool> is_stale_{true};
+  bool has_transforms_ = false;
+  FrameTransforms transforms_;
+  glm::mat3 uv_transform_ = glm::mat3(1.0f);
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_FRAME_TRANSFORMS_H_
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "gl_wrapper.h"
+
+#ifdef HELLOAR_GL_DEBUG
+#include <EGL/egl.h>
+#endif  // HELLOAR_GL_DEBUG
+
+#include <GLES3/gl3.h>
+
+#include <cstring>
+#include <mutex>
+
+#include "util.h"
+
+namespace hello_ar {
+namespace gl {
+
+#ifdef HELLOAR_GL_STATS
+GlFrameStats g_current_frame_stats;
+
+namespace {
+std::mutex g_last_frame_stats_mutex;
+GlFrameStats g_last_frame_stats;
+}  // namespace
+#endif  // HELLOAR_GL_STATS
+
+#ifdef HELLOAR_GL_DEBUG
+namespace {
+void GL_APIENTRY OnDebugMessage(GLenum, GLenum type, GLuint id,
+                                GLenum severity, GLsizei,
+                                const GLchar* message, const void*) {
+  if (type == GL_DEBUG_TYPE_ERROR_KHR) {
+    // Debug output is synchronous, so this runs inside the failing call.
+    HELLOAR_LOG_FATAL("GL error 0x%x: %s", id, message);
+  }
+  if (severity == GL_DEBUG_SEVERITY_HIGH_KHR ||
+      severity == GL_DEBUG_SEVERITY_MEDIUM_KHR) {
+    LOGI("GL debug message 0x%x: %s", id, message);
+  }
+}
+}  // namespace
+#endif  // HELLOAR_GL_DEBUG
+
+void BeginFrame() {
+#ifdef HELLOAR_GL_STATS
+  std::lock_guard<std::mutex> lock(g_last_frame_stats_mutex);
+  g_last_frame_stats = g_current_frame_stats;
+  g_current_frame_stats = GlFrameStats();
+#endif  // HELLOAR_GL_STATS
+}
+
+GlFrameStats GetLastFrameStats() {
+#ifdef HELLOAR_GL_STATS
+  std::lock_guard<std::mutex> lock(g_last_frame_stats_mutex);
+  return g_last_frame_stats;
+#else
+  return GlFrameStats();
+#endif  // HELLOAR_GL_STATS
+}
+
+void InitializeDebugOutput() {
+#ifdef HELLOAR_GL_DEBUG
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  PFNGLDEBUGMESSAGECALLBACKKHRPROC debug_message_callback =
+      extensions != nullptr && strstr(extensions, "GL_KHR_debug") != nullptr
+          ? reinterpret_cast<PFNGLDEBUGMESSAGECALLBACKKHRPROC>(
+                eglGetProcAddress("glDebugMessageCallbackKHR"))
+          : nullptr;
+  if (debug_message_callback == nullptr) {
+    LOGI("GL_KHR_debug unavailable, falling back to glGetError polling.");
+    util::SetGlErrorPollingEnabled(true);
+    return;
+  }
+  glEnable(GL_DEBUG_OUTPUT_KHR);
+  glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS_KHR);
+  debug_message_callback(OnDebugMessage, nullptr);
+  util::SetGlErrorPollingEnabled(false);
+#endif  // HELLOAR_GL_DEBUG
+}
+
+int64_t GetImageSizeBytes(GLsizei width, GLsizei height, GLenum format,
+                          GLenum type) {
+  int64_t components = 4;
+  switch (format) {
+    case GL_ALPHA:
+    case GL_LUMINANCE:
+    case GL_RED_EXT:
+      components = 1;
+      break;
+    case GL_LUMINANCE_ALPHA:
+    case GL_RG_EXT:
+      components = 2;
+      break;
+    case GL_RGB:
+      components = 3;
+      break;
+    default:
+      break;
+  }
+  int64_t bytes_per_pixel = components;
+  switch (type) {
+    case GL_UNSIGNED_SHORT_5_6_5:
+    case GL_UNSIGNED_SHORT_4_4_4_4:
+    case GL_UNSIGNED_SHORT_5_5_5_1:
+      bytes_per_pixel = 2;
+      break;
+    case GL_UNSIGNED_SHORT:
+    case GL_HALF_FLOAT:
+    case GL_HALF_FLOAT_OES:
+      bytes_per_pixel = 2 * components;
+      break;
+    case GL_UNSIGNED_INT:
+    case GL_FLOAT:
+      bytes_per_pixel = 4 * components;
+      break;
+    default:
+      break;
+  }
+  return bytes_per_pixel * width * height;
+}
+
+}  // namespace gl
+}  // namespace hello_ar
@@ -0,0 +1,166 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_GL_WRAPPER_H_
+#define C_ARCORE_GL_WRAPPER_H_
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+
+#include <cstdint>
+
+// Thin wrappers over the GL entry points that draw, change pipeline state,
+// bind programs and textures or upload data. The renderers call these instead
+// of the raw gl* functions so that, when built with HELLOAR_GL_STATS, every
+// call is counted into the current frame's GlFrameStats. Without
+// HELLOAR_GL_STATS each wrapper inlines to the plain GL call.
+namespace hello_ar {
+namespace gl {
+
+// GL work issued by the render thread during one frame.
+struct GlFrameStats {
+  int32_t draw_calls = 0;
+  // glEnable, glDisable, blend, depth, cull, viewport and clear state.
+  int32_t state_changes = 0;
+  int32_t program_binds = 0;
+  // glBindTexture and glActiveTexture.
+  int32_t texture_binds = 0;
+  // Texture and buffer data passed to glTexImage2D, glTexSubImage2D,
+  // glBufferData and glBufferSubData.
+  int64_t bytes_uploaded = 0;
+};
+
+#ifdef HELLOAR_GL_STATS
+// Stats of the frame in progress. Only touched on the render thread.
+extern GlFrameStats g_current_frame_stats;
+#define HELLOAR_GL_COUNT(field, amount) \
+  (::hello_ar::gl::g_current_frame_stats.field += (amount))
+#else
+#define HELLOAR_GL_COUNT(field, amount) ((void)0)
+#endif  // HELLOAR_GL_STATS
+
+// Publishes the stats of the frame that just ended and starts a new one.
+// Called on the render thread at the start of every frame.
+void BeginFrame();
+
+// Returns the stats of the last complete frame. All zero without
+// HELLOAR_GL_STATS. Safe to call from any thread.
+GlFrameStats GetLastFrameStats();
+
+// Installs a KHR_debug callback that logs GL errors and aborts on the call
+// that raised them, when built with HELLOAR_GL_DEBUG and the extension is
+// available. Called on the render thread once the context is current.
+void InitializeDebugOutput();
+
+// Size in bytes of a width x height image with the given format and type.
+int64_t GetImageSizeBytes(GLsizei width, GLsizei height, GLenum format,
+                          GLenum type);
+
+inline void DrawArrays(GLenum mode, GLint first, GLsizei count) {
+  HELLOAR_GL_COUNT(draw_calls, 1);
+  glDrawArrays(mode, first, count);
+}
+
+inline void DrawElements(GLenum mode, GLsizei count, GLenum type,
+                         const void* indices) {
+  HELLOAR_GL_COUNT(draw_calls, 1);
+  glDrawElements(mode, count, type, indices);
+}
+
+inline void Enable(GLenum capability) {
+  HELLOAR_GL_COUNT(state_changes, 1);
+  glEnable(capability);
+}
+
+inline void Disable(GLenum capability) {
+  HELLOAR_GL_COUNT(state_changes, 1);
+  glDisable(capability);
+}
+
+inline void BlendFunc(GLenum source_factor, GLenum destination_factor) {
+  HELLOAR_GL_COUNT(state_changes, 1);
+  glBlendFunc(source_factor, destination_factor);
+}
+
+inline void DepthMask(GLboolean flag) {
+  HELLOAR_GL_COUNT(state_changes, 1);
+  glDepthMask(flag);
+}
+
+inline void ClearColor(GLfloat red, GLfloat green, GLfloat blue,
+                       GLfloat alpha) {
+  HELLOAR_GL_COUNT(state_changes, 1);
+  glClearColor(red, green, blue, alpha);
+}
+
+inline void Viewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+  HELLOAR_GL_COUNT(state_changes, 1);
+  glViewport(x, y, width, height);
+}
+
+inline void UseProgram(GLuint program) {
+  HELLOAR_GL_COUNT(program_binds, 1);
+  glUseProgram(program);
+}
+
+inline void ActiveTexture(GLenum texture_unit) {
+  HELLOAR_GL_COUNT(texture_binds, 1);
+  glActiveTexture(texture_unit);
+}
+
+inline void BindTexture(GLenum target, GLuint texture) {
+  HELLOAR_GL_COUNT(texture_binds, 1);
+  glBindTexture(target, texture);
+}
+
+inline void TexImage2D(GLenum target, GLint level, GLint internal_format,
+                       GLsizei width, GLsizei height, GLint border,
+                       GLenum format, GLenum type, const void* pixels) {
+  if (pixels != nullptr) {
+    HELLOAR_GL_COUNT(bytes_uploaded,
+                     GetImageSizeBytes(width, height, format, type));
+  }
+  glTexImage2D(target, level, internal_format, width, height, border, format,
+               type, pixels);
+}
+
+inline void TexSubImage2D(GLenum target, GLint level, GLint x_offset,
+                          GLint y_offset, GLsizei width, GLsizei height,
+                          GLenum format, GLenum type, const void* pixels) {
+  HELLOAR_GL_COUNT(bytes_uploaded,
+                   GetImageSizeBytes(width, height, format, type));
+  glTexSubImage2D(target, level, x_offset, y_offset, width, height, format,
+                  type, pixels);
+}
+
+inline void BufferData(GLenum target, GLsizeiptr size, const void* data,
+                       GLenum usage) {
+  if (data != nullptr) {
+    HELLOAR_GL_COUNT(bytes_uploaded, size);
+  }
+  glBufferData(target, size, data, usage);
+}
+
+inline void BufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
+                          const void* data) {
+  HELLOAR_GL_COUNT(bytes_uploaded, size);
+  glBufferSubData(target, offset, size, data);
+}
+
+}  // namespace gl
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_GL_WRAPPER_H_
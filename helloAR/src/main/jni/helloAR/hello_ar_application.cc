@@ -18,15 +18,27 @@
 
 #include <android/asset_manager.h>
 
+#include <algorithm>
 #include <array>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <utility>
 
 #include "arcore_c_api.h"
+#include "arcore_profiler.h"
+#include "gl_wrapper.h"
 #include "plane_renderer.h"
+#include "trace.h"
 #include "util.h"
 
+#ifdef HELLOAR_ARCORE_REPLAY
+#include "arcore_replay.h"
+#endif  // HELLOAR_ARCORE_REPLAY
+
 namespace hello_ar {
 namespace {
-constexpr size_t kMaxNumberOfAndroidsToRender = 20;
+constexpr int32_t kMaxNumberOfAndroidsToRender = 20;
 
 const glm::vec3 kWhite = {255, 255, 255};
 
@@ -62,13 +74,39 @@ constexpr float kTintIntensity = 0.1f;
 // Load a single image (true) or a pre-generated image database (false).
 constexpr bool kUseSingleImage = false;
 
+#ifdef HELLOAR_TRACK_AR_HANDLES
+// Number of frames between two reports of the live ARCore handle counts.
+constexpr int64_t kArHandleReportIntervalFrames = 600;
+#endif  // HELLOAR_TRACK_AR_HANDLES
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
 }  // namespace
 
 HelloArApplication::HelloArApplication(AAssetManager* asset_manager)
-    : asset_manager_(asset_manager) {}
+    : asset_manager_(asset_manager),
+      anchors_(kMaxNumberOfAndroidsToRender),
+      job_system_(JobSystem::GetDefaultWorkerCount()),
+      render_thread_(RenderThread::Callbacks{
+          [this] { OnSurfaceCreated(); },
+          [this] {
+            OnDrawFrame(depth_color_visualization_enabled_,
+                        use_depth_for_occlusion_);
+          }}) {}
 
 HelloArApplication::~HelloArApplication() {
+  render_thread_.Stop();
+  // Anchors and trackables must be released before the session that owns them.
+  frame_recorder_.Stop();
+  anchors_.Clear();
+  augmented_image_map.clear();
+  hit_tester_.Release();
+  light_estimator_.Release();
   if (ar_session_ != nullptr) {
+    ArAugmentedImageDatabase_destroy(ar_augmented_image_database_);
     ArSession_destroy(ar_session_);
     ArFrame_destroy(ar_frame_);
   }
@@ -76,6 +114,9 @@ HelloArApplication::~HelloArApplication() {
 
 void HelloArApplication::OnPause() {
   LOGI("OnPause()");
+  // ArSession_update must not run on the render thread while the session
+  // pauses.
+  render_thread_.Pause();
   if (ar_session_ != nullptr) {
     ArSession_pause(ar_session_);
   }
@@ -113,22 +154,8 @@ void HelloArApplication::OnResume(void* env, void* context, void* activity) {
     CHECK(ArSession_create(env, context, &ar_session_) == AR_SUCCESS);
     CHECK(ar_session_);
 
-    ConfigureSession();
-
-    ArConfig* ar_config = nullptr;
-    ArConfig_create(ar_session_, &ar_config);
-    CHECK(ar_config);
-
-    ArAugmentedImageDatabase* ar_augmented_image_database =
-            CreateAugmentedImageDatabase();
-    ArConfig_setAugmentedImageDatabase(ar_session_, ar_config,
-                                       ar_augmented_image_database);
-
-    ArConfig_setFocusMode(ar_session_, ar_config, AR_FOCUS_MODE_AUTO);
-    CHECK(ArSession_configure(ar_session_, ar_config) == AR_SUCCESS);
-
-    ArAugmentedImageDatabase_destroy(ar_augmented_image_database);
-    ArConfig_destroy(ar_config);
+    ar_augmented_image_database_ = CreateAugmentedImageDatabase();
+    ApplyPerformanceProfile(/*is_session_resumed=*/false);
 
     ArFrame_create(ar_session_, &ar_frame_);
     CHECK(ar_frame_);
@@ -139,6 +166,7 @@ void HelloArApplication::OnResume(void* env, void* context, void* activity) {
 
   const ArStatus status = ArSession_resume(ar_session_);
   CHECK(status == AR_SUCCESS);
+  render_thread_.Resume();
 }
 
 ArAugmentedImageDatabase*
@@ -195,24 +223,30 @@ HelloArApplication::CreateAugmentedImageDatabase() const {
 
 void HelloArApplication::OnSurfaceCreated() {
   LOGI("OnSurfaceCreated()");
+  TRACE_SCOPE("OnSurfaceCreated");
+  gl::InitializeDebugOutput();
   image_renderer_.InitializeGlContent(asset_manager_);
 
   depth_texture_.CreateOnGlThread();
+  light_estimator_.InitializeGlContent();
   background_renderer_.InitializeGlContent(asset_manager_,
                                            depth_texture_.GetTextureId());
   point_cloud_renderer_.InitializeGlContent(asset_manager_);
-  andy_renderer_.InitializeGlContent(asset_manager_, "models/andy.obj",
-                                     "models/andy.png");
+  // Falls back to loading the model right here.
+  upload_thread_.Start();
+  andy_renderer_.InitializeGlContentAsync(asset_manager_, "models/andy.obj",
+                                          "models/andy.png", &upload_thread_);
   andy_renderer_.SetDepthTexture(depth_texture_.GetTextureId(),
                                  depth_texture_.GetWidth(),
                                  depth_texture_.GetHeight());
   plane_renderer_.InitializeGlContent(asset_manager_);
+  render_target_.InitializeGlContent(asset_manager_);
 }
 
 void HelloArApplication::OnDisplayGeometryChanged(int display_rotation,
                                                   int width, int height) {
   LOGI("OnSurfaceChanged(%d, %d)", width, height);
-  glViewport(0, 0, width, height);
+  gl::Viewport(0, 0, width, height);
   display_rotation_ = display_rotation;
   width_ = width;
   height_ = height;
@@ -221,20 +255,41 @@ void HelloArApplication::OnDisplayGeometryChanged(int display_rotation,
   }
 }
 
+void HelloArApplication::OnWindowGeometryChanged(int display_rotation,
+                                                 int width, int height) {
+  render_thread_.Post([this, display_rotation, width, height] {
+    OnDisplayGeometryChanged(display_rotation, width, height);
+  });
+  render_thread_.RequestFrame();
+}
+
+bool HelloArApplication::OnVsync(int64_t vsync_ns) {
+  if (!frame_scheduler_.OnVsync(vsync_ns)) {
+    return false;
+  }
+  render_thread_.RequestFrame();
+  return true;
+}
+
 void HelloArApplication::OnDrawFrame(bool depthColorVisualizationEnabled,
                                      bool useDepthForOcclusion) {
+  TRACE_SCOPE("OnDrawFrame");
+  const int64_t frame_begin_ns = NowNs();
+  gl::BeginFrame();
+  arcore_profiler::BeginFrame();
+  upload_thread_.PublishCompleted();
   // Render the scene.
-  glClearColor(0.9f, 0.9f, 0.9f, 1.0f);
+  gl::ClearColor(0.9f, 0.9f, 0.9f, 1.0f);
   glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
-  glEnable(GL_CULL_FACE);
-  glEnable(GL_DEPTH_TEST);
-  glEnable(GL_BLEND);
+  gl::Enable(GL_CULL_FACE);
+  gl::Enable(GL_DEPTH_TEST);
+  gl::Enable(GL_BLEND);
 
   // Textures are loaded with premultiplied alpha
   // (https://developer.android.com/reference/android/graphics/BitmapFactory.Options#inPremultiplied),
   // so we use the premultiplied alpha blend factors.
-  glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  gl::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
   if (ar_session_ == nullptr) return;
 
@@ -242,173 +297,317 @@ void HelloArApplication::OnDrawFrame(bool depthColorVisualizationEnabled,
                                  background_renderer_.GetTextureId());
 
   // Update session to get current frame and render camera background.
-  if (ArSession_update(ar_session_, ar_frame_) != AR_SUCCESS) {
-    LOGE("HelloArApplication::OnDrawFrame ArSession_update error");
+  // The update may wait for the camera, which the quality governor must not
+  // count as rendering time.
+  int64_t update_time_ns = 0;
+  {
+    TRACE_SCOPE("ArSession_update");
+    const int64_t update_begin_ns = NowNs();
+    if (ArSession_update(ar_session_, ar_frame_) != AR_SUCCESS) {
+      LOGE("HelloArApplication::OnDrawFrame ArSession_update error");
+    }
+    update_time_ns = NowNs() - update_begin_ns;
   }
+  // The frame repeats the camera image of the last one when rendering
+  // outpaces the camera, in latest camera image mode or when a blocking
+  // update times out. Nothing tracked can have changed then, so the scene is
+  // redrawn from what was cached for that image without querying ARCore.
+  int64_t frame_timestamp_ns = 0;
+  ArFrame_getTimestamp(ar_session_, ar_frame_, &frame_timestamp_ns);
+  const bool is_repeated_frame =
+      frame_timestamp_ns != 0 && frame_timestamp_ns == scene_timestamp_ns_;
+  frame_scheduler_.OnCameraFrame(frame_timestamp_ns);
+  frame_recorder_.RecordFrame(ar_session_, ar_frame_);
+  ProcessTouches();
 
   andy_renderer_.SetDepthTexture(depth_texture_.GetTextureId(),
                                  depth_texture_.GetWidth(),
                                  depth_texture_.GetHeight());
 
-  ArCamera* ar_camera;
-  ArFrame_acquireCamera(ar_session_, ar_frame_, &ar_camera);
+  util::ScopedArCamera ar_camera;
+  ArFrame_acquireCamera(ar_session_, ar_frame_, ar_camera.OutPtr());
 
-  int32_t geometry_changed = 0;
-  ArFrame_getDisplayGeometryChanged(ar_session_, ar_frame_, &geometry_changed);
-  if (geometry_changed != 0 || !calculate_uv_transform_) {
+  if (frame_transform_cache_.Update(ar_session_, ar_frame_,
+                                    ar_camera.Get())) {
     // The UV Transform represents the transformation between screenspace in
     // normalized units and screenspace in units of pixels.  Having the size of
     // each pixel is necessary in the virtual object shader, to perform
     // kernel-based blur effects.
-    calculate_uv_transform_ = false;
-    glm::mat3 transform = GetTextureTransformMatrix(ar_session_, ar_frame_);
-    andy_renderer_.SetUvTransformMatrix(transform);
+    andy_renderer_.SetUvTransformMatrix(
+        frame_transform_cache_.GetUvTransform());
+  }
+  const FrameTransforms& transforms = frame_transform_cache_.GetTransforms();
+  const PerformanceProfileSettings& profile =
+      GetPerformanceProfileSettings(performance_profile_);
+  const QualityLevel& quality = quality_governor_.GetQualityLevel();
+
+  // With a scaled render target the camera image is drawn after the virtual
+  // content, so that the surface is only bound once per frame.
+  render_target_.Resize(width_, height_,
+                        std::min(render_scale_, quality.render_scale));
+  const auto draw_background = [&]() {
+    TRACE_SCOPE("BackgroundRenderer::Draw");
+    background_renderer_.Draw(ar_session_, ar_frame_,
+                              depthColorVisualizationEnabled);
+  };
+  if (!render_target_.IsEnabled()) {
+    draw_background();
   }
-
-  glm::mat4 view_mat;
-  glm::mat4 projection_mat;
-  ArCamera_getViewMatrix(ar_session_, ar_camera, glm::value_ptr(view_mat));
-  ArCamera_getProjectionMatrix(ar_session_, ar_camera,
-                               /*near=*/0.1f, /*far=*/100.f,
-                               glm::value_ptr(projection_mat));
-
-  background_renderer_.Draw(ar_session_, ar_frame_,
-                            depthColorVisualizationEnabled);
 
   ArTrackingState camera_tracking_state;
-  ArCamera_getTrackingState(ar_session_, ar_camera, &camera_tracking_state);
-  ArCamera_release(ar_camera);
+  ArCamera_getTrackingState(ar_session_, ar_camera.Get(),
+                            &camera_tracking_state);
+  ar_camera.Reset();
 
   // If the camera isn't tracking don't bother rendering other objects.
   if (camera_tracking_state != AR_TRACKING_STATE_TRACKING) {
+    if (render_target_.IsEnabled()) {
+      draw_background();
+    }
+    reticle_hit_valid_ = false;
+    PublishStatus(camera_tracking_state, frame_begin_ns);
     return;
   }
 
-  int32_t is_depth_supported = 0;
-  ArSession_isDepthModeSupported(ar_session_, AR_DEPTH_MODE_AUTOMATIC,
-                                 &is_depth_supported);
-  if (is_depth_supported) {
+  if (is_depth_supported_ && !is_repeated_frame) {
+    TRACE_SCOPE("Texture::UpdateWithDepthImageOnGlThread");
     depth_texture_.UpdateWithDepthImageOnGlThread(*ar_session_, *ar_frame_);
   }
 
-  // Get light estimation value.
-  ArLightEstimate* ar_light_estimate;
-  ArLightEstimateState ar_light_estimate_state;
-  ArLightEstimate_create(ar_session_, &ar_light_estimate);
-
-  ArFrame_getLightEstimate(ar_session_, ar_frame_, ar_light_estimate);
-  ArLightEstimate_getState(ar_session_, ar_light_estimate,
-                           &ar_light_estimate_state);
-
-  // Set light intensity to default. Intensity value ranges from 0.0f to 1.0f.
-  // The first three components are color scaling factors.
-  // The last one is the average pixel intensity in gamma space.
-  float color_correction[4] = {1.f, 1.f, 1.f, 1.f};
-  if (ar_light_estimate_state == AR_LIGHT_ESTIMATE_STATE_VALID) {
-    ArLightEstimate_getColorCorrection(ar_session_, ar_light_estimate,
-                                       color_correction);
+  // Object shaders only set their light uniforms when the estimate changed.
+  {
+    TRACE_SCOPE("LightEstimate");
+    light_estimator_.Update(ar_session_, ar_frame_, light_estimation_mode_);
+  }
+  const LightEnvironment& light_environment =
+      light_estimator_.GetLightEnvironment();
+  andy_renderer_.SetUseEnvironmentalHdr(
+      asset_manager_, light_environment.is_environmental_hdr);
+  image_renderer_.SetUseEnvironmentalHdr(
+      asset_manager_, light_environment.is_environmental_hdr);
+
+  if (render_target_.IsEnabled()) {
+    render_target_.Begin();
   }
 
-  ArLightEstimate_destroy(ar_light_estimate);
-  ar_light_estimate = nullptr;
-
-  DrawAugmentedImage(view_mat, projection_mat, color_correction);
+  {
+    TRACE_SCOPE("DrawAugmentedImage");
+    DrawAugmentedImage(transforms, light_environment,
+                       /*scan_updates=*/!is_repeated_frame);
+  }
 
   // Update and render planes.
-  ArTrackableList* plane_list = nullptr;
-  ArTrackableList_create(ar_session_, &plane_list);
-  CHECK(plane_list != nullptr);
-
-  ArTrackableType plane_tracked_type = AR_TRACKABLE_PLANE;
-  ArSession_getAllTrackables(ar_session_, plane_tracked_type, plane_list);
-
-  int32_t plane_list_size = 0;
-  ArTrackableList_getSize(ar_session_, plane_list, &plane_list_size);
-  plane_count_ = plane_list_size;
-
-  for (int i = 0; i < plane_list_size; ++i) {
-    ArTrackable* ar_trackable = nullptr;
-    ArTrackableList_acquireItem(ar_session_, plane_list, i, &ar_trackable);
-    ArPlane* ar_plane = ArAsPlane(ar_trackable);
-    ArTrackingState out_tracking_state;
-    ArTrackable_getTrackingState(ar_session_, ar_trackable,
-                                 &out_tracking_state);
-
-    ArPlane* subsume_plane;
-    ArPlane_acquireSubsumedBy(ar_session_, ar_plane, &subsume_plane);
-    if (subsume_plane != nullptr) {
-      ArTrackable_release(ArAsTrackable(subsume_plane));
-      continue;
-    }
+  if (!is_repeated_frame) {
+    TRACE_SCOPE("Planes");
+    util::ScopedArTrackableList plane_list;
+    ArTrackableList_create(ar_session_, plane_list.OutPtr());
+    CHECK(plane_list);
+
+    ArTrackableType plane_tracked_type = AR_TRACKABLE_PLANE;
+    ArSession_getAllTrackables(ar_session_, plane_tracked_type,
+                               plane_list.Get());
+
+    int32_t plane_list_size = 0;
+    ArTrackableList_getSize(ar_session_, plane_list.Get(), &plane_list_size);
+    plane_count_ = plane_list_size;
+
+    // ARCore is only called here. The meshes and ray casting tables are
+    // built from the polygons below, in parallel.
+    int32_t polygon_count = 0;
+    for (int i = 0; i < plane_list_size; ++i) {
+      // Released at the end of every iteration, whichever branch is taken.
+      util::ScopedArTrackable ar_trackable;
+      ArTrackableList_acquireItem(ar_session_, plane_list.Get(), i,
+                                  ar_trackable.OutPtr());
+      ArPlane* ar_plane = ArAsPlane(ar_trackable.Get());
+      ArTrackingState out_tracking_state;
+      ArTrackable_getTrackingState(ar_session_, ar_trackable.Get(),
+                                   &out_tracking_state);
+
+      ArPlane* subsume_plane = nullptr;
+      ArPlane_acquireSubsumedBy(ar_session_, ar_plane, &subsume_plane);
+      util::ScopedArTrackable subsume_trackable(
+          subsume_plane != nullptr ? ArAsTrackable(subsume_plane) : nullptr);
+      if (subsume_trackable) {
+        continue;
+      }
 
-    if (ArTrackingState::AR_TRACKING_STATE_TRACKING != out_tracking_state) {
-      continue;
-    }
+      if (ArTrackingState::AR_TRACKING_STATE_TRACKING != out_tracking_state) {
+        continue;
+      }
 
-    ArTrackingState plane_tracking_state;
-    ArTrackable_getTrackingState(ar_session_, ArAsTrackable(ar_plane),
-                                 &plane_tracking_state);
-    if (plane_tracking_state == AR_TRACKING_STATE_TRACKING) {
-      plane_renderer_.Draw(projection_mat, view_mat, *ar_session_, *ar_plane);
-      ArTrackable_release(ar_trackable);
+      if (polygon_count == static_cast<int32_t>(plane_polygons_.size())) {
+        plane_polygons_.emplace_back();
+      }
+      ReadPlanePolygon(*ar_session_, *ar_plane,
+                       &plane_polygons_[polygon_count++]);
     }
-  }
 
-  ArTrackableList_destroy(plane_list);
-  plane_list = nullptr;
+    plane_ray_caster_.SetPlaneCount(polygon_count);
+    plane_renderer_.SetPlaneCount(polygon_count);
+    plane_renderer_.SetFeatherEdges(profile.feather_planes &&
+                                    quality.feather_planes);
+    job_system_.ParallelFor(polygon_count, /*grain=*/1, [this](int32_t i) {
+      plane_ray_caster_.BuildPlane(i, plane_polygons_[i]);
+      plane_renderer_.BuildMesh(i, plane_polygons_[i]);
+    });
+
+    // Place the reticle where the screen center ray meets a plane.
+    reticle_hit_valid_ = plane_ray_caster_.RaycastScreenPoint(
+        transforms.view_mat, transforms.projection_mat, width_, height_,
+        0.5f * width_, 0.5f * height_, &reticle_hit_);
+  }
+  plane_renderer_.Draw(transforms);
 
-  andy_renderer_.setUseDepthForOcclusion(asset_manager_, useDepthForOcclusion);
+  andy_renderer_.setUseDepthForOcclusion(
+      asset_manager_, useDepthForOcclusion && quality.occlusion);
+  andy_renderer_.SetUseOcclusionBlur(
+      asset_manager_, profile.blur_occlusion && quality.blur_occlusion);
 
   // Render Andy objects.
-  glm::mat4 model_mat(1.0f);
-  for (auto& colored_anchor : anchors_) {
-    ArTrackingState tracking_state = AR_TRACKING_STATE_STOPPED;
-    ArAnchor_getTrackingState(ar_session_, colored_anchor.anchor,
-                              &tracking_state);
-    if (tracking_state == AR_TRACKING_STATE_TRACKING) {
-      UpdateAnchorColor(&colored_anchor);
-      // Render object only if the tracking state is AR_TRACKING_STATE_TRACKING.
-      util::GetTransformMatrixFromAnchor(*colored_anchor.anchor, ar_session_,
-                                         &model_mat);
-      andy_renderer_.Draw(projection_mat, view_mat, model_mat, color_correction,
-                          colored_anchor.color);
+  {
+    TRACE_SCOPE("Anchors");
+    if (!is_repeated_frame) {
+      UpdateInstantPlacementColors();
+    }
+    anchor_draws_.clear();
+    anchors_.ForEach([&](AnchorHandle handle, ColoredAnchor& colored_anchor) {
+      if (!is_repeated_frame) {
+        ArTrackingState tracking_state = AR_TRACKING_STATE_STOPPED;
+        ArAnchor_getTrackingState(ar_session_, colored_anchor.anchor.Get(),
+                                  &tracking_state);
+        colored_anchor.was_drawn =
+            tracking_state == AR_TRACKING_STATE_TRACKING;
+      }
+      if (!colored_anchor.was_drawn) {
+        return;
+      }
+      // Render object only if the tracking state is
+      // AR_TRACKING_STATE_TRACKING.
+      if (has_drag_model_mat_ && handle == dragged_anchor_) {
+        colored_anchor.model_mat = drag_model_mat_;
+      } else if (!is_repeated_frame) {
+        util::GetTransformMatrixFromAnchor(*colored_anchor.anchor.Get(),
+                                           ar_session_,
+                                           &colored_anchor.model_mat);
+        // Anchors drift as tracking improves, keep the spatial index current.
+        anchors_.UpdatePosition(handle,
+                                glm::vec3(colored_anchor.model_mat[3]));
+      }
+      // The dragged model always counts as nearest.
+      const glm::vec3 view_position(transforms.view_mat *
+                                    colored_anchor.model_mat[3]);
+      anchor_draws_.push_back(
+          {handle == dragged_anchor_
+               ? 0.0f
+               : glm::dot(view_position, view_position),
+           handle, &colored_anchor});
+    });
+
+    // Past the quality level's cap only the models nearest to the camera are
+    // drawn. The others count as not drawn, so they can't be picked either.
+    const size_t max_drawn_anchors =
+        static_cast<size_t>(quality.max_drawn_anchors);
+    if (anchor_draws_.size() > max_drawn_anchors) {
+      std::nth_element(anchor_draws_.begin(),
+                       anchor_draws_.begin() + max_drawn_anchors,
+                       anchor_draws_.end(),
+                       [](const AnchorDraw& a, const AnchorDraw& b) {
+                         return a.distance_squared < b.distance_squared;
+                       });
+      for (size_t i = max_drawn_anchors; i < anchor_draws_.size(); ++i) {
+        anchor_draws_[i].colored_anchor->was_drawn = false;
+      }
+      anchor_draws_.resize(max_drawn_anchors);
+    }
+    for (const AnchorDraw& anchor_draw : anchor_draws_) {
+      anchors_.MarkVisible(anchor_draw.handle);
+      andy_renderer_.Draw(transforms, anchor_draw.colored_anchor->model_mat,
+                          light_environment,
+                          anchor_draw.colored_anchor->color);
     }
   }
 
   // Update and render point cloud.
-  ArPointCloud* ar_point_cloud = nullptr;
-  ArStatus point_cloud_status =
-      ArFrame_acquirePointCloud(ar_session_, ar_frame_, &ar_point_cloud);
-  if (point_cloud_status == AR_SUCCESS) {
-    point_cloud_renderer_.Draw(projection_mat * view_mat, ar_session_,
-                               ar_point_cloud);
-    ArPointCloud_release(ar_point_cloud);
+  if (profile.draw_point_cloud && quality.point_size > 0.0f) {
+    TRACE_SCOPE("PointCloud");
+    if (!is_repeated_frame) {
+      util::ScopedArPointCloud ar_point_cloud;
+      ArStatus point_cloud_status = ArFrame_acquirePointCloud(
+          ar_session_, ar_frame_, ar_point_cloud.OutPtr());
+      if (point_cloud_status == AR_SUCCESS) {
+        point_cloud_renderer_.Update(ar_session_, ar_point_cloud.Get());
+      } else {
+        point_cloud_renderer_.Clear();
+      }
+    }
+    // Points keep their size on screen at any render scale.
+    point_cloud_renderer_.SetPointSize(quality.point_size *
+                                       render_target_.GetScale());
+    point_cloud_renderer_.Draw(transforms.view_projection_mat);
+  }
+
+  if (render_target_.IsEnabled()) {
+    TRACE_SCOPE("Composite");
+    render_target_.End();
+    draw_background();
+    render_target_.Composite();
+  }
+  scene_timestamp_ns_ = frame_timestamp_ns;
+
+  if (quality_governor_.OnFrame(NowNs() - frame_begin_ns - update_time_ns,
+                                frame_scheduler_.GetFrameBudgetNs())) {
+    LOGI("Quality level %d, frame time p90 %.1f ms",
+         quality_governor_.GetLevel(),
+         quality_governor_.GetFrameTimeP90Ns() / 1e6);
   }
+
+  PublishStatus(camera_tracking_state, frame_begin_ns);
+
+#ifdef HELLOAR_TRACK_AR_HANDLES
+  // All per-frame handles are out of scope here. Only the anchor and
+  // trackable held by each ColoredAnchor and AugmentedImageRecord, the
+  // planes known to the frame recorder and the reusable objects of the hit
+  // tester and light estimator remain, so any other live handle is a leak.
+  if (++tracked_frame_count_ % kArHandleReportIntervalFrames == 0) {
+    util::LogLiveArHandleCounts();
+  }
+  CHECK(util::GetTotalLiveArHandleCount() ==
+        static_cast<int>(2 * (anchors_.GetSize() + augmented_image_map.size()) +
+                         frame_recorder_.GetRetainedHandleCount() +
+                         hit_tester_.GetRetainedHandleCount() +
+                         light_estimator_.GetRetainedHandleCount()));
+#endif  // HELLOAR_TRACK_AR_HANDLES
 }
 
 bool HelloArApplication::DrawAugmentedImage(
-        const glm::mat4& view_mat, const glm::mat4& projection_mat,
-        const float* color_correction) {
+        const FrameTransforms& transforms,
+        const LightEnvironment& light_environment, bool scan_updates) {
   bool found_ar_image = false;
 
-  ArTrackableList* updated_image_list = nullptr;
-  ArTrackableList_create(ar_session_, &updated_image_list);
-  CHECK(updated_image_list != nullptr);
-  ArFrame_getUpdatedTrackables(
-          ar_session_, ar_frame_, AR_TRACKABLE_AUGMENTED_IMAGE, updated_image_list);
-
-  int32_t image_list_size;
-  ArTrackableList_getSize(ar_session_, updated_image_list, &image_list_size);
+  util::ScopedArTrackableList updated_image_list;
+  ArTrackableList_create(ar_session_, updated_image_list.OutPtr());
+  CHECK(updated_image_list);
+  // The updates of a repeated frame were applied when it was first drawn.
+  int32_t image_list_size = 0;
+  if (scan_updates) {
+    ArFrame_getUpdatedTrackables(ar_session_, ar_frame_,
+                                 AR_TRACKABLE_AUGMENTED_IMAGE,
+                                 updated_image_list.Get());
+    ArTrackableList_getSize(ar_session_, updated_image_list.Get(),
+                            &image_list_size);
+  }
 
   // Find newly detected image, add it to map
   for (int i = 0; i < image_list_size; ++i) {
-    ArTrackable* ar_trackable = nullptr;
-    ArTrackableList_acquireItem(ar_session_, updated_image_list, i,
-                                &ar_trackable);
-    ArAugmentedImage* image = ArAsAugmentedImage(ar_trackable);
+    util::ScopedArTrackable ar_trackable;
+    ArTrackableList_acquireItem(ar_session_, updated_image_list.Get(), i,
+                                ar_trackable.OutPtr());
+    ArAugmentedImage* image = ArAsAugmentedImage(ar_trackable.Get());
 
     ArTrackingState tracking_state;
-    ArTrackable_getTrackingState(ar_session_, ar_trackable, &tracking_state);
+    ArTrackable_getTrackingState(ar_session_, ar_trackable.Get(),
+                                 &tracking_state);
 
     int image_index;
     ArAugmentedImage_getIndex(ar_session_, image, &image_index);
@@ -420,8 +619,6 @@ bool HelloArApplication::DrawAugmentedImage(
         LOGI("Detected Image %d", image_index);
             break;
       case AR_TRACKING_STATE_TRACKING:
-        found_ar_image = true;
-
             if (augmented_image_map.find(image_index) ==
                 augmented_image_map.end()) {
               // Record the image and its anchor.
@@ -429,45 +626,44 @@ bool HelloArApplication::DrawAugmentedImage(
               ArAugmentedImage_getCenterPose(ar_session_, image,
                                              scopedArPose.GetArPose());
 
-              ArAnchor* image_anchor = nullptr;
+              util::ScopedArAnchor image_anchor;
               const ArStatus status = ArTrackable_acquireNewAnchor(
-                      ar_session_, ar_trackable, scopedArPose.GetArPose(),
-                      &image_anchor);
+                      ar_session_, ar_trackable.Get(), scopedArPose.GetArPose(),
+                      image_anchor.OutPtr());
               CHECK(status == AR_SUCCESS);
 
-              // Now we have an Anchor, record this image.
-              augmented_image_map[image_index] =
-                      std::pair<ArAugmentedImage*, ArAnchor*>(image, image_anchor);
+              // Now we have an Anchor, record this image. The record keeps
+              // the trackable reference acquired above.
+              AugmentedImageRecord& record = augmented_image_map[image_index];
+              record.image = std::move(ar_trackable);
+              record.anchor = std::move(image_anchor);
             }
             break;
 
-      case AR_TRACKING_STATE_STOPPED: {
-        std::pair<ArAugmentedImage*, ArAnchor*> record =
-                augmented_image_map[image_index];
-        ArTrackable_release(ArAsTrackable(record.first));
-        ArAnchor_release(record.second);
+      case AR_TRACKING_STATE_STOPPED:
+        // Erasing the record releases its trackable and anchor.
         augmented_image_map.erase(image_index);
-      } break;
+        break;
 
       default:
         break;
     }  // End of switch (tracking_state)
   }    // End of for (int i = 0; i < image_list_size; ++i) {
 
-  ArTrackableList_destroy(updated_image_list);
-  updated_image_list = nullptr;
+  updated_image_list.Reset();
 
   // Display all augmented images in augmented_image_map.
   for (const auto& it : augmented_image_map) {
-    const std::pair<ArAugmentedImage*, ArAnchor*>& record = it.second;
-    ArAugmentedImage* ar_image = record.first;
-    ArAnchor* ar_anchor = record.second;
+    const AugmentedImageRecord& record = it.second;
+    ArAugmentedImage* ar_image = ArAsAugmentedImage(record.image.Get());
+    ArAnchor* ar_anchor = record.anchor.Get();
     ArTrackingState tracking_state;
     ArTrackable_getTrackingState(ar_session_, ArAsTrackable(ar_image),
                                  &tracking_state);
 
     // Draw this image frame.
     if (tracking_state == AR_TRACKING_STATE_TRACKING) {
+      found_ar_image = true;
       // Use Index to get tint color.
       int index;
       ArAugmentedImage_getIndex(ar_session_, ar_image, &index);
@@ -479,7 +675,7 @@ bool HelloArApplication::DrawAugmentedImage(
               ((tint_color_hex & 0x0000FF00) >> 8) / 255.0f * kTintIntensity,
               kTintAlpha};
 
-      image_renderer_.Draw(projection_mat, view_mat, color_correction,
+      image_renderer_.Draw(transforms, light_environment,
                            tint_color_rgba, ar_session_, ar_image, ar_anchor);
     }
   }
@@ -487,19 +683,61 @@ bool HelloArApplication::DrawAugmentedImage(
   return found_ar_image;
 }
 
-bool HelloArApplication::IsDepthSupported() {
-  int32_t is_supported = 0;
-  ArSession_isDepthModeSupported(ar_session_, AR_DEPTH_MODE_AUTOMATIC,
-                                 &is_supported);
-  return is_supported;
+void HelloArApplication::ApplyPerformanceProfile(bool is_session_resumed) {
+  const PerformanceProfileSettings& profile =
+      GetPerformanceProfileSettings(performance_profile_);
+  util::ScopedArCameraConfig current_camera_config;
+  ArCameraConfig_create(ar_session_, current_camera_config.OutPtr());
+  ArSession_getCameraConfig(ar_session_, current_camera_config.Get());
+  util::ScopedArCameraConfig camera_config;
+  ArCameraConfig_create(ar_session_, camera_config.OutPtr());
+  if (!FindCameraConfig(ar_session_, profile, camera_config.Get())) {
+    LOGI("No camera config matches the profile, keeping the current one.");
+    ConfigureSession();
+    return;
+  }
+  if (IsSameCameraConfig(ar_session_, camera_config.Get(),
+                         current_camera_config.Get())) {
+    ConfigureSession();
+    return;
+  }
+
+  // The camera config can only change while the session is paused.
+  if (is_session_resumed) {
+    ArSession_pause(ar_session_);
+  }
+  if (ArSession_setCameraConfig(ar_session_, camera_config.Get()) ==
+      AR_SUCCESS) {
+    // ARCore may never resume tracking the anchors and trackables of the
+    // previous camera config on some devices, so they are dropped.
+    anchors_.Clear();
+    augmented_image_map.clear();
+    plane_ray_caster_.Clear();
+    plane_renderer_.ClearPlanes();
+    reticle_hit_valid_ = false;
+    scene_timestamp_ns_ = 0;
+  } else {
+    LOGE("HelloArApplication::ApplyPerformanceProfile camera config error");
+  }
+  ConfigureSession();
+  if (is_session_resumed) {
+    CHECK(ArSession_resume(ar_session_) == AR_SUCCESS);
+  }
 }
 
 void HelloArApplication::ConfigureSession() {
-  const bool is_depth_supported = IsDepthSupported();
+  const PerformanceProfileSettings& profile =
+      GetPerformanceProfileSettings(performance_profile_);
+  // Capabilities only change with the configuration, so they are queried
+  // here rather than every frame.
+  int32_t is_depth_supported = 0;
+  ArSession_isDepthModeSupported(ar_session_, AR_DEPTH_MODE_AUTOMATIC,
+                                 &is_depth_supported);
+  is_depth_supported_ = is_depth_supported != 0 && profile.use_depth;
 
   ArConfig* ar_config = nullptr;
   ArConfig_create(ar_session_, &ar_config);
-  if (is_depth_supported) {
+  if (is_depth_supported_) {
     ArConfig_setDepthMode(ar_session_, ar_config, AR_DEPTH_MODE_AUTOMATIC);
   } else {
     ArConfig_setDepthMode(ar_session_, ar_config, AR_DEPTH_MODE_DISABLED);
@@ -513,147 +751,307 @@ void HelloArApplication::ConfigureSession() {
                                      AR_INSTANT_PLACEMENT_MODE_DISABLED);
   }
   CHECK(ar_config);
-  CHECK(ArSession_configure(ar_session_, ar_config) == AR_SUCCESS);
+  ArConfig_setUpdateMode(ar_session_, ar_config, update_mode_);
+  ArConfig_setPlaneFindingMode(ar_session_, ar_config,
+                               profile.plane_finding_mode);
+  ArConfig_setAugmentedImageDatabase(ar_session_, ar_config,
+                                     ar_augmented_image_database_);
+  ArConfig_setFocusMode(ar_session_, ar_config, AR_FOCUS_MODE_AUTO);
+
+  // Not every configuration supports environmental HDR, for instance the
+  // front camera doesn't, so fall back to the ambient intensity estimate.
+  light_estimation_mode_ = profile.use_environmental_hdr
+                               ? AR_LIGHT_ESTIMATION_MODE_ENVIRONMENTAL_HDR
+                               : AR_LIGHT_ESTIMATION_MODE_AMBIENT_INTENSITY;
+  ArConfig_setLightEstimationMode(ar_session_, ar_config,
+                                  light_estimation_mode_);
+  ArStatus status = ArSession_configure(ar_session_, ar_config);
+  if (status != AR_SUCCESS &&
+      light_estimation_mode_ == AR_LIGHT_ESTIMATION_MODE_ENVIRONMENTAL_HDR) {
+    LOGI("Environmental HDR lighting unsupported, using ambient intensity.");
+    light_estimation_mode_ = AR_LIGHT_ESTIMATION_MODE_AMBIENT_INTENSITY;
+    ArConfig_setLightEstimationMode(ar_session_, ar_config,
+                                    light_estimation_mode_);
+    status = ArSession_configure(ar_session_, ar_config);
+  }
+  CHECK(status == AR_SUCCESS);
   ArConfig_destroy(ar_config);
+  frame_transform_cache_.Invalidate();
 }
 
 void HelloArApplication::OnSettingsChange(bool is_instant_placement_enabled) {
-  is_instant_placement_enabled_ = is_instant_placement_enabled;
+  render_thread_.Post([this, is_instant_placement_enabled] {
+    is_instant_placement_enabled_ = is_instant_placement_enabled;
+    if (ar_session_ != nullptr) {
+      ConfigureSession();
+    }
+  });
+}
 
-  if (ar_session_ != nullptr) {
-    ConfigureSession();
-  }
+void HelloArApplication::SetAnchorEvictionPolicy(AnchorEvictionPolicy policy) {
+  render_thread_.Post([this, policy] { anchors_.SetEvictionPolicy(policy); });
 }
 
-void HelloArApplication::OnTouched(float x, float y) {
-  if (ar_frame_ != nullptr && ar_session_ != nullptr) {
-    ArHitResultList* hit_result_list = nullptr;
-    ArHitResultList_create(ar_session_, &hit_result_list);
-    CHECK(hit_result_list);
-    if (is_instant_placement_enabled_) {
-      ArFrame_hitTestInstantPlacement(ar_session_, ar_frame_, x, y,
-                                      kApproximateDistanceMeters,
-                                      hit_result_list);
-    } else {
-      ArFrame_hitTest(ar_session_, ar_frame_, x, y, hit_result_list);
+void HelloArApplication::SetPerformanceProfile(PerformanceProfile profile) {
+  render_thread_.Post([this, profile] {
+    performance_profile_ = profile;
+    if (ar_session_ != nullptr) {
+      ApplyPerformanceProfile(/*is_session_resumed=*/true);
     }
+  });
+}
 
-    int32_t hit_result_list_size = 0;
-    ArHitResultList_getSize(ar_session_, hit_result_list,
-                            &hit_result_list_size);
+void HelloArApplication::SetRenderScale(float scale) {
+  render_thread_.Post([this, scale] { render_scale_ = scale; });
+}
 
-    // The hitTest method sorts the resulting list by distance from the camera,
-    // increasing.  The first hit result will usually be the most relevant when
-    // responding to user input.
+void HelloArApplication::SetUpdateMode(ArUpdateMode update_mode) {
+  render_thread_.Post([this, update_mode] {
+    update_mode_ = update_mode;
+    if (ar_session_ != nullptr) {
+      ConfigureSession();
+    }
+  });
+}
 
-    ArHitResult* ar_hit_result = nullptr;
-    for (int32_t i = 0; i < hit_result_list_size; ++i) {
-      ArHitResult* ar_hit = nullptr;
-      ArHitResult_create(ar_session_, &ar_hit);
-      ArHitResultList_getItem(ar_session_, hit_result_list, i, ar_hit);
+bool HelloArApplication::StartFrameRecording(const char* path) {
+  return frame_recorder_.Start(path);
+}
 
-      if (ar_hit == nullptr) {
-        LOGE("HelloArApplication::OnTouched ArHitResultList_getItem error");
-        return;
-      }
+void HelloArApplication::StopFrameRecording() { frame_recorder_.Stop(); }
 
-      ArTrackable* ar_trackable = nullptr;
-      ArHitResult_acquireTrackable(ar_session_, ar_hit, &ar_trackable);
-      ArTrackableType ar_trackable_type = AR_TRACKABLE_NOT_VALID;
-      ArTrackable_getType(ar_session_, ar_trackable, &ar_trackable_type);
-      // Creates an anchor if a plane or an oriented point was hit.
-      if (AR_TRACKABLE_PLANE == ar_trackable_type) {
-        ArPose* hit_pose = nullptr;
-        ArPose_create(ar_session_, nullptr, &hit_pose);
-        ArHitResult_getHitPose(ar_session_, ar_hit, hit_pose);
-        int32_t in_polygon = 0;
-        ArPlane* ar_plane = ArAsPlane(ar_trackable);
-        ArPlane_isPoseInPolygon(ar_session_, ar_plane, hit_pose, &in_polygon);
-
-        // Use hit pose and camera pose to check if hittest is from the
-        // back of the plane, if it is, no need to create the anchor.
-        ArPose* camera_pose = nullptr;
-        ArPose_create(ar_session_, nullptr, &camera_pose);
-        ArCamera* ar_camera;
-        ArFrame_acquireCamera(ar_session_, ar_frame_, &ar_camera);
-        ArCamera_getPose(ar_session_, ar_camera, camera_pose);
-        ArCamera_release(ar_camera);
-        float normal_distance_to_plane = util::CalculateDistanceToPlane(
-            *ar_session_, *hit_pose, *camera_pose);
-
-        ArPose_destroy(hit_pose);
-        ArPose_destroy(camera_pose);
-
-        if (!in_polygon || normal_distance_to_plane < 0) {
-          continue;
-        }
+int32_t HelloArApplication::HitTestBatch(HitTestInput input,
+                                         const float* coordinates,
+                                         int32_t count, float* out_results) {
+  if (ar_session_ == nullptr || ar_frame_ == nullptr) {
+    return 0;
+  }
+  TRACE_SCOPE("HitTestBatch");
+  return hit_tester_.HitTestBatch(ar_session_, ar_frame_, input, coordinates,
+                                  count, out_results);
+}
+
+bool HelloArApplication::RegisterStatusBuffer(void* address,
+                                              int64_t capacity) {
+  return status_block_.Attach(address, capacity);
+}
 
-        ar_hit_result = ar_hit;
+void HelloArApplication::PublishStatus(ArTrackingState camera_tracking_state,
+                                       int64_t frame_begin_ns) {
+  AppStatus status = {};
+  status.plane_count = plane_count_;
+  status.tracking_state = camera_tracking_state;
+  status.is_depth_supported = is_depth_supported_ ? 1 : 0;
+  status.anchor_count = anchors_.GetSize();
+  ArFrame_getTimestamp(ar_session_, ar_frame_, &status.frame_timestamp_ns);
+  status.frame_time_ns = NowNs() - frame_begin_ns;
+  status.reticle_hit = reticle_hit_valid_ ? 1 : 0;
+  if (reticle_hit_valid_) {
+    status.reticle_position[0] = reticle_hit_.position.x;
+    status.reticle_position[1] = reticle_hit_.position.y;
+    status.reticle_position[2] = reticle_hit_.position.z;
+  }
+  status_block_.Publish(status);
+}
+
+void HelloArApplication::OnTouched(float x, float y) {
+  if (!touch_queue_.Push({TouchEvent::Type::kTap, x, y})) {
+    LOGE("HelloArApplication::OnTouched touch queue full, tap dropped");
+  }
+  frame_scheduler_.RequestFrame();
+}
+
+void HelloArApplication::OnPressed(float x, float y) {
+  if (!touch_queue_.Push({TouchEvent::Type::kPress, x, y})) {
+    LOGE("HelloArApplication::OnPressed touch queue full, press dropped");
+  }
+  frame_scheduler_.RequestFrame();
+}
+
+void HelloArApplication::OnReleased(float x, float y) {
+  if (!touch_queue_.Push({TouchEvent::Type::kRelease, x, y})) {
+    LOGE("HelloArApplication::OnReleased touch queue full, release dropped");
+  }
+  frame_scheduler_.RequestFrame();
+}
+
+void HelloArApplication::OnDragged(float x, float y) {
+  // Dropped drag samples are superseded by the next one anyway.
+  touch_queue_.Push({TouchEvent::Type::kDrag, x, y});
+  frame_scheduler_.RequestFrame();
+}
+
+void HelloArApplication::ProcessTouches() {
+  TRACE_SCOPE("ProcessTouches");
+#ifdef HELLOAR_ARCORE_REPLAY
+  // Deliver the touches that were handled with this frame when it was
+  // recorded. Live input is ignored so the replay stays deterministic.
+  for (const LoggedTouch& touch : replay::GetFrameTouches(ar_session_)) {
+    HandleTap(touch.x, touch.y);
+  }
+  touch_queue_.Drain(&touch_events_);
+#else
+  touch_queue_.Drain(&touch_events_);
+  for (const TouchEvent& touch : touch_events_) {
+    switch (touch.type) {
+      case TouchEvent::Type::kTap:
+        HandleTap(touch.x, touch.y);
+        break;
+      case TouchEvent::Type::kPress:
+        dragged_anchor_ = PickAnchor(touch.x, touch.y);
+        has_drag_model_mat_ = false;
         break;
-      } else if (AR_TRACKABLE_POINT == ar_trackable_type) {
-        ArPoint* ar_point = ArAsPoint(ar_trackable);
-        ArPointOrientationMode mode;
-        ArPoint_getOrientationMode(ar_session_, ar_point, &mode);
-        if (AR_POINT_ORIENTATION_ESTIMATED_SURFACE_NORMAL == mode) {
-          ar_hit_result = ar_hit;
-          break;
+      case TouchEvent::Type::kDrag:
+        // Drag samples arrive collapsed, so this is one hit test per frame.
+        if (anchors_.Get(dragged_anchor_) != nullptr) {
+          UpdateDrag(touch.x, touch.y);
         }
-      } else if (AR_TRACKABLE_INSTANT_PLACEMENT_POINT == ar_trackable_type) {
-        ar_hit_result = ar_hit;
-      }
+        break;
+      case TouchEvent::Type::kRelease:
+        if (anchors_.Get(dragged_anchor_) != nullptr) {
+          EndDrag(touch.x, touch.y);
+        }
+        break;
     }
+  }
+#endif  // HELLOAR_ARCORE_REPLAY
+}
 
-    if (ar_hit_result) {
-      // Note that the application is responsible for releasing the anchor
-      // pointer after using it. Call ArAnchor_release(anchor) to release.
-      ArAnchor* anchor = nullptr;
-      if (ArHitResult_acquireNewAnchor(ar_session_, ar_hit_result, &anchor) !=
-          AR_SUCCESS) {
-        LOGE(
-            "HelloArApplication::OnTouched ArHitResult_acquireNewAnchor error");
-        return;
-      }
+AnchorHandle HelloArApplication::PickAnchor(float x, float y) const {
+  const MeshBvh& mesh_bvh = andy_renderer_.GetMeshBvh();
+  if (!frame_transform_cache_.HasTransforms() || mesh_bvh.IsEmpty()) {
+    return AnchorHandle();
+  }
+  TRACE_SCOPE("PickAnchor");
+  glm::vec3 origin;
+  glm::vec3 direction;
+  const FrameTransforms& transforms = frame_transform_cache_.GetTransforms();
+  util::GetScreenPointRay(transforms.view_mat, transforms.projection_mat,
+                          width_, height_, x, y, &origin, &direction);
+
+  float nearest_distance = std::numeric_limits<float>::max();
+  AnchorHandle picked_anchor;
+  anchors_.ForEach([&](AnchorHandle handle,
+                       const ColoredAnchor& colored_anchor) {
+    float distance = 0.f;
+    if (colored_anchor.was_drawn &&
+        mesh_bvh.IntersectInstance(colored_anchor.model_mat, origin,
+                                   direction, nearest_distance, &distance)) {
+      nearest_distance = distance;
+      picked_anchor = handle;
+    }
+  });
+  return picked_anchor;
+}
 
-      ArTrackingState tracking_state = AR_TRACKING_STATE_STOPPED;
-      ArAnchor_getTrackingState(ar_session_, anchor, &tracking_state);
-      if (tracking_state != AR_TRACKING_STATE_TRACKING) {
-        ArAnchor_release(anchor);
-        return;
-      }
+void HelloArApplication::UpdateDrag(float x, float y) {
+  const ArHitResult* ar_hit_result = hit_tester_.HitTestScreenPoint(
+      ar_session_, ar_frame_, x, y, /*instant_placement_distance_meters=*/0.f);
+  if (ar_hit_result == nullptr) {
+    return;
+  }
+  util::ScopedArPose hit_pose(ar_session_);
+  ArHitResult_getHitPose(ar_session_, ar_hit_result, hit_pose.GetArPose());
+  ArPose_getMatrix(ar_session_, hit_pose.GetArPose(),
+                   glm::value_ptr(drag_model_mat_));
+  has_drag_model_mat_ = true;
+}
 
-      if (anchors_.size() >= kMaxNumberOfAndroidsToRender) {
-        ArAnchor_release(anchors_[0].anchor);
-        ArTrackable_release(anchors_[0].trackable);
-        anchors_.erase(anchors_.begin());
-      }
+void HelloArApplication::EndDrag(float x, float y) {
+  if (has_drag_model_mat_) {
+    ArHitResult* ar_hit_result = hit_tester_.HitTestScreenPoint(
+        ar_session_, ar_frame_, x, y,
+        /*instant_placement_distance_meters=*/0.f);
+    ColoredAnchor moved_anchor;
+    if (ar_hit_result != nullptr &&
+        AcquireColoredAnchor(ar_hit_result, &moved_anchor)) {
+      glm::mat4 anchor_mat;
+      util::GetTransformMatrixFromAnchor(*moved_anchor.anchor.Get(),
+                                         ar_session_, &anchor_mat);
+      // Like a tapped model, the moved one stays pickable and drawn at its
+      // new place even if the next frames repeat this camera image.
+      moved_anchor.was_drawn = true;
+      moved_anchor.model_mat = anchor_mat;
+      // Releasing the old anchor doesn't stop ARCore tracking it.
+      ColoredAnchor* colored_anchor = anchors_.Get(dragged_anchor_);
+      ArAnchor_detach(ar_session_, colored_anchor->anchor.Get());
+      anchors_.UpdatePosition(dragged_anchor_, glm::vec3(anchor_mat[3]));
+      *colored_anchor = std::move(moved_anchor);
+    }
+  }
+  dragged_anchor_ = AnchorHandle();
+  has_drag_model_mat_ = false;
+}
 
-      ArTrackable* ar_trackable = nullptr;
-      ArHitResult_acquireTrackable(ar_session_, ar_hit_result, &ar_trackable);
-      // Assign a color to the object for rendering based on the trackable type
-      // this anchor attached to. For AR_TRACKABLE_POINT, it's blue color, and
-      // for AR_TRACKABLE_PLANE, it's green color.
-      ColoredAnchor colored_anchor;
-      colored_anchor.anchor = anchor;
-      colored_anchor.trackable = ar_trackable;
+bool HelloArApplication::AcquireColoredAnchor(
+    ArHitResult* ar_hit_result, ColoredAnchor* out_colored_anchor) {
+  // The anchor and trackable are owned by the ColoredAnchor and released
+  // when it is removed from anchors_ or the application is destroyed.
+  util::ScopedArAnchor anchor;
+  if (ArHitResult_acquireNewAnchor(ar_session_, ar_hit_result,
+                                   anchor.OutPtr()) != AR_SUCCESS) {
+    LOGE("HelloArApplication::AcquireColoredAnchor "
+         "ArHitResult_acquireNewAnchor error");
+    return false;
+  }
 
-      UpdateAnchorColor(&colored_anchor);
-      anchors_.push_back(colored_anchor);
+  ArTrackingState tracking_state = AR_TRACKING_STATE_STOPPED;
+  ArAnchor_getTrackingState(ar_session_, anchor.Get(), &tracking_state);
+  if (tracking_state != AR_TRACKING_STATE_TRACKING) {
+    return false;
+  }
 
-      ArHitResult_destroy(ar_hit_result);
-      ar_hit_result = nullptr;
+  // Assign a color to the object for rendering based on the trackable type
+  // this anchor attached to. For AR_TRACKABLE_POINT, it's blue color, and
+  // for AR_TRACKABLE_PLANE, it's green color.
+  out_colored_anchor->anchor = std::move(anchor);
+  ArHitResult_acquireTrackable(ar_session_, ar_hit_result,
+                               out_colored_anchor->trackable.OutPtr());
+  ArTrackable_getType(ar_session_, out_colored_anchor->trackable.Get(),
+                      &out_colored_anchor->trackable_type);
+  UpdateAnchorColor(out_colored_anchor);
+  has_approximate_anchors_ |= out_colored_anchor->awaits_full_tracking;
+  return true;
+}
 
-      ArHitResultList_destroy(hit_result_list);
-      hit_result_list = nullptr;
-    }
+void HelloArApplication::HandleTap(float x, float y) {
+  if (ar_frame_ == nullptr || ar_session_ == nullptr) {
+    return;
+  }
+  frame_recorder_.AddTouch(x, y);
+  // Taps on a placed model select it rather than placing another one.
+  if (PickAnchor(x, y).IsValid()) {
+    return;
+  }
+  ArHitResult* ar_hit_result = hit_tester_.HitTestScreenPoint(
+      ar_session_, ar_frame_, x, y,
+      is_instant_placement_enabled_ ? kApproximateDistanceMeters : 0.f);
+
+  ColoredAnchor colored_anchor;
+  if (ar_hit_result == nullptr ||
+      !AcquireColoredAnchor(ar_hit_result, &colored_anchor)) {
+    return;
   }
+  glm::mat4 anchor_mat;
+  util::GetTransformMatrixFromAnchor(*colored_anchor.anchor.Get(), ar_session_,
+                                     &anchor_mat);
+  // The anchor is tracking, so it is drawn even if the next frames repeat
+  // this camera image.
+  colored_anchor.was_drawn = true;
+  colored_anchor.model_mat = anchor_mat;
+  // The store evicts a model by its policy when full. A dragged model that is
+  // evicted leaves dragged_anchor_ stale, which ends the drag.
+  const glm::mat4 camera_mat =
+      glm::inverse(frame_transform_cache_.GetTransforms().view_mat);
+  anchors_.Insert(std::move(colored_anchor), glm::vec3(anchor_mat[3]),
+                  glm::vec3(camera_mat[3]));
 }
 
 void HelloArApplication::UpdateAnchorColor(ColoredAnchor* colored_anchor) {
-  ArTrackable* ar_trackable = colored_anchor->trackable;
+  ArTrackable* ar_trackable = colored_anchor->trackable.Get();
   float* color = colored_anchor->color;
-
-  ArTrackableType ar_trackable_type;
-  ArTrackable_getType(ar_session_, ar_trackable, &ar_trackable_type);
+  const ArTrackableType ar_trackable_type = colored_anchor->trackable_type;
+  colored_anchor->awaits_full_tracking = false;
 
   if (ar_trackable_type == AR_TRACKABLE_POINT) {
     SetColor(66.0f, 133.0f, 244.0f, 255.0f, color);
@@ -679,6 +1077,7 @@ void HelloArApplication::UpdateAnchorColor(ColoredAnchor* colored_anchor) {
         tracking_method ==
         AR_INSTANT_PLACEMENT_POINT_TRACKING_METHOD_SCREENSPACE_WITH_APPROXIMATE_DISTANCE) {  // NOLINT
       SetColor(255.0f, 255.0f, 255.0f, 255.0f, color);
+      colored_anchor->awaits_full_tracking = true;
       return;
     }
   }
@@ -687,33 +1086,39 @@ void HelloArApplication::UpdateAnchorColor(ColoredAnchor* colored_anchor) {
   SetColor(0.0f, 0.0f, 0.0f, 0.0f, color);
 }
 
-// This method returns a transformation matrix that when applied to screen space
-// uvs makes them match correctly with the quad texture coords used to render
-// the camera feed. It takes into account device orientation.
-glm::mat3 HelloArApplication::GetTextureTransformMatrix(
-    const ArSession* session, const ArFrame* frame) {
-  float frameTransform[6];
-  float uvTransform[9];
-  // XY pairs of coordinates in NDC space that constitute the origin and points
-  // along the two principal axes.
-  const float ndcBasis[6] = {0, 0, 1, 0, 0, 1};
-  ArFrame_transformCoordinates2d(
-      session, frame, AR_COORDINATES_2D_OPENGL_NORMALIZED_DEVICE_COORDINATES, 3,
-      ndcBasis, AR_COORDINATES_2D_TEXTURE_NORMALIZED, frameTransform);
-
-  // Convert the transformed points into an affine transform and transpose it.
-  float ndcOriginX = frameTransform[0];
-  float ndcOriginY = frameTransform[1];
-  uvTransform[0] = frameTransform[2] - ndcOriginX;
-  uvTransform[1] = frameTransform[3] - ndcOriginY;
-  uvTransform[2] = 0;
-  uvTransform[3] = frameTransform[4] - ndcOriginX;
-  uvTransform[4] = frameTransform[5] - ndcOriginY;
-  uvTransform[5] = 0;
-  uvTransform[6] = ndcOriginX;
-  uvTransform[7] = ndcOriginY;
-  uvTransform[8] = 1;
-
-  return glm::make_mat3(uvTransform);
+void HelloArApplication::UpdateInstantPlacementColors() {
+  if (!has_approximate_anchors_) {
+    return;
+  }
+  util::ScopedArTrackableList updated_point_list;
+  ArTrackableList_create(ar_session_, updated_point_list.OutPtr());
+  CHECK(updated_point_list);
+  ArFrame_getUpdatedTrackables(ar_session_, ar_frame_,
+                               AR_TRACKABLE_INSTANT_PLACEMENT_POINT,
+                               updated_point_list.Get());
+  int32_t point_list_size = 0;
+  ArTrackableList_getSize(ar_session_, updated_point_list.Get(),
+                          &point_list_size);
+  if (point_list_size == 0) {
+    return;
+  }
+
+  // Every acquired reference to a trackable is the same ArTrackable, so the
+  // updated points can be matched to the anchors' trackables by address.
+  for (int32_t i = 0; i < point_list_size; ++i) {
+    util::ScopedArTrackable ar_trackable;
+    ArTrackableList_acquireItem(ar_session_, updated_point_list.Get(), i,
+                                ar_trackable.OutPtr());
+    anchors_.ForEach([&](AnchorHandle, ColoredAnchor& colored_anchor) {
+      if (colored_anchor.awaits_full_tracking &&
+          colored_anchor.trackable.Get() == ar_trackable.Get()) {
+        UpdateAnchorColor(&colored_anchor);
+      }
+    });
+  }
+  has_approximate_anchors_ = false;
+  anchors_.ForEach([&](AnchorHandle, const ColoredAnchor& colored_anchor) {
+    has_approximate_anchors_ |= colored_anchor.awaits_full_tracking;
+  });
 }
 }  // namespace hello_ar
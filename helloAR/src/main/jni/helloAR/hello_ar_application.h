@@ -20,21 +20,42 @@
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 #include <android/asset_manager.h>
+#include <android/native_window.h>
 #include <jni.h>
 
+#include <atomic>
+#include <functional>
 #include <memory>
 #include <set>
 #include <string>
 #include <unordered_map>
+#include <utility>
 
 #include "arcore_c_api.h"
+#include "anchor_store.h"
 #include "background_renderer.h"
 #include "augmented_image_renderer.h"
+#include "frame_recorder.h"
+#include "frame_scheduler.h"
+#include "frame_transforms.h"
 #include "glm.h"
+#include "hit_tester.h"
+#include "job_system.h"
+#include "light_estimator.h"
 #include "obj_renderer.h"
+#include "performance_profile.h"
+#include "plane_polygon.h"
+#include "plane_ray_caster.h"
 #include "plane_renderer.h"
 #include "point_cloud_renderer.h"
+#include "quality_governor.h"
+#include "render_thread.h"
+#include "scaled_render_target.h"
+#include "scoped_ar_handle.h"
+#include "status_block.h"
 #include "texture.h"
+#include "touch_queue.h"
+#include "upload_thread.h"
 #include "util.h"
 
 namespace hello_ar {
@@ -52,83 +73,328 @@ class HelloArApplication {
   // OnResume is called on the UI thread from the Activity's onResume method.
   void OnResume(void* env, void* context, void* activity);
 
-  // OnSurfaceCreated is called on the OpenGL thread when GLSurfaceView
+  // OnSurfaceCreated is called on the render thread when its OpenGL context
   // is created.
   void OnSurfaceCreated();
 
-  // OnDisplayGeometryChanged is called on the OpenGL thread when the
-  // render surface size or display rotation changes.
+  // OnDisplayGeometryChanged is called on the render thread when the
+  // window size or display rotation changes.
   //
   // @param display_rotation: current display rotation.
   // @param width: width of the changed surface view.
   // @param height: height of the changed surface view.
   void OnDisplayGeometryChanged(int display_rotation, int width, int height);
 
-  // OnDrawFrame is called on the OpenGL thread to render the next frame.
+  // OnDrawFrame is called on the render thread to render the next frame.
   void OnDrawFrame(bool depthColorVisualizationEnabled,
                    bool useDepthForOcclusion);
 
-  // OnTouched is called on the OpenGL thread after the user touches the screen.
+  // SetWindow is called on the UI thread from the SurfaceHolder callbacks to
+  // render into window on the application's own render thread rather than
+  // from a GLSurfaceView. That thread calls OnSurfaceCreated and OnDrawFrame
+  // itself, draws the frames OnVsync picks and is paused with the session.
+  // Pass nullptr when the surface is destroyed: returns once the window is
+  // no longer used.
+  void SetWindow(ANativeWindow* window) { render_thread_.SetWindow(window); }
+
+  // OnWindowGeometryChanged is called on the UI thread when the window size
+  // or display rotation changes. Applied with OnDisplayGeometryChanged on the
+  // render thread before its next frame.
+  void OnWindowGeometryChanged(int display_rotation, int width, int height);
+
+  // Runs task on the render thread before its next frame, for the calls made
+  // on the render thread. Safe to call from any thread.
+  void QueueEvent(std::function<void()> task) {
+    render_thread_.Post(std::move(task));
+  }
+
+  // Bounds the frames the render thread submits ahead of the GPU, see
+  // RenderThread. 1 for the lowest latency. Safe to call from any thread.
+  void SetMaxFramesInFlight(int32_t count) {
+    render_thread_.SetMaxFramesInFlight(count);
+  }
+
+  // The OnDrawFrame arguments of the frames the render thread draws. Safe to
+  // call from any thread.
+  void SetDepthRendering(bool depth_color_visualization_enabled,
+                         bool use_depth_for_occlusion) {
+    depth_color_visualization_enabled_ = depth_color_visualization_enabled;
+    use_depth_for_occlusion_ = use_depth_for_occlusion;
+  }
+
+  // OnVsync is called on the UI thread for every display vsync when the view
+  // renders on demand. Requests a frame from the render thread, if there is
+  // one, for the vsyncs it picks.
+  // @param vsync_ns: choreographer frame time of the vsync.
+  // @return true if a frame should be rendered for this vsync.
+  bool OnVsync(int64_t vsync_ns);
+
+  // Paces on demand rendering to frames_per_second, or to the camera with
+  // FrameScheduler::kCameraFrameRate. Safe to call from any thread.
+  void SetTargetFrameRate(int32_t frames_per_second) {
+    frame_scheduler_.SetTargetFrameRate(frames_per_second);
+  }
+
+  // While animating, frames are rendered up to the display rate even without
+  // new camera images. Safe to call from any thread.
+  void SetAnimating(bool animating) {
+    frame_scheduler_.SetAnimating(animating);
+  }
+
+  // OnTouched is called on the UI thread after the user taps the screen. The
+  // tap is queued and hit tested against the next frame on the render thread.
   // @param x: x position on the screen (pixels).
   // @param y: y position on the screen (pixels).
   void OnTouched(float x, float y);
 
+  // OnPressed is called on the UI thread when a finger goes down. A placed
+  // model under the finger is picked up and follows the drag.
+  // @param x: x position on the screen (pixels).
+  // @param y: y position on the screen (pixels).
+  void OnPressed(float x, float y);
+
+  // OnDragged is called on the UI thread for every move of a finger on the
+  // screen. Samples queued within a frame are collapsed to the latest one.
+  // @param x: x position on the screen (pixels).
+  // @param y: y position on the screen (pixels).
+  void OnDragged(float x, float y);
+
+  // OnReleased is called on the UI thread when the finger is lifted. A
+  // dragged model is anchored where it was dropped.
+  // @param x: x position on the screen (pixels).
+  // @param y: y position on the screen (pixels).
+  void OnReleased(float x, float y);
+
   // Returns true if any planes have been detected.  Used for hiding the
   // "searching for planes" snackbar.
   bool HasDetectedPlanes() const { return plane_count_ > 0; }
 
-  // Returns true if depth is supported.
-  bool IsDepthSupported();
+  // Returns true if depth is supported. Determined when the session is
+  // configured.
+  bool IsDepthSupported() const { return is_depth_supported_; }
 
+  // Enables or disables instant placement and reconfigures the session on the
+  // render thread before its next frame. Safe to call from any thread.
   void OnSettingsChange(bool is_instant_placement_enabled);
 
+  // Selects which placed model is removed when placing one more would exceed
+  // the limit. Applied on the render thread before its next frame. Safe to
+  // call from any thread.
+  void SetAnchorEvictionPolicy(AnchorEvictionPolicy policy);
+
+  // Switches to the camera config, ARCore features and rendering quality of
+  // profile with a single session configuration. Pauses the session while
+  // the camera config changes, which drops the placed models. Applied on the
+  // render thread before its next frame. Safe to call from any thread.
+  void SetPerformanceProfile(PerformanceProfile profile);
+
+  // Draws the virtual content at scale times the surface resolution, clamped
+  // to [ScaledRenderTarget::kMinScale, 1], and composites it over the full
+  // resolution camera image. The quality governor may lower the scale
+  // further. Applied on the render thread before its next frame. Safe to
+  // call from any thread.
+  void SetRenderScale(float scale);
+
+  // Passes on the device's thermal status, which caps the rendering quality
+  // the governor may choose. Safe to call from any thread.
+  void SetThermalStatus(ThermalStatus status) {
+    quality_governor_.SetThermalStatus(status);
+  }
+
+  // Selects whether ArSession_update waits for a new camera image or returns
+  // the last one right away, reconfiguring the session if it is running.
+  // Frames that repeat the last camera image redraw the scene cached for it.
+  // Applied on the render thread before its next frame. Safe to call from
+  // any thread.
+  void SetUpdateMode(ArUpdateMode update_mode);
+
+  // Starts logging every frame and touch to the file at path, replacing any
+  // recording in progress. The log can be replayed with the ARCore replay
+  // backend, see arcore_replay.h.
+  // @return false if the file could not be created.
+  bool StartFrameRecording(const char* path);
+
+  // Stops the recording in progress, if any.
+  void StopFrameRecording();
+
+  // Hit tests count screen points or rays against the current frame in one
+  // pass, writing kHitTestResultFloats floats per input to out_results. See
+  // hit_tester.h for the layouts. Called on the render thread between frames,
+  // from a QueueEvent task.
+  // @return the number of inputs that hit something.
+  int32_t HitTestBatch(HitTestInput input, const float* coordinates,
+                       int32_t count, float* out_results);
+
+  // Publishes an AppStatus snapshot into the capacity bytes at address after
+  // every frame. The buffer must stay valid for the application's lifetime.
+  // @return false if the buffer is too small or misaligned.
+  bool RegisterStatusBuffer(void* address, int64_t capacity);
+
  private:
   ArAugmentedImageDatabase* CreateAugmentedImageDatabase() const;
-  // Draws frame on an AugmentedImage.
+  // Draws frame on an AugmentedImage. Images that started or stopped
+  // tracking are only looked for when scan_updates is true.
   // @return true if there is an AugmentedImage, false otherwise.
-  bool DrawAugmentedImage(const glm::mat4& view_mat,
-                          const glm::mat4& projection_mat,
-                          const float* color_correction);
+  bool DrawAugmentedImage(const FrameTransforms& transforms,
+                          const LightEnvironment& light_environment,
+                          bool scan_updates);
+
+  // Handles the touches queued since the last frame. Called on the OpenGL
+  // thread right after ArSession_update.
+  void ProcessTouches();
+
+  // Hit tests a tap against the current frame and places an anchor at the
+  // first suitable hit, unless the tap lands on a placed model.
+  void HandleTap(float x, float y);
+
+  // Returns the handle of the nearest model drawn last frame under the screen
+  // point, or an invalid handle. Uses the camera of the last drawn frame,
+  // which is what the user saw when touching, and makes no ARCore calls.
+  AnchorHandle PickAnchor(float x, float y) const;
+
+  // Moves the dragged model to the surface under the screen point.
+  void UpdateDrag(float x, float y);
+
+  // Anchors the dragged model at the surface under the screen point and ends
+  // the drag. The model stays where it was if nothing is hit.
+  void EndDrag(float x, float y);
 
-  glm::mat3 GetTextureTransformMatrix(const ArSession* session,
-                                      const ArFrame* frame);
   ArSession* ar_session_ = nullptr;
   ArFrame* ar_frame_ = nullptr;
 
   bool install_requested_ = false;
-  bool calculate_uv_transform_ = false;
   int width_ = 1;
   int height_ = 1;
   int display_rotation_ = 0;
   bool is_instant_placement_enabled_ = true;
+  bool is_depth_supported_ = false;
+  // Environmental HDR where the session supports it, ambient intensity
+  // otherwise. Chosen when the session is configured.
+  ArLightEstimationMode light_estimation_mode_ =
+      AR_LIGHT_ESTIMATION_MODE_AMBIENT_INTENSITY;
+  ArUpdateMode update_mode_ = AR_UPDATE_MODE_BLOCKING;
+  float render_scale_ = 1.0f;
+  PerformanceProfile performance_profile_ = PerformanceProfile::kBalanced;
+  // Created with the session and set by every configuration.
+  ArAugmentedImageDatabase* ar_augmented_image_database_ = nullptr;
+  // Timestamp of the camera image the planes, point cloud and anchor poses
+  // held by the renderers and anchors were read from, 0 before the first.
+  int64_t scene_timestamp_ns_ = 0;
 
   AAssetManager* const asset_manager_;
 
-  // Stores the randomly-selected color each plane is drawn with
-  std::unordered_map<int32_t, std::pair<ArAugmentedImage*, ArAnchor*>>
-          augmented_image_map;
+  // A tracked augmented image and the anchor created at its center.
+  struct AugmentedImageRecord {
+    util::ScopedArTrackable image;
+    util::ScopedArAnchor anchor;
+  };
+
+  // Stores the tracked augmented images, keyed by database index.
+  std::unordered_map<int32_t, AugmentedImageRecord> augmented_image_map;
 
   // The anchors at which we are drawing android models using given colors.
   struct ColoredAnchor {
-    ArAnchor* anchor;
-    ArTrackable* trackable;
+    util::ScopedArAnchor anchor;
+    util::ScopedArTrackable trackable;
     float color[4];
+    // Where the model was drawn last frame, for picking.
+    bool was_drawn = false;
+    glm::mat4 model_mat = glm::mat4(1.0f);
+    // Type of the trackable, read once when the anchor is created.
+    ArTrackableType trackable_type = AR_TRACKABLE_NOT_VALID;
+    // True while the trackable is an instant placement point at an
+    // approximate distance, the only case in which the color can change.
+    bool awaits_full_tracking = false;
   };
 
-  std::vector<ColoredAnchor> anchors_;
+  // Creates an anchor at the hit and stores it with its trackable and color.
+  // @return false if the anchor could not be created or is not tracking.
+  bool AcquireColoredAnchor(ArHitResult* ar_hit_result,
+                            ColoredAnchor* out_colored_anchor);
+
+  AnchorStore<ColoredAnchor> anchors_;
+  // A model to draw this frame and its squared distance to the camera.
+  struct AnchorDraw {
+    float distance_squared;
+    AnchorHandle handle;
+    ColoredAnchor* colored_anchor;
+  };
+  // Reused every frame.
+  std::vector<AnchorDraw> anchor_draws_;
+  // Whether any anchor awaited full tracking when last checked. May stay
+  // true for a frame after that anchor is removed.
+  bool has_approximate_anchors_ = false;
+
+  // Camera of the current frame once it is read, and until then of the last
+  // drawn frame.
+  FrameTransformCache frame_transform_cache_;
+
+  // The model being dragged, or an invalid handle. Goes stale by itself if
+  // the model is evicted mid-drag.
+  AnchorHandle dragged_anchor_;
+  // Where the dragged model is drawn until it is anchored again.
+  bool has_drag_model_mat_ = false;
+  glm::mat4 drag_model_mat_ = glm::mat4(1.0f);
 
   PointCloudRenderer point_cloud_renderer_;
   BackgroundRenderer background_renderer_;
   AugmentedImageRenderer image_renderer_;
   PlaneRenderer plane_renderer_;
   ObjRenderer andy_renderer_;
+  ScaledRenderTarget render_target_;
   Texture depth_texture_;
+  LightEstimator light_estimator_;
 
   int32_t plane_count_ = 0;
 
+  // Runs the CPU stages of a frame that need no ARCore or GL calls.
+  JobSystem job_system_;
+  // Tracked, not subsumed planes of the current frame as read from ARCore.
+  // Entries beyond the current planes are kept for their storage.
+  std::vector<PlanePolygon> plane_polygons_;
+  // Tracked planes of the current frame, for CPU ray casts.
+  PlaneRayCaster plane_ray_caster_;
+  // Where the ray through the screen center meets a plane, if anywhere.
+  bool reticle_hit_valid_ = false;
+  PlaneRayHit reticle_hit_;
+
+  FrameRecorder frame_recorder_;
+  FrameScheduler frame_scheduler_;
+  QualityGovernor quality_governor_;
+  TouchQueue touch_queue_;
+  HitTester hit_tester_;
+  // Touches drained from touch_queue_, reused every frame.
+  std::vector<TouchEvent> touch_events_;
+  StatusBlock status_block_;
+
+  std::atomic<bool> depth_color_visualization_enabled_{false};
+  std::atomic<bool> use_depth_for_occlusion_{false};
+  // Loads the model off the render thread.
+  UploadThread upload_thread_;
+  // Draws into the window given to SetWindow. Stopped first when the
+  // application is destroyed, as its frames use the members above.
+  RenderThread render_thread_;
+
+#ifdef HELLOAR_TRACK_AR_HANDLES
+  // Frames rendered while tracking, used to pace the handle count reports.
+  int64_t tracked_frame_count_ = 0;
+#endif  // HELLOAR_TRACK_AR_HANDLES
+
+  // Selects the camera config of the current profile, pausing the session
+  // around the change if it is resumed, then configures the session.
+  void ApplyPerformanceProfile(bool is_session_resumed);
+
   void ConfigureSession();
 
+  // Publishes the status of the frame that began at frame_begin_ns.
+  void PublishStatus(ArTrackingState camera_tracking_state,
+                     int64_t frame_begin_ns);
+
   void UpdateAnchorColor(ColoredAnchor* colored_anchor);
+
+  // Recolors the anchors whose instant placement point ARCore reported
+  // updated this frame. Does nothing unless an anchor awaits full tracking.
+  void UpdateInstantPlacementColors();
 };
 }  // namespace hello_ar
 
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "hit_tester.h"
+
+namespace hello_ar {
+namespace {
+
+HitTestTrackable ToHitTestTrackable(ArTrackableType type) {
+  switch (type) {
+    case AR_TRACKABLE_NOT_VALID:
+      return HitTestTrackable::kNone;
+    case AR_TRACKABLE_PLANE:
+      return HitTestTrackable::kPlane;
+    case AR_TRACKABLE_POINT:
+      return HitTestTrackable::kPoint;
+    case AR_TRACKABLE_INSTANT_PLACEMENT_POINT:
+      return HitTestTrackable::kInstantPlacementPoint;
+    default:
+      return HitTestTrackable::kOther;
+  }
+}
+
+}  // namespace
+
+ArHitResult* HitTester::HitTestScreenPoint(
+    ArSession* session, const ArFrame* frame, float x, float y,
+    float instant_placement_distance_meters) {
+  Prepare(session, frame);
+  if (instant_placement_distance_meters > 0.f) {
+    ArFrame_hitTestInstantPlacement(session, frame, x, y,
+                                    instant_placement_distance_meters,
+                                    hit_result_list_.Get());
+  } else {
+    ArFrame_hitTest(session, frame, x, y, hit_result_list_.Get());
+  }
+  return SelectHit(session);
+}
+
+int32_t HitTester::HitTestBatch(ArSession* session, const ArFrame* frame,
+                                HitTestInput input, const float* coordinates,
+                                int32_t count, float* out_results) {
+  Prepare(session, frame);
+  int32_t hit_count = 0;
+  for (int32_t i = 0; i < count; ++i) {
+    if (input == HitTestInput::kRay) {
+      const float* ray = coordinates + i * kHitTestRayFloats;
+      test_origin_ = glm::vec3(ray[0], ray[1], ray[2]);
+      ArFrame_hitTestRay(session, frame, ray, ray + 3,
+                         hit_result_list_.Get());
+    } else {
+      const float* point = coordinates + i * kHitTestScreenPointFloats;
+      ArFrame_hitTest(session, frame, point[0], point[1],
+                      hit_result_list_.Get());
+    }
+
+    float* result = out_results + i * kHitTestResultFloats;
+    const ArHitResult* hit = SelectHit(session);
+    if (hit == nullptr) {
+      result[0] = static_cast<float>(HitTestTrackable::kNone);
+      continue;
+    }
+    util::ScopedArTrackable trackable;
+    ArHitResult_acquireTrackable(session, hit, trackable.OutPtr());
+    ArTrackableType type = AR_TRACKABLE_NOT_VALID;
+    ArTrackable_getType(session, trackable.Get(), &type);
+    result[0] = static_cast<float>(ToHitTestTrackable(type));
+    ArHitResult_getDistance(session, hit, &result[1]);
+    ArHitResult_getHitPose(session, hit, hit_pose_.Get());
+    ArPose_getPoseRaw(session, hit_pose_.Get(), &result[2]);
+    ++hit_count;
+  }
+  return hit_count;
+}
+
+int HitTester::GetRetainedHandleCount() const {
+  return (hit_result_list_ ? 1 : 0) + (hit_result_ ? 1 : 0) +
+         (hit_pose_ ? 1 : 0) + (camera_pose_ ? 1 : 0);
+}
+
+void HitTester::Release() {
+  hit_result_list_.Reset();
+  hit_result_.Reset();
+  hit_pose_.Reset();
+  camera_pose_.Reset();
+}
+
+void HitTester::Prepare(ArSession* session, const ArFrame* frame) {
+  if (!hit_result_list_) {
+    ArHitResultList_create(session, hit_result_list_.OutPtr());
+    ArHitResult_create(session, hit_result_.OutPtr());
+    ArPose_create(session, nullptr, hit_pose_.OutPtr());
+    ArPose_create(session, nullptr, camera_pose_.OutPtr());
+    CHECK(hit_result_list_ && hit_result_ && hit_pose_ && camera_pose_);
+  }
+  util::ScopedArCamera camera;
+  ArFrame_acquireCamera(session, frame, camera.OutPtr());
+  ArCamera_getPose(session, camera.Get(), camera_pose_.Get());
+  float camera_pose_raw[7] = {0.f};
+  ArPose_getPoseRaw(session, camera_pose_.Get(), camera_pose_raw);
+  test_origin_ = glm::vec3(camera_pose_raw[4], camera_pose_raw[5],
+                           camera_pose_raw[6]);
+}
+
+ArHitResult* HitTester::SelectHit(const ArSession* session) {
+  int32_t size = 0;
+  ArHitResultList_getSize(session, hit_result_list_.Get(), &size);
+
+  // The hitTest method sorts the resulting list by distance from the camera,
+  // increasing.  The first hit result will usually be the most relevant when
+  // responding to user input.
+  int32_t instant_placement_index = -1;
+  for (int32_t i = 0; i < size; ++i) {
+    ArHitResultList_getItem(session, hit_result_list_.Get(), i,
+                            hit_result_.Get());
+
+    util::ScopedArTrackable trackable;
+    ArHitResult_acquireTrackable(session, hit_result_.Get(),
+                                 trackable.OutPtr());
+    ArTrackableType type = AR_TRACKABLE_NOT_VALID;
+    ArTrackable_getType(session, trackable.Get(), &type);
+    if (AR_TRACKABLE_PLANE == type) {
+      ArHitResult_getHitPose(session, hit_result_.Get(), hit_pose_.Get());
+      int32_t in_polygon = 0;
+      ArPlane_isPoseInPolygon(session, ArAsPlane(trackable.Get()),
+                              hit_pose_.Get(), &in_polygon);
+
+      // Use hit pose and test origin to check if hittest is from the
+      // back of the plane, if it is, no need to create the anchor.
+      float hit_pose_raw[7] = {0.f};
+      ArPose_getPoseRaw(session, hit_pose_.Get(), hit_pose_raw);
+      const glm::vec3 hit_position(hit_pose_raw[4], hit_pose_raw[5],
+                                   hit_pose_raw[6]);
+      float normal_distance_to_plane =
+          glm::dot(util::GetPlaneNormal(*session, *hit_pose_.Get()),
+                   test_origin_ - hit_position);
+      if (in_polygon && normal_distance_to_plane >= 0) {
+        return hit_result_.Get();
+      }
+    } else if (AR_TRACKABLE_POINT == type) {
+      ArPointOrientationMode mode;
+      ArPoint_getOrientationMode(session, ArAsPoint(trackable.Get()), &mode);
+      if (AR_POINT_ORIENTATION_ESTIMATED_SURFACE_NORMAL == mode) {
+        return hit_result_.Get();
+      }
+    } else if (AR_TRACKABLE_INSTANT_PLACEMENT_POINT == type) {
+      instant_placement_index = i;
+    }
+  }
+
+  if (instant_placement_index < 0) {
+    return nullptr;
+  }
+  ArHitResultList_getItem(session, hit_result_list_.Get(),
+                          instant_placement_index, hit_result_.Get());
+  return hit_result_.Get();
+}
+
+}  // namespace hello_ar
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_HIT_TESTER_H_
+#define C_ARCORE_HIT_TESTER_H_
+
+#include <cstdint>
+
+#include "arcore_c_api.h"
+#include "util.h"
+
+namespace hello_ar {
+
+// Coordinates of one input of a hit test batch.
+enum class HitTestInput {
+  // Screen point in pixels: x, y.
+  kScreenPoint,
+  // World space ray: origin x, y, z, then direction x, y, z.
+  kRay,
+};
+
+// Number of floats per input of each HitTestInput.
+constexpr int32_t kHitTestScreenPointFloats = 2;
+constexpr int32_t kHitTestRayFloats = 6;
+
+// Kind of trackable hit, as written to a packed hit test result. The
+// ArTrackableType values are all near 2^30 and don't survive a float, so
+// results carry these small codes instead. Keep in sync with the
+// HIT_TEST_TRACKABLE_* constants in JniInterface.java.
+enum class HitTestTrackable : int32_t {
+  kNone = 0,
+  kPlane = 1,
+  kPoint = 2,
+  kInstantPlacementPoint = 3,
+  // Any other ArTrackableType.
+  kOther = 4,
+};
+
+// Packed result of one input of a hit test batch. Keep in sync with the
+// HIT_TEST_RESULT_* constants in JniInterface.java.
+//   [0] HitTestTrackable code of the hit trackable, kNone if nothing was hit.
+//   [1] distance from the camera or ray origin, in meters.
+//   [2..8] hit pose as qx, qy, qz, qw, tx, ty, tz.
+constexpr int32_t kHitTestResultFloats = 9;
+
+// Runs hit tests and picks the first hit suitable for placing content: a
+// plane hit inside its polygon and facing the camera or ray origin, a point
+// with an estimated surface normal or, failing those, an instant placement
+// point.
+// The hit result list, hit result and poses are created once and reused by
+// every test. Only used on the OpenGL thread, against the current frame.
+class HitTester {
+ public:
+  HitTester() = default;
+
+  // Returns the placement hit for the screen point, or nullptr. Taps fall
+  // back to instant placement at instant_placement_distance_meters when it
+  // is positive. The result is owned by the tester and valid until its next
+  // call.
+  ArHitResult* HitTestScreenPoint(ArSession* session, const ArFrame* frame,
+                                  float x, float y,
+                                  float instant_placement_distance_meters);
+
+  // Hit tests count inputs laid out back to back in coordinates and writes
+  // kHitTestResultFloats packed floats per input to out_results. The camera
+  // pose is read once for the whole batch.
+  // @return the number of inputs that hit something.
+  int32_t HitTestBatch(ArSession* session, const ArFrame* frame,
+                       HitTestInput input, const float* coordinates,
+                       int32_t count, float* out_results);
+
+  // Number of ARCore handles kept alive for reuse.
+  int GetRetainedHandleCount() const;
+
+  // Destroys the reusable objects. Must be called before the session is
+  // destroyed; the next test creates them again.
+  void Release();
+
+ private:
+  // Creates the reusable objects on first use and reads the camera pose
+  // into test_origin_.
+  void Prepare(ArSession* session, const ArFrame* frame);
+
+  // Returns the placement hit in hit_result_list_, or nullptr. Plane hits
+  // must face test_origin_.
+  ArHitResult* SelectHit(const ArSession* session);
+
+  util::ScopedArHitResultList hit_result_list_;
+  util::ScopedArHitResult hit_result_;
+  util::ScopedArHandle<ArPose, ArPose_destroy> hit_pose_;
+  util::ScopedArHandle<ArPose, ArPose_destroy> camera_pose_;
+  // Where the current test starts: the camera position for screen points,
+  // the ray origin for rays.
+  glm::vec3 test_origin_;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_HIT_TESTER_H_
@@ -0,0 +1,184 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "job_system.h"
+
+namespace hello_ar {
+namespace {
+// Jobs a deque holds. Forking past that runs the job right away.
+constexpr int32_t kDequeCapacity = 256;
+
+// Failed attempts to find a job before an idle worker goes to sleep.
+constexpr int32_t kIdleSpins = 64;
+
+// Index of the calling thread's deque in the job system it works for.
+thread_local const JobSystem* t_job_system = nullptr;
+thread_local int32_t t_deque_index = -1;
+}  // namespace
+
+// Fixed capacity ring of jobs. The owner pushes and pops at the back,
+// thieves pop at the front. A lock per deque is uncontended unless a thief
+// is at work, which only happens while there is work to share.
+class JobSystem::WorkDeque {
+ public:
+  WorkDeque() : jobs_(kDequeCapacity) {}
+
+  bool PushBack(const Job& job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (back_ - front_ == kDequeCapacity) {
+      return false;
+    }
+    jobs_[back_++ % kDequeCapacity] = job;
+    return true;
+  }
+
+  bool PopBack(Job* out_job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (back_ == front_) {
+      return false;
+    }
+    *out_job = jobs_[--back_ % kDequeCapacity];
+    return true;
+  }
+
+  bool PopFront(Job* out_job) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (back_ == front_) {
+      return false;
+    }
+    *out_job = jobs_[front_++ % kDequeCapacity];
+    return true;
+  }
+
+ private:
+  std::mutex mutex_;
+  std::vector<Job> jobs_;
+  // Positions only grow, the slot is the position modulo the capacity.
+  uint64_t front_ = 0;
+  uint64_t back_ = 0;
+};
+
+JobSystem::JobSystem(int32_t worker_count)
+    : worker_count_(std::max(worker_count, 0)) {
+  for (int32_t i = 0; i <= worker_count_; ++i) {
+    deques_.emplace_back(new WorkDeque());
+  }
+  for (int32_t i = 0; i < worker_count_; ++i) {
+    workers_.emplace_back(&JobSystem::RunWorker, this, i);
+  }
+}
+
+JobSystem::~JobSystem() {
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    is_stopping_ = true;
+  }
+  wake_.notify_all();
+  for (std::thread& worker : workers_) {
+    worker.join();
+  }
+}
+
+int32_t JobSystem::GetDefaultWorkerCount() {
+  const int32_t cores =
+      static_cast<int32_t>(std::thread::hardware_concurrency());
+  return std::max(0, std::min(cores - 1, 4));
+}
+
+void JobSystem::Run(JobGroup* group, JobFunction function, void* context,
+                    int32_t begin, int32_t end) {
+  const Job job = {function, context, begin, end, group};
+  group->pending_.fetch_add(1, std::memory_order_relaxed);
+  if (worker_count_ == 0 ||
+      !deques_[GetLocalDequeIndex()]->PushBack(job)) {
+    Execute(job);
+    return;
+  }
+  queued_jobs_.fetch_add(1);
+  // Either a worker about to sleep sees the new job, or it is counted as
+  // sleeping here and waits on the condition variable by the time the
+  // mutex is free, so the wake up can't be lost.
+  if (sleeping_workers_.load() > 0) {
+    { std::lock_guard<std::mutex> lock(sleep_mutex_); }
+    wake_.notify_one();
+  }
+}
+
+void JobSystem::Wait(JobGroup* group) {
+  const int32_t local_index = GetLocalDequeIndex();
+  while (group->pending_.load(std::memory_order_acquire) > 0) {
+    Job job;
+    if (TakeJob(local_index, &job)) {
+      Execute(job);
+    } else {
+      // The remaining jobs of the group are running on other threads.
+      std::this_thread::yield();
+    }
+  }
+}
+
+int32_t JobSystem::GetLocalDequeIndex() const {
+  return t_job_system == this ? t_deque_index : worker_count_;
+}
+
+bool JobSystem::TakeJob(int32_t local_index, Job* out_job) {
+  bool found = deques_[local_index]->PopBack(out_job);
+  // Steal starting after the local deque, so thieves spread out.
+  const int32_t deque_count = static_cast<int32_t>(deques_.size());
+  for (int32_t i = 1; !found && i < deque_count; ++i) {
+    found = deques_[(local_index + i) % deque_count]->PopFront(out_job);
+  }
+  if (found) {
+    queued_jobs_.fetch_sub(1);
+  }
+  return found;
+}
+
+void JobSystem::Execute(const Job& job) {
+  job.function(job.context, job.begin, job.end);
+  job.group->pending_.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::RunWorker(int32_t index) {
+  t_job_system = this;
+  t_deque_index = index;
+  int32_t idle_spins = 0;
+  for (;;) {
+    Job job;
+    if (TakeJob(index, &job)) {
+      Execute(job);
+      idle_spins = 0;
+      continue;
+    }
+    if (++idle_spins < kIdleSpins) {
+      std::this_thread::yield();
+      continue;
+    }
+    idle_spins = 0;
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    sleeping_workers_.fetch_add(1);
+    wake_.wait(lock, [this] {
+      return is_stopping_ || queued_jobs_.load() > 0;
+    });
+    sleeping_workers_.fetch_sub(1);
+    if (is_stopping_) {
+      return;
+    }
+  }
+}
+
+}  // namespace hello_ar
@@ -0,0 +1,146 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef C_ARCORE_JOB_SYSTEM_H_
+#define C_ARCORE_JOB_SYSTEM_H_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace hello_ar {
+
+// A job runs function(context, begin, end) for one range of a batch.
+using JobFunction = void (*)(void* context, int32_t begin, int32_t end);
+
+// Fork/join handle of a batch of jobs: jobs are forked into it with
+// JobSystem::Run and joined with JobSystem::Wait.
+class JobGroup {
+ public:
+  JobGroup() = default;
+  JobGroup(const JobGroup&) = delete;
+  JobGroup& operator=(const JobGroup&) = delete;
+
+ private:
+  friend class JobSystem;
+  // Jobs forked and not finished yet.
+  std::atomic<int32_t> pending_{0};
+};
+
+// Work stealing thread pool for the CPU stages of a frame. Each worker owns
+// a deque: jobs it forks go to the back, it takes its own work from the back
+// too, which keeps recently touched data hot, and idle workers steal from
+// the front of the others' deques, which holds the oldest and typically
+// largest remaining work. Threads outside the pool share one more deque, and
+// a thread waiting for a group runs jobs rather than blocking, so the
+// render thread works alongside the workers. Idle workers sleep.
+//
+// Jobs must not call ARCore or GL, which stay on the render thread.
+class JobSystem {
+ public:
+  // Starts worker_count threads. With none, every job runs on the thread
+  // that waits for it.
+  explicit JobSystem(int32_t worker_count);
+  ~JobSystem();
+
+  JobSystem(const JobSystem&) = delete;
+  JobSystem& operator=(const JobSystem&) = delete;
+
+  // One worker per core besides the calling thread, at most four. The
+  // frame's CPU stages are short, and little cores add little to them.
+  static int32_t GetDefaultWorkerCount();
+
+  int32_t GetWorkerCount() const { return worker_count_; }
+
+  // Forks a job into group. Safe to call from any thread, including from
+  // inside a job.
+  void Run(JobGroup* group, JobFunction function, void* context,
+           int32_t begin, int32_t end);
+
+  // Joins group, running queued jobs on the calling thread until every job
+  // of the group finished.
+  void Wait(JobGroup* group);
+
+  // Calls function(i) for every i in [0, count) across the pool, grain
+  // indices per job, and returns once all calls returned. Calls for
+  // different indices may run concurrently.
+  template <typename F>
+  void ParallelFor(int32_t count, int32_t grain, const F& function);
+
+ private:
+  struct Job {
+    JobFunction function;
+    void* context;
+    int32_t begin;
+    int32_t end;
+    JobGroup* group;
+  };
+  class WorkDeque;
+
+  // Index of the calling thread's deque, the shared one for threads outside
+  // the pool.
+  int32_t GetLocalDequeIndex() const;
+  // Takes a job from the back of the local deque or the front of another.
+  bool TakeJob(int32_t local_index, Job* out_job);
+  static void Execute(const Job& job);
+  void RunWorker(int32_t index);
+
+  const int32_t worker_count_;
+  // One per worker, then the one shared by outside threads.
+  std::vector<std::unique_ptr<WorkDeque>> deques_;
+  std::vector<std::thread> workers_;
+
+  // Jobs queued and not taken yet, for sleeping workers.
+  std::atomic<int32_t> queued_jobs_{0};
+  std::atomic<int32_t> sleeping_workers_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool is_stopping_ = false;
+};
+
+template <typename F>
+void JobSystem::ParallelFor(int32_t count, int32_t grain, const F& function) {
+  grain = std::max(grain, 1);
+  if (worker_count_ == 0 || count <= grain) {
+    for (int32_t i = 0; i < count; ++i) {
+      function(i);
+    }
+    return;
+  }
+  const JobFunction run_range = [](void* context, int32_t begin,
+                                   int32_t end) {
+    const F& range_function = *static_cast<const F*>(context);
+    for (int32_t i = begin; i < end; ++i) {
+      range_function(i);
+    }
+  };
+  JobGroup group;
+  void* context = const_cast<F*>(&function);
+  for (int32_t begin = 0; begin < count; begin += grain) {
+    Run(&group, run_range, context, begin, std::min(begin + grain, count));
+  }
+  Wait(&group);
+}
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_JOB_SYSTEM_H_
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "light_estimator.h"
+
+// clang-format off
+#include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
+// clang-format on
+
+#include "gl_wrapper.h"
+
+namespace hello_ar {
+namespace {
+constexpr int32_t kCubemapFaceCount = 6;
+// AIMAGE_FORMAT_RGBA_FP16 pixels.
+constexpr int32_t kCubemapBytesPerPixel = 8;
+
+// Convolution of each spherical harmonics band with the clamped cosine lobe,
+// folded with the basis normalization, turning radiance coefficients into
+// irradiance ones.
+constexpr float kSphericalHarmonicsFactors[9] = {
+    0.282095f, -0.325735f, 0.325735f,  -0.325735f, 0.273137f,
+    -0.273137f, 0.078848f, -0.273137f, 0.136569f};
+}  // namespace
+
+void LightEstimator::InitializeGlContent() {
+  glGenTextures(1, &environment_.cubemap_texture_id);
+  gl::BindTexture(GL_TEXTURE_CUBE_MAP, environment_.cubemap_texture_id);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  gl::BindTexture(GL_TEXTURE_CUBE_MAP, 0);
+  // A new context lost the old texture's contents.
+  cubemap_size_ = 0;
+  last_timestamp_ns_ = -1;
+}
+
+void LightEstimator::Update(const ArSession* session, const ArFrame* frame,
+                            ArLightEstimationMode light_estimation_mode) {
+  if (light_estimation_mode != light_estimation_mode_) {
+    // Start over from the defaults so that nothing from the previous mode's
+    // estimates is used with the new one.
+    const LightEnvironment previous = environment_;
+    environment_ = LightEnvironment();
+    environment_.version = previous.version + 1;
+    environment_.cubemap_texture_id = previous.cubemap_texture_id;
+    environment_.is_environmental_hdr =
+        light_estimation_mode == AR_LIGHT_ESTIMATION_MODE_ENVIRONMENTAL_HDR;
+    light_estimation_mode_ = light_estimation_mode;
+    last_timestamp_ns_ = -1;
+  }
+  if (light_estimation_mode_ == AR_LIGHT_ESTIMATION_MODE_DISABLED) {
+    return;
+  }
+
+  if (!light_estimate_) {
+    ArLightEstimate_create(session, light_estimate_.OutPtr());
+  }
+  ArFrame_getLightEstimate(session, frame, light_estimate_.Get());
+  ArLightEstimateState state = AR_LIGHT_ESTIMATE_STATE_NOT_VALID;
+  ArLightEstimate_getState(session, light_estimate_.Get(), &state);
+  if (state != AR_LIGHT_ESTIMATE_STATE_VALID) {
+    // Keep lighting with the last valid estimate.
+    return;
+  }
+  int64_t timestamp_ns = 0;
+  ArLightEstimate_getTimestamp(session, light_estimate_.Get(), &timestamp_ns);
+  if (timestamp_ns == last_timestamp_ns_) {
+    return;
+  }
+  last_timestamp_ns_ = timestamp_ns;
+  ++environment_.version;
+
+  if (!environment_.is_environmental_hdr) {
+    ArLightEstimate_getColorCorrection(session, light_estimate_.Get(),
+                                       environment_.color_correction);
+    return;
+  }
+
+  ArLightEstimate_getEnvironmentalHdrMainLightDirection(
+      session, light_estimate_.Get(), environment_.main_light_direction);
+  ArLightEstimate_getEnvironmentalHdrMainLightIntensity(
+      session, light_estimate_.Get(), environment_.main_light_intensity);
+  ArLightEstimate_getEnvironmentalHdrAmbientSphericalHarmonics(
+      session, light_estimate_.Get(), environment_.spherical_harmonics);
+  for (int32_t i = 0; i < 27; ++i) {
+    environment_.spherical_harmonics[i] *= kSphericalHarmonicsFactors[i / 3];
+  }
+  UploadCubemap(session);
+}
+
+void LightEstimator::UploadCubemap(const ArSession* session) {
+  ArImageCubemap faces = {nullptr};
+  ArLightEstimate_acquireEnvironmentalHdrCubemap(session, light_estimate_.Get(),
+                                                 faces);
+  // Owned here so that every face is released, whatever gets uploaded.
+  util::ScopedArImage scoped_faces[kCubemapFaceCount];
+  for (int32_t face = 0; face < kCubemapFaceCount; ++face) {
+    scoped_faces[face].Reset(faces[face]);
+  }
+  if (environment_.cubemap_texture_id == 0 || !scoped_faces[0]) {
+    return;
+  }
+
+  int32_t size = 0;
+  ArImage_getWidth(session, scoped_faces[0].Get(), &size);
+  gl::BindTexture(GL_TEXTURE_CUBE_MAP, environment_.cubemap_texture_id);
+  if (size != cubemap_size_) {
+    for (int32_t face = 0; face < kCubemapFaceCount; ++face) {
+      gl::TexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGBA16F,
+                     size, size, 0, GL_RGBA, GL_HALF_FLOAT, nullptr);
+    }
+    cubemap_size_ = size;
+  }
+
+  // The faces come in GL_TEXTURE_CUBE_MAP_POSITIVE_X + face order.
+  for (int32_t face = 0; face < kCubemapFaceCount; ++face) {
+    const ArImage* image = scoped_faces[face].Get();
+    if (image == nullptr) {
+      continue;
+    }
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t row_stride = 0;
+    const uint8_t* data = nullptr;
+    int32_t data_length = 0;
+    ArImage_getWidth(session, image, &width);
+    ArImage_getHeight(session, image, &height);
+    ArImage_getPlaneRowStride(session, image, /*plane_index=*/0, &row_stride);
+    ArImage_getPlaneData(session, image, /*plane_index=*/0, &data,
+                         &data_length);
+    if (data == nullptr || width != size || height != size) {
+      continue;
+    }
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, row_stride / kCubemapBytesPerPixel);
+    gl::TexSubImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, 0, 0, size,
+                      size, GL_RGBA, GL_HALF_FLOAT, data);
+  }
+  glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  gl::BindTexture(GL_TEXTURE_CUBE_MAP, 0);
+}
+
+}  // namespace hello_ar
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_LIGHT_ESTIMATOR_H_
+#define C_ARCORE_LIGHT_ESTIMATOR_H_
+
+#include <GLES2/gl2.h>
+
+#include <cstdint>
+
+#include "arcore_c_api.h"
+#include "util.h"
+
+namespace hello_ar {
+
+// Lighting of the current frame, shared by every object shader. Renderers
+// compare version with the one they last uploaded and only set their light
+// uniforms when it differs.
+struct LightEnvironment {
+  // Incremented whenever a new estimate is read.
+  uint32_t version = 0;
+  // True for AR_LIGHT_ESTIMATION_MODE_ENVIRONMENTAL_HDR, in which case the
+  // color correction is unused and the fields below are valid.
+  bool is_environmental_hdr = false;
+  // RGB scale and average pixel intensity, in gamma space.
+  float color_correction[4] = {1.f, 1.f, 1.f, 1.f};
+  // Direction towards the main light in world space, and its linear RGB
+  // intensity.
+  float main_light_direction[3] = {0.f, 1.f, 0.f};
+  float main_light_intensity[3] = {0.f, 0.f, 0.f};
+  // Ambient irradiance as 9 RGB spherical harmonics coefficients, already
+  // scaled by the cosine lobe convolution so the shader only evaluates the
+  // basis.
+  float spherical_harmonics[27] = {0.f};
+  // GL_TEXTURE_CUBE_MAP holding the HDR environment in linear space.
+  GLuint cubemap_texture_id = 0;
+};
+
+// Reads the light estimate of each frame into a LightEnvironment. The
+// estimate object is created once and reused, and nothing is read or
+// uploaded while the estimate's timestamp stays the same, so the cubemap is
+// uploaded at the rate ARCore produces new estimates rather than every
+// frame. Only used on the OpenGL thread.
+class LightEstimator {
+ public:
+  LightEstimator() = default;
+
+  // Creates the cubemap texture. Must be called on the OpenGL thread before
+  // Update.
+  void InitializeGlContent();
+
+  // Reads the frame's estimate if it is newer than the last one read, for a
+  // session configured with light_estimation_mode.
+  void Update(const ArSession* session, const ArFrame* frame,
+              ArLightEstimationMode light_estimation_mode);
+
+  const LightEnvironment& GetLightEnvironment() const { return environment_; }
+
+  // Number of ARCore handles kept alive for reuse.
+  int GetRetainedHandleCount() const { return light_estimate_ ? 1 : 0; }
+
+  // Destroys the reusable estimate. Must be called before the session is
+  // destroyed; the next update creates it again.
+  void Release() { light_estimate_.Reset(); }
+
+ private:
+  void UploadCubemap(const ArSession* session);
+
+  util::ScopedArLightEstimate light_estimate_;
+  ArLightEstimationMode light_estimation_mode_ =
+      AR_LIGHT_ESTIMATION_MODE_DISABLED;
+  int64_t last_timestamp_ns_ = -1;
+  // Size of the cubemap faces allocated so far, 0 before the first upload.
+  int32_t cubemap_size_ = 0;
+  LightEnvironment environment_;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_LIGHT_ESTIMATOR_H_
@@ -0,0 +1,237 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "logger.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+
+namespace hello_ar {
+namespace logger {
+namespace {
+constexpr char kLogTag[] = "hello_ar_example_c";
+
+// Records each call site may log per window before being suppressed.
+constexpr int32_t kMaxRecordsPerWindow = 5;
+constexpr int64_t kRateLimitWindowNs = 1000000000;
+
+// Queue capacity, must be a power of two.
+constexpr uint64_t kQueueCapacity = 256;
+constexpr size_t kMaxRecordLength = 512;
+
+// How long the logger thread sleeps when the queue is empty and nobody
+// notifies it.
+constexpr std::chrono::milliseconds kIdleWait(100);
+
+struct Record {
+  int level;
+  char text[kMaxRecordLength];
+};
+
+// Bounded multi-producer single-consumer queue. Each cell's sequence number
+// tells producers whether the cell is free for their position and the
+// consumer whether it has been filled, so neither side ever takes a lock.
+class RecordQueue {
+ public:
+  RecordQueue() {
+    for (uint64_t i = 0; i < kQueueCapacity; ++i) {
+      cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Returns a cell to fill at the next position, or nullptr if the queue is
+  // full. The caller must hand the cell back with Publish.
+  Record* Reserve(uint64_t* out_position) {
+    uint64_t position = enqueue_position_.load(std::memory_order_relaxed);
+    for (;;) {
+      Cell& cell = cells_[position & (kQueueCapacity - 1)];
+      const uint64_t sequence = cell.sequence.load(std::memory_order_acquire);
+      const int64_t difference =
+          static_cast<int64_t>(sequence) - static_cast<int64_t>(position);
+      if (difference == 0) {
+        if (enqueue_position_.compare_exchange_weak(
+                position, position + 1, std::memory_order_relaxed)) {
+          *out_position = position;
+          return &cell.record;
+        }
+      } else if (difference < 0) {
+        return nullptr;
+      } else {
+        position = enqueue_position_.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  void Publish(uint64_t position) {
+    cells_[position & (kQueueCapacity - 1)].sequence.store(
+        position + 1, std::memory_order_release);
+  }
+
+  // Consumer side. Returns the next filled record or nullptr.
+  const Record* Front() {
+    const uint64_t position = dequeue_position_.load(std::memory_order_relaxed);
+    Cell& cell = cells_[position & (kQueueCapacity - 1)];
+    if (cell.sequence.load(std::memory_order_acquire) != position + 1) {
+      return nullptr;
+    }
+    return &cell.record;
+  }
+
+  void Pop() {
+    const uint64_t position = dequeue_position_.load(std::memory_order_relaxed);
+    cells_[position & (kQueueCapacity - 1)].sequence.store(
+        position + kQueueCapacity, std::memory_order_release);
+    dequeue_position_.store(position + 1, std::memory_order_release);
+  }
+
+  bool IsDrained(uint64_t up_to_position) const {
+    return dequeue_position_.load(std::memory_order_acquire) >=
+           up_to_position;
+  }
+
+  uint64_t GetEnqueuePosition() const {
+    return enqueue_position_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  struct Cell {
+    std::atomic<uint64_t> sequence;
+    Record record;
+  };
+
+  Cell cells_[kQueueCapacity];
+  std::atomic<uint64_t> enqueue_position_{0};
+  std::atomic<uint64_t> dequeue_position_{0};
+};
+
+// Shared with the detached logger thread, so it is never destroyed.
+struct LoggerState {
+  RecordQueue queue;
+  std::atomic<int32_t> dropped_records{0};
+  std::mutex wake_mutex;
+  std::condition_variable wake;
+};
+
+LoggerState* GetLoggerState();
+
+void RunLoggerThread(LoggerState* state) {
+  for (;;) {
+    while (const Record* record = state->queue.Front()) {
+      __android_log_write(record->level, kLogTag, record->text);
+      state->queue.Pop();
+    }
+    const int32_t dropped = state->dropped_records.exchange(0);
+    if (dropped > 0) {
+      __android_log_print(ANDROID_LOG_WARN, kLogTag,
+                          "%d log records dropped, queue full", dropped);
+    }
+    std::unique_lock<std::mutex> lock(state->wake_mutex);
+    state->wake.wait_for(lock, kIdleWait);
+  }
+}
+
+LoggerState* GetLoggerState() {
+  static LoggerState* state = [] {
+    LoggerState* new_state = new LoggerState();
+    std::thread(RunLoggerThread, new_state).detach();
+    return new_state;
+  }();
+  return state;
+}
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+}  // namespace
+
+bool CallSite::Admit(int32_t* out_suppressed) {
+  *out_suppressed = 0;
+  const int64_t now_ns = NowNs();
+  int64_t window_start_ns = window_start_ns_.load(std::memory_order_relaxed);
+  if (now_ns - window_start_ns >= kRateLimitWindowNs &&
+      window_start_ns_.compare_exchange_strong(window_start_ns, now_ns,
+                                               std::memory_order_relaxed)) {
+    window_count_.store(0, std::memory_order_relaxed);
+    *out_suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+  }
+  if (window_count_.fetch_add(1, std::memory_order_relaxed) <
+      kMaxRecordsPerWindow) {
+    return true;
+  }
+  suppressed_.fetch_add(1, std::memory_order_relaxed);
+  return false;
+}
+
+void Log(CallSite* site, int level, const char* format, ...) {
+  int32_t suppressed = 0;
+  if (site != nullptr && !site->Admit(&suppressed)) {
+    return;
+  }
+  LoggerState* state = GetLoggerState();
+  uint64_t position = 0;
+  Record* record = state->queue.Reserve(&position);
+  if (record == nullptr) {
+    state->dropped_records.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+
+  record->level = level;
+  va_list arguments;
+  va_start(arguments, format);
+  int length = vsnprintf(record->text, kMaxRecordLength, format, arguments);
+  va_end(arguments);
+  if (suppressed > 0 && length >= 0 &&
+      static_cast<size_t>(length) < kMaxRecordLength) {
+    snprintf(record->text + length, kMaxRecordLength - length,
+             " [%d similar records suppressed]", suppressed);
+  }
+  state->queue.Publish(position);
+  state->wake.notify_one();
+}
+
+bool Flush(int timeout_ms) {
+  LoggerState* state = GetLoggerState();
+  const uint64_t position = state->queue.GetEnqueuePosition();
+  const auto deadline =
+      std::chrono::steady_clock::now() + std::chrono::milliseconds(timeout_ms);
+  while (!state->queue.IsDrained(position)) {
+    if (std::chrono::steady_clock::now() >= deadline) {
+      return false;
+    }
+    state->wake.notify_one();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return true;
+}
+
+void LogFatal(const char* format, ...) {
+  Flush(/*timeout_ms=*/500);
+  va_list arguments;
+  va_start(arguments, format);
+  __android_log_vprint(ANDROID_LOG_FATAL, kLogTag, format, arguments);
+  va_end(arguments);
+  abort();
+}
+
+}  // namespace logger
+}  // namespace hello_ar
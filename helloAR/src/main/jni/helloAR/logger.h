@@ -0,0 +1,89 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_LOGGER_H_
+#define C_ARCORE_LOGGER_H_
+
+#include <android/log.h>
+
+#include <atomic>
+#include <cstdint>
+
+// Records below this android_LogPriority are compiled out, format strings
+// included. Override with -DHELLOAR_MIN_LOG_LEVEL=<priority>.
+#ifndef HELLOAR_MIN_LOG_LEVEL
+#define HELLOAR_MIN_LOG_LEVEL ANDROID_LOG_INFO
+#endif  // HELLOAR_MIN_LOG_LEVEL
+
+// Formats a record on the calling thread and queues it for the logger thread,
+// which writes it to logcat. Each call site is rate limited on its own, so a
+// message logged every frame costs a formatted record a few times per second
+// and an atomic check otherwise. Never blocks the caller: records are dropped
+// when the queue is full.
+#define HELLOAR_LOG(level, ...)                               \
+  do {                                                        \
+    if ((level) >= HELLOAR_MIN_LOG_LEVEL) {                   \
+      static ::hello_ar::logger::CallSite helloar_log_site;   \
+      ::hello_ar::logger::Log(&helloar_log_site, (level),     \
+                              __VA_ARGS__);                   \
+    }                                                         \
+  } while (false)
+
+// Like HELLOAR_LOG without the rate limit, for reports that log many lines
+// from one place at a low rate.
+#define HELLOAR_LOG_UNLIMITED(level, ...)                              \
+  do {                                                                 \
+    if ((level) >= HELLOAR_MIN_LOG_LEVEL) {                            \
+      ::hello_ar::logger::Log(nullptr, (level), __VA_ARGS__);          \
+    }                                                                  \
+  } while (false)
+
+// Writes the pending records and a final message synchronously, then aborts.
+#define HELLOAR_LOG_FATAL(...) ::hello_ar::logger::LogFatal(__VA_ARGS__)
+
+namespace hello_ar {
+namespace logger {
+
+// Rate limiting state of one HELLOAR_LOG call site.
+class CallSite {
+ public:
+  CallSite() = default;
+
+  // Returns true if a record may be logged now. When it returns true after
+  // some records were rejected, out_suppressed is set to their number.
+  bool Admit(int32_t* out_suppressed);
+
+ private:
+  std::atomic<int64_t> window_start_ns_{0};
+  std::atomic<int32_t> window_count_{0};
+  std::atomic<int32_t> suppressed_{0};
+};
+
+// Queues a record. site may be null to bypass rate limiting.
+void Log(CallSite* site, int level, const char* format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+// Waits for the logger thread to write every queued record, for at most
+// timeout_ms. Returns false on timeout.
+bool Flush(int timeout_ms);
+
+[[noreturn]] void LogFatal(const char* format, ...)
+    __attribute__((format(printf, 1, 2)));
+
+}  // namespace logger
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_LOGGER_H_
@@ -0,0 +1,238 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "mesh_bvh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace hello_ar {
+namespace {
+// Triangles per leaf. Small leaves keep the number of triangle tests per ray
+// in the tens for meshes of a few thousand triangles.
+constexpr int32_t kMaxLeafTriangles = 4;
+
+// Depth of the traversal stack. A median split halves the triangles per
+// level, so this covers any mesh indexable with GLushort.
+constexpr int32_t kMaxDepth = 64;
+
+struct BuildTriangle {
+  glm::vec3 vertices[3];
+  glm::vec3 centroid;
+};
+
+// Slab test. Returns true if the ray enters the box before max_t.
+bool IntersectBox(const glm::vec3& min, const glm::vec3& max,
+                  const glm::vec3& origin, const glm::vec3& inverse_direction,
+                  float max_t, float* out_entry_t) {
+  const glm::vec3 t0 = (min - origin) * inverse_direction;
+  const glm::vec3 t1 = (max - origin) * inverse_direction;
+  const glm::vec3 near_t = glm::min(t0, t1);
+  const glm::vec3 far_t = glm::max(t0, t1);
+  const float entry = std::max(std::max(near_t.x, near_t.y),
+                               std::max(near_t.z, 0.f));
+  const float exit = std::min(std::min(far_t.x, far_t.y),
+                              std::min(far_t.z, max_t));
+  *out_entry_t = entry;
+  return entry <= exit;
+}
+}  // namespace
+
+void MeshBvh::Build(const std::vector<GLfloat>& vertices,
+                    const std::vector<GLushort>& indices) {
+  nodes_.clear();
+  triangles_.clear();
+  const int32_t triangle_count = static_cast<int32_t>(indices.size() / 3);
+  if (triangle_count == 0) {
+    return;
+  }
+
+  std::vector<BuildTriangle> build_triangles(triangle_count);
+  glm::vec3 mesh_min(std::numeric_limits<float>::max());
+  glm::vec3 mesh_max(-std::numeric_limits<float>::max());
+  for (int32_t i = 0; i < triangle_count; ++i) {
+    BuildTriangle& triangle = build_triangles[i];
+    for (int32_t corner = 0; corner < 3; ++corner) {
+      const GLfloat* position = &vertices[3 * indices[3 * i + corner]];
+      triangle.vertices[corner] =
+          glm::vec3(position[0], position[1], position[2]);
+      mesh_min = glm::min(mesh_min, triangle.vertices[corner]);
+      mesh_max = glm::max(mesh_max, triangle.vertices[corner]);
+    }
+    triangle.centroid = (triangle.vertices[0] + triangle.vertices[1] +
+                         triangle.vertices[2]) / 3.f;
+  }
+  bounding_center_ = 0.5f * (mesh_min + mesh_max);
+  bounding_radius_ = 0.5f * glm::length(mesh_max - mesh_min);
+
+  // Each entry is a node to fill and its range of build_triangles.
+  struct Range {
+    int32_t node;
+    int32_t begin;
+    int32_t end;
+  };
+  std::vector<Range> pending;
+  nodes_.push_back(Node());
+  pending.push_back({0, 0, triangle_count});
+  while (!pending.empty()) {
+    const Range range = pending.back();
+    pending.pop_back();
+
+    glm::vec3 node_min(std::numeric_limits<float>::max());
+    glm::vec3 node_max(-std::numeric_limits<float>::max());
+    glm::vec3 centroid_min = node_min;
+    glm::vec3 centroid_max = node_max;
+    for (int32_t i = range.begin; i < range.end; ++i) {
+      const BuildTriangle& triangle = build_triangles[i];
+      for (const glm::vec3& vertex : triangle.vertices) {
+        node_min = glm::min(node_min, vertex);
+        node_max = glm::max(node_max, vertex);
+      }
+      centroid_min = glm::min(centroid_min, triangle.centroid);
+      centroid_max = glm::max(centroid_max, triangle.centroid);
+    }
+    nodes_[range.node].min = node_min;
+    nodes_[range.node].max = node_max;
+
+    if (range.end - range.begin <= kMaxLeafTriangles) {
+      nodes_[range.node].first = range.begin;
+      nodes_[range.node].count = range.end - range.begin;
+      continue;
+    }
+
+    // Median split along the axis where the centroids spread the most.
+    const glm::vec3 extent = centroid_max - centroid_min;
+    const int axis = extent.x >= extent.y && extent.x >= extent.z
+                         ? 0
+                         : (extent.y >= extent.z ? 1 : 2);
+    const int32_t middle = range.begin + (range.end - range.begin) / 2;
+    std::nth_element(build_triangles.begin() + range.begin,
+                     build_triangles.begin() + middle,
+                     build_triangles.begin() + range.end,
+                     [axis](const BuildTriangle& a, const BuildTriangle& b) {
+                       return a.centroid[axis] < b.centroid[axis];
+                     });
+
+    const int32_t first_child = static_cast<int32_t>(nodes_.size());
+    const int32_t second_child = first_child + 1;
+    nodes_.push_back(Node());
+    nodes_.push_back(Node());
+    nodes_[range.node].first = first_child;
+    nodes_[range.node].count = 0;
+    pending.push_back({second_child, middle, range.end});
+    pending.push_back({first_child, range.begin, middle});
+  }
+
+  triangles_.reserve(triangle_count);
+  for (const BuildTriangle& triangle : build_triangles) {
+    triangles_.push_back({triangle.vertices[0],
+                          triangle.vertices[1] - triangle.vertices[0],
+                          triangle.vertices[2] - triangle.vertices[0]});
+  }
+}
+
+bool MeshBvh::Intersect(const glm::vec3& origin, const glm::vec3& direction,
+                        float max_t, float* out_t) const {
+  if (nodes_.empty()) {
+    return false;
+  }
+  const glm::vec3 inverse_direction = 1.f / direction;
+  float nearest_t = max_t;
+  bool found = false;
+
+  int32_t stack[kMaxDepth];
+  int32_t stack_size = 0;
+  stack[stack_size++] = 0;
+  while (stack_size > 0) {
+    const Node& node = nodes_[stack[--stack_size]];
+    float entry_t = 0.f;
+    if (!IntersectBox(node.min, node.max, origin, inverse_direction,
+                      nearest_t, &entry_t)) {
+      continue;
+    }
+    if (node.count == 0) {
+      if (stack_size + 2 > kMaxDepth) {
+        continue;
+      }
+      stack[stack_size++] = node.first + 1;
+      stack[stack_size++] = node.first;
+      continue;
+    }
+
+    // Moller-Trumbore ray/triangle intersection.
+    for (int32_t i = node.first; i < node.first + node.count; ++i) {
+      const Triangle& triangle = triangles_[i];
+      const glm::vec3 p = glm::cross(direction, triangle.edge2);
+      const float determinant = glm::dot(triangle.edge1, p);
+      if (std::abs(determinant) < 1e-12f) {
+        continue;
+      }
+      const float inverse_determinant = 1.f / determinant;
+      const glm::vec3 s = origin - triangle.vertex;
+      const float u = glm::dot(s, p) * inverse_determinant;
+      if (u < 0.f || u > 1.f) {
+        continue;
+      }
+      const glm::vec3 q = glm::cross(s, triangle.edge1);
+      const float v = glm::dot(direction, q) * inverse_determinant;
+      if (v < 0.f || u + v > 1.f) {
+        continue;
+      }
+      const float t = glm::dot(triangle.edge2, q) * inverse_determinant;
+      if (t >= 0.f && t < nearest_t) {
+        nearest_t = t;
+        found = true;
+      }
+    }
+  }
+  if (found) {
+    *out_t = nearest_t;
+  }
+  return found;
+}
+
+bool MeshBvh::IntersectInstance(const glm::mat4& model_mat,
+                                const glm::vec3& origin,
+                                const glm::vec3& direction, float max_t,
+                                float* out_t) const {
+  if (nodes_.empty()) {
+    return false;
+  }
+  // Model matrices are rigid, so distances along the ray are the same in
+  // world and model space, and the bounding sphere keeps its radius.
+  const glm::vec3 center(model_mat * glm::vec4(bounding_center_, 1.f));
+  const glm::vec3 to_center = center - origin;
+  const float center_t = glm::dot(to_center, direction);
+  const float miss_squared =
+      glm::dot(to_center, to_center) - center_t * center_t;
+  const float radius_squared = bounding_radius_ * bounding_radius_;
+  if (miss_squared > radius_squared) {
+    return false;
+  }
+  const float half_chord = std::sqrt(radius_squared - miss_squared);
+  if (center_t + half_chord < 0.f || center_t - half_chord >= max_t) {
+    return false;
+  }
+
+  const glm::mat4 inverse_model_mat = glm::inverse(model_mat);
+  const glm::vec3 model_origin(inverse_model_mat * glm::vec4(origin, 1.f));
+  const glm::vec3 model_direction(inverse_model_mat *
+                                  glm::vec4(direction, 0.f));
+  return Intersect(model_origin, model_direction, max_t, out_t);
+}
+
+}  // namespace hello_ar
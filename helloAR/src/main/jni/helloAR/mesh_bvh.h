@@ -0,0 +1,83 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_MESH_BVH_H_
+#define C_ARCORE_MESH_BVH_H_
+
+#include <GLES2/gl2.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "glm.h"
+
+namespace hello_ar {
+
+// Bounding volume hierarchy over the triangles of a mesh, for ray picking.
+// Built once when the mesh is loaded. Queries run in the mesh's model space,
+// or against placed instances of the mesh with IntersectInstance.
+class MeshBvh {
+ public:
+  MeshBvh() = default;
+
+  // Builds the hierarchy from xyz vertex positions and triangle indices, as
+  // loaded by util::LoadObjFile.
+  void Build(const std::vector<GLfloat>& vertices,
+             const std::vector<GLushort>& indices);
+
+  bool IsEmpty() const { return nodes_.empty(); }
+
+  // Finds the nearest triangle hit by origin + t * direction with
+  // 0 <= t < max_t. direction need not be normalized.
+  // @return false if no triangle is hit before max_t.
+  bool Intersect(const glm::vec3& origin, const glm::vec3& direction,
+                 float max_t, float* out_t) const;
+
+  // Like Intersect, for an instance of the mesh placed with the rigid
+  // model_mat and a world space ray with a unit length direction. Instances
+  // the ray misses are rejected with the bounding sphere before the ray is
+  // transformed into their model space, which costs a few flops.
+  bool IntersectInstance(const glm::mat4& model_mat, const glm::vec3& origin,
+                         const glm::vec3& direction, float max_t,
+                         float* out_t) const;
+
+ private:
+  struct Node {
+    glm::vec3 min;
+    glm::vec3 max;
+    // Leaves: first triangle and triangle count. Inner nodes: index of the
+    // first child, the second one follows it, and a count of 0.
+    int32_t first;
+    int32_t count;
+  };
+
+  // A triangle as one vertex and two edges, ready for intersection.
+  struct Triangle {
+    glm::vec3 vertex;
+    glm::vec3 edge1;
+    glm::vec3 edge2;
+  };
+
+  std::vector<Node> nodes_;
+  std::vector<Triangle> triangles_;
+  // Sphere around the mesh's bounding box.
+  glm::vec3 bounding_center_ = glm::vec3(0.f);
+  float bounding_radius_ = 0.f;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_MESH_BVH_H_
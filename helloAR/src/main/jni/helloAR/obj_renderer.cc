@@ -16,6 +16,13 @@
 
 #include "obj_renderer.h"
 
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "gl_wrapper.h"
 #include "util.h"
 
 namespace hello_ar {
@@ -24,35 +31,147 @@ const glm::vec4 kLightDirection(0.0f, 1.0f, 0.0f, 0.0f);
 constexpr char kVertexShaderFilename[] = "shaders/ar_object.vert";
 constexpr char kFragmentShaderFilename[] = "shaders/ar_object.frag";
 constexpr char kUseDepthForOcclusionShaderFlag[] = "USE_DEPTH_FOR_OCCLUSION";
+constexpr char kUseEnvironmentalHdrShaderFlag[] = "USE_ENVIRONMENTAL_HDR";
+constexpr char kUseOcclusionBlurShaderFlag[] = "USE_OCCLUSION_BLUR";
 }  // namespace
 
 void ObjRenderer::InitializeGlContent(AAssetManager* asset_manager,
                                       const std::string& obj_file_name,
                                       const std::string& png_file_name) {
-  compileAndLoadShaderProgram(asset_manager);
-  position_attrib_ = glGetAttribLocation(shader_program_, "a_Position");
-  tex_coord_attrib_ = glGetAttribLocation(shader_program_, "a_TexCoord");
-  normal_attrib_ = glGetAttribLocation(shader_program_, "a_Normal");
+  InitializeProgram(asset_manager);
+  LoadModel(asset_manager, obj_file_name, png_file_name, &model_);
+  util::CheckGlError("obj_renderer::InitializeGlContent()");
+}
+
+void ObjRenderer::InitializeGlContentAsync(AAssetManager* asset_manager,
+                                           const std::string& obj_file_name,
+                                           const std::string& png_file_name,
+                                           UploadThread* upload_thread) {
+  InitializeProgram(asset_manager);
+  // Shared by the two functions, std::function needs them copyable.
+  std::shared_ptr<Model> model = std::make_shared<Model>();
+  upload_thread->Upload(
+      [asset_manager, obj_file_name, png_file_name, model] {
+        LoadModel(asset_manager, obj_file_name, png_file_name, model.get());
+      },
+      [this, model] { model_ = std::move(*model); });
+}
+
+constexpr int ObjRenderer::kShaderVariantOcclusion;
+constexpr int ObjRenderer::kShaderVariantEnvironmentalHdr;
+constexpr int ObjRenderer::kShaderVariantOcclusionBlur;
+constexpr int ObjRenderer::kShaderVariantCount;
+
+void ObjRenderer::InitializeProgram(AAssetManager* asset_manager) {
+  // Programs of a previous context went away with it.
+  std::fill(std::begin(shader_variants_), std::end(shader_variants_), 0);
+  // Occlusion and its blur are toggled while rendering, by the user and by
+  // the quality governor, so their variants are compiled up front. The light
+  // estimation mode changes rarely, its variants are compiled on first use.
+  const int fixed_bits = GetShaderVariant() & kShaderVariantEnvironmentalHdr;
+  for (int bits : {0, kShaderVariantOcclusion, kShaderVariantOcclusionBlur,
+                   kShaderVariantOcclusion | kShaderVariantOcclusionBlur}) {
+    CompileShaderVariant(asset_manager, fixed_bits | bits);
+  }
+  LoadShaderProgram(asset_manager);
+}
+
+int ObjRenderer::GetShaderVariant() const {
+  return (use_depth_for_occlusion_ ? kShaderVariantOcclusion : 0) |
+         (use_environmental_hdr_ ? kShaderVariantEnvironmentalHdr : 0) |
+         (use_occlusion_blur_ ? kShaderVariantOcclusionBlur : 0);
+}
+
+void ObjRenderer::CompileShaderVariant(AAssetManager* asset_manager,
+                                       int variant) {
+  if (shader_variants_[variant] != 0) {
+    return;
+  }
+  std::map<std::string, int> define_values_map;
+  define_values_map[kUseDepthForOcclusionShaderFlag] =
+      (variant & kShaderVariantOcclusion) != 0 ? 1 : 0;
+  define_values_map[kUseEnvironmentalHdrShaderFlag] =
+      (variant & kShaderVariantEnvironmentalHdr) != 0 ? 1 : 0;
+  define_values_map[kUseOcclusionBlurShaderFlag] =
+      (variant & kShaderVariantOcclusionBlur) != 0 ? 1 : 0;
+  shader_variants_[variant] =
+      util::CreateProgram(kVertexShaderFilename, kFragmentShaderFilename,
+                          asset_manager, define_values_map);
+  if (!shader_variants_[variant]) {
+    LOGE("Could not create program.");
+  }
+}
 
-  glGenTextures(1, &texture_id_);
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
+void ObjRenderer::LoadModel(AAssetManager* asset_manager,
+                            const std::string& obj_file_name,
+                            const std::string& png_file_name,
+                            Model* out_model) {
+  std::vector<GLfloat> vertices;
+  std::vector<GLfloat> normals;
+  std::vector<GLfloat> uvs;
+  std::vector<GLushort> indices;
+  if (!util::LoadObjFile(obj_file_name, asset_manager, &vertices, &normals,
+                         &uvs, &indices)) {
+    LOGE("Could not load obj file %s.", obj_file_name.c_str());
+    return;
+  }
+  out_model->mesh_bvh.Build(vertices, indices);
+
+  // Plain GL calls rather than the gl:: wrappers, as this may run on the
+  // upload thread and the frame stats only count the render thread's calls.
+  const GLsizeiptr positions_size = vertices.size() * sizeof(GLfloat);
+  const GLsizeiptr normals_size = normals.size() * sizeof(GLfloat);
+  const GLsizeiptr uvs_size = uvs.size() * sizeof(GLfloat);
+  out_model->normals_offset = positions_size;
+  out_model->uvs_offset = positions_size + normals_size;
+  glGenBuffers(1, &out_model->vertex_buffer);
+  glBindBuffer(GL_ARRAY_BUFFER, out_model->vertex_buffer);
+  glBufferData(GL_ARRAY_BUFFER, positions_size + normals_size + uvs_size,
+               nullptr, GL_STATIC_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, positions_size, vertices.data());
+  glBufferSubData(GL_ARRAY_BUFFER, out_model->normals_offset, normals_size,
+                  normals.data());
+  glBufferSubData(GL_ARRAY_BUFFER, out_model->uvs_offset, uvs_size,
+                  uvs.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glGenBuffers(1, &out_model->index_buffer);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, out_model->index_buffer);
+  glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLushort),
+               indices.data(), GL_STATIC_DRAW);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  out_model->index_count = static_cast<GLsizei>(indices.size());
+
+  glGenTextures(1, &out_model->texture_id);
+  glBindTexture(GL_TEXTURE_2D, out_model->texture_id);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
                   GL_LINEAR_MIPMAP_NEAREST);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-  if (!util::LoadPngFromAssetManager(GL_TEXTURE_2D, png_file_name)) {
-    LOGE("Could not load png texture for planes.");
+  // Decoded premultiplied, like the bitmaps GLUtils.texImage2D uploads.
+  int width = 0;
+  int height = 0;
+  int stride = 0;
+  uint8_t* pixels = nullptr;
+  if (util::LoadImageFromAssetManager(png_file_name, &width, &height, &stride,
+                                      &pixels)) {
+    // GLES2 has no GL_UNPACK_ROW_LENGTH, so padded rows are packed first.
+    const int row_size = width * 4;
+    if (stride != row_size) {
+      for (int row = 1; row < height; ++row) {
+        memmove(pixels + row * row_size, pixels + row * stride, row_size);
+      }
+    }
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, pixels);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    delete[] pixels;
+  } else {
+    LOGE("Could not load png texture %s.", png_file_name.c_str());
   }
-  glGenerateMipmap(GL_TEXTURE_2D);
-
   glBindTexture(GL_TEXTURE_2D, 0);
-
-  util::LoadObjFile(obj_file_name, asset_manager, &vertices_, &normals_, &uvs_,
-                    &indices_);
-
-  util::CheckGlError("obj_renderer::InitializeGlContent()");
 }
 
 void ObjRenderer::setUseDepthForOcclusion(AAssetManager* asset_manager,
@@ -61,23 +180,39 @@ void ObjRenderer::setUseDepthForOcclusion(AAssetManager* asset_manager,
     return;  // No change, does nothing.
   }
 
-  // Toggles the occlusion rendering mode and recompiles the shader.
+  // Toggles the occlusion rendering mode and switches the shader.
   use_depth_for_occlusion_ = use_depth_for_occlusion;
-  compileAndLoadShaderProgram(asset_manager);
+  LoadShaderProgram(asset_manager);
 }
 
-void ObjRenderer::compileAndLoadShaderProgram(AAssetManager* asset_manager) {
-  // Compiles and loads the shader program based on the selected mode.
-  std::map<std::string, int> define_values_map;
-  define_values_map[kUseDepthForOcclusionShaderFlag] =
-      use_depth_for_occlusion_ ? 1 : 0;
+void ObjRenderer::SetUseEnvironmentalHdr(AAssetManager* asset_manager,
+                                         bool use_environmental_hdr) {
+  if (use_environmental_hdr_ == use_environmental_hdr) {
+    return;
+  }
+  use_environmental_hdr_ = use_environmental_hdr;
+  LoadShaderProgram(asset_manager);
+}
 
-  shader_program_ =
-      util::CreateProgram(kVertexShaderFilename, kFragmentShaderFilename,
-                          asset_manager, define_values_map);
-  if (!shader_program_) {
-    LOGE("Could not create program.");
+void ObjRenderer::SetUseOcclusionBlur(AAssetManager* asset_manager,
+                                      bool use_occlusion_blur) {
+  if (use_occlusion_blur_ == use_occlusion_blur) {
+    return;
   }
+  use_occlusion_blur_ = use_occlusion_blur;
+  LoadShaderProgram(asset_manager);
+}
+
+void ObjRenderer::LoadShaderProgram(AAssetManager* asset_manager) {
+  // Loads the shader program based on the selected mode.
+  const int variant = GetShaderVariant();
+  CompileShaderVariant(asset_manager, variant);
+  shader_program_ = shader_variants_[variant];
+
+  // The variants may lay out their attributes differently.
+  position_attrib_ = glGetAttribLocation(shader_program_, "a_Position");
+  tex_coord_attrib_ = glGetAttribLocation(shader_program_, "a_TexCoord");
+  normal_attrib_ = glGetAttribLocation(shader_program_, "a_Normal");
 
   mvp_mat_uniform_ =
       glGetUniformLocation(shader_program_, "u_ModelViewProjection");
@@ -101,6 +236,21 @@ void ObjRenderer::compileAndLoadShaderProgram(AAssetManager* asset_manager) {
     depth_aspect_ratio_uniform_ =
         glGetUniformLocation(shader_program_, "u_DepthAspectRatio");
   }
+
+  // Environmental HDR uniforms.
+  if (use_environmental_hdr_) {
+    spherical_harmonics_uniform_ =
+        glGetUniformLocation(shader_program_, "u_SphericalHarmonics");
+    main_light_direction_uniform_ =
+        glGetUniformLocation(shader_program_, "u_MainLightDirection");
+    main_light_intensity_uniform_ =
+        glGetUniformLocation(shader_program_, "u_MainLightIntensity");
+    cubemap_uniform_ = glGetUniformLocation(shader_program_, "u_Cubemap");
+    view_to_world_uniform_ =
+        glGetUniformLocation(shader_program_, "u_ViewToWorld");
+  }
+  // The program may have been drawn with an older light estimate, or none.
+  uploaded_light_version_ = -1;
 }
 
 void ObjRenderer::SetMaterialProperty(float ambient, float diffuse,
@@ -111,31 +261,37 @@ void ObjRenderer::SetMaterialProperty(float ambient, float diffuse,
   specular_power_ = specular_power;
 }
 
-void ObjRenderer::Draw(const glm::mat4& projection_mat,
-                       const glm::mat4& view_mat, const glm::mat4& model_mat,
-                       const float* color_correction4,
+void ObjRenderer::Draw(const FrameTransforms& transforms,
+                       const glm::mat4& model_mat,
+                       const LightEnvironment& light_environment,
                        const float* object_color4) const {
   if (!shader_program_) {
     LOGE("shader_program is null.");
     return;
   }
+  if (model_.index_count == 0) {
+    // Not loaded yet.
+    return;
+  }
 
-  glUseProgram(shader_program_);
+  gl::UseProgram(shader_program_);
 
-  glActiveTexture(GL_TEXTURE0);
+  gl::ActiveTexture(GL_TEXTURE0);
   glUniform1i(texture_uniform_, 0);
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
+  gl::BindTexture(GL_TEXTURE_2D, model_.texture_id);
 
-  glm::mat4 mvp_mat = projection_mat * view_mat * model_mat;
-  glm::mat4 mv_mat = view_mat * model_mat;
+  glm::mat4 mvp_mat = transforms.view_projection_mat * model_mat;
+  glm::mat4 mv_mat = transforms.view_mat * model_mat;
   glm::vec4 view_light_direction = glm::normalize(mv_mat * kLightDirection);
 
   glUniform4f(lighting_param_uniform_, view_light_direction[0],
               view_light_direction[1], view_light_direction[2], 1.f);
   glUniform4f(material_param_uniform_, ambient_, diffuse_, specular_,
               specular_power_);
-  glUniform4fv(color_correction_param_uniform_, 1, color_correction4);
   glUniform4fv(color_uniform_, 1, object_color4);
+  if (uploaded_light_version_ != light_environment.version) {
+    UploadLightUniforms(light_environment);
+  }
 
   glUniformMatrix4fv(mvp_mat_uniform_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
   glUniformMatrix4fv(mv_mat_uniform_, 1, GL_FALSE, glm::value_ptr(mv_mat));
@@ -143,8 +299,8 @@ void ObjRenderer::Draw(const glm::mat4& projection_mat,
   // Occlusion parameters.
   if (use_depth_for_occlusion_) {
     // Attach the depth texture.
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, depth_texture_id_);
+    gl::ActiveTexture(GL_TEXTURE1);
+    gl::BindTexture(GL_TEXTURE_2D, depth_texture_id_);
     glUniform1i(depth_texture_uniform_, 1);
 
     // Set the depth texture uv transform.
@@ -153,38 +309,67 @@ void ObjRenderer::Draw(const glm::mat4& projection_mat,
     glUniform1f(depth_aspect_ratio_uniform_, depth_aspect_ratio_);
   }
 
-  // Note: for simplicity, we are uploading the model each time we draw it.  A
-  // real application should use vertex buffers to upload the geometry once.
+  if (use_environmental_hdr_) {
+    gl::ActiveTexture(GL_TEXTURE2);
+    gl::BindTexture(GL_TEXTURE_CUBE_MAP, light_environment.cubemap_texture_id);
+    glUniform1i(cubemap_uniform_, 2);
+    // The view matrix is rigid, so its inverse rotation is the transpose.
+    const glm::mat3 view_to_world =
+        glm::transpose(glm::mat3(transforms.view_mat));
+    glUniformMatrix3fv(view_to_world_uniform_, 1, GL_FALSE,
+                       glm::value_ptr(view_to_world));
+  }
+
+  glBindBuffer(GL_ARRAY_BUFFER, model_.vertex_buffer);
   glEnableVertexAttribArray(position_attrib_);
-  glVertexAttribPointer(position_attrib_, 3, GL_FLOAT, GL_FALSE, 0,
-                        vertices_.data());
+  glVertexAttribPointer(position_attrib_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
 
   glEnableVertexAttribArray(normal_attrib_);
   glVertexAttribPointer(normal_attrib_, 3, GL_FLOAT, GL_FALSE, 0,
-                        normals_.data());
+                        reinterpret_cast<const void*>(model_.normals_offset));
 
   glEnableVertexAttribArray(tex_coord_attrib_);
   glVertexAttribPointer(tex_coord_attrib_, 2, GL_FLOAT, GL_FALSE, 0,
-                        uvs_.data());
+                        reinterpret_cast<const void*>(model_.uvs_offset));
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, model_.index_buffer);
 
-  glDepthMask(GL_TRUE);
-  glEnable(GL_BLEND);
+  gl::DepthMask(GL_TRUE);
+  gl::Enable(GL_BLEND);
 
   // Textures are loaded with premultiplied alpha
   // (https://developer.android.com/reference/android/graphics/BitmapFactory.Options#inPremultiplied),
   // so we use the premultiplied alpha blend factors.
-  glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+  gl::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
 
-  glDrawElements(GL_TRIANGLES, indices_.size(), GL_UNSIGNED_SHORT,
-                 indices_.data());
+  gl::DrawElements(GL_TRIANGLES, model_.index_count, GL_UNSIGNED_SHORT,
+                   nullptr);
 
-  glDisable(GL_BLEND);
+  gl::Disable(GL_BLEND);
   glDisableVertexAttribArray(position_attrib_);
   glDisableVertexAttribArray(tex_coord_attrib_);
   glDisableVertexAttribArray(normal_attrib_);
+  // The other renderers draw from client memory.
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-  glUseProgram(0);
+  gl::UseProgram(0);
   util::CheckGlError("obj_renderer::Draw()");
 }
 
+void ObjRenderer::UploadLightUniforms(
+    const LightEnvironment& light_environment) const {
+  if (use_environmental_hdr_) {
+    glUniform3fv(spherical_harmonics_uniform_, 9,
+                 light_environment.spherical_harmonics);
+    glUniform3fv(main_light_direction_uniform_, 1,
+                 light_environment.main_light_direction);
+    glUniform3fv(main_light_intensity_uniform_, 1,
+                 light_environment.main_light_intensity);
+  } else {
+    glUniform4fv(color_correction_param_uniform_, 1,
+                 light_environment.color_correction);
+  }
+  uploaded_light_version_ = light_environment.version;
+}
+
 }  // namespace hello_ar
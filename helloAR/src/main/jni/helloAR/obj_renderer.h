@@ -26,7 +26,11 @@
 #include <vector>
 
 #include "arcore_c_api.h"
+#include "frame_transforms.h"
 #include "glm.h"
+#include "light_estimator.h"
+#include "mesh_bvh.h"
+#include "upload_thread.h"
 
 namespace hello_ar {
 
@@ -42,16 +46,30 @@ class ObjRenderer {
                            const std::string& obj_file_name,
                            const std::string& png_file_name);
 
+  // Like InitializeGlContent, but the model is read and its buffers and
+  // texture are created on upload_thread, so the calling frame doesn't wait
+  // for them. Draw draws nothing, and GetMeshBvh is empty, until
+  // UploadThread::PublishCompleted hands the model over.
+  void InitializeGlContentAsync(AAssetManager* asset_manager,
+                                const std::string& obj_file_name,
+                                const std::string& png_file_name,
+                                UploadThread* upload_thread);
+
   // Sets the surface's lighting reflectace properties.  Diffuse is modulated by
   // the texture's color.
   void SetMaterialProperty(float ambient, float diffuse, float specular,
                            float specular_power);
 
-  // Draws the model.
-  void Draw(const glm::mat4& projection_mat, const glm::mat4& view_mat,
-            const glm::mat4& model_mat, const float* color_correction4,
+  // Draws the model. The light uniforms are only set when light_environment
+  // holds a newer estimate than the last one this renderer drew with.
+  void Draw(const FrameTransforms& transforms, const glm::mat4& model_mat,
+            const LightEnvironment& light_environment,
             const float* object_color4) const;
 
+  // Returns the hierarchy over the model's triangles, for picking placed
+  // instances. Empty until the model is loaded.
+  const MeshBvh& GetMeshBvh() const { return model_.mesh_bvh; }
+
   void SetUvTransformMatrix(const glm::mat3& uv_transform) {
     uv_transform_ = uv_transform;
   }
@@ -65,10 +83,10 @@ class ObjRenderer {
   // of virtual objects from real-world geometry.
   //
   // This function is a no-op if the value provided is the same as what is
-  // already set. If the value changes, this function will recompile and reload
-  // the shader program to either enable/disable depth-based occlusion. NOTE:
-  // recompilation of the shader is inefficient. This code could be optimized to
-  // precompile both versions of the shader.
+  // already set. If the value changes, this function switches to the shader
+  // variant with depth-based occlusion enabled/disabled. The variants that
+  // only differ in occlusion and blur are compiled by InitializeGlContent, so
+  // the switch doesn't compile anything.
   //
   // @param context Context for loading the shader.
   // @param useDepthForOcclusion Specifies whether to use the depth texture to
@@ -76,8 +94,60 @@ class ObjRenderer {
   void setUseDepthForOcclusion(AAssetManager* asset_manager,
                                bool use_depth_for_occlusion);
 
+  // Specifies whether to light the model with the environmental HDR estimate
+  // rather than the ambient color correction. Like setUseDepthForOcclusion,
+  // switches the shader variant when the value changes, compiling it the
+  // first time it is used.
+  void SetUseEnvironmentalHdr(AAssetManager* asset_manager,
+                              bool use_environmental_hdr);
+
+  // Specifies whether depth occlusion is blurred over a 5x5 kernel or taken
+  // from a single depth sample. Switches to the precompiled shader variant
+  // when the value changes.
+  void SetUseOcclusionBlur(AAssetManager* asset_manager,
+                           bool use_occlusion_blur);
+
  private:
-  void compileAndLoadShaderProgram(AAssetManager* asset_manager);
+  // A model read from the assets, and the GL objects it is drawn from.
+  struct Model {
+    MeshBvh mesh_bvh;
+    // Positions, then normals, then uvs.
+    GLuint vertex_buffer = 0;
+    intptr_t normals_offset = 0;
+    intptr_t uvs_offset = 0;
+    GLuint index_buffer = 0;
+    GLsizei index_count = 0;
+    GLuint texture_id = 0;
+  };
+
+  // Reads the model and creates its GL objects with the context current on
+  // the calling thread. Leaves out_model empty if the OBJ file can't be read.
+  static void LoadModel(AAssetManager* asset_manager,
+                        const std::string& obj_file_name,
+                        const std::string& png_file_name, Model* out_model);
+
+  // Shader variants, indexed by a combination of the kShaderVariant* bits.
+  static constexpr int kShaderVariantOcclusion = 1;
+  static constexpr int kShaderVariantEnvironmentalHdr = 2;
+  static constexpr int kShaderVariantOcclusionBlur = 4;
+  static constexpr int kShaderVariantCount = 8;
+
+  // Compiles the variants that the current settings can switch between at
+  // runtime and uses the current one.
+  void InitializeProgram(AAssetManager* asset_manager);
+
+  // Returns the variant selected by the current settings.
+  int GetShaderVariant() const;
+
+  // Compiles the variant unless it already is.
+  void CompileShaderVariant(AAssetManager* asset_manager, int variant);
+
+  // Makes the variant selected by the current settings shader_program_,
+  // compiling it if needed, and looks up its locations.
+  void LoadShaderProgram(AAssetManager* asset_manager);
+
+  // Sets the uniforms that only change with the light estimate.
+  void UploadLightUniforms(const LightEnvironment& light_environment) const;
 
   // Shader material lighting pateremrs
   float ambient_ = 0.0f;
@@ -85,20 +155,14 @@ class ObjRenderer {
   float specular_ = 0.5f;
   float specular_power_ = 6.0f;
 
-  // Model attribute arrays
-  std::vector<GLfloat> vertices_;
-  std::vector<GLfloat> uvs_;
-  std::vector<GLfloat> normals_;
-
-  // Model triangle indices
-  std::vector<GLushort> indices_;
+  Model model_;
 
-  // Loaded TEXTURE_2D object name
-  GLuint texture_id_;
   GLuint depth_texture_id_;
 
-  // Shader program details
-  GLuint shader_program_;
+  // Shader program details. shader_program_ is one of shader_variants_, 0 for
+  // variants that are not compiled yet.
+  GLuint shader_variants_[kShaderVariantCount] = {0};
+  GLuint shader_program_ = 0;
   GLint position_attrib_;
   GLint tex_coord_attrib_;
   GLint normal_attrib_;
@@ -112,8 +176,18 @@ class ObjRenderer {
   GLint depth_texture_uniform_;
   GLint depth_uv_transform_uniform_;
   GLint depth_aspect_ratio_uniform_;
+  GLint spherical_harmonics_uniform_;
+  GLint main_light_direction_uniform_;
+  GLint main_light_intensity_uniform_;
+  GLint cubemap_uniform_;
+  GLint view_to_world_uniform_;
+
+  // LightEnvironment::version last uploaded to shader_program_, -1 if none.
+  mutable int64_t uploaded_light_version_ = -1;
 
   bool use_depth_for_occlusion_ = false;
+  bool use_environmental_hdr_ = false;
+  bool use_occlusion_blur_ = true;
   float depth_aspect_ratio_ = 0.0f;
   glm::mat3 uv_transform_ = glm::mat3(1.0f);
 };
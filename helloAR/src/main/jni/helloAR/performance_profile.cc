@@ -0,0 +1,144 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "performance_profile.h"
+
+#include "scoped_ar_handle.h"
+
+namespace hello_ar {
+namespace {
+constexpr PerformanceProfileSettings kLowPowerSettings = {
+    /*camera_target_fps=*/AR_CAMERA_CONFIG_TARGET_FPS_30,
+    /*camera_depth_sensor_usage=*/
+    AR_CAMERA_CONFIG_DEPTH_SENSOR_USAGE_DO_NOT_USE,
+    /*prefer_smallest_camera_texture=*/true,
+    /*plane_finding_mode=*/AR_PLANE_FINDING_MODE_HORIZONTAL,
+    /*use_depth=*/false,
+    /*use_environmental_hdr=*/false,
+    /*blur_occlusion=*/false,
+    /*draw_point_cloud=*/false,
+    /*feather_planes=*/false,
+};
+
+constexpr PerformanceProfileSettings kBalancedSettings = {
+    /*camera_target_fps=*/AR_CAMERA_CONFIG_TARGET_FPS_30,
+    /*camera_depth_sensor_usage=*/
+    AR_CAMERA_CONFIG_DEPTH_SENSOR_USAGE_REQUIRE_AND_USE |
+        AR_CAMERA_CONFIG_DEPTH_SENSOR_USAGE_DO_NOT_USE,
+    /*prefer_smallest_camera_texture=*/false,
+    /*plane_finding_mode=*/AR_PLANE_FINDING_MODE_HORIZONTAL,
+    /*use_depth=*/true,
+    /*use_environmental_hdr=*/true,
+    /*blur_occlusion=*/true,
+    /*draw_point_cloud=*/true,
+    /*feather_planes=*/true,
+};
+
+// ARCore ranks 60 fps and depth sensor configs first, so devices without
+// them fall back to 30 fps or no sensor.
+constexpr PerformanceProfileSettings kHighFidelitySettings = {
+    /*camera_target_fps=*/AR_CAMERA_CONFIG_TARGET_FPS_60 |
+        AR_CAMERA_CONFIG_TARGET_FPS_30,
+    /*camera_depth_sensor_usage=*/
+    AR_CAMERA_CONFIG_DEPTH_SENSOR_USAGE_REQUIRE_AND_USE |
+        AR_CAMERA_CONFIG_DEPTH_SENSOR_USAGE_DO_NOT_USE,
+    /*prefer_smallest_camera_texture=*/false,
+    /*plane_finding_mode=*/AR_PLANE_FINDING_MODE_HORIZONTAL_AND_VERTICAL,
+    /*use_depth=*/true,
+    /*use_environmental_hdr=*/true,
+    /*blur_occlusion=*/true,
+    /*draw_point_cloud=*/true,
+    /*feather_planes=*/true,
+};
+
+int64_t GetTextureArea(const ArSession* session,
+                       const ArCameraConfig* camera_config) {
+  int32_t width = 0;
+  int32_t height = 0;
+  ArCameraConfig_getTextureDimensions(session, camera_config, &width, &height);
+  return static_cast<int64_t>(width) * height;
+}
+}  // namespace
+
+const PerformanceProfileSettings& GetPerformanceProfileSettings(
+    PerformanceProfile profile) {
+  switch (profile) {
+    case PerformanceProfile::kLowPower:
+      return kLowPowerSettings;
+    case PerformanceProfile::kHighFidelity:
+      return kHighFidelitySettings;
+    case PerformanceProfile::kBalanced:
+      break;
+  }
+  return kBalancedSettings;
+}
+
+bool FindCameraConfig(const ArSession* session,
+                      const PerformanceProfileSettings& settings,
+                      ArCameraConfig* out_camera_config) {
+  util::ScopedArCameraConfigFilter filter;
+  ArCameraConfigFilter_create(session, filter.OutPtr());
+  ArCameraConfigFilter_setTargetFps(session, filter.Get(),
+                                    settings.camera_target_fps);
+  ArCameraConfigFilter_setDepthSensorUsage(session, filter.Get(),
+                                           settings.camera_depth_sensor_usage);
+
+  util::ScopedArCameraConfigList camera_configs;
+  ArCameraConfigList_create(session, camera_configs.OutPtr());
+  ArSession_getSupportedCameraConfigsWithFilter(session, filter.Get(),
+                                                camera_configs.Get());
+  int32_t size = 0;
+  ArCameraConfigList_getSize(session, camera_configs.Get(), &size);
+  if (size == 0) {
+    return false;
+  }
+
+  // Element 0 is the best match by frame rate and depth sensor usage.
+  int32_t best_index = 0;
+  if (settings.prefer_smallest_camera_texture) {
+    int64_t best_area = 0;
+    for (int32_t i = 0; i < size; ++i) {
+      ArCameraConfigList_getItem(session, camera_configs.Get(), i,
+                                 out_camera_config);
+      const int64_t area = GetTextureArea(session, out_camera_config);
+      if (i == 0 || area < best_area) {
+        best_index = i;
+        best_area = area;
+      }
+    }
+  }
+  ArCameraConfigList_getItem(session, camera_configs.Get(), best_index,
+                             out_camera_config);
+  return true;
+}
+
+bool IsSameCameraConfig(const ArSession* session, const ArCameraConfig* a,
+                        const ArCameraConfig* b) {
+  int32_t a_width = 0, a_height = 0, b_width = 0, b_height = 0;
+  ArCameraConfig_getTextureDimensions(session, a, &a_width, &a_height);
+  ArCameraConfig_getTextureDimensions(session, b, &b_width, &b_height);
+  int32_t a_min_fps = 0, a_max_fps = 0, b_min_fps = 0, b_max_fps = 0;
+  ArCameraConfig_getFpsRange(session, a, &a_min_fps, &a_max_fps);
+  ArCameraConfig_getFpsRange(session, b, &b_min_fps, &b_max_fps);
+  uint32_t a_depth_sensor_usage = 0, b_depth_sensor_usage = 0;
+  ArCameraConfig_getDepthSensorUsage(session, a, &a_depth_sensor_usage);
+  ArCameraConfig_getDepthSensorUsage(session, b, &b_depth_sensor_usage);
+  return a_width == b_width && a_height == b_height &&
+         a_min_fps == b_min_fps && a_max_fps == b_max_fps &&
+         a_depth_sensor_usage == b_depth_sensor_usage;
+}
+
+}  // namespace hello_ar
@@ -0,0 +1,79 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_PERFORMANCE_PROFILE_H_
+#define C_ARCORE_PERFORMANCE_PROFILE_H_
+
+#include <cstdint>
+
+#include "arcore_c_api.h"
+
+namespace hello_ar {
+
+// Named trade-offs between power and quality. The values are shared with
+// JniInterface.PERFORMANCE_PROFILE_*.
+enum class PerformanceProfile : int32_t {
+  // 30 fps camera at the smallest texture, horizontal planes only, no depth,
+  // ambient lighting and the cheapest rendering.
+  kLowPower = 0,
+  // ARCore's default camera at 30 fps with every feature the device
+  // supports, as the app behaved before profiles existed.
+  kBalanced = 1,
+  // 60 fps and the depth sensor where available, horizontal and vertical
+  // planes.
+  kHighFidelity = 2,
+};
+
+struct PerformanceProfileSettings {
+  // ArCameraConfigTargetFps and ArCameraConfigDepthSensorUsage bits of the
+  // camera config filter.
+  uint32_t camera_target_fps;
+  uint32_t camera_depth_sensor_usage;
+  // Take the matching camera config with the smallest GPU texture rather
+  // than the one ARCore ranks first.
+  bool prefer_smallest_camera_texture;
+
+  ArPlaneFindingMode plane_finding_mode;
+  // Depth and environmental HDR lighting are only used where the session
+  // supports them.
+  bool use_depth;
+  bool use_environmental_hdr;
+
+  // Blur depth occlusion with a 5x5 kernel rather than one depth sample.
+  bool blur_occlusion;
+  bool draw_point_cloud;
+  // Fade plane edges out, which doubles the vertices of each plane.
+  bool feather_planes;
+};
+
+const PerformanceProfileSettings& GetPerformanceProfileSettings(
+    PerformanceProfile profile);
+
+// Writes to out_camera_config the supported camera config that best matches
+// the camera filter of settings.
+// @return false if the device supports no matching config.
+bool FindCameraConfig(const ArSession* session,
+                      const PerformanceProfileSettings& settings,
+                      ArCameraConfig* out_camera_config);
+
+// Returns true if both configs capture at the same texture size, frame rate
+// range and depth sensor usage, so switching between them changes nothing.
+bool IsSameCameraConfig(const ArSession* session, const ArCameraConfig* a,
+                        const ArCameraConfig* b);
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_PERFORMANCE_PROFILE_H_
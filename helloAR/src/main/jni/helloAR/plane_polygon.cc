@@ -0,0 +1,40 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "plane_polygon.h"
+
+#include "util.h"
+
+namespace hello_ar {
+
+void ReadPlanePolygon(const ArSession& ar_session, const ArPlane& ar_plane,
+                      PlanePolygon* out_polygon) {
+  util::ScopedArPose pose(&ar_session);
+  ArPlane_getCenterPose(&ar_session, &ar_plane, pose.GetArPose());
+  ArPose_getMatrix(&ar_session, pose.GetArPose(),
+                   glm::value_ptr(out_polygon->model_mat));
+
+  int32_t polygon_length = 0;
+  ArPlane_getPolygonSize(&ar_session, &ar_plane, &polygon_length);
+  out_polygon->vertices.resize(polygon_length / 2);
+  if (!out_polygon->vertices.empty()) {
+    ArPlane_getPolygon(&ar_session, &ar_plane,
+                       glm::value_ptr(out_polygon->vertices.front()));
+  }
+}
+
+}  // namespace hello_ar
@@ -0,0 +1,44 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef C_ARCORE_PLANE_POLYGON_H_
+#define C_ARCORE_PLANE_POLYGON_H_
+
+#include <vector>
+
+#include "arcore_c_api.h"
+#include "glm.h"
+
+namespace hello_ar {
+
+// Boundary and pose of a plane as read from ARCore once per frame, so that
+// the meshes and ray casting tables built from it need no ARCore calls and
+// can be built on any thread.
+struct PlanePolygon {
+  glm::mat4 model_mat = glm::mat4(1.0f);
+  // Convex boundary in the plane's local x/z coordinates.
+  std::vector<glm::vec2> vertices;
+};
+
+// Reads the plane's center pose and polygon into out_polygon, reusing its
+// storage.
+void ReadPlanePolygon(const ArSession& ar_session, const ArPlane& ar_plane,
+                      PlanePolygon* out_polygon);
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_PLANE_POLYGON_H_
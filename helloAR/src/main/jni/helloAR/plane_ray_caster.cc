@@ -0,0 +1,140 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "plane_ray_caster.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "util.h"
+
+namespace hello_ar {
+namespace {
+// Rays closer than this to parallel with a plane never hit it.
+constexpr float kMinCosine = 1e-6f;
+}  // namespace
+
+void PlaneRayCaster::SetPlaneCount(int32_t plane_count) {
+  if (static_cast<int32_t>(planes_.size()) < plane_count) {
+    planes_.resize(plane_count);
+  }
+  plane_count_ = plane_count;
+}
+
+void PlaneRayCaster::BuildPlane(int32_t index, const PlanePolygon& polygon) {
+  const glm::mat4& model_mat = polygon.model_mat;
+  CachedPlane& plane = planes_[index];
+  plane.center = glm::vec3(model_mat[3]);
+  plane.axis_x = glm::vec3(model_mat[0]);
+  plane.normal = glm::vec3(model_mat[1]);
+  plane.axis_z = glm::vec3(model_mat[2]);
+  plane.edges.clear();
+
+  const std::vector<glm::vec2>& vertices = polygon.vertices;
+  const int32_t vertices_size = static_cast<int32_t>(vertices.size());
+  if (vertices_size < 3) {
+    // Never hit, see Raycast.
+    plane.bounding_radius_squared = -1.f;
+    return;
+  }
+
+  // The polygon is convex. Its winding decides which side of each edge is
+  // inside.
+  float twice_area = 0.f;
+  for (int32_t i = 0; i < vertices_size; ++i) {
+    const int32_t j = (i + 1) % vertices_size;
+    twice_area += vertices[i].x * vertices[j].y - vertices[j].x * vertices[i].y;
+  }
+  const float winding = twice_area < 0.f ? -1.f : 1.f;
+
+  plane.bounding_radius_squared = 0.f;
+  for (int32_t i = 0; i < vertices_size; ++i) {
+    const int32_t j = (i + 1) % vertices_size;
+    const glm::vec2& from = vertices[i];
+    const glm::vec2& to = vertices[j];
+    // Outward normal of the edge for the polygon's winding.
+    const glm::vec2 outward = winding * glm::vec2(to.y - from.y,
+                                                  from.x - to.x);
+    plane.edges.push_back(
+        glm::vec3(outward.x, outward.y, glm::dot(outward, from)));
+    plane.bounding_radius_squared =
+        std::max(plane.bounding_radius_squared, glm::dot(from, from));
+  }
+}
+
+bool PlaneRayCaster::Raycast(const glm::vec3& origin,
+                             const glm::vec3& direction,
+                             PlaneRayHit* out_hit) const {
+  const glm::vec3 unit_direction = glm::normalize(direction);
+  bool found = false;
+  for (int32_t i = 0; i < plane_count_; ++i) {
+    const CachedPlane& plane = planes_[i];
+    // Rays from behind the plane never hit it, like hit tests checked with
+    // util::CalculateDistanceToPlane.
+    const float origin_height = glm::dot(plane.normal, origin - plane.center);
+    if (origin_height < 0.f) {
+      continue;
+    }
+    const float cosine = glm::dot(plane.normal, unit_direction);
+    if (cosine > -kMinCosine) {
+      continue;
+    }
+    const float distance = -origin_height / cosine;
+    if (found && distance >= out_hit->distance) {
+      continue;
+    }
+
+    const glm::vec3 offset = origin + distance * unit_direction - plane.center;
+    const float x = glm::dot(offset, plane.axis_x);
+    const float z = glm::dot(offset, plane.axis_z);
+    if (x * x + z * z > plane.bounding_radius_squared) {
+      continue;
+    }
+    bool inside = true;
+    for (const glm::vec3& edge : plane.edges) {
+      if (edge.x * x + edge.y * z > edge.z) {
+        inside = false;
+        break;
+      }
+    }
+    if (!inside) {
+      continue;
+    }
+
+    found = true;
+    out_hit->position = plane.center + offset;
+    out_hit->normal = plane.normal;
+    out_hit->distance = distance;
+    out_hit->plane_index = i;
+  }
+  return found;
+}
+
+bool PlaneRayCaster::RaycastScreenPoint(const glm::mat4& view_mat,
+                                        const glm::mat4& projection_mat,
+                                        int width, int height, float x,
+                                        float y, PlaneRayHit* out_hit) const {
+  if (plane_count_ == 0 || width <= 0 || height <= 0) {
+    return false;
+  }
+  glm::vec3 origin;
+  glm::vec3 direction;
+  util::GetScreenPointRay(view_mat, projection_mat, width, height, x, y,
+                          &origin, &direction);
+  return Raycast(origin, direction, out_hit);
+}
+
+}  // namespace hello_ar
@@ -0,0 +1,95 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_PLANE_RAY_CASTER_H_
+#define C_ARCORE_PLANE_RAY_CASTER_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "arcore_c_api.h"
+#include "glm.h"
+#include "plane_polygon.h"
+
+namespace hello_ar {
+
+// Nearest plane hit of a ray.
+struct PlaneRayHit {
+  glm::vec3 position;
+  glm::vec3 normal;
+  // Distance along the normalized ray direction, in meters.
+  float distance = 0.f;
+  // Index of the plane in the order it was added this frame.
+  int32_t plane_index = -1;
+};
+
+// Casts rays against the tracked planes on the CPU. The planes' poses and
+// boundary polygons are cached once per frame, with each polygon's edges
+// turned into half-plane equations, so a query costs a few dot products per
+// plane and never calls ARCore. Hits follow the same rules as placing
+// content through ARCore hit tests: inside the polygon and from the front of
+// the plane, see util::CalculateDistanceToPlane.
+class PlaneRayCaster {
+ public:
+  PlaneRayCaster() = default;
+
+  // Forgets the planes of the previous frame. Keeps their storage.
+  void Clear() { SetPlaneCount(0); }
+
+  // Makes room for the tracked, not subsumed planes of the current frame, to
+  // be cached with BuildPlane. Keeps the storage of earlier planes.
+  void SetPlaneCount(int32_t plane_count);
+
+  // Caches the plane at index from polygon. Planes at different indices may
+  // be built concurrently, from any thread.
+  void BuildPlane(int32_t index, const PlanePolygon& polygon);
+
+  // Finds the nearest plane hit by the ray. direction need not be normalized.
+  // @return false if no plane is hit.
+  bool Raycast(const glm::vec3& origin, const glm::vec3& direction,
+               PlaneRayHit* out_hit) const;
+
+  // Like Raycast, for the camera ray through a screen point in pixels.
+  bool RaycastScreenPoint(const glm::mat4& view_mat,
+                          const glm::mat4& projection_mat, int width,
+                          int height, float x, float y,
+                          PlaneRayHit* out_hit) const;
+
+  int32_t GetPlaneCount() const { return plane_count_; }
+
+ private:
+  struct CachedPlane {
+    glm::vec3 center;
+    glm::vec3 normal;
+    // Plane local axes in world space; the polygon lies in the x/z plane.
+    glm::vec3 axis_x;
+    glm::vec3 axis_z;
+    // Squared radius of the circle around the center holding the polygon,
+    // checked before the edges. Negative for planes without a polygon.
+    float bounding_radius_squared = 0.f;
+    // One (a, b, c) per polygon edge: local (x, z) is inside the polygon when
+    // a * x + b * z <= c holds for every edge.
+    std::vector<glm::vec3> edges;
+  };
+
+  // Entries beyond plane_count_ are unused storage from earlier frames.
+  std::vector<CachedPlane> planes_;
+  int32_t plane_count_ = 0;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_PLANE_RAY_CASTER_H_
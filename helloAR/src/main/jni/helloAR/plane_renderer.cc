@@ -16,6 +16,7 @@
 
 #include "plane_renderer.h"
 #include <string>
+#include "gl_wrapper.h"
 #include "util.h"
 
 namespace hello_ar {
@@ -38,7 +39,7 @@ void PlaneRenderer::InitializeGlContent(AAssetManager* asset_manager) {
   attri_vertices_ = glGetAttribLocation(shader_program_, "vertex");
 
   glGenTextures(1, &texture_id_);
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
+  gl::BindTexture(GL_TEXTURE_2D, texture_id_);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
@@ -51,57 +52,70 @@ void PlaneRenderer::InitializeGlContent(AAssetManager* asset_manager) {
 
   glGenerateMipmap(GL_TEXTURE_2D);
 
-  glBindTexture(GL_TEXTURE_2D, 0);
+  gl::BindTexture(GL_TEXTURE_2D, 0);
 
   util::CheckGlError("plane_renderer::InitializeGlContent()");
 }
 
-void PlaneRenderer::Draw(const glm::mat4& projection_mat,
-                         const glm::mat4& view_mat, const ArSession& ar_session,
-                         const ArPlane& ar_plane) {
+void PlaneRenderer::SetPlaneCount(size_t plane_count) {
+  if (meshes_.size() < plane_count) {
+    meshes_.resize(plane_count);
+  }
+  plane_count_ = plane_count;
+}
+
+void PlaneRenderer::Draw(const FrameTransforms& transforms) const {
   if (!shader_program_) {
     LOGE("shader_program is null.");
     return;
   }
+  if (plane_count_ == 0) {
+    return;
+  }
 
-  UpdateForPlane(ar_session, ar_plane);
-
-  glUseProgram(shader_program_);
-  glDepthMask(GL_FALSE);
+  gl::UseProgram(shader_program_);
+  gl::DepthMask(GL_FALSE);
 
-  glActiveTexture(GL_TEXTURE0);
+  gl::ActiveTexture(GL_TEXTURE0);
   glUniform1i(uniform_texture_, 0);
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
-
-  // Compose final mvp matrix for this plane renderer.
-  glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE,
-                     glm::value_ptr(projection_mat * view_mat * model_mat_));
-
-  glUniformMatrix4fv(uniform_model_mat_, 1, GL_FALSE,
-                     glm::value_ptr(model_mat_));
-  glUniform3f(uniform_normal_vec_, normal_vec_.x, normal_vec_.y, normal_vec_.z);
+  gl::BindTexture(GL_TEXTURE_2D, texture_id_);
 
   glEnableVertexAttribArray(attri_vertices_);
-  glVertexAttribPointer(attri_vertices_, 3, GL_FLOAT, GL_FALSE, 0,
-                        vertices_.data());
-
-  glEnable(GL_BLEND);
+  gl::Enable(GL_BLEND);
 
   // Textures are loaded with premultiplied alpha
   // (https://developer.android.com/reference/android/graphics/BitmapFactory.Options#inPremultiplied),
   // so we use the premultiplied alpha blend factors.
-  glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-  glDrawElements(GL_TRIANGLES, triangles_.size(), GL_UNSIGNED_SHORT,
-                 triangles_.data());
+  gl::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+  for (size_t i = 0; i < plane_count_; ++i) {
+    const PlaneMesh& mesh = meshes_[i];
+    if (mesh.triangles.empty()) {
+      continue;
+    }
+    // Compose final mvp matrix for this plane.
+    glUniformMatrix4fv(
+        uniform_mvp_mat_, 1, GL_FALSE,
+        glm::value_ptr(transforms.view_projection_mat * mesh.model_mat));
+
+    glUniformMatrix4fv(uniform_model_mat_, 1, GL_FALSE,
+                       glm::value_ptr(mesh.model_mat));
+    glUniform3f(uniform_normal_vec_, mesh.normal_vec.x, mesh.normal_vec.y,
+                mesh.normal_vec.z);
+
+    glVertexAttribPointer(attri_vertices_, 3, GL_FLOAT, GL_FALSE, 0,
+                          mesh.vertices.data());
+    gl::DrawElements(GL_TRIANGLES, mesh.triangles.size(), GL_UNSIGNED_SHORT,
+                     mesh.triangles.data());
+  }
 
-  glDisable(GL_BLEND);
-  glUseProgram(0);
-  glDepthMask(GL_TRUE);
+  gl::Disable(GL_BLEND);
+  gl::UseProgram(0);
+  gl::DepthMask(GL_TRUE);
   util::CheckGlError("plane_renderer::Draw()");
 }
 
-void PlaneRenderer::UpdateForPlane(const ArSession& ar_session,
-                                   const ArPlane& ar_plane) {
+void PlaneRenderer::BuildMesh(size_t index, const PlanePolygon& polygon) {
   // The following code generates a triangle mesh filling a convex polygon,
   // including a feathered edge for blending.
   //
@@ -114,35 +128,43 @@ void PlaneRenderer::UpdateForPlane(const ArSession& ar_session,
   // |             |      |7-----------6|
   // ---------------     3---------------2
 
-  vertices_.clear();
-  triangles_.clear();
-
-  int32_t polygon_length;
-  ArPlane_getPolygonSize(&ar_session, &ar_plane, &polygon_length);
+  PlaneMesh* mesh = &meshes_[index];
+  std::vector<glm::vec3>& vertices = mesh->vertices;
+  std::vector<GLushort>& triangles = mesh->triangles;
+  vertices.clear();
+  triangles.clear();
 
-  if (polygon_length == 0) {
-    LOGE("PlaneRenderer::UpdatePlane, no valid plane polygon is found");
+  const std::vector<glm::vec2>& raw_vertices = polygon.vertices;
+  const int32_t vertices_size = static_cast<int32_t>(raw_vertices.size());
+  if (vertices_size == 0) {
+    LOGE("PlaneRenderer::BuildMesh, no valid plane polygon is found");
     return;
   }
 
-  const int32_t vertices_size = polygon_length / 2;
-  std::vector<glm::vec2> raw_vertices(vertices_size);
-  ArPlane_getPolygon(&ar_session, &ar_plane,
-                     glm::value_ptr(raw_vertices.front()));
+  mesh->model_mat = polygon.model_mat;
+  // The normal is the local y axis of the plane.
+  mesh->normal_vec = glm::normalize(glm::vec3(polygon.model_mat[1]));
+
+  if (!feather_edges_) {
+    // The polygon alone, opaque up to its edge, as a triangle fan.
+    for (int32_t i = 0; i < vertices_size; ++i) {
+      vertices.push_back(glm::vec3(raw_vertices[i].x, raw_vertices[i].y, 1.0f));
+    }
+    for (int32_t i = 1; i < vertices_size - 1; ++i) {
+      triangles.push_back(0);
+      triangles.push_back(i);
+      triangles.push_back(i + 1);
+    }
+    return;
+  }
 
   // Fill vertex 0 to 3. Note that the vertex.xy are used for x and z
   // position. vertex.z is used for alpha. The outter polygon's alpha
   // is 0.
   for (int32_t i = 0; i < vertices_size; ++i) {
-    vertices_.push_back(glm::vec3(raw_vertices[i].x, raw_vertices[i].y, 0.0f));
+    vertices.push_back(glm::vec3(raw_vertices[i].x, raw_vertices[i].y, 0.0f));
   }
 
-  util::ScopedArPose scopedArPose(&ar_session);
-  ArPlane_getCenterPose(&ar_session, &ar_plane, scopedArPose.GetArPose());
-  ArPose_getMatrix(&ar_session, scopedArPose.GetArPose(),
-                   glm::value_ptr(model_mat_));
-  normal_vec_ = util::GetPlaneNormal(ar_session, *scopedArPose.GetArPose());
-
   // Feather distance 0.2 meters.
   const float kFeatherLength = 0.2f;
   // Feather scale over the distance between plane center and vertices.
@@ -156,29 +178,29 @@ void PlaneRenderer::UpdateForPlane(const ArSession& ar_session,
         1.0f - std::min((kFeatherLength / glm::length(v)), kFeatherScale);
     const glm::vec2 result_v = scale * v;
 
-    vertices_.push_back(glm::vec3(result_v.x, result_v.y, 1.0f));
+    vertices.push_back(glm::vec3(result_v.x, result_v.y, 1.0f));
   }
 
-  const int32_t vertices_length = vertices_.size();
+  const int32_t vertices_length = vertices.size();
   const int32_t half_vertices_length = vertices_length / 2;
 
   // Generate triangle (4, 5, 6) and (4, 6, 7).
   for (int i = half_vertices_length + 1; i < vertices_length - 1; ++i) {
-    triangles_.push_back(half_vertices_length);
-    triangles_.push_back(i);
-    triangles_.push_back(i + 1);
+    triangles.push_back(half_vertices_length);
+    triangles.push_back(i);
+    triangles.push_back(i + 1);
   }
 
   // Generate triangle (0, 1, 4), (4, 1, 5), (5, 1, 2), (5, 2, 6),
   // (6, 2, 3), (6, 3, 7), (7, 3, 0), (7, 0, 4)
   for (int i = 0; i < half_vertices_length; ++i) {
-    triangles_.push_back(i);
-    triangles_.push_back((i + 1) % half_vertices_length);
-    triangles_.push_back(i + half_vertices_length);
+    triangles.push_back(i);
+    triangles.push_back((i + 1) % half_vertices_length);
+    triangles.push_back(i + half_vertices_length);
 
-    triangles_.push_back(i + half_vertices_length);
-    triangles_.push_back((i + 1) % half_vertices_length);
-    triangles_.push_back((i + half_vertices_length + 1) % half_vertices_length +
+    triangles.push_back(i + half_vertices_length);
+    triangles.push_back((i + 1) % half_vertices_length);
+    triangles.push_back((i + half_vertices_length + 1) % half_vertices_length +
                          half_vertices_length);
   }
 }
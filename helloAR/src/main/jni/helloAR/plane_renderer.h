@@ -26,7 +26,9 @@
 #include <vector>
 
 #include "arcore_c_api.h"
+#include "frame_transforms.h"
 #include "glm.h"
+#include "plane_polygon.h"
 
 namespace hello_ar {
 
@@ -40,17 +42,39 @@ class PlaneRenderer {
   // OpenGL thread.
   void InitializeGlContent(AAssetManager* asset_manager);
 
-  // Draws the provided plane.
-  void Draw(const glm::mat4& projection_mat, const glm::mat4& view_mat,
-            const ArSession& ar_session, const ArPlane& ar_plane);
+  // Specifies whether plane edges fade out. Without feathering each plane
+  // has half the vertices. Applies to planes added from then on.
+  void SetFeatherEdges(bool feather_edges) { feather_edges_ = feather_edges; }
+
+  // Forgets the meshes of the previous camera frame.
+  void ClearPlanes() { SetPlaneCount(0); }
+
+  // Makes room for the meshes of plane_count planes, to be built with
+  // BuildMesh and drawn until the next change of count. Keeps the storage of
+  // earlier meshes.
+  void SetPlaneCount(size_t plane_count);
+
+  // Builds the mesh at index from polygon. Meshes at different indices may
+  // be built concurrently, from any thread.
+  void BuildMesh(size_t index, const PlanePolygon& polygon);
+
+  // Draws the planes built since the last SetPlaneCount.
+  void Draw(const FrameTransforms& transforms) const;
 
  private:
-  void UpdateForPlane(const ArSession& ar_session, const ArPlane& ar_plane);
+  struct PlaneMesh {
+    std::vector<glm::vec3> vertices;
+    std::vector<GLushort> triangles;
+    glm::mat4 model_mat = glm::mat4(1.0f);
+    glm::vec3 normal_vec = glm::vec3(0.0f);
+  };
 
-  std::vector<glm::vec3> vertices_;
-  std::vector<GLushort> triangles_;
-  glm::mat4 model_mat_ = glm::mat4(1.0f);
-  glm::vec3 normal_vec_ = glm::vec3(0.0f);
+  // Meshes are kept across frames so that their buffers are reused, only the
+  // first plane_count_ are current. Planes without a polygon have no
+  // triangles.
+  std::vector<PlaneMesh> meshes_;
+  size_t plane_count_ = 0;
+  bool feather_edges_ = true;
 
   GLuint texture_id_;
 
@@ -15,6 +15,7 @@
  */
 
 #include "point_cloud_renderer.h"
+#include "gl_wrapper.h"
 #include "util.h"
 
 namespace hello_ar {
@@ -39,13 +40,9 @@ void PointCloudRenderer::InitializeGlContent(AAssetManager* asset_manager) {
   util::CheckGlError("point_cloud_renderer::InitializeGlContent()");
 }
 
-void PointCloudRenderer::Draw(const glm::mat4& mvp_matrix,
-                              ArSession* ar_session,
-                              ArPointCloud* ar_point_cloud) const {
-  CHECK(shader_program_);
-
-  glUseProgram(shader_program_);
-
+void PointCloudRenderer::Update(ArSession* ar_session,
+                                ArPointCloud* ar_point_cloud) {
+  points_.clear();
   int32_t number_of_points = 0;
   ArPointCloud_getNumberOfPoints(ar_session, ar_point_cloud, &number_of_points);
   if (number_of_points <= 0) {
@@ -54,21 +51,33 @@ void PointCloudRenderer::Draw(const glm::mat4& mvp_matrix,
 
   const float* point_cloud_data;
   ArPointCloud_getData(ar_session, ar_point_cloud, &point_cloud_data);
+  points_.assign(point_cloud_data, point_cloud_data + 4 * number_of_points);
+}
+
+void PointCloudRenderer::Draw(const glm::mat4& mvp_matrix) const {
+  CHECK(shader_program_);
+
+  const int32_t number_of_points = static_cast<int32_t>(points_.size() / 4);
+  if (number_of_points == 0) {
+    return;
+  }
+
+  gl::UseProgram(shader_program_);
 
   glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_matrix));
 
   glEnableVertexAttribArray(attribute_vertices_);
   glVertexAttribPointer(attribute_vertices_, 4, GL_FLOAT, GL_FALSE, 0,
-                        point_cloud_data);
+                        points_.data());
 
   // Set cyan color to the point cloud.
   glUniform4f(uniform_color_, 31.0f / 255.0f, 188.0f / 255.0f, 210.0f / 255.0f,
               1.0f);
-  glUniform1f(uniform_point_size_, 5.0f);
+  glUniform1f(uniform_point_size_, point_size_);
 
-  glDrawArrays(GL_POINTS, 0, number_of_points);
+  gl::DrawArrays(GL_POINTS, 0, number_of_points);
 
-  glUseProgram(0);
+  gl::UseProgram(0);
   util::CheckGlError("PointCloudRenderer::Draw");
 }
 
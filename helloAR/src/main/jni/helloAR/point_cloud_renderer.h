@@ -38,16 +38,30 @@ class PointCloudRenderer {
   // Initialize the GL content, needs to be called on GL thread.
   void InitializeGlContent(AAssetManager* asset_manager);
 
-  // Render the AR point cloud.
+  // Copies the points of the AR point cloud, to be drawn until the next
+  // update.
   //
-  // @param mvp_matrix, the model view projection matrix of point cloud.
   // @param ar_session, the session that is used to query point cloud points
   //     from ar_point_cloud.
   // @param ar_point_cloud, point cloud data to for rendering.
-  void Draw(const glm::mat4& mvp_matrix, ArSession* ar_session,
-            ArPointCloud* ar_point_cloud) const;
+  void Update(ArSession* ar_session, ArPointCloud* ar_point_cloud);
+
+  // Size of the points in pixels.
+  void SetPointSize(float point_size) { point_size_ = point_size; }
+
+  // Forgets the points of the last update.
+  void Clear() { points_.clear(); }
+
+  // Render the points of the last update.
+  //
+  // @param mvp_matrix, the model view projection matrix of point cloud.
+  void Draw(const glm::mat4& mvp_matrix) const;
 
  private:
+  // x, y, z and confidence of every point.
+  std::vector<float> points_;
+  float point_size_ = 5.0f;
+
   GLuint shader_program_;
   GLint attribute_vertices_;
   GLint uniform_mvp_mat_;
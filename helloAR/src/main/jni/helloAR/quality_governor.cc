@@ -0,0 +1,145 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "quality_governor.h"
+
+#include <algorithm>
+
+namespace hello_ar {
+namespace {
+// From full quality down: blurred occlusion, single sample occlusion,
+// smaller points and unfeathered planes, no point cloud, fewer models and
+// three quarter resolution, and finally no occlusion at half resolution.
+constexpr QualityLevel kQualityLevels[QualityGovernor::kLevelCount] = {
+    {true, true, 5.0f, true, 20, 1.0f},
+    {true, false, 5.0f, true, 20, 1.0f},
+    {true, false, 3.0f, false, 20, 1.0f},
+    {true, false, 0.0f, false, 10, 0.75f},
+    {false, false, 0.0f, false, 5, 0.5f},
+};
+
+// Weight of each new frame in the moving average.
+constexpr double kAverageSmoothing = 0.1;
+
+// Fractions of the frame budget. Above the first the level steps down,
+// below the second it may step up.
+constexpr double kDegradeBudgetFraction = 0.85;
+constexpr double kUpgradeBudgetFraction = 0.6;
+
+// Good windows needed before stepping up, doubled after every upgrade that
+// overloads within kProbationWindows windows.
+constexpr int32_t kMinUpgradeHoldWindows = 3;
+constexpr int32_t kMaxUpgradeHoldWindows = 48;
+constexpr int32_t kProbationWindows = 2;
+}  // namespace
+
+constexpr int32_t QualityGovernor::kLevelCount;
+constexpr int32_t QualityGovernor::kWindowFrames;
+
+QualityGovernor::QualityGovernor() { Reset(); }
+
+bool QualityGovernor::OnFrame(int64_t frame_time_ns, int64_t frame_budget_ns) {
+  frame_time_average_ns_ =
+      frame_time_average_ns_ == 0.0
+          ? frame_time_ns
+          : frame_time_average_ns_ +
+                kAverageSmoothing * (frame_time_ns - frame_time_average_ns_);
+  window_ns_[window_size_++] = frame_time_ns;
+
+  // Thermal throttling can't wait for the end of a window.
+  const int32_t thermal_floor = GetThermalFloor();
+  if (level_ < thermal_floor) {
+    ChangeLevel(thermal_floor);
+    return true;
+  }
+  if (window_size_ < kWindowFrames) {
+    return false;
+  }
+
+  // A few slow frames per window, such as shader compiles, are tolerated.
+  const int32_t p90_index = kWindowFrames * 9 / 10;
+  std::nth_element(window_ns_.begin(), window_ns_.begin() + p90_index,
+                   window_ns_.end());
+  frame_time_p90_ns_ = window_ns_[p90_index];
+  window_size_ = 0;
+
+  if (frame_time_p90_ns_ > kDegradeBudgetFraction * frame_budget_ns ||
+      frame_time_average_ns_ > kDegradeBudgetFraction * frame_budget_ns) {
+    good_windows_ = 0;
+    if (level_ == kLevelCount - 1) {
+      return false;
+    }
+    if (probation_windows_ > 0) {
+      upgrade_hold_windows_ =
+          std::min(2 * upgrade_hold_windows_, kMaxUpgradeHoldWindows);
+    }
+    ChangeLevel(level_ + 1);
+    return true;
+  }
+
+  if (probation_windows_ > 0 && --probation_windows_ == 0) {
+    // The upgrade held, so the next one may come sooner again.
+    upgrade_hold_windows_ = kMinUpgradeHoldWindows;
+  }
+  if (level_ == thermal_floor ||
+      frame_time_p90_ns_ >= kUpgradeBudgetFraction * frame_budget_ns) {
+    good_windows_ = 0;
+    return false;
+  }
+  if (++good_windows_ < upgrade_hold_windows_) {
+    return false;
+  }
+  ChangeLevel(level_ - 1);
+  probation_windows_ = kProbationWindows;
+  return true;
+}
+
+const QualityLevel& QualityGovernor::GetQualityLevel() const {
+  return kQualityLevels[level_];
+}
+
+void QualityGovernor::Reset() {
+  ChangeLevel(0);
+  upgrade_hold_windows_ = kMinUpgradeHoldWindows;
+  probation_windows_ = 0;
+  frame_time_p90_ns_ = 0;
+}
+
+int32_t QualityGovernor::GetThermalFloor() const {
+  switch (static_cast<ThermalStatus>(
+      thermal_status_.load(std::memory_order_relaxed))) {
+    case ThermalStatus::kNone:
+    case ThermalStatus::kLight:
+      return 0;
+    case ThermalStatus::kModerate:
+      return 1;
+    case ThermalStatus::kSevere:
+      return 3;
+    default:
+      return kLevelCount - 1;
+  }
+}
+
+void QualityGovernor::ChangeLevel(int32_t level) {
+  level_ = level;
+  window_size_ = 0;
+  frame_time_average_ns_ = 0.0;
+  good_windows_ = 0;
+  probation_windows_ = 0;
+}
+
+}  // namespace hello_ar
@@ -0,0 +1,120 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef C_ARCORE_QUALITY_GOVERNOR_H_
+#define C_ARCORE_QUALITY_GOVERNOR_H_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace hello_ar {
+
+// Android's PowerManager.THERMAL_STATUS_* values.
+enum class ThermalStatus : int32_t {
+  kNone = 0,
+  kLight = 1,
+  kModerate = 2,
+  kSevere = 3,
+  kCritical = 4,
+  kEmergency = 5,
+  kShutdown = 6,
+};
+
+// Rendering quality at one step of the QualityGovernor. The settings only
+// ever lower what the performance profile and the user asked for.
+struct QualityLevel {
+  // Depth occlusion, and its 5x5 blur.
+  bool occlusion;
+  bool blur_occlusion;
+  // Point cloud point size in pixels, 0 to skip the point cloud.
+  float point_size;
+  bool feather_planes;
+  // Most placed models drawn, nearest to the camera first.
+  int32_t max_drawn_anchors;
+  // Fraction of the surface resolution the virtual content is drawn at.
+  float render_scale;
+};
+
+// Closed loop control of the rendering quality. Frame times are collected in
+// windows of kWindowFrames frames, and at the end of each window the
+// governor steps one level down if the 90th percentile or the moving
+// average nears the frame budget, or one level up after several windows
+// well under it. The gap between the two thresholds, the fresh window
+// measured after every change and a hold before upgrading that doubles
+// whenever an upgrade overloads right away keep the level from
+// oscillating. The thermal status sets a floor the level can't rise above.
+//
+// The governor keeps no clock of its own and makes no platform calls, so it
+// can be driven by synthetic frame time traces. Used on the render thread,
+// except for SetThermalStatus.
+class QualityGovernor {
+ public:
+  // Level 0 is full quality, every further level is cheaper.
+  static constexpr int32_t kLevelCount = 5;
+  static constexpr int32_t kWindowFrames = 30;
+
+  QualityGovernor();
+
+  // Records the time the render thread spent on a frame and the time it had
+  // for it, which may change between frames.
+  // @return true if the quality level changed.
+  bool OnFrame(int64_t frame_time_ns, int64_t frame_budget_ns);
+
+  // Safe to call from any thread. Takes effect on the next frame.
+  void SetThermalStatus(ThermalStatus status) {
+    thermal_status_.store(static_cast<int32_t>(status),
+                          std::memory_order_relaxed);
+  }
+
+  int32_t GetLevel() const { return level_; }
+  const QualityLevel& GetQualityLevel() const;
+
+  // Moving average of the frame time since the last level change, and the
+  // 90th percentile of the last complete window.
+  double GetFrameTimeAverageNs() const { return frame_time_average_ns_; }
+  int64_t GetFrameTimeP90Ns() const { return frame_time_p90_ns_; }
+
+  // Returns to full quality and forgets the frame time history.
+  void Reset();
+
+ private:
+  // Lowest level allowed by the thermal status.
+  int32_t GetThermalFloor() const;
+
+  // Moves to level and starts measuring it from scratch.
+  void ChangeLevel(int32_t level);
+
+  std::atomic<int32_t> thermal_status_{0};
+  int32_t level_ = 0;
+
+  std::array<int64_t, kWindowFrames> window_ns_;
+  int32_t window_size_ = 0;
+  double frame_time_average_ns_ = 0.0;
+  int64_t frame_time_p90_ns_ = 0;
+
+  // Consecutive windows well under budget, and how many are needed before
+  // stepping up.
+  int32_t good_windows_ = 0;
+  int32_t upgrade_hold_windows_ = 0;
+  // Windows left in which an overload counts against the last upgrade.
+  int32_t probation_windows_ = 0;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_QUALITY_GOVERNOR_H_
@@ -0,0 +1,329 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "render_thread.h"
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+#include "trace.h"
+#include "util.h"
+
+namespace hello_ar {
+
+constexpr int32_t RenderThread::kDefaultMaxFramesInFlight;
+constexpr int32_t RenderThread::kMaxFramesInFlightLimit;
+
+RenderThread::RenderThread(Callbacks callbacks)
+    : callbacks_(std::move(callbacks)) {}
+
+RenderThread::~RenderThread() { Stop(); }
+
+void RenderThread::SetWindow(ANativeWindow* window) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (stop_requested_) {
+    if (window != nullptr) {
+      ANativeWindow_release(window);
+    }
+    return;
+  }
+  if (window_requests_ != window_changes_ && pending_window_ != nullptr) {
+    // Replaced before the render thread picked it up.
+    ANativeWindow_release(pending_window_);
+  }
+  pending_window_ = window;
+  const int64_t request = ++window_requests_;
+  if (!thread_.joinable()) {
+    if (window == nullptr) {
+      window_changes_ = request;
+      return;
+    }
+    thread_ = std::thread(&RenderThread::Run, this);
+  }
+  wake_.notify_one();
+  if (window == nullptr) {
+    done_.wait(lock, [this, request] { return window_changes_ >= request; });
+  }
+}
+
+void RenderThread::RequestFrame() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  frame_requested_ = true;
+  wake_.notify_one();
+}
+
+void RenderThread::Post(std::function<void()> task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (stop_requested_) {
+    return;
+  }
+  tasks_.push_back(std::move(task));
+  wake_.notify_one();
+}
+
+void RenderThread::Pause() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  paused_ = true;
+  done_.wait(lock, [this] { return !busy_; });
+}
+
+void RenderThread::Resume() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  paused_ = false;
+  wake_.notify_one();
+}
+
+void RenderThread::SetMaxFramesInFlight(int32_t count) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  max_frames_in_flight_ = std::min(std::max(count, 1), kMaxFramesInFlightLimit);
+}
+
+void RenderThread::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_requested_ = true;
+    wake_.notify_one();
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  std::deque<std::function<void()>> tasks;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    tasks.swap(tasks_);
+    if (window_requests_ != window_changes_ && pending_window_ != nullptr) {
+      ANativeWindow_release(pending_window_);
+    }
+    pending_window_ = nullptr;
+    window_changes_ = window_requests_;
+  }
+}
+
+void RenderThread::Run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    wake_.wait(lock, [this] {
+      return stop_requested_ || window_changes_ != window_requests_ ||
+             (!paused_ && has_surface_ &&
+              (frame_requested_ || !tasks_.empty()));
+    });
+    if (stop_requested_) {
+      break;
+    }
+
+    if (window_changes_ != window_requests_) {
+      ANativeWindow* window = pending_window_;
+      pending_window_ = nullptr;
+      const int64_t request = window_requests_;
+      lock.unlock();
+      DestroySurface();
+      if (window != nullptr) {
+        CreateSurface(window);
+      }
+      lock.lock();
+      has_surface_ = surface_ != EGL_NO_SURFACE;
+      window_changes_ = request;
+      done_.notify_all();
+      continue;
+    }
+
+    std::deque<std::function<void()>> tasks;
+    tasks.swap(tasks_);
+    const bool draw_frame = frame_requested_;
+    frame_requested_ = false;
+    const int32_t max_frames_in_flight = max_frames_in_flight_;
+    busy_ = true;
+    lock.unlock();
+    for (std::function<void()>& task : tasks) {
+      task();
+    }
+    tasks.clear();
+    if (draw_frame) {
+      DrawFrame(max_frames_in_flight);
+    }
+    lock.lock();
+    busy_ = false;
+    has_surface_ = surface_ != EGL_NO_SURFACE;
+    done_.notify_all();
+  }
+  lock.unlock();
+
+  DestroySurface();
+  DestroyContext();
+  // The display is shared with every other EGL user of the process, so it
+  // is left initialized.
+  eglReleaseThread();
+}
+
+bool RenderThread::InitializeDisplay() {
+  if (display_ != EGL_NO_DISPLAY) {
+    return true;
+  }
+  EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  if (display == EGL_NO_DISPLAY ||
+      eglInitialize(display, nullptr, nullptr) != EGL_TRUE) {
+    LOGE("RenderThread: cannot initialize EGL, error 0x%x", eglGetError());
+    return false;
+  }
+
+  // The config the GLSurfaceView used: RGBA8888, alpha for plane blending,
+  // and a 16 bit depth buffer.
+  const EGLint config_attributes[] = {
+      EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+      EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+      EGL_RED_SIZE, 8,
+      EGL_GREEN_SIZE, 8,
+      EGL_BLUE_SIZE, 8,
+      EGL_ALPHA_SIZE, 8,
+      EGL_DEPTH_SIZE, 16,
+      EGL_NONE};
+  EGLint config_count = 0;
+  if (eglChooseConfig(display, config_attributes, &config_, 1,
+                      &config_count) != EGL_TRUE ||
+      config_count == 0) {
+    LOGE("RenderThread: no EGL config with RGBA8888 and a depth buffer");
+    return false;
+  }
+
+  const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (extensions != nullptr &&
+      strstr(extensions, "EGL_KHR_fence_sync") != nullptr) {
+    create_sync_ = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(
+        eglGetProcAddress("eglCreateSyncKHR"));
+    destroy_sync_ = reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(
+        eglGetProcAddress("eglDestroySyncKHR"));
+    client_wait_sync_ = reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(
+        eglGetProcAddress("eglClientWaitSyncKHR"));
+  }
+  if (create_sync_ == nullptr || destroy_sync_ == nullptr ||
+      client_wait_sync_ == nullptr) {
+    LOGI("EGL_KHR_fence_sync unavailable, frames in flight are bounded by "
+         "eglSwapBuffers only.");
+    create_sync_ = nullptr;
+  }
+  display_ = display;
+  return true;
+}
+
+void RenderThread::CreateSurface(ANativeWindow* window) {
+  window_ = window;
+  if (!InitializeDisplay()) {
+    return;
+  }
+  EGLint format = 0;
+  eglGetConfigAttrib(display_, config_, EGL_NATIVE_VISUAL_ID, &format);
+  ANativeWindow_setBuffersGeometry(window, 0, 0, format);
+  surface_ = eglCreateWindowSurface(display_, config_, window, nullptr);
+  if (surface_ == EGL_NO_SURFACE) {
+    LOGE("RenderThread: eglCreateWindowSurface failed, error 0x%x",
+         eglGetError());
+    return;
+  }
+
+  const bool is_new_context = context_ == EGL_NO_CONTEXT;
+  if (is_new_context) {
+    const EGLint context_attributes[] = {EGL_CONTEXT_CLIENT_VERSION, 2,
+                                         EGL_NONE};
+    context_ = eglCreateContext(display_, config_, EGL_NO_CONTEXT,
+                                context_attributes);
+    if (context_ == EGL_NO_CONTEXT) {
+      LOGE("RenderThread: eglCreateContext failed, error 0x%x",
+           eglGetError());
+      DestroySurface();
+      return;
+    }
+  }
+  if (eglMakeCurrent(display_, surface_, surface_, context_) != EGL_TRUE) {
+    LOGE("RenderThread: eglMakeCurrent failed, error 0x%x", eglGetError());
+    DestroySurface();
+    return;
+  }
+  if (is_new_context) {
+    callbacks_.on_context_created();
+  }
+}
+
+void RenderThread::DestroySurface() {
+  if (surface_ != EGL_NO_SURFACE) {
+    eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroySurface(display_, surface_);
+    surface_ = EGL_NO_SURFACE;
+  }
+  if (window_ != nullptr) {
+    ANativeWindow_release(window_);
+    window_ = nullptr;
+  }
+}
+
+void RenderThread::DestroyContext() {
+  DestroyFences();
+  if (context_ != EGL_NO_CONTEXT) {
+    // Deletes every GL object of the context with it.
+    eglDestroyContext(display_, context_);
+    context_ = EGL_NO_CONTEXT;
+  }
+}
+
+void RenderThread::DrawFrame(int32_t max_frames_in_flight) {
+  WaitForFramesInFlight(max_frames_in_flight);
+  callbacks_.on_draw_frame();
+  if (create_sync_ != nullptr) {
+    EGLSyncKHR fence = create_sync_(display_, EGL_SYNC_FENCE_KHR, nullptr);
+    if (fence != EGL_NO_SYNC_KHR) {
+      frame_fences_.push_back(fence);
+    }
+  }
+  if (eglSwapBuffers(display_, surface_) == EGL_TRUE) {
+    return;
+  }
+
+  const EGLint error = eglGetError();
+  if (error != EGL_CONTEXT_LOST) {
+    // Typically the window is going away, and SetWindow follows.
+    LOGE("RenderThread: eglSwapBuffers failed, error 0x%x", error);
+    return;
+  }
+  LOGI("RenderThread: EGL context lost, recreating it.");
+  ANativeWindow* window = window_;
+  ANativeWindow_acquire(window);
+  DestroySurface();
+  DestroyContext();
+  CreateSurface(window);
+}
+
+void RenderThread::WaitForFramesInFlight(int32_t count) {
+  if (static_cast<int32_t>(frame_fences_.size()) < count) {
+    return;
+  }
+  TRACE_SCOPE("WaitForGpu");
+  while (static_cast<int32_t>(frame_fences_.size()) >= count) {
+    EGLSyncKHR fence = frame_fences_.front();
+    frame_fences_.pop_front();
+    client_wait_sync_(display_, fence, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR,
+                      EGL_FOREVER_KHR);
+    destroy_sync_(display_, fence);
+  }
+}
+
+void RenderThread::DestroyFences() {
+  for (EGLSyncKHR fence : frame_fences_) {
+    destroy_sync_(display_, fence);
+  }
+  frame_fences_.clear();
+}
+
+}  // namespace hello_ar
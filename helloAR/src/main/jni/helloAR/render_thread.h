@@ -0,0 +1,150 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_RENDER_THREAD_H_
+#define C_ARCORE_RENDER_THREAD_H_
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <android/native_window.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace hello_ar {
+
+// Renders into an ANativeWindow on a thread of its own, in place of the
+// thread of a GLSurfaceView. The thread owns an OpenGL ES 2 context, which it
+// keeps while the window comes and goes, and draws one frame per
+// RequestFrame.
+//
+// eglSwapBuffers returns as soon as a frame is queued, so the thread goes on
+// to the CPU work of frame N + 1 (ArSession_update, reading the scene,
+// culling) while the GPU still executes frame N. An EGL fence after each
+// frame bounds how far ahead it may get: before starting a frame the thread
+// waits until fewer than the maximum frames in flight are unfinished on the
+// GPU. One frame in flight gives the lowest latency from camera image to
+// display, more give the CPU and GPU room to overlap.
+class RenderThread {
+ public:
+  // Run on the render thread with the context current.
+  struct Callbacks {
+    // The context was created, or recreated after it was lost. Every GL
+    // object must be created anew.
+    std::function<void()> on_context_created;
+    // Draws a frame into the window.
+    std::function<void()> on_draw_frame;
+  };
+
+  static constexpr int32_t kDefaultMaxFramesInFlight = 2;
+  static constexpr int32_t kMaxFramesInFlightLimit = 3;
+
+  // The thread starts with the first window, paused.
+  explicit RenderThread(Callbacks callbacks);
+  ~RenderThread();
+
+  RenderThread(const RenderThread&) = delete;
+  RenderThread& operator=(const RenderThread&) = delete;
+
+  // Renders into window from now on, taking over the caller's reference to
+  // it. With nullptr, for a destroyed surface, returns only once the thread
+  // no longer uses the previous window and has released it. Called on the UI
+  // thread.
+  void SetWindow(ANativeWindow* window);
+
+  // Draws a frame once a window is set and the thread is not paused. A
+  // request made while the last one is pending is merged into it. Safe to
+  // call from any thread.
+  void RequestFrame();
+
+  // Runs task on the render thread before the next frame, with the context
+  // current. Tasks wait while there is no window or the thread is paused.
+  // Safe to call from any thread.
+  void Post(std::function<void()> task);
+
+  // Returns once the frame or tasks being run, if any, are finished, and holds
+  // back further ones until Resume. The window is still taken and released
+  // while paused.
+  void Pause();
+  void Resume();
+
+  // Bounds the frames submitted to the GPU and not finished yet to count,
+  // clamped to [1, kMaxFramesInFlightLimit]. Without EGL_KHR_fence_sync only
+  // eglSwapBuffers throttles the thread. Safe to call from any thread.
+  void SetMaxFramesInFlight(int32_t count);
+
+  // Stops and joins the thread, destroying the context and releasing the
+  // window. Tasks not run yet are dropped.
+  void Stop();
+
+ private:
+  void Run();
+
+  // Render thread side. Failures are logged and leave the thread without a
+  // surface until the next window.
+  bool InitializeDisplay();
+  void CreateSurface(ANativeWindow* window);
+  void DestroySurface();
+  void DestroyContext();
+  void DrawFrame(int32_t max_frames_in_flight);
+  // Waits for the oldest fences until fewer than count frames are in flight.
+  void WaitForFramesInFlight(int32_t count);
+  void DestroyFences();
+
+  const Callbacks callbacks_;
+  std::thread thread_;
+
+  std::mutex mutex_;
+  // Wakes the render thread.
+  std::condition_variable wake_;
+  // Wakes callers waiting for the render thread.
+  std::condition_variable done_;
+  // Guarded by mutex_.
+  bool stop_requested_ = false;
+  bool paused_ = true;
+  // Whether the thread is running a frame or tasks.
+  bool busy_ = false;
+  bool frame_requested_ = false;
+  std::deque<std::function<void()>> tasks_;
+  int32_t max_frames_in_flight_ = kDefaultMaxFramesInFlight;
+  // The window the thread is to switch to, and how many switches were
+  // requested and done.
+  ANativeWindow* pending_window_ = nullptr;
+  int64_t window_requests_ = 0;
+  int64_t window_changes_ = 0;
+  bool has_surface_ = false;
+
+  // Only touched on the render thread.
+  EGLDisplay display_ = EGL_NO_DISPLAY;
+  EGLConfig config_ = nullptr;
+  EGLContext context_ = EGL_NO_CONTEXT;
+  EGLSurface surface_ = EGL_NO_SURFACE;
+  ANativeWindow* window_ = nullptr;
+  // Fences after the frames that may still be executing, oldest first.
+  std::deque<EGLSyncKHR> frame_fences_;
+  // EGL_KHR_fence_sync entry points, null if the extension is missing.
+  PFNEGLCREATESYNCKHRPROC create_sync_ = nullptr;
+  PFNEGLDESTROYSYNCKHRPROC destroy_sync_ = nullptr;
+  PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync_ = nullptr;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_RENDER_THREAD_H_
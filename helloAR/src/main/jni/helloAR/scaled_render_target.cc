@@ -0,0 +1,179 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "scaled_render_target.h"
+
+#include <EGL/egl.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "gl_wrapper.h"
+#include "util.h"
+
+namespace hello_ar {
+namespace {
+// Positions of the quad vertices in clip space (X, Y).
+const GLfloat kVertices[] = {
+    -1.0f, -1.0f, +1.0f, -1.0f, -1.0f, +1.0f, +1.0f, +1.0f,
+};
+
+constexpr char kVertexShaderFilename[] = "shaders/composite.vert";
+constexpr char kFragmentShaderFilename[] = "shaders/composite.frag";
+}  // namespace
+
+constexpr float ScaledRenderTarget::kMinScale;
+
+void ScaledRenderTarget::InitializeGlContent(AAssetManager* asset_manager) {
+  program_ = util::CreateProgram(kVertexShaderFilename,
+                                 kFragmentShaderFilename, asset_manager);
+  if (!program_) {
+    LOGE("Could not create program.");
+  }
+  position_attrib_ = glGetAttribLocation(program_, "a_Position");
+  texture_uniform_ = glGetUniformLocation(program_, "u_Texture");
+
+  // Tilers can skip writing the depth buffer back to memory when told it is
+  // no longer needed.
+  const char* extensions =
+      reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+  discard_framebuffer_ =
+      extensions != nullptr &&
+              strstr(extensions, "GL_EXT_discard_framebuffer") != nullptr
+          ? reinterpret_cast<PFNGLDISCARDFRAMEBUFFEREXTPROC>(
+                eglGetProcAddress("glDiscardFramebufferEXT"))
+          : nullptr;
+
+  // A new context holds none of the old buffers.
+  framebuffer_ = 0;
+  color_texture_ = 0;
+  depth_renderbuffer_ = 0;
+  width_ = 0;
+  height_ = 0;
+  util::CheckGlError("ScaledRenderTarget::InitializeGlContent()");
+}
+
+void ScaledRenderTarget::Resize(int width, int height, float scale) {
+  surface_width_ = width;
+  surface_height_ = height;
+  scale_ = std::max(kMinScale, std::min(scale, 1.0f));
+  const int scaled_width =
+      scale_ < 1.0f ? std::max(1, static_cast<int>(std::lround(width * scale_)))
+                    : 0;
+  const int scaled_height =
+      scale_ < 1.0f
+          ? std::max(1, static_cast<int>(std::lround(height * scale_)))
+          : 0;
+  if (scaled_width == width_ && scaled_height == height_) {
+    return;
+  }
+  ReleaseBuffers();
+  width_ = scaled_width;
+  height_ = scaled_height;
+  if (width_ == 0) {
+    return;
+  }
+
+  glGenTextures(1, &color_texture_);
+  gl::BindTexture(GL_TEXTURE_2D, color_texture_);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  gl::TexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width_, height_, 0, GL_RGBA,
+                 GL_UNSIGNED_BYTE, nullptr);
+  gl::BindTexture(GL_TEXTURE_2D, 0);
+
+  glGenRenderbuffers(1, &depth_renderbuffer_);
+  glBindRenderbuffer(GL_RENDERBUFFER, depth_renderbuffer_);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, width_,
+                        height_);
+  glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+  glGenFramebuffers(1, &framebuffer_);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         color_texture_, 0);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT,
+                            GL_RENDERBUFFER, depth_renderbuffer_);
+  const GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    LOGE("ScaledRenderTarget::Resize incomplete framebuffer 0x%x", status);
+    ReleaseBuffers();
+  }
+  util::CheckGlError("ScaledRenderTarget::Resize()");
+}
+
+void ScaledRenderTarget::Begin() {
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer_);
+  gl::Viewport(0, 0, width_, height_);
+  gl::ClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void ScaledRenderTarget::End() {
+  if (discard_framebuffer_ != nullptr) {
+    const GLenum attachment = GL_DEPTH_ATTACHMENT;
+    discard_framebuffer_(GL_FRAMEBUFFER, 1, &attachment);
+  }
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  gl::Viewport(0, 0, surface_width_, surface_height_);
+}
+
+void ScaledRenderTarget::Composite() const {
+  CHECK(program_);
+
+  // The content is premultiplied and was cleared to transparent, so
+  // blending it over the camera gives what drawing it there directly would.
+  gl::Disable(GL_DEPTH_TEST);
+  gl::Enable(GL_BLEND);
+  gl::BlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+  gl::UseProgram(program_);
+  gl::ActiveTexture(GL_TEXTURE0);
+  gl::BindTexture(GL_TEXTURE_2D, color_texture_);
+  glUniform1i(texture_uniform_, 0);
+  glVertexAttribPointer(position_attrib_, 2, GL_FLOAT, GL_FALSE, 0, kVertices);
+  glEnableVertexAttribArray(position_attrib_);
+
+  gl::DrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+  glDisableVertexAttribArray(position_attrib_);
+  gl::BindTexture(GL_TEXTURE_2D, 0);
+  gl::UseProgram(0);
+  gl::Enable(GL_DEPTH_TEST);
+  util::CheckGlError("ScaledRenderTarget::Composite()");
+}
+
+void ScaledRenderTarget::ReleaseBuffers() {
+  if (framebuffer_ != 0) {
+    glDeleteFramebuffers(1, &framebuffer_);
+    framebuffer_ = 0;
+  }
+  if (color_texture_ != 0) {
+    glDeleteTextures(1, &color_texture_);
+    color_texture_ = 0;
+  }
+  if (depth_renderbuffer_ != 0) {
+    glDeleteRenderbuffers(1, &depth_renderbuffer_);
+    depth_renderbuffer_ = 0;
+  }
+}
+
+}  // namespace hello_ar
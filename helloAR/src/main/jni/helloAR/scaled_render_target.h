@@ -0,0 +1,80 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef C_ARCORE_SCALED_RENDER_TARGET_H_
+#define C_ARCORE_SCALED_RENDER_TARGET_H_
+
+#include <GLES2/gl2.h>
+#include <GLES2/gl2ext.h>
+#include <android/asset_manager.h>
+
+namespace hello_ar {
+
+// Offscreen color and depth buffers for the virtual content at a fraction of
+// the surface resolution, composited over the full resolution camera image
+// afterwards. Fragment cost drops with the square of the scale, at the price
+// of a softer image and one full screen blend. At scale 1 the target is
+// disabled and content should be drawn straight to the surface. Used on the
+// OpenGL thread.
+class ScaledRenderTarget {
+ public:
+  static constexpr float kMinScale = 0.5f;
+
+  ScaledRenderTarget() = default;
+  ~ScaledRenderTarget() = default;
+
+  void InitializeGlContent(AAssetManager* asset_manager);
+
+  // Sizes the buffers for a width x height surface at scale, clamped to
+  // [kMinScale, 1]. Buffers are only reallocated when their size changes.
+  void Resize(int width, int height, float scale);
+
+  // False at scale 1, or if the buffers could not be created.
+  bool IsEnabled() const { return framebuffer_ != 0; }
+  float GetScale() const { return IsEnabled() ? scale_ : 1.0f; }
+
+  // Binds the buffers and clears them to transparent, for drawing the
+  // virtual content with premultiplied alpha blending.
+  void Begin();
+
+  // Drops the depth buffer and binds the surface again at full resolution.
+  void End();
+
+  // Blends the content drawn between Begin and End over the surface.
+  void Composite() const;
+
+ private:
+  void ReleaseBuffers();
+
+  GLuint program_ = 0;
+  GLint position_attrib_ = -1;
+  GLint texture_uniform_ = -1;
+  PFNGLDISCARDFRAMEBUFFEREXTPROC discard_framebuffer_ = nullptr;
+
+  int surface_width_ = 1;
+  int surface_height_ = 1;
+  float scale_ = 1.0f;
+  int width_ = 0;
+  int height_ = 0;
+  GLuint framebuffer_ = 0;
+  GLuint color_texture_ = 0;
+  GLuint depth_renderbuffer_ = 0;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_SCALED_RENDER_TARGET_H_
@@ -0,0 +1,170 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_SCOPED_AR_HANDLE_H_
+#define C_ARCORE_SCOPED_AR_HANDLE_H_
+
+#ifdef HELLOAR_TRACK_AR_HANDLES
+#include <atomic>
+#endif  // HELLOAR_TRACK_AR_HANDLES
+
+#include "arcore_c_api.h"
+
+namespace hello_ar {
+namespace util {
+
+#ifdef HELLOAR_TRACK_AR_HANDLES
+// Number of handles of type T currently owned by a ScopedArHandle. Only
+// maintained when built with HELLOAR_TRACK_AR_HANDLES, so that long-running
+// sessions can verify that the counts stay bounded.
+template <typename T>
+struct LiveArHandleCount {
+  static std::atomic<int> value;
+};
+template <typename T>
+std::atomic<int> LiveArHandleCount<T>::value(0);
+#endif  // HELLOAR_TRACK_AR_HANDLES
+
+// Move-only owner of a single ARCore handle. The release function is a
+// template argument, so an instance is exactly one pointer wide and every
+// accessor inlines to a raw pointer access.
+//
+// Typical use with the ARCore acquire/create functions:
+//
+//   ScopedArTrackable trackable;
+//   ArTrackableList_acquireItem(session, list, i, trackable.OutPtr());
+//   ArTrackable_getType(session, trackable.Get(), &type);
+template <typename T, void (*ReleaseFunction)(T*)>
+class ScopedArHandle {
+#ifdef HELLOAR_TRACK_AR_HANDLES
+  // Out parameter proxy which records the handle written by the ARCore call
+  // once the full expression containing OutPtr() has been evaluated.
+  class OutParam {
+   public:
+    explicit OutParam(T** handle) : handle_(handle) {}
+    ~OutParam() {
+      if (*handle_ != nullptr) {
+        ++LiveArHandleCount<T>::value;
+      }
+    }
+    operator T**() const { return handle_; }
+
+   private:
+    T** handle_;
+  };
+#else
+  using OutParam = T**;
+#endif  // HELLOAR_TRACK_AR_HANDLES
+
+ public:
+  ScopedArHandle() = default;
+  explicit ScopedArHandle(T* handle) : handle_(handle) {
+#ifdef HELLOAR_TRACK_AR_HANDLES
+    if (handle_ != nullptr) {
+      ++LiveArHandleCount<T>::value;
+    }
+#endif  // HELLOAR_TRACK_AR_HANDLES
+  }
+  ~ScopedArHandle() { Reset(); }
+
+  ScopedArHandle(ScopedArHandle&& other) : handle_(other.Release()) {}
+  ScopedArHandle& operator=(ScopedArHandle&& other) {
+    if (this != &other) {
+      Reset(other.Release());
+    }
+    return *this;
+  }
+
+  // Delete copy constructors.
+  ScopedArHandle(const ScopedArHandle&) = delete;
+  void operator=(const ScopedArHandle&) = delete;
+
+  T* Get() const { return handle_; }
+
+  // Releases the currently owned handle and returns the address of the
+  // internal pointer, to be passed as the out parameter of an ARCore call.
+  OutParam OutPtr() {
+    Reset();
+    return OutParam(&handle_);
+  }
+
+  // Gives up ownership without releasing the handle.
+  T* Release() {
+#ifdef HELLOAR_TRACK_AR_HANDLES
+    if (handle_ != nullptr) {
+      --LiveArHandleCount<T>::value;
+    }
+#endif  // HELLOAR_TRACK_AR_HANDLES
+    T* handle = handle_;
+    handle_ = nullptr;
+    return handle;
+  }
+
+  void Reset(T* handle = nullptr) {
+    if (handle_ != nullptr) {
+      ReleaseFunction(handle_);
+#ifdef HELLOAR_TRACK_AR_HANDLES
+      --LiveArHandleCount<T>::value;
+#endif  // HELLOAR_TRACK_AR_HANDLES
+    }
+#ifdef HELLOAR_TRACK_AR_HANDLES
+    if (handle != nullptr) {
+      ++LiveArHandleCount<T>::value;
+    }
+#endif  // HELLOAR_TRACK_AR_HANDLES
+    handle_ = handle;
+  }
+
+  explicit operator bool() const { return handle_ != nullptr; }
+
+ private:
+  T* handle_ = nullptr;
+};
+
+using ScopedArAnchor = ScopedArHandle<ArAnchor, ArAnchor_release>;
+using ScopedArCamera = ScopedArHandle<ArCamera, ArCamera_release>;
+using ScopedArCameraConfig =
+    ScopedArHandle<ArCameraConfig, ArCameraConfig_destroy>;
+using ScopedArCameraConfigFilter =
+    ScopedArHandle<ArCameraConfigFilter, ArCameraConfigFilter_destroy>;
+using ScopedArCameraConfigList =
+    ScopedArHandle<ArCameraConfigList, ArCameraConfigList_destroy>;
+using ScopedArHitResult = ScopedArHandle<ArHitResult, ArHitResult_destroy>;
+using ScopedArHitResultList =
+    ScopedArHandle<ArHitResultList, ArHitResultList_destroy>;
+using ScopedArImage = ScopedArHandle<ArImage, ArImage_release>;
+using ScopedArLightEstimate =
+    ScopedArHandle<ArLightEstimate, ArLightEstimate_destroy>;
+using ScopedArPointCloud = ScopedArHandle<ArPointCloud, ArPointCloud_release>;
+using ScopedArTrackable = ScopedArHandle<ArTrackable, ArTrackable_release>;
+using ScopedArTrackableList =
+    ScopedArHandle<ArTrackableList, ArTrackableList_destroy>;
+
+static_assert(sizeof(ScopedArTrackable) == sizeof(ArTrackable*),
+              "ScopedArHandle must not add storage over a raw pointer");
+
+#ifdef HELLOAR_TRACK_AR_HANDLES
+// Logs the number of live handles per ARCore type.
+void LogLiveArHandleCounts();
+
+// Returns the total number of live handles of all ARCore types.
+int GetTotalLiveArHandleCount();
+#endif  // HELLOAR_TRACK_AR_HANDLES
+
+}  // namespace util
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_SCOPED_AR_HANDLE_H_
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "status_block.h"
+
+#include <cstring>
+
+namespace hello_ar {
+
+bool StatusBlock::Attach(void* address, int64_t capacity) {
+  if (address == nullptr ||
+      capacity < static_cast<int64_t>(sizeof(AppStatus)) ||
+      reinterpret_cast<uintptr_t>(address) % alignof(AppStatus) != 0) {
+    return false;
+  }
+  block_ = static_cast<AppStatus*>(address);
+  memset(block_, 0, sizeof(AppStatus));
+  block_->version = kAppStatusVersion;
+  return true;
+}
+
+void StatusBlock::Publish(const AppStatus& status) {
+  if (block_ == nullptr) {
+    return;
+  }
+  const uint32_t sequence =
+      __atomic_load_n(&block_->sequence, __ATOMIC_RELAXED);
+  __atomic_store_n(&block_->sequence, sequence + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  block_->version = kAppStatusVersion;
+  block_->plane_count = status.plane_count;
+  block_->tracking_state = status.tracking_state;
+  block_->is_depth_supported = status.is_depth_supported;
+  block_->anchor_count = status.anchor_count;
+  block_->frame_timestamp_ns = status.frame_timestamp_ns;
+  block_->frame_time_ns = status.frame_time_ns;
+  block_->reticle_hit = status.reticle_hit;
+  memcpy(block_->reticle_position, status.reticle_position,
+         sizeof(status.reticle_position));
+  __atomic_store_n(&block_->sequence, sequence + 2, __ATOMIC_RELEASE);
+}
+
+}  // namespace hello_ar
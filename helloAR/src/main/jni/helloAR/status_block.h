@@ -0,0 +1,74 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_STATUS_BLOCK_H_
+#define C_ARCORE_STATUS_BLOCK_H_
+
+#include <cstdint>
+
+namespace hello_ar {
+
+// Bumped whenever the layout of AppStatus changes. Java checks it against
+// STATUS_VERSION in JniInterface.java before trusting the buffer.
+constexpr int32_t kAppStatusVersion = 2;
+
+// State the Java UI reads every frame. Laid out in a direct ByteBuffer owned
+// by JniInterface; keep the field offsets in sync with the STATUS_* constants
+// there. All fields are in native byte order.
+struct AppStatus {
+  // Odd while a frame's status is being written, even once it is complete.
+  // Readers retry when it is odd or changes under them.
+  uint32_t sequence;
+  int32_t version;
+  int32_t plane_count;
+  // An ArTrackingState value of the camera.
+  int32_t tracking_state;
+  int32_t is_depth_supported;
+  int32_t anchor_count;
+  // ArFrame timestamp of the frame, in nanoseconds.
+  int64_t frame_timestamp_ns;
+  // Time spent in OnDrawFrame for the frame, in nanoseconds.
+  int64_t frame_time_ns;
+  // 1 if the ray through the screen center hits a plane, at
+  // reticle_position in world space.
+  int32_t reticle_hit;
+  float reticle_position[3];
+};
+
+static_assert(sizeof(AppStatus) == 56, "Update JniInterface.STATUS_SIZE_BYTES");
+
+// Publishes AppStatus snapshots into a buffer shared with Java, so the UI can
+// poll them without crossing JNI. Only used on the OpenGL thread.
+class StatusBlock {
+ public:
+  StatusBlock() = default;
+
+  // Starts publishing into the capacity bytes at address, which must stay
+  // valid until Detach. Returns false if the buffer is too small.
+  bool Attach(void* address, int64_t capacity);
+
+  void Detach() { block_ = nullptr; }
+
+  // Writes status as the latest snapshot. Does nothing while detached.
+  void Publish(const AppStatus& status);
+
+ private:
+  AppStatus* block_ = nullptr;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_STATUS_BLOCK_H_
@@ -20,6 +20,7 @@
 #include <GLES3/gl31.h>
 #include <GLES2/gl2ext.h>
 // clang-format on
+#include "gl_wrapper.h"
 #include "util.h"
 
 namespace hello_ar {
@@ -29,7 +30,7 @@ void Texture::CreateOnGlThread() {
   glGenTextures(1, texture_id_array);
   texture_id_ = texture_id_array[0];
 
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
+  gl::BindTexture(GL_TEXTURE_2D, texture_id_);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
   glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
@@ -38,18 +39,19 @@ void Texture::CreateOnGlThread() {
 
 void Texture::UpdateWithDepthImageOnGlThread(const ArSession& session,
                                              const ArFrame& frame) {
-  ArImage* depth_image = nullptr;
-  if (ArFrame_acquireDepthImage(&session, &frame, &depth_image) != AR_SUCCESS) {
+  // Released on every return path, including the early outs below.
+  util::ScopedArImage scoped_depth_image;
+  if (ArFrame_acquireDepthImage(&session, &frame,
+                                scoped_depth_image.OutPtr()) != AR_SUCCESS) {
     // No depth image received for this frame.
     return;
   }
+  const ArImage* depth_image = scoped_depth_image.Get();
   // Checks that the format is as expected.
   ArImageFormat image_format;
   ArImage_getFormat(&session, depth_image, &image_format);
   if (image_format != AR_IMAGE_FORMAT_DEPTH16) {
-    LOGE("Unexpected image format 0x%x", image_format);
-    abort();
-    return;
+    HELLOAR_LOG_FATAL("Unexpected image format 0x%x", image_format);
   }
 
   const uint8_t* depth_data = nullptr;
@@ -69,9 +71,9 @@ void Texture::UpdateWithDepthImageOnGlThread(const ArSession& session,
   ArImage_getHeight(&session, depth_image, &image_height);
   ArImage_getPlanePixelStride(&session, depth_image, 0, &image_pixel_stride);
   ArImage_getPlaneRowStride(&session, depth_image, 0, &image_row_stride);
-  glBindTexture(GL_TEXTURE_2D, texture_id_);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, image_width, image_height, 0, GL_RG,
-               GL_UNSIGNED_BYTE, depth_data);
+  gl::BindTexture(GL_TEXTURE_2D, texture_id_);
+  gl::TexImage2D(GL_TEXTURE_2D, 0, GL_RG8, image_width, image_height, 0, GL_RG,
+                 GL_UNSIGNED_BYTE, depth_data);
   width_ = image_width;
   height_ = image_height;
 }
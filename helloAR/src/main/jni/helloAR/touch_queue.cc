@@ -0,0 +1,49 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "touch_queue.h"
+
+namespace hello_ar {
+
+constexpr uint32_t TouchQueue::kCapacity;
+
+bool TouchQueue::Push(const TouchEvent& event) {
+  const uint32_t tail = tail_.load(std::memory_order_relaxed);
+  if (tail - head_.load(std::memory_order_acquire) == kCapacity) {
+    return false;
+  }
+  events_[tail & (kCapacity - 1)] = event;
+  tail_.store(tail + 1, std::memory_order_release);
+  return true;
+}
+
+void TouchQueue::Drain(std::vector<TouchEvent>* out) {
+  out->clear();
+  uint32_t head = head_.load(std::memory_order_relaxed);
+  const uint32_t tail = tail_.load(std::memory_order_acquire);
+  for (; head != tail; ++head) {
+    const TouchEvent& event = events_[head & (kCapacity - 1)];
+    if (event.type == TouchEvent::Type::kDrag && !out->empty() &&
+        out->back().type == TouchEvent::Type::kDrag) {
+      out->back() = event;
+    } else {
+      out->push_back(event);
+    }
+  }
+  head_.store(head, std::memory_order_release);
+}
+
+}  // namespace hello_ar
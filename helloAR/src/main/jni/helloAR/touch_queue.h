@@ -0,0 +1,69 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_TOUCH_QUEUE_H_
+#define C_ARCORE_TOUCH_QUEUE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace hello_ar {
+
+// A touch sample in screen pixels.
+struct TouchEvent {
+  enum class Type : int32_t {
+    kTap,
+    // A finger went down.
+    kPress,
+    // One sample of a finger moving across the screen.
+    kDrag,
+    // The finger was lifted.
+    kRelease,
+  };
+
+  Type type;
+  float x;
+  float y;
+};
+
+// Lock-free single-producer single-consumer queue carrying touches from the
+// UI thread to the OpenGL thread, which handles them once per frame against
+// the frame that was just updated.
+class TouchQueue {
+ public:
+  TouchQueue() = default;
+
+  // Producer side. Returns false and drops the event if the queue is full.
+  bool Push(const TouchEvent& event);
+
+  // Consumer side. Replaces out with every queued event in order, where each
+  // run of consecutive drag samples is collapsed to its latest sample.
+  void Drain(std::vector<TouchEvent>* out);
+
+ private:
+  // Must be a power of two. Far more than a frame's worth of input.
+  static constexpr uint32_t kCapacity = 64;
+
+  TouchEvent events_[kCapacity];
+  // Only the producer writes tail_ and only the consumer writes head_.
+  std::atomic<uint32_t> head_{0};
+  std::atomic<uint32_t> tail_{0};
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_TOUCH_QUEUE_H_
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "trace.h"
+
+#ifdef HELLOAR_TRACING
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#endif  // HELLOAR_TRACING
+
+namespace hello_ar {
+namespace trace {
+
+#ifdef HELLOAR_TRACING
+namespace {
+// Events kept per thread. At roughly a dozen scopes per frame this holds the
+// last ten seconds of the render loop at 60 fps.
+constexpr uint32_t kEventsPerThread = 8192;
+
+// One slot of a ring buffer. The sequence number is odd while the owning
+// thread is writing the slot and 2 * (index + 1) once event index is complete,
+// so a reader can detect and skip slots that were overwritten while it was
+// copying them. The payload is atomic too, but only ever accessed relaxed.
+struct EventSlot {
+  std::atomic<uint64_t> sequence{0};
+  std::atomic<const char*> name{nullptr};
+  std::atomic<int64_t> begin_ns{0};
+  std::atomic<int64_t> duration_ns{0};
+};
+
+struct ThreadBuffer {
+  explicit ThreadBuffer(int32_t tid) : thread_id(tid) {}
+
+  const int32_t thread_id;
+  // Number of events ever written. Only the owning thread writes it.
+  std::atomic<uint64_t> write_index{0};
+  EventSlot slots[kEventsPerThread];
+  // Next buffer in the global list, immutable once published.
+  ThreadBuffer* next = nullptr;
+};
+
+// Buffers are pushed onto this list the first time a thread traces and are
+// never freed, so a dump can't race with a thread exiting.
+std::atomic<ThreadBuffer*> g_thread_buffers{nullptr};
+
+int64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+ThreadBuffer* GetThreadBuffer() {
+  thread_local ThreadBuffer* buffer = nullptr;
+  if (buffer == nullptr) {
+    buffer = new ThreadBuffer(static_cast<int32_t>(syscall(__NR_gettid)));
+    ThreadBuffer* head = g_thread_buffers.load(std::memory_order_relaxed);
+    do {
+      buffer->next = head;
+    } while (!g_thread_buffers.compare_exchange_weak(
+        head, buffer, std::memory_order_release, std::memory_order_relaxed));
+  }
+  return buffer;
+}
+
+void AppendEvent(const char* name, int64_t begin_ns, int64_t duration_ns) {
+  ThreadBuffer* buffer = GetThreadBuffer();
+  const uint64_t index = buffer->write_index.load(std::memory_order_relaxed);
+  EventSlot& slot = buffer->slots[index % kEventsPerThread];
+  slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.begin_ns.store(begin_ns, std::memory_order_relaxed);
+  slot.duration_ns.store(duration_ns, std::memory_order_relaxed);
+  slot.sequence.store(2 * index + 2, std::memory_order_release);
+  buffer->write_index.store(index + 1, std::memory_order_release);
+}
+
+void AppendJsonEvent(int32_t pid, int32_t tid, const char* name,
+                     int64_t begin_ns, int64_t duration_ns, bool first,
+                     std::string* json) {
+  // Event names are string literals from the instrumented code, so they
+  // never need escaping.
+  char event[256];
+  snprintf(event, sizeof(event),
+           "%s{\"name\":\"%s\",\"cat\":\"helloAR\",\"ph\":\"X\",\"pid\":%d,"
+           "\"tid\":%d,\"ts\":%" PRId64 ".%03d,\"dur\":%" PRId64 ".%03d}",
+           first ? "" : ",\n", name, pid, tid, begin_ns / 1000,
+           static_cast<int>(begin_ns % 1000), duration_ns / 1000,
+           static_cast<int>(duration_ns % 1000));
+  json->append(event);
+}
+}  // namespace
+
+ScopedTrace::ScopedTrace(const char* name) : name_(name), begin_ns_(NowNs()) {}
+
+ScopedTrace::~ScopedTrace() {
+  AppendEvent(name_, begin_ns_, NowNs() - begin_ns_);
+}
+#endif  // HELLOAR_TRACING
+
+std::string DumpChromeTraceJson() {
+  std::string json = "{\"traceEvents\":[\n";
+#ifdef HELLOAR_TRACING
+  const int32_t pid = static_cast<int32_t>(getpid());
+  bool first = true;
+  for (ThreadBuffer* buffer =
+           g_thread_buffers.load(std::memory_order_acquire);
+       buffer != nullptr; buffer = buffer->next) {
+    const uint64_t end = buffer->write_index.load(std::memory_order_acquire);
+    const uint64_t begin = end > kEventsPerThread ? end - kEventsPerThread : 0;
+    for (uint64_t index = begin; index < end; ++index) {
+      const EventSlot& slot = buffer->slots[index % kEventsPerThread];
+      const uint64_t sequence = slot.sequence.load(std::memory_order_acquire);
+      const char* name = slot.name.load(std::memory_order_relaxed);
+      const int64_t begin_ns = slot.begin_ns.load(std::memory_order_relaxed);
+      const int64_t duration_ns =
+          slot.duration_ns.load(std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (sequence != 2 * index + 2 ||
+          slot.sequence.load(std::memory_order_relaxed) != sequence) {
+        // Overwritten by the owning thread since write_index was read.
+        continue;
+      }
+      AppendJsonEvent(pid, buffer->thread_id, name, begin_ns, duration_ns,
+                      first, &json);
+      first = false;
+    }
+  }
+#endif  // HELLOAR_TRACING
+  json.append("\n],\"displayTimeUnit\":\"ms\"}\n");
+  return json;
+}
+
+}  // namespace trace
+}  // namespace hello_ar
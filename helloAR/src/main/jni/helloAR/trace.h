@@ -0,0 +1,81 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_TRACE_H_
+#define C_ARCORE_TRACE_H_
+
+#include <cstdint>
+#include <string>
+
+// Scoped timers for profiling the render loop.
+//
+//   void HelloArApplication::OnDrawFrame(...) {
+//     TRACE_SCOPE("OnDrawFrame");
+//     {
+//       TRACE_SCOPE("ArSession_update");
+//       ArSession_update(ar_session_, ar_frame_);
+//     }
+//     ...
+//   }
+//
+// Each thread appends completed scopes to its own fixed-size ring buffer
+// without locking, so the oldest events are overwritten once the buffer is
+// full. Nesting is recovered from the timestamps by the trace viewer.
+//
+// Tracing is only compiled in when HELLOAR_TRACING is defined, which the
+// build does for debug builds. Otherwise TRACE_SCOPE expands to nothing.
+#ifdef HELLOAR_TRACING
+#define HELLOAR_TRACE_CONCAT_INNER(a, b) a##b
+#define HELLOAR_TRACE_CONCAT(a, b) HELLOAR_TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name)                                 \
+  ::hello_ar::trace::ScopedTrace HELLOAR_TRACE_CONCAT(    \
+      trace_scope_, __LINE__)(name)
+#else
+#define TRACE_SCOPE(name)
+#endif  // HELLOAR_TRACING
+
+namespace hello_ar {
+namespace trace {
+
+#ifdef HELLOAR_TRACING
+// Records the time between its construction and destruction as a complete
+// event on the calling thread. name must be a string literal, only the
+// pointer is stored.
+class ScopedTrace {
+ public:
+  explicit ScopedTrace(const char* name);
+  ~ScopedTrace();
+
+  // Delete copy constructors.
+  ScopedTrace(const ScopedTrace&) = delete;
+  void operator=(const ScopedTrace&) = delete;
+
+ private:
+  const char* name_;
+  int64_t begin_ns_;
+};
+#endif  // HELLOAR_TRACING
+
+// Returns the events currently held by all threads' buffers in the Chrome
+// trace_event JSON format, which can be loaded in chrome://tracing or
+// Perfetto. Safe to call from any thread while others keep tracing. Without
+// HELLOAR_TRACING the trace is always empty.
+std::string DumpChromeTraceJson();
+
+}  // namespace trace
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_TRACE_H_
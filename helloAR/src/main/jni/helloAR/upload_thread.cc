@@ -0,0 +1,223 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "upload_thread.h"
+
+#include <GLES2/gl2.h>
+
+#include <cstring>
+#include <utility>
+
+#include "trace.h"
+#include "util.h"
+
+namespace hello_ar {
+
+UploadThread::~UploadThread() { Stop(); }
+
+bool UploadThread::Start() {
+  Stop();
+  EGLDisplay display = eglGetCurrentDisplay();
+  EGLContext share_context = eglGetCurrentContext();
+  if (display == EGL_NO_DISPLAY || share_context == EGL_NO_CONTEXT) {
+    LOGE("UploadThread: no current context to share objects with");
+    return false;
+  }
+
+  // The same config and client version as the render context, which every
+  // implementation accepts for sharing.
+  EGLint config_id = 0;
+  EGLint client_version = 2;
+  eglQueryContext(display, share_context, EGL_CONFIG_ID, &config_id);
+  eglQueryContext(display, share_context, EGL_CONTEXT_CLIENT_VERSION,
+                  &client_version);
+  const EGLint config_attributes[] = {EGL_CONFIG_ID, config_id, EGL_NONE};
+  EGLConfig config = nullptr;
+  EGLint config_count = 0;
+  if (eglChooseConfig(display, config_attributes, &config, 1,
+                      &config_count) != EGL_TRUE ||
+      config_count == 0) {
+    LOGE("UploadThread: cannot find the render context's EGL config");
+    return false;
+  }
+  const EGLint context_attributes[] = {EGL_CONTEXT_CLIENT_VERSION,
+                                       client_version, EGL_NONE};
+  display_ = display;
+  context_ =
+      eglCreateContext(display, config, share_context, context_attributes);
+  if (context_ == EGL_NO_CONTEXT) {
+    LOGE("UploadThread: eglCreateContext failed, error 0x%x", eglGetError());
+    return false;
+  }
+
+  const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+  if (extensions == nullptr ||
+      strstr(extensions, "EGL_KHR_surfaceless_context") == nullptr) {
+    const EGLint pbuffer_attributes[] = {EGL_WIDTH, 1, EGL_HEIGHT, 1,
+                                         EGL_NONE};
+    surface_ = eglCreatePbufferSurface(display, config, pbuffer_attributes);
+    if (surface_ == EGL_NO_SURFACE) {
+      LOGE("UploadThread: eglCreatePbufferSurface failed, error 0x%x",
+           eglGetError());
+      DestroyContext();
+      return false;
+    }
+  }
+  if (extensions != nullptr &&
+      strstr(extensions, "EGL_KHR_fence_sync") != nullptr) {
+    create_sync_ = reinterpret_cast<PFNEGLCREATESYNCKHRPROC>(
+        eglGetProcAddress("eglCreateSyncKHR"));
+    destroy_sync_ = reinterpret_cast<PFNEGLDESTROYSYNCKHRPROC>(
+        eglGetProcAddress("eglDestroySyncKHR"));
+    client_wait_sync_ = reinterpret_cast<PFNEGLCLIENTWAITSYNCKHRPROC>(
+        eglGetProcAddress("eglClientWaitSyncKHR"));
+  }
+  if (create_sync_ == nullptr || destroy_sync_ == nullptr ||
+      client_wait_sync_ == nullptr) {
+    LOGI("EGL_KHR_fence_sync unavailable, uploads wait for glFinish.");
+    create_sync_ = nullptr;
+  }
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  stop_requested_ = false;
+  has_start_result_ = false;
+  thread_ = std::thread(&UploadThread::Run, this);
+  started_.wait(lock, [this] { return has_start_result_; });
+  if (!is_context_current_) {
+    lock.unlock();
+    Stop();
+    return false;
+  }
+  is_running_ = true;
+  return true;
+}
+
+void UploadThread::Stop() {
+  if (thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_requested_ = true;
+      is_running_ = false;
+      wake_.notify_one();
+    }
+    thread_.join();
+  }
+  std::deque<Task> pending;
+  std::deque<PublishFunction> completed;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending.swap(pending_);
+    completed.swap(completed_);
+  }
+  DestroyContext();
+}
+
+void UploadThread::Upload(UploadFunction upload, PublishFunction publish) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (is_running_) {
+      pending_.push_back(Task{std::move(upload), std::move(publish)});
+      wake_.notify_one();
+      return;
+    }
+  }
+  upload();
+  publish();
+}
+
+void UploadThread::PublishCompleted() {
+  std::deque<PublishFunction> completed;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (completed_.empty()) {
+      return;
+    }
+    completed.swap(completed_);
+  }
+  TRACE_SCOPE("PublishUploads");
+  for (PublishFunction& publish : completed) {
+    publish();
+  }
+}
+
+void UploadThread::Run() {
+  const bool is_context_current =
+      eglMakeCurrent(display_, surface_, surface_, context_) == EGL_TRUE;
+  if (!is_context_current) {
+    LOGE("UploadThread: eglMakeCurrent failed, error 0x%x", eglGetError());
+  }
+  std::unique_lock<std::mutex> lock(mutex_);
+  is_context_current_ = is_context_current;
+  has_start_result_ = true;
+  started_.notify_all();
+  if (!is_context_current) {
+    return;
+  }
+
+  for (;;) {
+    wake_.wait(lock, [this] { return stop_requested_ || !pending_.empty(); });
+    if (stop_requested_) {
+      break;
+    }
+    std::deque<Task> tasks;
+    tasks.swap(pending_);
+    lock.unlock();
+    {
+      TRACE_SCOPE("Upload");
+      for (Task& task : tasks) {
+        task.upload();
+      }
+      // One fence covers the whole batch.
+      WaitForUploads();
+    }
+    lock.lock();
+    for (Task& task : tasks) {
+      completed_.push_back(std::move(task.publish));
+    }
+  }
+  lock.unlock();
+
+  eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglReleaseThread();
+}
+
+void UploadThread::WaitForUploads() {
+  if (create_sync_ != nullptr) {
+    EGLSyncKHR fence = create_sync_(display_, EGL_SYNC_FENCE_KHR, nullptr);
+    if (fence != EGL_NO_SYNC_KHR) {
+      client_wait_sync_(display_, fence, EGL_SYNC_FLUSH_COMMANDS_BIT_KHR,
+                        EGL_FOREVER_KHR);
+      destroy_sync_(display_, fence);
+      return;
+    }
+  }
+  glFinish();
+}
+
+void UploadThread::DestroyContext() {
+  if (surface_ != EGL_NO_SURFACE) {
+    eglDestroySurface(display_, surface_);
+    surface_ = EGL_NO_SURFACE;
+  }
+  if (context_ != EGL_NO_CONTEXT) {
+    // The objects it created live on in the share group.
+    eglDestroyContext(display_, context_);
+    context_ = EGL_NO_CONTEXT;
+  }
+  display_ = EGL_NO_DISPLAY;
+}
+
+}  // namespace hello_ar
@@ -0,0 +1,121 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef C_ARCORE_UPLOAD_THREAD_H_
+#define C_ARCORE_UPLOAD_THREAD_H_
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace hello_ar {
+
+// Reads assets and creates their GL objects on a background thread, so that
+// decoding textures, parsing meshes and glTexImage2D and glBufferData calls
+// never stall a frame. The thread has its own context in the share group of
+// the render thread's. The context is current without a surface where
+// EGL_KHR_surfaceless_context is supported, on a 1x1 pbuffer otherwise.
+//
+// An upload is only handed to the render thread once its GL commands have
+// completed: after a batch of uploads the thread inserts an EGL fence and
+// waits for it before queueing their publish functions, which the render
+// thread runs from PublishCompleted. Until then the render thread never sees
+// the new objects' names, so it can't bind a half written texture or
+// buffer.
+class UploadThread {
+ public:
+  // Runs on the upload thread with its context current, and creates the GL
+  // objects of an asset. May call into Java, as the thread is attached to
+  // the JVM on first use like any other native thread.
+  using UploadFunction = std::function<void()>;
+  // Runs on the render thread once the upload's GL commands completed, and
+  // hands the new objects to their renderer.
+  using PublishFunction = std::function<void()>;
+
+  UploadThread() = default;
+  ~UploadThread();
+
+  UploadThread(const UploadThread&) = delete;
+  UploadThread& operator=(const UploadThread&) = delete;
+
+  // Starts the thread with a context sharing objects with the one current on
+  // the calling thread, which must be the render thread. Stops a running
+  // thread first. Called again whenever the render context is recreated.
+  // @return false if no shared context could be made current, in which case
+  // Upload runs uploads on the calling thread.
+  bool Start();
+
+  // Stops and joins the thread and destroys its context. Uploads not
+  // published yet are dropped. Called on the render thread.
+  void Stop();
+
+  // Queues upload on the upload thread, and publish for the first
+  // PublishCompleted after the upload's GL commands completed. Safe to call
+  // from any thread while the upload thread runs. Otherwise both run right
+  // away on the calling thread, which must then be the render thread.
+  void Upload(UploadFunction upload, PublishFunction publish);
+
+  // Runs the publish functions of the completed uploads. Called on the render
+  // thread at the start of each frame.
+  void PublishCompleted();
+
+ private:
+  struct Task {
+    UploadFunction upload;
+    PublishFunction publish;
+  };
+
+  void Run();
+  // Waits on the upload thread until every GL command issued so far on it
+  // completed.
+  void WaitForUploads();
+  void DestroyContext();
+
+  std::thread thread_;
+
+  std::mutex mutex_;
+  // Wakes the upload thread.
+  std::condition_variable wake_;
+  // Wakes Start, waiting for the thread to make its context current.
+  std::condition_variable started_;
+  // Guarded by mutex_.
+  bool stop_requested_ = false;
+  // Whether uploads go to the thread, set once it made its context current.
+  bool is_running_ = false;
+  bool has_start_result_ = false;
+  bool is_context_current_ = false;
+  std::deque<Task> pending_;
+  std::deque<PublishFunction> completed_;
+
+  // Set by Start before the thread starts.
+  EGLDisplay display_ = EGL_NO_DISPLAY;
+  EGLContext context_ = EGL_NO_CONTEXT;
+  EGLSurface surface_ = EGL_NO_SURFACE;
+  // EGL_KHR_fence_sync entry points, null if the extension is missing.
+  PFNEGLCREATESYNCKHRPROC create_sync_ = nullptr;
+  PFNEGLDESTROYSYNCKHRPROC destroy_sync_ = nullptr;
+  PFNEGLCLIENTWAITSYNCKHRPROC client_wait_sync_ = nullptr;
+};
+
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_UPLOAD_THREAD_H_
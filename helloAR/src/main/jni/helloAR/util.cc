@@ -37,24 +37,43 @@ namespace hello_ar {
             static jclass jni_class_id = nullptr;
             static jmethodID jni_load_image_method_id = nullptr;
             static jmethodID jni_load_texture_method_id = nullptr;
+
+#ifdef HELLOAR_GL_DEBUG
+            static bool gl_error_polling_enabled = true;
+#endif  // HELLOAR_GL_DEBUG
         }  // namespace
 
 
+#ifdef HELLOAR_GL_DEBUG
+        void SetGlErrorPollingEnabled(bool enabled) {
+          gl_error_polling_enabled = enabled;
+        }
+
         void CheckGlError(const char* operation) {
+          if (!gl_error_polling_enabled) {
+            return;
+          }
           bool anyError = false;
           for (GLint error = glGetError(); error; error = glGetError()) {
             LOGE("after %s() glError (0x%x)\n", operation, error);
             anyError = true;
           }
           if (anyError) {
-            abort();
+            HELLOAR_LOG_FATAL("Aborting on glError after %s()", operation);
           }
         }
+#endif  // HELLOAR_GL_DEBUG
 
-        void InitializeJavaMethodIDs() {
+        bool InitializeJavaMethodIDs() {
           JNIEnv* env = GetJniEnv();
           jclass local_class_id = FindClass(kJniInterfaceClassName);
+          if (local_class_id == nullptr) {
+            LOGE("hello_ar::util::Could not find Java helper class %s",
+                 kJniInterfaceClassName);
+            return false;
+          }
           jni_class_id = static_cast<jclass>(env->NewGlobalRef(local_class_id));
+          env->DeleteLocalRef(local_class_id);
           jni_load_image_method_id =
                   env->GetStaticMethodID(jni_class_id,
                                          kLoadImageMethodName,
@@ -63,6 +82,8 @@ namespace hello_ar {
                   env->GetStaticMethodID(jni_class_id,
                                          kLoadTextureMethodName,
                                          kLoadTextureMethodSignature);
+          return jni_load_image_method_id != nullptr &&
+                 jni_load_texture_method_id != nullptr;
         }
 
         void ReleaseJavaMethodIDs() {
@@ -222,10 +243,17 @@ namespace hello_ar {
         bool LoadImageFromAssetManager(const std::string& path, int* out_width,
                                        int* out_height, int* out_stride,
                                        uint8_t** out_pixel_buffer) {
+          if (jni_class_id == nullptr) {
+            return false;
+          }
           JNIEnv* env = GetJniEnv();
           jstring j_path = env->NewStringUTF(path.c_str());
           jobject image_obj = CallJavaLoadImage(j_path);
           env->DeleteLocalRef(j_path);
+          if (image_obj == nullptr) {
+            // The asset is missing or could not be decoded.
+            return false;
+          }
 
           // image_obj contains a Bitmap Java object.
           AndroidBitmapInfo bitmap_info;
@@ -242,13 +270,16 @@ namespace hello_ar {
                 ANDROID_BITMAP_RESULT_SUCCESS);
 
           // Copy jvm_buffer_address to pixel_buffer_address
-          int32_t total_size_in_byte = bitmap_info.stride * bitmap_info.width;
+          int32_t total_size_in_byte = bitmap_info.stride * bitmap_info.height;
           *out_pixel_buffer = new uint8_t[total_size_in_byte];
           memcpy(*out_pixel_buffer, jvm_buffer, total_size_in_byte);
 
           // release jvm_buffer back to JVM
           CHECK(AndroidBitmap_unlockPixels(env, image_obj) ==
                 ANDROID_BITMAP_RESULT_SUCCESS);
+          // The env may belong to a long-lived native thread, whose local
+          // references are otherwise only released when it exits.
+          env->DeleteLocalRef(image_obj);
           return true;
         }
 
@@ -280,53 +311,20 @@ namespace hello_ar {
         }
 
         bool LoadPngFromAssetManager(int target, const std::string& path) {
-          JNIEnv* env = GetJniEnv();
-
-          // Put all the JNI values in a structure that is statically initalized on the
-          // first call to this method.  This makes it thread safe in the unlikely case
-          // of multiple threads calling this method.
-          static struct JNIData {
-              jclass helper_class;
-              jmethodID load_image_method;
-              jmethodID load_texture_method;
-          } jniIds = [env]() -> JNIData {
-              constexpr char kHelperClassName[] =
-                      "com/kt/helloAR/JniInterface";
-              constexpr char kLoadImageMethodName[] = "loadImage";
-              constexpr char kLoadImageMethodSignature[] =
-                      "(Ljava/lang/String;)Landroid/graphics/Bitmap;";
-              constexpr char kLoadTextureMethodName[] = "loadTexture";
-              constexpr char kLoadTextureMethodSignature[] =
-                      "(ILandroid/graphics/Bitmap;)V";
-              jclass helper_class = FindClass(kHelperClassName);
-              if (helper_class) {
-                helper_class = static_cast<jclass>(env->NewGlobalRef(helper_class));
-                jmethodID load_image_method = env->GetStaticMethodID(
-                        helper_class, kLoadImageMethodName, kLoadImageMethodSignature);
-                jmethodID load_texture_method = env->GetStaticMethodID(
-                        helper_class, kLoadTextureMethodName, kLoadTextureMethodSignature);
-                return {helper_class, load_image_method, load_texture_method};
-              }
-              LOGE("hello_ar::util::Could not find Java helper class %s",
-                   kHelperClassName);
-              return {};
-          }();
-
-          if (!jniIds.helper_class) {
+          if (jni_class_id == nullptr) {
             return false;
           }
-
+          JNIEnv* env = GetJniEnv();
           jstring j_path = env->NewStringUTF(path.c_str());
-
-          jobject image_obj = env->CallStaticObjectMethod(
-                  jniIds.helper_class, jniIds.load_image_method, j_path);
-
+          jobject image_obj = CallJavaLoadImage(j_path);
           if (j_path) {
             env->DeleteLocalRef(j_path);
           }
 
-          env->CallStaticVoidMethod(jniIds.helper_class, jniIds.load_texture_method,
-                                    target, image_obj);
+          CallJavaLoadTexture(target, image_obj);
+          if (image_obj) {
+            env->DeleteLocalRef(image_obj);
+          }
           return true;
         }
 
@@ -570,6 +568,25 @@ namespace hello_ar {
           return glm::dot(normal, camera_P_plane);
         }
 
+        void GetScreenPointRay(const glm::mat4& view_mat,
+                               const glm::mat4& projection_mat, int width,
+                               int height, float x, float y,
+                               glm::vec3* out_origin,
+                               glm::vec3* out_direction) {
+          const glm::mat4 inverse_view_projection =
+                  glm::inverse(projection_mat * view_mat);
+          const float ndc_x = 2.f * x / width - 1.f;
+          const float ndc_y = 1.f - 2.f * y / height;
+          glm::vec4 near_point =
+                  inverse_view_projection * glm::vec4(ndc_x, ndc_y, -1.f, 1.f);
+          glm::vec4 far_point =
+                  inverse_view_projection * glm::vec4(ndc_x, ndc_y, 1.f, 1.f);
+          near_point /= near_point.w;
+          far_point /= far_point.w;
+          *out_origin = glm::vec3(glm::inverse(view_mat)[3]);
+          *out_direction = glm::normalize(glm::vec3(far_point - near_point));
+        }
+
         void ConvertRgbaToGrayscale(const uint8_t* image_pixel_buffer, int32_t width,
                                     int32_t height, int32_t stride,
                                     uint8_t** out_grayscale_buffer) {
@@ -597,5 +614,47 @@ namespace hello_ar {
           ArPose_getMatrix(ar_session, scopedArPose.GetArPose(), glm::value_ptr(pos));
           return pos;
         }
+
+#ifdef HELLOAR_TRACK_AR_HANDLES
+        void LogLiveArHandleCounts() {
+          // Resident set size, to correlate handle counts with heap growth.
+          long resident_pages = 0;
+          FILE* statm = fopen("/proc/self/statm", "r");
+          if (statm != nullptr) {
+            if (fscanf(statm, "%*s %ld", &resident_pages) != 1) {
+              resident_pages = 0;
+            }
+            fclose(statm);
+          }
+          LOGI(
+                  "RSS %ld KiB, live ARCore handles: anchor %d, camera %d, hit_result %d, "
+                  "hit_result_list %d, image %d, light_estimate %d, "
+                  "point_cloud %d, pose %d, trackable %d, trackable_list %d",
+                  resident_pages * (sysconf(_SC_PAGESIZE) / 1024),
+                  LiveArHandleCount<ArAnchor>::value.load(),
+                  LiveArHandleCount<ArCamera>::value.load(),
+                  LiveArHandleCount<ArHitResult>::value.load(),
+                  LiveArHandleCount<ArHitResultList>::value.load(),
+                  LiveArHandleCount<ArImage>::value.load(),
+                  LiveArHandleCount<ArLightEstimate>::value.load(),
+                  LiveArHandleCount<ArPointCloud>::value.load(),
+                  LiveArHandleCount<ArPose>::value.load(),
+                  LiveArHandleCount<ArTrackable>::value.load(),
+                  LiveArHandleCount<ArTrackableList>::value.load());
+        }
+
+        int GetTotalLiveArHandleCount() {
+          return LiveArHandleCount<ArAnchor>::value +
+                 LiveArHandleCount<ArCamera>::value +
+                 LiveArHandleCount<ArHitResult>::value +
+                 LiveArHandleCount<ArHitResultList>::value +
+                 LiveArHandleCount<ArImage>::value +
+                 LiveArHandleCount<ArLightEstimate>::value +
+                 LiveArHandleCount<ArPointCloud>::value +
+                 LiveArHandleCount<ArPose>::value +
+                 LiveArHandleCount<ArTrackable>::value +
+                 LiveArHandleCount<ArTrackableList>::value;
+        }
+#endif  // HELLOAR_TRACK_AR_HANDLES
     }  // namespace util
 }  // namespace hello_ar
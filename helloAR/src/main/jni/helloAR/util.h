@@ -20,33 +20,36 @@
 #include <GLES2/gl2.h>
 #include <GLES2/gl2ext.h>
 #include <android/asset_manager.h>
-#include <android/log.h>
 #include <errno.h>
 #include <jni.h>
 
 #include <cstdint>
 #include <cstdlib>
 #include <map>
+#include <string>
 #include <vector>
 
 #include "arcore_c_api.h"
+#include "arcore_profiler.h"
 #include "glm.h"
+#include "logger.h"
+#include "scoped_ar_handle.h"
 
+// Logging goes through the asynchronous, per call site rate limited logger in
+// logger.h, so these are safe to use on the render thread.
 #ifndef LOGI
-#define LOGI(...) \
-  __android_log_print(ANDROID_LOG_INFO, "hello_ar_example_c", __VA_ARGS__)
+#define LOGI(...) HELLOAR_LOG(ANDROID_LOG_INFO, __VA_ARGS__)
 #endif  // LOGI
 
 #ifndef LOGE
-#define LOGE(...) \
-  __android_log_print(ANDROID_LOG_ERROR, "hello_ar_example_c", __VA_ARGS__)
+#define LOGE(...) HELLOAR_LOG(ANDROID_LOG_ERROR, __VA_ARGS__)
 #endif  // LOGE
 
 #ifndef CHECK
 #define CHECK(condition)                                                   \
   if (!(condition)) {                                                      \
-    LOGE("*** CHECK FAILED at %s:%d: %s", __FILE__, __LINE__, #condition); \
-    abort();                                                               \
+    HELLOAR_LOG_FATAL("*** CHECK FAILED at %s:%d: %s", __FILE__, __LINE__, \
+                      #condition);                                         \
   }
 #endif  // CHECK
 
@@ -55,34 +58,39 @@ namespace hello_ar {
 // Utilities for C hello AR project.
 namespace util {
 
-// Provides a scoped allocated instance of Anchor.
-// Can be treated as an ArAnchor*.
-class ScopedArPose {
+// Provides a scoped allocated instance of Pose.
+// Can be treated as an ArPose*.
+class ScopedArPose : public ScopedArHandle<ArPose, ArPose_destroy> {
  public:
   explicit ScopedArPose(const ArSession* session) {
-    ArPose_create(session, nullptr, &pose_);
+    ArPose_create(session, nullptr, OutPtr());
   }
-  ~ScopedArPose() { ArPose_destroy(pose_); }
-  ArPose* GetArPose() { return pose_; }
-  // Delete copy constructors.
-  ScopedArPose(const ScopedArPose&) = delete;
-  void operator=(const ScopedArPose&) = delete;
-
- private:
-  ArPose* pose_;
+  ArPose* GetArPose() const { return Get(); }
 };
 
-// Looks up Java class IDs and Method IDs and cache them.
-void InitializeJavaMethodIDs();
+// Looks up Java class IDs and Method IDs and cache them as global references.
+// Called once from JNI_OnLoad, where the app's class loader is in scope.
+// Returns false if the JniInterface class or one of its methods is missing.
+bool InitializeJavaMethodIDs();
 
 // Clear the Java class IDs and Method IDs.
 void ReleaseJavaMethodIDs();
 
-// Check GL error, and abort if an error is encountered.
+#ifdef HELLOAR_GL_DEBUG
+// Check GL error, and abort if an error is encountered. Does nothing once
+// gl::InitializeDebugOutput has installed a KHR_debug callback, which
+// reports errors as they happen instead.
 //
 // @param operation, the name of the GL function call.
 void CheckGlError(const char* operation);
 
+// Enables or disables the glGetError polling done by CheckGlError.
+void SetGlErrorPollingEnabled(bool enabled);
+#else
+// Release builds never call glGetError, which can stall the GL pipeline.
+inline void CheckGlError(const char*) {}
+#endif  // HELLOAR_GL_DEBUG
+
 // Create a shader program ID.
 //
 // @param asset_manager, AAssetManager pointer.
@@ -183,6 +191,13 @@ float CalculateDistanceToPlane(const ArSession& ar_session,
                                const ArPose& plane_pose,
                                const ArPose& camera_pose);
 
+// Computes the world space ray through a screen point in pixels for the given
+// camera matrices. The direction is normalized.
+void GetScreenPointRay(const glm::mat4& view_mat,
+                       const glm::mat4& projection_mat, int width, int height,
+                       float x, float y, glm::vec3* out_origin,
+                       glm::vec3* out_direction);
+
 // Converts image to grayscale.
 // The AugmentedImage API takes a grayscale image as input,
 // so we need to manually convert the image to grayscale
@@ -1,9 +1,15 @@
 #include <android/asset_manager.h>
 #include <android/asset_manager_jni.h>
+#include <android/native_window_jni.h>
 #include <jni.h>
+#include <pthread.h>
+#include <memory>
 #include <string>
 
+#include "helloAR/gl_wrapper.h"
 #include "helloAR/hello_ar_application.h"
+#include "helloAR/trace.h"
+#include "helloAR/util.h"
 
 #define JNI_METHOD(return_type, method_name) \
   JNIEXPORT return_type JNICALL              \
@@ -15,6 +21,18 @@ namespace {
 // maintain a reference to the JVM so we can use it later.
     static JavaVM *g_vm = nullptr;
 
+    // Set on threads this library attached to the JVM. Its destructor runs when
+    // such a thread exits and detaches it, which releases the local references
+    // the thread still holds.
+    static pthread_key_t g_detach_key;
+
+    // The env of the current thread, once GetJniEnv has looked it up.
+    static thread_local JNIEnv *t_env = nullptr;
+
+    void DetachThread(void *) {
+        g_vm->DetachCurrentThread();
+    }
+
     inline jlong jptr(hello_ar::HelloArApplication *native_hello_ar_application) {
         return reinterpret_cast<intptr_t>(native_hello_ar_application);
     }
@@ -26,13 +44,38 @@ namespace {
 
 jint JNI_OnLoad(JavaVM *vm, void *) {
     g_vm = vm;
+    if (pthread_key_create(&g_detach_key, DetachThread) != 0) {
+        return JNI_ERR;
+    }
+    // Classes must be resolved here: on threads attached from native code
+    // FindClass only sees the system class loader, not the app's classes.
+    if (!hello_ar::util::InitializeJavaMethodIDs()) {
+        return JNI_ERR;
+    }
     return JNI_VERSION_1_6;
 }
 
+void JNI_OnUnload(JavaVM *, void *) {
+    hello_ar::util::ReleaseJavaMethodIDs();
+}
+
 JNIEnv *GetJniEnv() {
-    JNIEnv *env;
-    jint result = g_vm->AttachCurrentThread(&env, nullptr);
-    return result == JNI_OK ? env : nullptr;
+    if (t_env != nullptr) {
+        return t_env;
+    }
+    JNIEnv *env = nullptr;
+    jint result = g_vm->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6);
+    if (result == JNI_EDETACHED) {
+        if (g_vm->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+            return nullptr;
+        }
+        // Any non-null value makes the key's destructor run on thread exit.
+        pthread_setspecific(g_detach_key, env);
+    } else if (result != JNI_OK) {
+        return nullptr;
+    }
+    t_env = env;
+    return env;
 }
 
 jclass FindClass(const char *classname) {
@@ -62,23 +105,77 @@ JNI_METHOD(void, destroyNativeApplication)
     delete native(native_application);
 }
 
-JNI_METHOD(void, onGlSurfaceCreated)
-(JNIEnv *, jclass, jlong native_application) {
-    native(native_application)->OnSurfaceCreated();
+JNI_METHOD(void, onSurfaceCreated)
+(JNIEnv *env, jclass, jlong native_application, jobject surface) {
+    ANativeWindow *window = ANativeWindow_fromSurface(env, surface);
+    if (window == nullptr) {
+        LOGE("onSurfaceCreated: no native window for the surface");
+        return;
+    }
+    native(native_application)->SetWindow(window);
 }
 
-JNI_METHOD(void, onDisplayGeometryChanged)
-(JNIEnv *, jclass, jlong native_application, int display_rotation, int width,
- int height) {
+JNI_METHOD(void, onSurfaceChanged)
+(JNIEnv *, jclass, jlong native_application, jint display_rotation, jint width,
+ jint height) {
     native(native_application)
-            ->OnDisplayGeometryChanged(display_rotation, width, height);
+            ->OnWindowGeometryChanged(display_rotation, width, height);
+}
+
+JNI_METHOD(void, onSurfaceDestroyed)
+(JNIEnv *, jclass, jlong native_application) {
+    native(native_application)->SetWindow(nullptr);
+}
+
+JNI_METHOD(void, queueEvent)
+(JNIEnv *env, jclass, jlong native_application, jobject runnable) {
+    jclass runnable_class = env->GetObjectClass(runnable);
+    jmethodID run_method = env->GetMethodID(runnable_class, "run", "()V");
+    env->DeleteLocalRef(runnable_class);
+    // std::function needs a copyable task. The last copy deletes the global
+    // reference on whichever thread drops it.
+    std::shared_ptr<_jobject> global_runnable(
+            env->NewGlobalRef(runnable),
+            [](jobject ref) { GetJniEnv()->DeleteGlobalRef(ref); });
+    native(native_application)->QueueEvent([global_runnable, run_method] {
+        JNIEnv *thread_env = GetJniEnv();
+        thread_env->CallVoidMethod(global_runnable.get(), run_method);
+        if (thread_env->ExceptionCheck()) {
+            LOGE("queueEvent: uncaught exception in the queued runnable");
+            thread_env->ExceptionDescribe();
+            thread_env->ExceptionClear();
+        }
+    });
+}
+
+JNI_METHOD(void, setMaxFramesInFlight)
+(JNIEnv *, jclass, jlong native_application, jint count) {
+    native(native_application)->SetMaxFramesInFlight(count);
 }
 
-JNI_METHOD(void, onGlSurfaceDrawFrame)
+JNI_METHOD(void, setDepthRendering)
 (JNIEnv *, jclass, jlong native_application,
  jboolean depth_color_visualization_enabled, jboolean use_depth_for_occlusion) {
     native(native_application)
-            ->OnDrawFrame(depth_color_visualization_enabled, use_depth_for_occlusion);
+            ->SetDepthRendering(depth_color_visualization_enabled,
+                                use_depth_for_occlusion);
+}
+
+JNI_METHOD(jboolean, onVsync)
+(JNIEnv *, jclass, jlong native_application, jlong frame_time_nanos) {
+    return static_cast<jboolean>(
+            native(native_application)->OnVsync(frame_time_nanos)
+            ? JNI_TRUE : JNI_FALSE);
+}
+
+JNI_METHOD(void, setTargetFrameRate)
+(JNIEnv *, jclass, jlong native_application, jint frames_per_second) {
+    native(native_application)->SetTargetFrameRate(frames_per_second);
+}
+
+JNI_METHOD(void, setAnimating)
+(JNIEnv *, jclass, jlong native_application, jboolean animating) {
+    native(native_application)->SetAnimating(animating);
 }
 
 JNI_METHOD(void, onTouched)
@@ -86,15 +183,52 @@ JNI_METHOD(void, onTouched)
     native(native_application)->OnTouched(x, y);
 }
 
-JNI_METHOD(jboolean, hasDetectedPlanes)
-(JNIEnv *, jclass, jlong native_application) {
-    return static_cast<jboolean>(
-            native(native_application)->HasDetectedPlanes() ? JNI_TRUE : JNI_FALSE);
+JNI_METHOD(void, onPressed)
+(JNIEnv *, jclass, jlong native_application, jfloat x, jfloat y) {
+    native(native_application)->OnPressed(x, y);
 }
 
-JNI_METHOD(jboolean, isDepthSupported)
-(JNIEnv *, jclass, jlong native_application) {
-    return native(native_application)->IsDepthSupported();
+JNI_METHOD(void, onReleased)
+(JNIEnv *, jclass, jlong native_application, jfloat x, jfloat y) {
+    native(native_application)->OnReleased(x, y);
+}
+
+JNI_METHOD(void, onDragged)
+(JNIEnv *, jclass, jlong native_application, jfloat x, jfloat y) {
+    native(native_application)->OnDragged(x, y);
+}
+
+JNI_METHOD(jint, hitTestBatch)
+(JNIEnv *env, jclass, jlong native_application, jobject coordinates,
+ jint count, jboolean rays, jobject results) {
+    const hello_ar::HitTestInput input = rays
+            ? hello_ar::HitTestInput::kRay
+            : hello_ar::HitTestInput::kScreenPoint;
+    const jlong input_floats = rays ? hello_ar::kHitTestRayFloats
+                                    : hello_ar::kHitTestScreenPointFloats;
+    // Capacities of FloatBuffers are in floats.
+    const float *coordinates_address =
+            static_cast<const float *>(env->GetDirectBufferAddress(coordinates));
+    float *results_address =
+            static_cast<float *>(env->GetDirectBufferAddress(results));
+    if (count < 0 || coordinates_address == nullptr ||
+        results_address == nullptr ||
+        env->GetDirectBufferCapacity(coordinates) < count * input_floats ||
+        env->GetDirectBufferCapacity(results) <
+        count * static_cast<jlong>(hello_ar::kHitTestResultFloats)) {
+        return -1;
+    }
+    return native(native_application)
+            ->HitTestBatch(input, coordinates_address, count, results_address);
+}
+
+JNI_METHOD(jboolean, registerStatusBuffer)
+(JNIEnv *env, jclass, jlong native_application, jobject status_buffer) {
+    void *address = env->GetDirectBufferAddress(status_buffer);
+    jlong capacity = env->GetDirectBufferCapacity(status_buffer);
+    return static_cast<jboolean>(
+            native(native_application)->RegisterStatusBuffer(address, capacity)
+            ? JNI_TRUE : JNI_FALSE);
 }
 
 JNI_METHOD(void, onSettingsChange)
@@ -102,4 +236,86 @@ JNI_METHOD(void, onSettingsChange)
  jboolean is_instant_placement_enabled) {
     native(native_application)->OnSettingsChange(is_instant_placement_enabled);
 }
+
+JNI_METHOD(void, setAnchorEvictionPolicy)
+(JNIEnv *, jclass, jlong native_application, jint policy) {
+    if (policy < static_cast<jint>(hello_ar::AnchorEvictionPolicy::kOldest) ||
+        policy > static_cast<jint>(
+                hello_ar::AnchorEvictionPolicy::kLeastRecentlyVisible)) {
+        LOGE("setAnchorEvictionPolicy: unknown policy %d", policy);
+        return;
+    }
+    native(native_application)->SetAnchorEvictionPolicy(
+            static_cast<hello_ar::AnchorEvictionPolicy>(policy));
+}
+
+JNI_METHOD(void, setPerformanceProfile)
+(JNIEnv *, jclass, jlong native_application, jint profile) {
+    if (profile < static_cast<jint>(hello_ar::PerformanceProfile::kLowPower) ||
+        profile > static_cast<jint>(
+                hello_ar::PerformanceProfile::kHighFidelity)) {
+        LOGE("setPerformanceProfile: unknown profile %d", profile);
+        return;
+    }
+    native(native_application)->SetPerformanceProfile(
+            static_cast<hello_ar::PerformanceProfile>(profile));
+}
+
+JNI_METHOD(void, setRenderScale)
+(JNIEnv *, jclass, jlong native_application, jfloat scale) {
+    native(native_application)->SetRenderScale(scale);
+}
+
+JNI_METHOD(void, setThermalStatus)
+(JNIEnv *, jclass, jlong native_application, jint thermal_status) {
+    native(native_application)->SetThermalStatus(
+            static_cast<hello_ar::ThermalStatus>(thermal_status));
+}
+
+JNI_METHOD(void, setUpdateMode)
+(JNIEnv *, jclass, jlong native_application, jint update_mode) {
+    if (update_mode != AR_UPDATE_MODE_BLOCKING &&
+        update_mode != AR_UPDATE_MODE_LATEST_CAMERA_IMAGE) {
+        LOGE("setUpdateMode: unknown update mode %d", update_mode);
+        return;
+    }
+    native(native_application)->SetUpdateMode(
+            static_cast<ArUpdateMode>(update_mode));
+}
+
+JNI_METHOD(jboolean, startFrameRecording)
+(JNIEnv *env, jclass, jlong native_application, jstring j_path) {
+    const char *path = env->GetStringUTFChars(j_path, nullptr);
+    if (path == nullptr) {
+        return JNI_FALSE;
+    }
+    bool started = native(native_application)->StartFrameRecording(path);
+    env->ReleaseStringUTFChars(j_path, path);
+    return static_cast<jboolean>(started ? JNI_TRUE : JNI_FALSE);
+}
+
+JNI_METHOD(void, stopFrameRecording)
+(JNIEnv *, jclass, jlong native_application) {
+    native(native_application)->StopFrameRecording();
+}
+
+JNI_METHOD(jlongArray, getGlFrameStats)
+(JNIEnv *env, jclass) {
+    // Keep in sync with the GL_FRAME_STATS_* indices in JniInterface.java.
+    const hello_ar::gl::GlFrameStats stats = hello_ar::gl::GetLastFrameStats();
+    const jlong values[] = {stats.draw_calls, stats.state_changes,
+                            stats.program_binds, stats.texture_binds,
+                            stats.bytes_uploaded};
+    const jsize length = sizeof(values) / sizeof(values[0]);
+    jlongArray result = env->NewLongArray(length);
+    if (result != nullptr) {
+        env->SetLongArrayRegion(result, 0, length, values);
+    }
+    return result;
+}
+
+JNI_METHOD(jstring, dumpTrace)
+(JNIEnv *env, jclass) {
+    return env->NewStringUTF(hello_ar::trace::DumpChromeTraceJson().c_str());
+}
 }
\ No newline at end of file
@@ -20,10 +20,13 @@
 extern "C" {
 
 // Helper function used to access the jni environment on the current thread.
-// In this sample, no consideration is made for detaching the thread when the
-// thread exits. This can cause memory leaks, so production applications should
-// detach when the thread no longer needs access to the JVM.
+// The env is cached per thread. Threads that are not already known to the JVM
+// are attached on first use and detached automatically when they exit, so any
+// thread may call into Java.
 JNIEnv *GetJniEnv();
 
+// Looks up a class with the current thread's class loader. Only app classes
+// resolved at JNI_OnLoad are reliably found from native threads; prefer the
+// IDs cached by util::InitializeJavaMethodIDs.
 jclass FindClass(const char *classname);
 }  // extern "C"
\ No newline at end of file
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks AnchorStore's eviction policies, handle generations and spatial
+// index, the latter against a brute force scan of the entries.
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "anchor_store.h"
+#include "glm.h"
+#include "host_test.h"
+
+namespace hello_ar {
+namespace {
+
+const glm::vec3 kCamera(0.f, 0.f, 0.f);
+
+// Inserts values 1, 2 and 3 one, five and two meters ahead of the camera
+// into a store of capacity 3, then inserts 4.
+// @return the value evicted by the fourth insertion, or 0.
+int EvictOneOfThree(AnchorEvictionPolicy policy, bool mark_first_visible) {
+  AnchorStore<int> store(3);
+  store.SetEvictionPolicy(policy);
+  const AnchorHandle handles[3] = {
+      store.Insert(1, glm::vec3(0.f, 0.f, -1.f), kCamera),
+      store.Insert(2, glm::vec3(0.f, 0.f, -5.f), kCamera),
+      store.Insert(3, glm::vec3(0.f, 0.f, -2.f), kCamera)};
+  if (mark_first_visible) {
+    store.MarkVisible(handles[0]);
+  }
+  const AnchorHandle fourth =
+      store.Insert(4, glm::vec3(0.f, 0.f, -3.f), kCamera);
+  EXPECT(store.GetSize() == 3);
+  EXPECT(store.Get(fourth) != nullptr && *store.Get(fourth) == 4);
+  int evicted = 0;
+  for (int i = 0; i < 3; ++i) {
+    if (store.Get(handles[i]) == nullptr) {
+      EXPECT(evicted == 0);
+      evicted = i + 1;
+    }
+  }
+  return evicted;
+}
+
+void EvictsOldest() {
+  EXPECT(EvictOneOfThree(AnchorEvictionPolicy::kOldest, false) == 1);
+  // Visibility doesn't change the insertion order.
+  EXPECT(EvictOneOfThree(AnchorEvictionPolicy::kOldest, true) == 1);
+}
+
+void EvictsFarthestFromCamera() {
+  EXPECT(EvictOneOfThree(AnchorEvictionPolicy::kFarthestFromCamera, false) ==
+         2);
+}
+
+void EvictsLeastRecentlyVisible() {
+  EXPECT(EvictOneOfThree(AnchorEvictionPolicy::kLeastRecentlyVisible,
+                         false) == 1);
+  EXPECT(EvictOneOfThree(AnchorEvictionPolicy::kLeastRecentlyVisible,
+                         true) == 2);
+}
+
+void StaleHandlesStayInvalid() {
+  AnchorStore<int> store(2);
+  const AnchorHandle first = store.Insert(1, glm::vec3(0.f), kCamera);
+  EXPECT(store.Remove(first));
+  EXPECT(!store.Remove(first));
+
+  // The freed slot is reused with a new generation.
+  const AnchorHandle second = store.Insert(2, glm::vec3(0.f), kCamera);
+  EXPECT(second.index == first.index);
+  EXPECT(second != first);
+  EXPECT(store.Get(first) == nullptr);
+  EXPECT(store.Get(second) != nullptr && *store.Get(second) == 2);
+  store.UpdatePosition(first, glm::vec3(10.f, 0.f, 0.f));
+  EXPECT(store.FindNearest(glm::vec3(0.f), 0.1f) == second);
+  EXPECT(!store.Remove(first));
+  EXPECT(store.GetSize() == 1);
+
+  // Eviction and Clear invalidate handles the same way.
+  store.Insert(3, glm::vec3(1.f), kCamera);
+  store.Insert(4, glm::vec3(2.f), kCamera);
+  EXPECT(store.Get(second) == nullptr);
+  AnchorHandle last;
+  store.ForEach([&last](AnchorHandle handle, int) { last = handle; });
+  store.Clear();
+  EXPECT(store.GetSize() == 0);
+  EXPECT(store.Get(last) == nullptr);
+  EXPECT(!store.FindNearest(glm::vec3(2.f), 1.f).IsValid());
+}
+
+void UpdatePositionMovesAcrossCells() {
+  AnchorStore<int> store(256, /*cell_size_meters=*/0.5f);
+  // Enough far away entries that FindNearest walks the grid rather than
+  // scanning every entry.
+  for (int i = 0; i < 200; ++i) {
+    store.Insert(0, glm::vec3(i % 10, 50.f, i / 10), kCamera);
+  }
+  const AnchorHandle handle = store.Insert(1, glm::vec3(0.f), kCamera);
+  EXPECT(store.FindNearest(glm::vec3(0.1f, 0.f, 0.f), 0.2f) == handle);
+
+  store.UpdatePosition(handle, glm::vec3(-3.2f, 1.7f, 4.4f));
+  EXPECT(!store.FindNearest(glm::vec3(0.1f, 0.f, 0.f), 0.2f).IsValid());
+  EXPECT(store.FindNearest(glm::vec3(-3.1f, 1.7f, 4.4f), 0.2f) == handle);
+
+  // Within the same cell.
+  store.UpdatePosition(handle, glm::vec3(-3.4f, 1.6f, 4.3f));
+  EXPECT(store.FindNearest(glm::vec3(-3.3f, 1.6f, 4.3f), 0.2f) == handle);
+  EXPECT(store.Remove(handle));
+  EXPECT(!store.FindNearest(glm::vec3(-3.3f, 1.6f, 4.3f), 0.2f).IsValid());
+}
+
+// Returns the distance to the nearest entry within max_distance by scanning
+// them all, or -1.
+float BruteForceNearestDistance(const AnchorStore<int>& store,
+                                const std::vector<glm::vec3>& positions,
+                                const glm::vec3& query, float max_distance) {
+  float best = -1.f;
+  store.ForEach([&](AnchorHandle, const int& value) {
+    const float distance = glm::distance(positions[value], query);
+    if (distance <= max_distance && (best < 0.f || distance < best)) {
+      best = distance;
+    }
+  });
+  return best;
+}
+
+void FindNearestMatchesBruteForce() {
+  constexpr int kEntryCount = 1000;
+  std::mt19937 random(7);
+  std::uniform_real_distribution<float> coordinate(-4.f, 4.f);
+  std::uniform_real_distribution<float> radius(0.05f, 3.f);
+  const auto random_position = [&]() {
+    return glm::vec3(coordinate(random), coordinate(random),
+                     coordinate(random));
+  };
+
+  AnchorStore<int> store(kEntryCount / 2, /*cell_size_meters=*/0.5f);
+  // Values index positions. Inserting twice the capacity evicts the first
+  // half, and later moves and removals churn the grid.
+  std::vector<glm::vec3> positions;
+  std::vector<AnchorHandle> handles;
+  for (int i = 0; i < kEntryCount; ++i) {
+    positions.push_back(random_position());
+    handles.push_back(store.Insert(static_cast<int>(i), positions[i], kCamera));
+  }
+  for (int i = kEntryCount / 2; i < kEntryCount; i += 3) {
+    positions[i] = random_position();
+    store.UpdatePosition(handles[i], positions[i]);
+  }
+  for (int i = kEntryCount / 2 + 1; i < kEntryCount; i += 7) {
+    EXPECT(store.Remove(handles[i]));
+  }
+
+  int mismatches = 0;
+  for (int query = 0; query < 2000; ++query) {
+    const glm::vec3 position = random_position();
+    const float max_distance = radius(random);
+    const float expected =
+        BruteForceNearestDistance(store, positions, position, max_distance);
+    const AnchorHandle nearest = store.FindNearest(position, max_distance);
+    const float actual =
+        nearest.IsValid()
+            ? glm::distance(positions[*store.Get(nearest)], position)
+            : -1.f;
+    if (actual != expected) {
+      ++mismatches;
+    }
+  }
+  EXPECT(mismatches == 0);
+}
+
+}  // namespace
+}  // namespace hello_ar
+
+int main() {
+  using namespace hello_ar;
+  RUN_TEST(EvictsOldest);
+  RUN_TEST(EvictsFarthestFromCamera);
+  RUN_TEST(EvictsLeastRecentlyVisible);
+  RUN_TEST(StaleHandlesStayInvalid);
+  RUN_TEST(UpdatePositionMovesAcrossCells);
+  RUN_TEST(FindNearestMatchesBruteForce);
+  return TEST_EXIT_CODE();
+}
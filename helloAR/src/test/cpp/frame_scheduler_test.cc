@@ -0,0 +1,255 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Drives FrameScheduler with synthetic vsync and camera timestamps.
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "frame_scheduler.h"
+#include "host_test.h"
+
+namespace hello_ar {
+namespace {
+
+constexpr int64_t kVsync60HzNs = 16666667;
+constexpr int64_t kVsync90HzNs = 11111111;
+constexpr int64_t kCamera30FpsNs = 33333333;
+// Vsync and camera clocks have different origins.
+constexpr int64_t kVsyncStartNs = 5000000000;
+constexpr int64_t kCameraStartNs = 123000000000;
+
+// Synthetic display and camera. Each rendered frame reports the newest
+// camera image available at its vsync, like ArSession_update.
+class Trace {
+ public:
+  Trace(FrameScheduler* scheduler, int64_t vsync_period_ns,
+        int64_t camera_period_ns)
+      : scheduler_(scheduler),
+        vsync_period_ns_(vsync_period_ns),
+        camera_period_ns_(camera_period_ns) {}
+
+  // Runs one vsync, and a frame if the scheduler asks for it.
+  // @return true if a frame was rendered.
+  bool Step() {
+    elapsed_ns_ += vsync_period_ns_;
+    if (!scheduler_->OnVsync(kVsyncStartNs + elapsed_ns_)) {
+      return false;
+    }
+    int64_t camera_timestamp_ns = last_camera_timestamp_ns_;
+    if (camera_period_ns_ > 0 && !is_camera_stalled_) {
+      // Images arrive a quarter period behind the vsync they belong to.
+      const int64_t camera_elapsed_ns =
+          elapsed_ns_ - camera_period_ns_ / 4 - camera_delay_ns_;
+      camera_timestamp_ns =
+          kCameraStartNs +
+          (camera_elapsed_ns / camera_period_ns_) * camera_period_ns_;
+    }
+    scheduler_->OnCameraFrame(camera_timestamp_ns);
+    last_camera_timestamp_ns_ = camera_timestamp_ns;
+    return true;
+  }
+
+  // Runs vsyncs and returns how many rendered a frame.
+  int32_t Run(int32_t vsyncs) {
+    int32_t frames = 0;
+    for (int32_t i = 0; i < vsyncs; ++i) {
+      frames += Step() ? 1 : 0;
+    }
+    return frames;
+  }
+
+  // Delays the camera images relative to the display.
+  void SetCameraDelayNs(int64_t delay_ns) { camera_delay_ns_ = delay_ns; }
+
+  // While stalled, the camera keeps reporting its last image.
+  void SetCameraStalled(bool stalled) { is_camera_stalled_ = stalled; }
+
+ private:
+  FrameScheduler* scheduler_;
+  const int64_t vsync_period_ns_;
+  const int64_t camera_period_ns_;
+  int64_t camera_delay_ns_ = 0;
+  bool is_camera_stalled_ = false;
+  int64_t last_camera_timestamp_ns_ = 0;
+  int64_t elapsed_ns_ = 0;
+};
+
+bool IsNear(int64_t value, int64_t expected, int64_t tolerance) {
+  return std::llabs(value - expected) <= tolerance;
+}
+
+void SixtyFpsTargetRendersEveryVsync() {
+  FrameScheduler scheduler;
+  scheduler.SetTargetFrameRate(60);
+  Trace trace(&scheduler, kVsync60HzNs, kCamera30FpsNs);
+  EXPECT(trace.Run(120) == 120);
+  EXPECT(IsNear(scheduler.GetFrameBudgetNs(), kVsync60HzNs, 100000));
+}
+
+void ThirtyFpsTargetRendersEveryOtherVsync() {
+  FrameScheduler scheduler;
+  scheduler.SetTargetFrameRate(30);
+  Trace trace(&scheduler, kVsync60HzNs, kCamera30FpsNs);
+  trace.Run(10);
+  for (int32_t i = 0; i < 60; ++i) {
+    EXPECT(trace.Step() != trace.Step());
+  }
+  EXPECT(IsNear(scheduler.GetFrameBudgetNs(), 2 * kVsync60HzNs, 100000));
+
+  // A 90 Hz display can't show 30 fps any other way than every third vsync.
+  FrameScheduler fast_display;
+  fast_display.SetTargetFrameRate(30);
+  Trace fast_trace(&fast_display, kVsync90HzNs, kCamera30FpsNs);
+  fast_trace.Run(90);
+  EXPECT(IsNear(fast_display.GetVsyncPeriodNs(), kVsync90HzNs, 100000));
+  EXPECT(fast_trace.Run(90) == 30);
+  EXPECT(IsNear(fast_display.GetFrameBudgetNs(), 3 * kVsync90HzNs, 100000));
+}
+
+void CameraPacingRendersEachImageOnce() {
+  FrameScheduler scheduler;
+  Trace trace(&scheduler, kVsync60HzNs, kCamera30FpsNs);
+  trace.Run(60);
+  EXPECT(IsNear(scheduler.GetCameraFramePeriodNs(), kCamera30FpsNs, 100000));
+  // 30 camera images in 60 vsyncs.
+  EXPECT(trace.Run(60) == 30);
+}
+
+void LateCameraImageIsRetriedNextVsync() {
+  FrameScheduler scheduler;
+  Trace trace(&scheduler, kVsync60HzNs, kCamera30FpsNs);
+  trace.Run(60);
+  // The camera falls behind by most of a vsync, so the frame paced for the
+  // next image finds the previous one again.
+  trace.SetCameraDelayNs(kVsync60HzNs * 3 / 4);
+  bool retried = false;
+  for (int32_t i = 0; i < 4 && !retried; ++i) {
+    // A frame right after a frame is the retry.
+    retried = trace.Step() && trace.Step();
+  }
+  EXPECT(retried);
+  // The cadence is back in phase with the camera: one frame per image, no
+  // more retries.
+  EXPECT(trace.Run(60) == 30);
+
+  // Late images are not retried at a fixed frame rate, or while animating.
+  FrameScheduler fixed_rate;
+  fixed_rate.SetTargetFrameRate(30);
+  fixed_rate.OnVsync(kVsyncStartNs);
+  fixed_rate.OnCameraFrame(kCameraStartNs);
+  fixed_rate.OnVsync(kVsyncStartNs + 2 * kVsync60HzNs);
+  fixed_rate.OnCameraFrame(kCameraStartNs);
+  EXPECT(!fixed_rate.OnVsync(kVsyncStartNs + 3 * kVsync60HzNs));
+}
+
+// Runs vsyncs and returns true if two in a row rendered a frame, the second
+// being a retry.
+bool RunRetries(Trace* trace, int32_t vsyncs) {
+  bool rendered = false;
+  bool retried = false;
+  for (int32_t i = 0; i < vsyncs; ++i) {
+    const bool was_rendered = rendered;
+    rendered = trace->Step();
+    retried = retried || (was_rendered && rendered);
+  }
+  return retried;
+}
+
+void StalledCameraIsRetriedOnce() {
+  FrameScheduler scheduler;
+  Trace trace(&scheduler, kVsync60HzNs, kCamera30FpsNs);
+  trace.Run(60);
+  // Every frame finds the same image. Only the first is retried, then frames
+  // keep to the camera period instead of following the display.
+  trace.SetCameraStalled(true);
+  EXPECT(RunRetries(&trace, 4));
+  EXPECT(trace.Run(60) == 30);
+
+  // Once the camera recovers, a new stall is retried again.
+  trace.SetCameraStalled(false);
+  EXPECT(trace.Run(60) == 30);
+  trace.SetCameraStalled(true);
+  EXPECT(RunRetries(&trace, 4));
+  EXPECT(trace.Run(60) == 30);
+}
+
+void IdleVsyncsRequestNoFrame() {
+  FrameScheduler scheduler;
+  scheduler.SetTargetFrameRate(20);
+  Trace trace(&scheduler, kVsync60HzNs, kCamera30FpsNs);
+  trace.Run(30);
+  // Without input the two vsyncs between frames stay idle.
+  int32_t idle_vsyncs = 0;
+  for (int32_t i = 0; i < 60; ++i) {
+    idle_vsyncs += trace.Step() ? 0 : 1;
+  }
+  EXPECT(idle_vsyncs == 40);
+
+  // Before the camera produced an image nothing is retried.
+  FrameScheduler no_camera;
+  Trace no_camera_trace(&no_camera, kVsync60HzNs, 0);
+  no_camera_trace.Run(10);
+  EXPECT(no_camera_trace.Run(60) == 30);
+}
+
+void RequestedFrameRendersOnNextVsync() {
+  FrameScheduler scheduler;
+  scheduler.SetTargetFrameRate(20);
+  Trace trace(&scheduler, kVsync60HzNs, kCamera30FpsNs);
+  while (!trace.Step()) {
+  }
+  EXPECT(!trace.Step());
+  scheduler.RequestFrame();
+  EXPECT(trace.Step());
+  // The request is used up, and the interval counts from the new frame.
+  EXPECT(!trace.Step());
+  EXPECT(!trace.Step());
+  EXPECT(trace.Step());
+}
+
+void AnimationFollowsTheDisplay() {
+  FrameScheduler scheduler;
+  Trace trace(&scheduler, kVsync60HzNs, kCamera30FpsNs);
+  trace.Run(30);
+  scheduler.SetAnimating(true);
+  EXPECT(trace.Run(60) == 60);
+  // Animations still respect a fixed target rate.
+  scheduler.SetTargetFrameRate(30);
+  trace.Run(2);
+  EXPECT(trace.Run(60) == 30);
+  scheduler.SetTargetFrameRate(FrameScheduler::kCameraFrameRate);
+  scheduler.SetAnimating(false);
+  trace.Run(2);
+  EXPECT(trace.Run(60) == 30);
+}
+
+}  // namespace
+}  // namespace hello_ar
+
+int main() {
+  using namespace hello_ar;
+  RUN_TEST(SixtyFpsTargetRendersEveryVsync);
+  RUN_TEST(ThirtyFpsTargetRendersEveryOtherVsync);
+  RUN_TEST(CameraPacingRendersEachImageOnce);
+  RUN_TEST(LateCameraImageIsRetriedNextVsync);
+  RUN_TEST(StalledCameraIsRetriedOnce);
+  RUN_TEST(IdleVsyncsRequestNoFrame);
+  RUN_TEST(RequestedFrameRendersOnNextVsync);
+  RUN_TEST(AnimationFollowsTheDisplay);
+  return TEST_EXIT_CODE();
+}
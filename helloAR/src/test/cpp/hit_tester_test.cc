@@ -0,0 +1,130 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Hit tests on the replay backend against a single logged floor plane one
+// meter below the origin. Plane hits must face where the test starts, the
+// camera for screen points and the ray origin for rays.
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "arcore_c_api.h"
+#include "arcore_replay.h"
+#include "frame_log.h"
+#include "hit_tester.h"
+#include "host_test.h"
+
+namespace hello_ar {
+namespace {
+
+// A frame with the camera at camera_y, looking down -Z, and a two meter
+// square floor plane at y = -1 centered two meters ahead.
+LoggedFrame MakeFrame(float camera_y) {
+  LoggedFrame frame;
+  frame.timestamp_ns = 33333333;
+  frame.camera_tracking_state = AR_TRACKING_STATE_TRACKING;
+  frame.camera_pose[5] = camera_y;
+  LoggedPlane plane;
+  plane.id = 1;
+  plane.tracking_state = AR_TRACKING_STATE_TRACKING;
+  plane.center_pose[5] = -1.f;
+  plane.center_pose[6] = -2.f;
+  plane.polygon = {-1.f, -1.f, 1.f, -1.f, 1.f, 1.f, -1.f, 1.f};
+  frame.planes.push_back(plane);
+  return frame;
+}
+
+// Replays frame in a fresh session and hit tests the rays against it.
+// @return the HitTestTrackable code of each ray.
+std::vector<int32_t> HitTestRays(const LoggedFrame& frame,
+                                 const std::vector<float>& rays) {
+  std::vector<int32_t> trackables;
+  char path[] = "/tmp/hit_tester_XXXXXX";
+  const int fd = mkstemp(path);
+  EXPECT(fd >= 0);
+  if (fd < 0) {
+    return trackables;
+  }
+  close(fd);
+  FrameLogWriter writer;
+  EXPECT(writer.Open(path) && writer.Write(frame));
+  writer.Close();
+  setenv(replay::kReplayLogEnvironmentVariable, path, 1);
+
+  ArSession* session = nullptr;
+  EXPECT(ArSession_create(nullptr, nullptr, &session) == AR_SUCCESS);
+  if (session != nullptr) {
+    ArFrame* ar_frame = nullptr;
+    ArFrame_create(session, &ar_frame);
+    EXPECT(ArSession_update(session, ar_frame) == AR_SUCCESS);
+
+    const int32_t count =
+        static_cast<int32_t>(rays.size()) / kHitTestRayFloats;
+    std::vector<float> results(count * kHitTestResultFloats);
+    HitTester hit_tester;
+    hit_tester.HitTestBatch(session, ar_frame, HitTestInput::kRay,
+                            rays.data(), count, results.data());
+    hit_tester.Release();
+    for (int32_t i = 0; i < count; ++i) {
+      trackables.push_back(
+          static_cast<int32_t>(results[i * kHitTestResultFloats]));
+    }
+    ArFrame_destroy(ar_frame);
+    ArSession_destroy(session);
+  }
+  unlink(path);
+  return trackables;
+}
+
+// Rays straight down from above the plane and straight up from below it.
+const std::vector<float> kDownAndUpRays = {0.f, 0.f,  -2.f, 0.f, -1.f, 0.f,
+                                           0.f, -2.f, -2.f, 0.f, 1.f,  0.f};
+
+void RayFromAboveHitsPlaneUnderCamera() {
+  const std::vector<int32_t> trackables =
+      HitTestRays(MakeFrame(/*camera_y=*/0.f), kDownAndUpRays);
+  EXPECT(trackables.size() == 2);
+  if (trackables.size() == 2) {
+    EXPECT(trackables[0] == static_cast<int32_t>(HitTestTrackable::kPlane));
+    // The camera is above the plane, but the ray comes from below.
+    EXPECT(trackables[1] == static_cast<int32_t>(HitTestTrackable::kNone));
+  }
+}
+
+void RayFromAboveHitsPlaneOverCamera() {
+  const std::vector<int32_t> trackables =
+      HitTestRays(MakeFrame(/*camera_y=*/-3.f), kDownAndUpRays);
+  EXPECT(trackables.size() == 2);
+  if (trackables.size() == 2) {
+    // The camera is below the plane, but the ray comes from above.
+    EXPECT(trackables[0] == static_cast<int32_t>(HitTestTrackable::kPlane));
+    EXPECT(trackables[1] == static_cast<int32_t>(HitTestTrackable::kNone));
+  }
+}
+
+}  // namespace
+}  // namespace hello_ar
+
+int main() {
+  using namespace hello_ar;
+  RUN_TEST(RayFromAboveHitsPlaneUnderCamera);
+  RUN_TEST(RayFromAboveHitsPlaneOverCamera);
+  return TEST_EXIT_CODE();
+}
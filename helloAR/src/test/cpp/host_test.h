@@ -0,0 +1,58 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef C_ARCORE_HOST_TEST_H_
+#define C_ARCORE_HOST_TEST_H_
+
+#include <cstdio>
+
+// Checks for the host tests, which run without a test framework. A failed
+// EXPECT is reported and the test goes on. main runs each test function with
+// RUN_TEST and returns TEST_EXIT_CODE().
+
+namespace hello_ar {
+namespace host_test {
+
+inline int& GetFailureCount() {
+  static int failure_count = 0;
+  return failure_count;
+}
+
+inline void Run(const char* name, void (*test)()) {
+  const int failures_before = GetFailureCount();
+  test();
+  const bool passed = GetFailureCount() == failures_before;
+  printf("[%s] %s\n", passed ? "  OK  " : " FAIL ", name);
+}
+
+}  // namespace host_test
+}  // namespace hello_ar
+
+#define EXPECT(condition)                                                 \
+  do {                                                                    \
+    if (!(condition)) {                                                   \
+      fprintf(stderr, "%s:%d: EXPECT failed: %s\n", __FILE__, __LINE__,   \
+              #condition);                                                \
+      ++hello_ar::host_test::GetFailureCount();                           \
+    }                                                                     \
+  } while (false)
+
+#define RUN_TEST(test) hello_ar::host_test::Run(#test, test)
+
+#define TEST_EXIT_CODE() (hello_ar::host_test::GetFailureCount() == 0 ? 0 : 1)
+
+#endif  // C_ARCORE_HOST_TEST_H_
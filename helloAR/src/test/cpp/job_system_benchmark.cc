@@ -0,0 +1,117 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Times the plane stage of HelloArApplication::OnDrawFrame, the ray caster
+// tables and plane meshes built across the JobSystem, for every worker count
+// from none up to one per core, and prints the speedup over running on the
+// calling thread alone. Not a test, the numbers depend on the host:
+//
+//   job_system_benchmark [plane_count] [frame_count]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "glm.h"
+#include "job_system.h"
+#include "plane_polygon.h"
+#include "plane_ray_caster.h"
+#include "plane_renderer.h"
+
+namespace hello_ar {
+namespace {
+
+// ARCore polygons of well explored planes have tens of vertices.
+constexpr int32_t kVertexCount = 48;
+
+std::vector<PlanePolygon> MakePolygons(int32_t plane_count) {
+  std::vector<PlanePolygon> polygons(plane_count);
+  for (int32_t i = 0; i < plane_count; ++i) {
+    PlanePolygon& polygon = polygons[i];
+    polygon.model_mat =
+        glm::translate(glm::mat4(1.f), glm::vec3(i % 4, -1.f, -1.f - i / 4));
+    const float radius = 0.5f + 0.1f * (i % 5);
+    for (int32_t v = 0; v < kVertexCount; ++v) {
+      const float angle = 6.2831853f * v / kVertexCount;
+      polygon.vertices.push_back(
+          glm::vec2(radius * glm::cos(angle), radius * glm::sin(angle)));
+    }
+  }
+  return polygons;
+}
+
+// Returns the mean time of a frame's plane stage with worker_count workers.
+double TimeFrameMs(int32_t worker_count,
+                   const std::vector<PlanePolygon>& polygons,
+                   int32_t frame_count) {
+  JobSystem job_system(worker_count);
+  PlaneRayCaster plane_ray_caster;
+  PlaneRenderer plane_renderer;
+  plane_renderer.SetFeatherEdges(true);
+  const int32_t polygon_count = static_cast<int32_t>(polygons.size());
+  const auto build_frame = [&]() {
+    plane_ray_caster.SetPlaneCount(polygon_count);
+    plane_renderer.SetPlaneCount(polygon_count);
+    job_system.ParallelFor(polygon_count, /*grain=*/1, [&](int32_t i) {
+      plane_ray_caster.BuildPlane(i, polygons[i]);
+      plane_renderer.BuildMesh(i, polygons[i]);
+    });
+  };
+
+  // The first frames grow the mesh storage, which later frames reuse.
+  for (int32_t frame = 0; frame < 10; ++frame) {
+    build_frame();
+  }
+  const auto begin = std::chrono::steady_clock::now();
+  for (int32_t frame = 0; frame < frame_count; ++frame) {
+    build_frame();
+  }
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - begin;
+  return elapsed.count() / frame_count;
+}
+
+}  // namespace
+}  // namespace hello_ar
+
+int main(int argc, char** argv) {
+  using namespace hello_ar;
+  const int32_t plane_count = argc > 1 ? std::max(atoi(argv[1]), 1) : 32;
+  const int32_t frame_count = argc > 2 ? std::max(atoi(argv[2]), 1) : 2000;
+  const int32_t core_count =
+      static_cast<int32_t>(std::thread::hardware_concurrency());
+  const int32_t max_workers = std::max(core_count - 1, 4);
+  const std::vector<PlanePolygon> polygons = MakePolygons(plane_count);
+
+  printf("%d planes of %d vertices, %d frames, %d cores, default %d "
+         "workers\n",
+         plane_count, kVertexCount, frame_count, core_count,
+         JobSystem::GetDefaultWorkerCount());
+  printf("workers  ms/frame  speedup\n");
+  double serial_ms = 0.0;
+  for (int32_t workers = 0; workers <= max_workers; ++workers) {
+    const double frame_ms = TimeFrameMs(workers, polygons, frame_count);
+    if (workers == 0) {
+      serial_ms = frame_ms;
+    }
+    printf("%7d  %8.3f  %6.2fx\n", workers, frame_ms, serial_ms / frame_ms);
+  }
+  return 0;
+}
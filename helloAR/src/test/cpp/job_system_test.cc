@@ -0,0 +1,164 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Stress tests of JobSystem at several worker counts. Build with
+// -fsanitize=thread to check the deques and the sleep handshake for races.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "host_test.h"
+#include "job_system.h"
+
+namespace hello_ar {
+namespace {
+
+constexpr int32_t kMaxWorkers = 4;
+
+// Runs test against a fresh job system with 0 to kMaxWorkers workers.
+void ForEachWorkerCount(void (*test)(JobSystem* job_system)) {
+  for (int32_t workers = 0; workers <= kMaxWorkers; ++workers) {
+    JobSystem job_system(workers);
+    EXPECT(job_system.GetWorkerCount() == workers);
+    test(&job_system);
+  }
+}
+
+void ParallelForVisitsEachIndexOnce() {
+  ForEachWorkerCount([](JobSystem* job_system) {
+    for (int32_t count : {0, 1, 7, 64, 1000, 5000}) {
+      for (int32_t grain : {0, 1, 3, 64, 10000}) {
+        std::vector<std::atomic<int32_t>> visits(count);
+        for (std::atomic<int32_t>& visit : visits) {
+          visit.store(0);
+        }
+        job_system->ParallelFor(count, grain, [&visits](int32_t i) {
+          visits[i].fetch_add(1, std::memory_order_relaxed);
+        });
+        bool each_once = true;
+        for (const std::atomic<int32_t>& visit : visits) {
+          each_once &= visit.load() == 1;
+        }
+        EXPECT(each_once);
+      }
+    }
+  });
+}
+
+// Counts the leaves of a binary tree of jobs, each forking its two children
+// and waiting for them.
+struct TreeContext {
+  JobSystem* job_system;
+  std::atomic<int32_t>* leaves;
+};
+
+void RunTree(void* context, int32_t begin, int32_t end) {
+  TreeContext* tree = static_cast<TreeContext*>(context);
+  if (end - begin == 1) {
+    tree->leaves->fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  const int32_t middle = begin + (end - begin) / 2;
+  JobGroup group;
+  tree->job_system->Run(&group, RunTree, context, begin, middle);
+  tree->job_system->Run(&group, RunTree, context, middle, end);
+  tree->job_system->Wait(&group);
+}
+
+void NestedForkJoinCompletes() {
+  ForEachWorkerCount([](JobSystem* job_system) {
+    // Deep enough that the forks overflow the deques, which run jobs inline.
+    for (int32_t leaf_count : {1, 2, 1000, 20000}) {
+      std::atomic<int32_t> leaves(0);
+      TreeContext tree = {job_system, &leaves};
+      JobGroup group;
+      job_system->Run(&group, RunTree, &tree, 0, leaf_count);
+      job_system->Wait(&group);
+      EXPECT(leaves.load() == leaf_count);
+    }
+  });
+}
+
+void ManySmallBatchesComplete() {
+  // The per frame pattern: a short batch, then idle long enough for the
+  // workers to go to sleep, and the next batch has to wake them.
+  ForEachWorkerCount([](JobSystem* job_system) {
+    std::atomic<int64_t> sum(0);
+    int64_t expected = 0;
+    for (int32_t batch = 0; batch < 2000; ++batch) {
+      const int32_t count = batch % 9;
+      job_system->ParallelFor(count, 1, [&sum, batch](int32_t i) {
+        sum.fetch_add(batch + i, std::memory_order_relaxed);
+      });
+      expected += static_cast<int64_t>(count) * batch + count * (count - 1) / 2;
+      if (batch % 500 == 0) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+      }
+    }
+    EXPECT(sum.load() == expected);
+  });
+}
+
+void OutsideThreadsShareThePool() {
+  ForEachWorkerCount([](JobSystem* job_system) {
+    constexpr int32_t kThreads = 4;
+    constexpr int32_t kBatches = 200;
+    constexpr int32_t kCount = 100;
+    std::atomic<int32_t> calls(0);
+    std::vector<std::thread> threads;
+    for (int32_t t = 0; t < kThreads; ++t) {
+      threads.emplace_back([job_system, &calls] {
+        for (int32_t batch = 0; batch < kBatches; ++batch) {
+          job_system->ParallelFor(kCount, 4, [&calls](int32_t) {
+            calls.fetch_add(1, std::memory_order_relaxed);
+          });
+        }
+      });
+    }
+    for (std::thread& thread : threads) {
+      thread.join();
+    }
+    EXPECT(calls.load() == kThreads * kBatches * kCount);
+  });
+}
+
+void DestroysWhileWorkersSleepOrSpin() {
+  for (int32_t round = 0; round < 200; ++round) {
+    JobSystem job_system(1 + round % kMaxWorkers);
+    if (round % 2 == 0) {
+      std::atomic<int32_t> calls(0);
+      job_system.ParallelFor(16, 1, [&calls](int32_t) { ++calls; });
+      EXPECT(calls.load() == 16);
+    }
+  }
+}
+
+}  // namespace
+}  // namespace hello_ar
+
+int main() {
+  using namespace hello_ar;
+  RUN_TEST(ParallelForVisitsEachIndexOnce);
+  RUN_TEST(NestedForkJoinCompletes);
+  RUN_TEST(ManySmallBatchesComplete);
+  RUN_TEST(OutsideThreadsShareThePool);
+  RUN_TEST(DestroysWhileWorkersSleepOrSpin);
+  return TEST_EXIT_CODE();
+}
@@ -0,0 +1,298 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Checks MeshBvh against a brute force scan of the triangles, on the Andy
+// model and on a random triangle soup, and times picking among thousands of
+// placed instances.
+
+#include <GLES2/gl2.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "glm.h"
+#include "host_shims.h"
+#include "host_test.h"
+#include "mesh_bvh.h"
+#include "util.h"
+
+namespace hello_ar {
+namespace {
+
+// Budget of one pick among kInstanceCount instances, in milliseconds.
+constexpr double kMaxPickMilliseconds = 1.0;
+constexpr int32_t kInstanceCount = 4096;
+
+struct Mesh {
+  std::vector<GLfloat> vertices;
+  std::vector<GLushort> indices;
+};
+
+Mesh LoadAndy() {
+  Mesh mesh;
+  AAssetManager* asset_manager =
+      host::CreateAssetManager(HELLOAR_HOST_ASSET_DIRECTORY);
+  std::vector<GLfloat> normals;
+  std::vector<GLfloat> uvs;
+  EXPECT(util::LoadObjFile("models/andy.obj", asset_manager, &mesh.vertices,
+                           &normals, &uvs, &mesh.indices));
+  host::DestroyAssetManager(asset_manager);
+  return mesh;
+}
+
+// Random triangles of up to a tenth of the unit cube they are in.
+Mesh MakeTriangleSoup(int32_t triangle_count, std::mt19937* random) {
+  std::uniform_real_distribution<float> coordinate(0.f, 1.f);
+  std::uniform_real_distribution<float> offset(-0.1f, 0.1f);
+  Mesh mesh;
+  for (int32_t i = 0; i < triangle_count; ++i) {
+    const glm::vec3 corner(coordinate(*random), coordinate(*random),
+                           coordinate(*random));
+    for (int32_t v = 0; v < 3; ++v) {
+      mesh.vertices.push_back(corner.x + (v > 0 ? offset(*random) : 0.f));
+      mesh.vertices.push_back(corner.y + (v > 0 ? offset(*random) : 0.f));
+      mesh.vertices.push_back(corner.z + (v > 0 ? offset(*random) : 0.f));
+      mesh.indices.push_back(static_cast<GLushort>(3 * i + v));
+    }
+  }
+  return mesh;
+}
+
+// Nearest hit of every triangle, with the same Moller-Trumbore test as
+// MeshBvh.
+bool BruteForceIntersect(const Mesh& mesh, const glm::vec3& origin,
+                         const glm::vec3& direction, float max_t,
+                         float* out_t) {
+  bool found = false;
+  for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+    const glm::vec3 vertex =
+        glm::make_vec3(&mesh.vertices[3 * mesh.indices[i]]);
+    const glm::vec3 edge1 =
+        glm::make_vec3(&mesh.vertices[3 * mesh.indices[i + 1]]) - vertex;
+    const glm::vec3 edge2 =
+        glm::make_vec3(&mesh.vertices[3 * mesh.indices[i + 2]]) - vertex;
+    const glm::vec3 p = glm::cross(direction, edge2);
+    const float determinant = glm::dot(edge1, p);
+    if (std::abs(determinant) < 1e-12f) {
+      continue;
+    }
+    const float inverse_determinant = 1.f / determinant;
+    const glm::vec3 s = origin - vertex;
+    const float u = glm::dot(s, p) * inverse_determinant;
+    if (u < 0.f || u > 1.f) {
+      continue;
+    }
+    const glm::vec3 q = glm::cross(s, edge1);
+    const float v = glm::dot(direction, q) * inverse_determinant;
+    if (v < 0.f || u + v > 1.f) {
+      continue;
+    }
+    const float t = glm::dot(edge2, q) * inverse_determinant;
+    if (t >= 0.f && t < max_t) {
+      max_t = t;
+      found = true;
+    }
+  }
+  if (found) {
+    *out_t = max_t;
+  }
+  return found;
+}
+
+// Casts rays from around the mesh's bounding box towards points inside it,
+// with and without a limit, and counts where the BVH and the brute force
+// scan disagree.
+int32_t CountMismatches(const Mesh& mesh, std::mt19937* random) {
+  MeshBvh bvh;
+  bvh.Build(mesh.vertices, mesh.indices);
+  EXPECT(!bvh.IsEmpty());
+  glm::vec3 min(std::numeric_limits<float>::max());
+  glm::vec3 max(-std::numeric_limits<float>::max());
+  for (size_t i = 0; i < mesh.vertices.size(); i += 3) {
+    min = glm::min(min, glm::make_vec3(&mesh.vertices[i]));
+    max = glm::max(max, glm::make_vec3(&mesh.vertices[i]));
+  }
+  const glm::vec3 center = 0.5f * (min + max);
+  const float size = glm::length(max - min);
+  std::uniform_real_distribution<float> unit(0.f, 1.f);
+  std::normal_distribution<float> normal(0.f, 1.f);
+
+  int32_t mismatches = 0;
+  int32_t hits = 0;
+  for (int32_t ray = 0; ray < 4000; ++ray) {
+    const glm::vec3 origin =
+        center + size * glm::normalize(glm::vec3(
+                            normal(*random), normal(*random), normal(*random)));
+    const glm::vec3 target =
+        min + glm::vec3(unit(*random), unit(*random), unit(*random)) *
+                  (max - min);
+    // Unnormalized directions and, for every other ray, a limit that may
+    // end the ray before the mesh.
+    const glm::vec3 direction = 0.5f * (target - origin);
+    const float max_t = ray % 2 == 0 ? std::numeric_limits<float>::max()
+                                     : 4.f * unit(*random);
+    float expected_t = -1.f;
+    float actual_t = -1.f;
+    const bool expected =
+        BruteForceIntersect(mesh, origin, direction, max_t, &expected_t);
+    const bool actual = bvh.Intersect(origin, direction, max_t, &actual_t);
+    hits += expected ? 1 : 0;
+    if (actual != expected || actual_t != expected_t) {
+      ++mismatches;
+    }
+  }
+  // Enough rays hit for the comparison to mean something.
+  EXPECT(hits > 400);
+  return mismatches;
+}
+
+void IntersectMatchesBruteForce() {
+  std::mt19937 random(11);
+  EXPECT(CountMismatches(LoadAndy(), &random) == 0);
+  EXPECT(CountMismatches(MakeTriangleSoup(3000, &random), &random) == 0);
+
+  // The limit is exclusive, and an empty hierarchy hits nothing.
+  MeshBvh bvh;
+  const Mesh triangle = {{0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 1.f, 0.f},
+                         {0, 1, 2}};
+  bvh.Build(triangle.vertices, triangle.indices);
+  float t = 0.f;
+  EXPECT(bvh.Intersect(glm::vec3(0.2f, 0.2f, 1.f), glm::vec3(0.f, 0.f, -2.f),
+                       1.f, &t));
+  EXPECT(t == 0.5f);
+  EXPECT(!bvh.Intersect(glm::vec3(0.2f, 0.2f, 1.f),
+                        glm::vec3(0.f, 0.f, -2.f), 0.5f, &t));
+  MeshBvh empty;
+  empty.Build(std::vector<GLfloat>(), std::vector<GLushort>());
+  EXPECT(empty.IsEmpty());
+  EXPECT(!empty.IntersectInstance(glm::mat4(1.f), glm::vec3(0.f),
+                                  glm::vec3(0.f, 0.f, -1.f), 1.f, &t));
+}
+
+// Picks the nearest of the instances hit by the ray, like
+// HelloArApplication::PickAnchor.
+int32_t Pick(const MeshBvh& bvh, const std::vector<glm::mat4>& model_mats,
+             const glm::vec3& origin, const glm::vec3& direction) {
+  float nearest_t = std::numeric_limits<float>::max();
+  int32_t picked = -1;
+  for (size_t i = 0; i < model_mats.size(); ++i) {
+    float t = 0.f;
+    if (bvh.IntersectInstance(model_mats[i], origin, direction, nearest_t,
+                              &t)) {
+      nearest_t = t;
+      picked = static_cast<int32_t>(i);
+    }
+  }
+  return picked;
+}
+
+// Like Pick, testing every instance without rejecting any by its bounds.
+int32_t PickWithoutBounds(const MeshBvh& bvh,
+                          const std::vector<glm::mat4>& model_mats,
+                          const glm::vec3& origin,
+                          const glm::vec3& direction) {
+  float nearest_t = std::numeric_limits<float>::max();
+  int32_t picked = -1;
+  for (size_t i = 0; i < model_mats.size(); ++i) {
+    const glm::mat4 inverse_model_mat = glm::inverse(model_mats[i]);
+    float t = 0.f;
+    if (bvh.Intersect(glm::vec3(inverse_model_mat * glm::vec4(origin, 1.f)),
+                      glm::vec3(inverse_model_mat * glm::vec4(direction, 0.f)),
+                      nearest_t, &t)) {
+      nearest_t = t;
+      picked = static_cast<int32_t>(i);
+    }
+  }
+  return picked;
+}
+
+void PickingThousandsOfInstancesTakesUnderAMillisecond() {
+  const Mesh andy = LoadAndy();
+  MeshBvh bvh;
+  bvh.Build(andy.vertices, andy.indices);
+
+  // Androids a quarter meter apart on a floor one meter below the camera,
+  // each turned its own way.
+  std::mt19937 random(5);
+  std::uniform_real_distribution<float> yaw(0.f, 6.2831853f);
+  std::vector<glm::mat4> model_mats;
+  for (int32_t i = 0; i < kInstanceCount; ++i) {
+    const glm::vec3 position(0.25f * (i % 64) - 8.f, -1.f,
+                             -0.5f - 0.25f * (i / 64));
+    model_mats.push_back(
+        glm::translate(glm::mat4(1.f), position) *
+        glm::rotate(glm::mat4(1.f), yaw(random), glm::vec3(0.f, 1.f, 0.f)));
+  }
+  // Anchors are visited in placement order, not by distance.
+  std::shuffle(model_mats.begin(), model_mats.end(), random);
+
+  // Rays from the camera towards the floor at eye level, where they pass
+  // many instances.
+  std::uniform_real_distribution<float> x(-8.f, 8.f);
+  std::uniform_real_distribution<float> z(-16.f, -0.5f);
+  std::vector<glm::vec3> directions;
+  for (int32_t ray = 0; ray < 500; ++ray) {
+    directions.push_back(
+        glm::normalize(glm::vec3(x(random), -0.9f, z(random))));
+  }
+  const glm::vec3 origin(0.f);
+
+  int32_t picked_count = 0;
+  for (const glm::vec3& direction : directions) {
+    const int32_t picked = Pick(bvh, model_mats, origin, direction);
+    EXPECT(picked == PickWithoutBounds(bvh, model_mats, origin, direction));
+    picked_count += picked >= 0 ? 1 : 0;
+  }
+  EXPECT(picked_count > 0);
+
+  // Overlapping instances, the farther one first: the nearer one is still
+  // tested although the ray already hit inside its bounding sphere.
+  const std::vector<glm::mat4> overlapping = {
+      glm::translate(glm::mat4(1.f), glm::vec3(0.f, -0.1f, -2.05f)),
+      glm::translate(glm::mat4(1.f), glm::vec3(0.f, -0.1f, -2.f))};
+  EXPECT(Pick(bvh, overlapping, glm::vec3(0.03f, 0.f, 0.f),
+              glm::vec3(0.f, 0.f, -1.f)) == 1);
+
+  const auto begin = std::chrono::steady_clock::now();
+  int32_t checksum = 0;
+  for (const glm::vec3& direction : directions) {
+    checksum += Pick(bvh, model_mats, origin, direction);
+  }
+  const std::chrono::duration<double, std::milli> elapsed =
+      std::chrono::steady_clock::now() - begin;
+  const double pick_ms = elapsed.count() / directions.size();
+  printf("%d instances of %d triangles, %d of %d rays picked one: %.3f ms "
+         "per pick (checksum %d)\n",
+         kInstanceCount, static_cast<int32_t>(andy.indices.size() / 3),
+         picked_count, static_cast<int32_t>(directions.size()), pick_ms,
+         checksum);
+  EXPECT(pick_ms < kMaxPickMilliseconds);
+}
+
+}  // namespace
+}  // namespace hello_ar
+
+int main() {
+  using namespace hello_ar;
+  RUN_TEST(IntersectMatchesBruteForce);
+  RUN_TEST(PickingThousandsOfInstancesTakesUnderAMillisecond);
+  return TEST_EXIT_CODE();
+}
@@ -0,0 +1,196 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Casts rays against hand built planes: convex polygons of either winding,
+// rays from behind, stacked planes, and the cost of a reticle query.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "glm.h"
+#include "host_test.h"
+#include "plane_polygon.h"
+#include "plane_ray_caster.h"
+
+namespace hello_ar {
+namespace {
+
+// Budget of one reticle query against a busy scene, in microseconds.
+constexpr double kMaxRaycastMicroseconds = 5.0;
+
+const glm::vec3 kDown(0.f, -1.f, 0.f);
+
+// Polygon of vertices, given counter-clockwise in x/z, at model_mat.
+PlanePolygon MakePolygon(const glm::mat4& model_mat,
+                         const std::vector<glm::vec2>& vertices,
+                         bool clockwise) {
+  PlanePolygon polygon;
+  polygon.model_mat = model_mat;
+  polygon.vertices = vertices;
+  if (clockwise) {
+    polygon.vertices.assign(vertices.rbegin(), vertices.rend());
+  }
+  return polygon;
+}
+
+// Floor plane at height y, facing up.
+glm::mat4 FloorAt(float y) {
+  return glm::translate(glm::mat4(1.f), glm::vec3(0.f, y, 0.f));
+}
+
+void ConvexPolygonsOfEitherWinding() {
+  // A right triangle and a hexagon, neither centered on the origin, so
+  // points inside their bounding circles can still be outside.
+  const std::vector<glm::vec2> triangle = {
+      glm::vec2(0.f, 0.f), glm::vec2(1.f, 0.f), glm::vec2(0.f, 1.f)};
+  std::vector<glm::vec2> hexagon;
+  for (int32_t i = 0; i < 6; ++i) {
+    const float angle = 1.0471976f * i;
+    hexagon.push_back(glm::vec2(0.2f + glm::cos(angle), glm::sin(angle)));
+  }
+
+  for (bool clockwise : {false, true}) {
+    PlaneRayCaster caster;
+    caster.SetPlaneCount(1);
+    caster.BuildPlane(0, MakePolygon(FloorAt(0.f), triangle, clockwise));
+    PlaneRayHit hit;
+    EXPECT(caster.Raycast(glm::vec3(0.2f, 1.f, 0.2f), kDown, &hit));
+    EXPECT(glm::distance(hit.position, glm::vec3(0.2f, 0.f, 0.2f)) < 1e-5f);
+    EXPECT(glm::abs(hit.distance - 1.f) < 1e-5f);
+    // Past the hypotenuse, inside the bounding circle.
+    EXPECT(!caster.Raycast(glm::vec3(0.6f, 1.f, 0.6f), kDown, &hit));
+    EXPECT(!caster.Raycast(glm::vec3(-0.1f, 1.f, 0.5f), kDown, &hit));
+
+    caster.BuildPlane(0, MakePolygon(FloorAt(0.f), hexagon, clockwise));
+    EXPECT(caster.Raycast(glm::vec3(1.1f, 1.f, 0.f), kDown, &hit));
+    EXPECT(caster.Raycast(glm::vec3(-0.4f, 1.f, -0.5f), kDown, &hit));
+    // Just outside the edge between the first two vertices.
+    EXPECT(!caster.Raycast(glm::vec3(1.f, 1.f, 0.5f), kDown, &hit));
+  }
+
+  // A wall facing +z, hit head on.
+  PlaneRayCaster caster;
+  caster.SetPlaneCount(1);
+  const glm::mat4 wall_mat =
+      glm::translate(glm::mat4(1.f), glm::vec3(0.f, 1.f, -2.f)) *
+      glm::rotate(glm::mat4(1.f), glm::radians(90.f), glm::vec3(1.f, 0.f, 0.f));
+  caster.BuildPlane(0, MakePolygon(wall_mat, hexagon, false));
+  PlaneRayHit hit;
+  EXPECT(caster.Raycast(glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f, 0.f, -3.f),
+                        &hit));
+  EXPECT(glm::distance(hit.normal, glm::vec3(0.f, 0.f, 1.f)) < 1e-5f);
+  EXPECT(glm::abs(hit.distance - 2.f) < 1e-5f);
+}
+
+void RaysFromBehindMiss() {
+  PlaneRayCaster caster;
+  caster.SetPlaneCount(1);
+  const std::vector<glm::vec2> square = {
+      glm::vec2(-1.f, -1.f), glm::vec2(1.f, -1.f), glm::vec2(1.f, 1.f),
+      glm::vec2(-1.f, 1.f)};
+  caster.BuildPlane(0, MakePolygon(FloorAt(0.f), square, false));
+  PlaneRayHit hit;
+  EXPECT(caster.Raycast(glm::vec3(0.f, 1.f, 0.f), kDown, &hit));
+  EXPECT(!caster.Raycast(glm::vec3(0.f, -1.f, 0.f), -kDown, &hit));
+  // Rays parallel to the plane, or pointing away from it, miss too.
+  EXPECT(!caster.Raycast(glm::vec3(0.f, 1.f, 0.f), glm::vec3(1.f, 0.f, 0.f),
+                         &hit));
+  EXPECT(!caster.Raycast(glm::vec3(0.f, 1.f, 0.f), -kDown, &hit));
+}
+
+void NearestOfStackedPlanesWins() {
+  const std::vector<glm::vec2> square = {
+      glm::vec2(-1.f, -1.f), glm::vec2(1.f, -1.f), glm::vec2(1.f, 1.f),
+      glm::vec2(-1.f, 1.f)};
+  const std::vector<glm::vec2> small_square = {
+      glm::vec2(-0.2f, -0.2f), glm::vec2(0.2f, -0.2f), glm::vec2(0.2f, 0.2f),
+      glm::vec2(-0.2f, 0.2f)};
+  // A table top above the floor, added in either order.
+  for (int32_t table_index = 0; table_index < 2; ++table_index) {
+    PlaneRayCaster caster;
+    caster.SetPlaneCount(2);
+    caster.BuildPlane(table_index,
+                      MakePolygon(FloorAt(-0.3f), small_square, false));
+    caster.BuildPlane(1 - table_index,
+                      MakePolygon(FloorAt(-1.f), square, false));
+    PlaneRayHit hit;
+    EXPECT(caster.Raycast(glm::vec3(0.f, 0.5f, 0.f), kDown, &hit));
+    EXPECT(hit.plane_index == table_index);
+    EXPECT(glm::abs(hit.distance - 0.8f) < 1e-5f);
+    // Beside the table, the floor.
+    EXPECT(caster.Raycast(glm::vec3(0.5f, 0.5f, 0.f), kDown, &hit));
+    EXPECT(hit.plane_index == 1 - table_index);
+    EXPECT(glm::abs(hit.distance - 1.5f) < 1e-5f);
+    // Between them, the table is behind the ray and only the floor is hit.
+    EXPECT(caster.Raycast(glm::vec3(0.f, -0.5f, 0.f), kDown, &hit));
+    EXPECT(hit.plane_index == 1 - table_index);
+  }
+}
+
+void RaycastTakesMicroseconds() {
+  // As many planes as a well explored room, with the tens of vertices of
+  // ARCore's polygons, overlapping on two levels so that every ray crosses
+  // several of them.
+  constexpr int32_t kPlaneCount = 32;
+  constexpr int32_t kVertexCount = 48;
+  std::vector<glm::vec2> circle;
+  for (int32_t v = 0; v < kVertexCount; ++v) {
+    const float angle = 6.2831853f * v / kVertexCount;
+    circle.push_back(glm::vec2(glm::cos(angle), glm::sin(angle)));
+  }
+  PlaneRayCaster caster;
+  caster.SetPlaneCount(kPlaneCount);
+  for (int32_t i = 0; i < kPlaneCount; ++i) {
+    const glm::vec3 center(0.25f * (i % 4) - 0.375f, -1.f + 0.5f * (i % 2),
+                           -0.625f - 0.25f * (i / 8));
+    caster.BuildPlane(
+        i, MakePolygon(glm::translate(glm::mat4(1.f), center), circle, false));
+  }
+
+  constexpr int32_t kQueryCount = 100000;
+  int32_t hit_count = 0;
+  const auto begin = std::chrono::steady_clock::now();
+  for (int32_t i = 0; i < kQueryCount; ++i) {
+    // The reticle ray sways over the planes and always hits the upper level.
+    const float sway = 0.3f * glm::sin(0.001f * i);
+    PlaneRayHit hit;
+    if (caster.Raycast(glm::vec3(sway, 1.f, 0.f),
+                       glm::vec3(0.f, -1.f, -0.5f), &hit)) {
+      ++hit_count;
+    }
+  }
+  const std::chrono::duration<double, std::micro> elapsed =
+      std::chrono::steady_clock::now() - begin;
+  const double query_us = elapsed.count() / kQueryCount;
+  printf("%d planes of %d vertices: %.3f us per raycast\n", kPlaneCount,
+         kVertexCount, query_us);
+  EXPECT(hit_count == kQueryCount);
+  EXPECT(query_us < kMaxRaycastMicroseconds);
+}
+
+}  // namespace
+}  // namespace hello_ar
+
+int main() {
+  using namespace hello_ar;
+  RUN_TEST(ConvexPolygonsOfEitherWinding);
+  RUN_TEST(RaysFromBehindMiss);
+  RUN_TEST(NearestOfStackedPlanesWins);
+  RUN_TEST(RaycastTakesMicroseconds);
+  return TEST_EXIT_CODE();
+}
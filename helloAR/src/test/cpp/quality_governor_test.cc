@@ -0,0 +1,201 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Drives QualityGovernor with synthetic frame time traces.
+
+#include <cstdint>
+#include <functional>
+
+#include "host_test.h"
+#include "quality_governor.h"
+
+namespace hello_ar {
+namespace {
+
+constexpr int64_t kMs = 1000000;
+// 60 Hz.
+constexpr int64_t kBudgetNs = 16666667;
+// Good windows needed before the first upgrade, and the most the hold grows
+// to, kMinUpgradeHoldWindows and kMaxUpgradeHoldWindows in
+// quality_governor.cc.
+constexpr int32_t kMinHoldWindows = 3;
+constexpr int32_t kMaxHoldWindows = 48;
+
+// Feeds one window of frames, frame_time_ns(level) each, and returns how
+// many times the level changed.
+int32_t RunWindow(QualityGovernor* governor,
+                  const std::function<int64_t(int32_t)>& frame_time_ns) {
+  int32_t changes = 0;
+  for (int32_t i = 0; i < QualityGovernor::kWindowFrames; ++i) {
+    if (governor->OnFrame(frame_time_ns(governor->GetLevel()), kBudgetNs)) {
+      ++changes;
+    }
+  }
+  return changes;
+}
+
+int32_t RunWindow(QualityGovernor* governor, int64_t frame_time_ns) {
+  return RunWindow(governor, [=](int32_t) { return frame_time_ns; });
+}
+
+void SustainedOverloadStepsDown() {
+  QualityGovernor governor;
+  EXPECT(governor.GetLevel() == 0);
+  // Each window measures the level the last one chose, one step at a time.
+  for (int32_t level = 1; level < QualityGovernor::kLevelCount; ++level) {
+    EXPECT(RunWindow(&governor, 20 * kMs) == 1);
+    EXPECT(governor.GetLevel() == level);
+  }
+  // The cheapest level has nowhere to go.
+  EXPECT(RunWindow(&governor, 20 * kMs) == 0);
+  EXPECT(governor.GetLevel() == QualityGovernor::kLevelCount - 1);
+  EXPECT(!governor.GetQualityLevel().occlusion);
+  EXPECT(governor.GetQualityLevel().render_scale < 1.f);
+}
+
+void SlowFramesUnderTheP90AreTolerated() {
+  QualityGovernor governor;
+  // Two shader compile hitches per window, the rest well within budget.
+  for (int32_t window = 0; window < 10; ++window) {
+    for (int32_t i = 0; i < QualityGovernor::kWindowFrames; ++i) {
+      governor.OnFrame(i % 15 == 0 ? 40 * kMs : 8 * kMs, kBudgetNs);
+    }
+    EXPECT(governor.GetLevel() == 0);
+  }
+}
+
+void RecoveryStepsUpAfterHold() {
+  QualityGovernor governor;
+  RunWindow(&governor, 20 * kMs);
+  RunWindow(&governor, 20 * kMs);
+  EXPECT(governor.GetLevel() == 2);
+
+  // Light load: one level up every kMinHoldWindows windows.
+  for (int32_t level = 1; level >= 0; --level) {
+    for (int32_t window = 1; window < kMinHoldWindows; ++window) {
+      EXPECT(RunWindow(&governor, 5 * kMs) == 0);
+      EXPECT(governor.GetLevel() == level + 1);
+    }
+    EXPECT(RunWindow(&governor, 5 * kMs) == 1);
+    EXPECT(governor.GetLevel() == level);
+  }
+
+  // Frames between the two thresholds neither step down nor up.
+  RunWindow(&governor, 20 * kMs);
+  EXPECT(governor.GetLevel() == 1);
+  for (int32_t window = 0; window < 4 * kMinHoldWindows; ++window) {
+    EXPECT(RunWindow(&governor, 12 * kMs) == 0);
+  }
+  EXPECT(governor.GetLevel() == 1);
+}
+
+void OscillatingLoadDoesNotFlap() {
+  QualityGovernor governor;
+  // Full quality is just over budget and every other level far under it, so
+  // each upgrade overloads right away.
+  const auto frame_time_ns = [](int32_t level) {
+    return level == 0 ? 17 * kMs : 6 * kMs;
+  };
+  int32_t changes = 0;
+  int32_t last_upgrade_window = 0;
+  int32_t upgrade_gap = 0;
+  const int32_t kWindows = 2000;
+  for (int32_t window = 1; window <= kWindows; ++window) {
+    const int32_t level = governor.GetLevel();
+    changes += RunWindow(&governor, frame_time_ns);
+    if (governor.GetLevel() < level) {
+      if (last_upgrade_window != 0) {
+        // The hold before retrying grows after every failed upgrade.
+        const int32_t gap = window - last_upgrade_window;
+        EXPECT(gap >= upgrade_gap);
+        upgrade_gap = gap;
+      }
+      last_upgrade_window = window;
+    }
+  }
+  EXPECT(upgrade_gap > kMaxHoldWindows);
+  // Every retry costs two changes, so with the hold at its cap the level
+  // changes at most once every kMaxHoldWindows / 2 windows.
+  EXPECT(changes < 2 * kWindows / kMaxHoldWindows + 20);
+  // Most of the time is spent at the level that fits the budget.
+  EXPECT(governor.GetLevel() <= 1);
+
+  // Frame times alternating between windows well under and over budget
+  // only ever step down.
+  QualityGovernor alternating;
+  for (int32_t window = 0; window < 200; ++window) {
+    const int32_t level = alternating.GetLevel();
+    RunWindow(&alternating, window % 2 == 0 ? 20 * kMs : 4 * kMs);
+    EXPECT(alternating.GetLevel() >= level);
+  }
+}
+
+void ThermalFloorHolds() {
+  QualityGovernor governor;
+  governor.SetThermalStatus(ThermalStatus::kSevere);
+  // Throttling applies on the next frame, not at the end of a window.
+  EXPECT(governor.OnFrame(5 * kMs, kBudgetNs));
+  EXPECT(governor.GetLevel() == 3);
+  for (int32_t window = 0; window < 10 * kMaxHoldWindows; ++window) {
+    RunWindow(&governor, 1 * kMs);
+    EXPECT(governor.GetLevel() == 3);
+  }
+  // Overload still steps below the floor.
+  RunWindow(&governor, 20 * kMs);
+  EXPECT(governor.GetLevel() == 4);
+
+  governor.SetThermalStatus(ThermalStatus::kCritical);
+  for (int32_t window = 0; window < 10 * kMaxHoldWindows; ++window) {
+    RunWindow(&governor, 1 * kMs);
+    EXPECT(governor.GetLevel() == QualityGovernor::kLevelCount - 1);
+  }
+
+  // Once the device cools down the levels come back one by one.
+  governor.SetThermalStatus(ThermalStatus::kNone);
+  for (int32_t window = 0; window < kMinHoldWindows; ++window) {
+    RunWindow(&governor, 1 * kMs);
+  }
+  EXPECT(governor.GetLevel() == QualityGovernor::kLevelCount - 2);
+  for (int32_t window = 0; window < 4 * kMinHoldWindows; ++window) {
+    RunWindow(&governor, 1 * kMs);
+  }
+  EXPECT(governor.GetLevel() == 0);
+}
+
+void ResetReturnsToFullQuality() {
+  QualityGovernor governor;
+  RunWindow(&governor, 20 * kMs);
+  EXPECT(governor.GetLevel() == 1);
+  governor.Reset();
+  EXPECT(governor.GetLevel() == 0);
+  EXPECT(governor.GetFrameTimeAverageNs() == 0.0);
+  EXPECT(governor.GetFrameTimeP90Ns() == 0);
+}
+
+}  // namespace
+}  // namespace hello_ar
+
+int main() {
+  using namespace hello_ar;
+  RUN_TEST(SustainedOverloadStepsDown);
+  RUN_TEST(SlowFramesUnderTheP90AreTolerated);
+  RUN_TEST(RecoveryStepsUpAfterHold);
+  RUN_TEST(OscillatingLoadDoesNotFlap);
+  RUN_TEST(ThermalFloorHolds);
+  RUN_TEST(ResetReturnsToFullQuality);
+  return TEST_EXIT_CODE();
+}
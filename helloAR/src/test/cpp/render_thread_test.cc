@@ -0,0 +1,190 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Runs RenderThread against Mesa's surfaceless EGL platform, with host
+// windows drawn to as pbuffers: pausing, window changes and shutdown.
+
+#include <GLES2/gl2.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <thread>
+
+#include "host_shims.h"
+#include "host_test.h"
+#include "render_thread.h"
+
+namespace hello_ar {
+namespace {
+
+// Polls condition for up to a few seconds.
+bool WaitFor(const std::function<bool()>& condition) {
+  for (int32_t i = 0; i < 5000; ++i) {
+    if (condition()) {
+      return true;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  return condition();
+}
+
+struct Counters {
+  std::atomic<int32_t> contexts_created{0};
+  std::atomic<int32_t> frames{0};
+  std::atomic<int32_t> tasks{0};
+  // Frames drawn before the first task ran.
+  std::atomic<int32_t> frames_before_task{-1};
+  std::atomic<bool> has_renderer{false};
+};
+
+RenderThread::Callbacks MakeCallbacks(Counters* counters) {
+  return RenderThread::Callbacks{
+      [counters] {
+        ++counters->contexts_created;
+        counters->has_renderer = glGetString(GL_RENDERER) != nullptr;
+      },
+      [counters] {
+        glClearColor(1.f, 0.f, 0.f, 1.f);
+        glClear(GL_COLOR_BUFFER_BIT);
+        ++counters->frames;
+      }};
+}
+
+void StartsPausedAndResumes() {
+  Counters counters;
+  RenderThread render_thread(MakeCallbacks(&counters));
+  render_thread.SetWindow(host::CreateWindow(64, 64));
+  render_thread.Post([&counters] {
+    ++counters.tasks;
+    counters.frames_before_task = counters.frames.load();
+  });
+  render_thread.RequestFrame();
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT(counters.frames == 0);
+  EXPECT(counters.tasks == 0);
+
+  render_thread.Resume();
+  EXPECT(WaitFor([&counters] { return counters.frames > 0; }));
+  EXPECT(counters.contexts_created == 1);
+  EXPECT(counters.has_renderer);
+  // Tasks run before the next frame.
+  EXPECT(counters.tasks == 1);
+  EXPECT(counters.frames_before_task == 0);
+  render_thread.Stop();
+  EXPECT(host::GetLiveWindowCount() == 0);
+}
+
+void DrawsOneFramePerRequest() {
+  Counters counters;
+  RenderThread render_thread(MakeCallbacks(&counters));
+  render_thread.SetWindow(host::CreateWindow(64, 64));
+  render_thread.Resume();
+  for (int32_t max_frames : {1, 2, RenderThread::kMaxFramesInFlightLimit}) {
+    render_thread.SetMaxFramesInFlight(max_frames);
+    for (int32_t i = 0; i < 50; ++i) {
+      const int32_t frames = counters.frames;
+      render_thread.RequestFrame();
+      EXPECT(WaitFor([&counters, frames] {
+        return counters.frames == frames + 1;
+      }));
+    }
+  }
+  // Without requests nothing is drawn.
+  const int32_t frames = counters.frames;
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT(counters.frames == frames);
+  render_thread.Stop();
+}
+
+void PauseHoldsFrames() {
+  Counters counters;
+  RenderThread render_thread(MakeCallbacks(&counters));
+  render_thread.SetWindow(host::CreateWindow(64, 64));
+  render_thread.Resume();
+  render_thread.RequestFrame();
+  EXPECT(WaitFor([&counters] { return counters.frames == 1; }));
+
+  render_thread.Pause();
+  render_thread.RequestFrame();
+  render_thread.Post([&counters] { ++counters.tasks; });
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT(counters.frames == 1);
+  EXPECT(counters.tasks == 0);
+  render_thread.Resume();
+  EXPECT(WaitFor([&counters] { return counters.frames == 2; }));
+  EXPECT(counters.tasks == 1);
+  render_thread.Stop();
+}
+
+void KeepsContextAcrossWindows() {
+  Counters counters;
+  RenderThread render_thread(MakeCallbacks(&counters));
+  render_thread.Resume();
+  for (int32_t window = 0; window < 5; ++window) {
+    render_thread.SetWindow(host::CreateWindow(32 + window, 32));
+    const int32_t frames = counters.frames;
+    render_thread.RequestFrame();
+    EXPECT(WaitFor([&counters, frames] { return counters.frames > frames; }));
+    // A destroyed surface is released before SetWindow returns.
+    render_thread.SetWindow(nullptr);
+    EXPECT(host::GetLiveWindowCount() == 0);
+  }
+  EXPECT(counters.contexts_created == 1);
+
+  // Without a window, requests wait for the next one.
+  const int32_t frames = counters.frames;
+  render_thread.RequestFrame();
+  std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  EXPECT(counters.frames == frames);
+  render_thread.SetWindow(host::CreateWindow(64, 64));
+  EXPECT(WaitFor([&counters, frames] { return counters.frames > frames; }));
+  render_thread.Stop();
+  EXPECT(host::GetLiveWindowCount() == 0);
+}
+
+void StopsWithPendingWork() {
+  for (int32_t round = 0; round < 20; ++round) {
+    Counters counters;
+    RenderThread render_thread(MakeCallbacks(&counters));
+    render_thread.SetWindow(host::CreateWindow(64, 64));
+    if (round % 2 == 0) {
+      render_thread.Resume();
+    }
+    for (int32_t i = 0; i < 10; ++i) {
+      render_thread.Post([&counters] { ++counters.tasks; });
+      render_thread.RequestFrame();
+    }
+    // The destructor stops the thread.
+  }
+  EXPECT(host::GetLiveWindowCount() == 0);
+}
+
+}  // namespace
+}  // namespace hello_ar
+
+int main() {
+  using namespace hello_ar;
+  host::UseSurfacelessEgl();
+  RUN_TEST(StartsPausedAndResumes);
+  RUN_TEST(DrawsOneFramePerRequest);
+  RUN_TEST(PauseHoldsFrames);
+  RUN_TEST(KeepsContextAcrossWindows);
+  RUN_TEST(StopsWithPendingWork);
+  return TEST_EXIT_CODE();
+}
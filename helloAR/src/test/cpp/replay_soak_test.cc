@@ -0,0 +1,264 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Soaks HelloArApplication on the replay backend: a synthetic session in
+// which planes keep appearing, merging and stopping while taps place
+// anchors. The live ARCore handle counts and the resident set size must
+// stay flat once the anchor limit is reached.
+//
+// The frame count defaults to a short run for ctest. Pass a larger one for
+// a real soak, e.g. replay_soak_test 300000.
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "arcore_c_api.h"
+#include "arcore_replay.h"
+#include "frame_log.h"
+#include "glm.h"
+#include "hello_ar_application.h"
+#include "host_shims.h"
+#include "host_test.h"
+#include "scoped_ar_handle.h"
+
+namespace hello_ar {
+namespace {
+
+constexpr int32_t kDefaultFrameCount = 1800;
+// Every cycle replays the same plane life cycle with fresh geometry.
+constexpr int32_t kCycleFrames = 300;
+constexpr int64_t kFrameIntervalNs = 33333333;
+constexpr int32_t kWidth = 96;
+constexpr int32_t kHeight = 160;
+// Cycles run before measuring: the anchor limit is reached and the allocator
+// has seen every kind of frame.
+constexpr int32_t kWarmUpCycles = 3;
+// Allowed growth of the peak resident set between the halves of the run.
+constexpr long kMaxResidentGrowthBytes = 1024 * 1024;
+
+int32_t frame_count = kDefaultFrameCount;
+
+long GetResidentBytes() {
+  long size_pages = 0;
+  long resident_pages = 0;
+  FILE* statm = fopen("/proc/self/statm", "r");
+  if (statm == nullptr) {
+    return 0;
+  }
+  if (fscanf(statm, "%ld %ld", &size_pages, &resident_pages) != 2) {
+    resident_pages = 0;
+  }
+  fclose(statm);
+  return resident_pages * sysconf(_SC_PAGESIZE);
+}
+
+void SetPose(const glm::quat& rotation, const glm::vec3& translation,
+             float* out_raw) {
+  out_raw[0] = rotation.x;
+  out_raw[1] = rotation.y;
+  out_raw[2] = rotation.z;
+  out_raw[3] = rotation.w;
+  out_raw[4] = translation.x;
+  out_raw[5] = translation.y;
+  out_raw[6] = translation.z;
+}
+
+// A square of the given half size, as x, z pairs.
+std::vector<float> MakeSquare(float half_size) {
+  return {-half_size, -half_size, half_size, -half_size,
+          half_size,  half_size,  -half_size, half_size};
+}
+
+// Floor plane id at x, one meter below the camera and two ahead.
+LoggedPlane MakeFloorPlane(int32_t id, float x, float half_size) {
+  LoggedPlane plane;
+  plane.id = id;
+  plane.tracking_state = AR_TRACKING_STATE_TRACKING;
+  SetPose(glm::quat(1.f, 0.f, 0.f, 0.f), glm::vec3(x, -1.f, -2.f),
+          plane.center_pose);
+  plane.polygon = MakeSquare(half_size);
+  return plane;
+}
+
+// Frame i of the synthetic session. Within each cycle:
+//  - the camera sways and briefly loses tracking near the end,
+//  - plane 1 appears and grows, plane 2 appears next to it,
+//  - plane 2 is subsumed by plane 1, which then covers both,
+//  - both planes stop tracking,
+// and taps land before any plane exists (instant placement) and on the
+// planes, more than the anchor limit over a few cycles.
+LoggedFrame MakeFrame(int32_t i) {
+  const int32_t cycle_frame = i % kCycleFrames;
+  LoggedFrame frame;
+  frame.timestamp_ns = (i + 1) * kFrameIntervalNs;
+  frame.camera_tracking_state = cycle_frame >= 280 && cycle_frame < 290
+                                    ? AR_TRACKING_STATE_PAUSED
+                                    : AR_TRACKING_STATE_TRACKING;
+  const float sway = 0.05f * glm::sin(0.1f * static_cast<float>(i));
+  SetPose(glm::angleAxis(sway, glm::vec3(0.f, 1.f, 0.f)),
+          glm::vec3(sway, 0.f, 0.f), frame.camera_pose);
+  const glm::mat4 projection_mat =
+      glm::perspective(glm::radians(60.f),
+                       static_cast<float>(kWidth) / kHeight,
+                       kLoggedProjectionNear, kLoggedProjectionFar);
+  memcpy(frame.projection_mat, glm::value_ptr(projection_mat),
+         sizeof(frame.projection_mat));
+  const float ndc_basis_uvs[6] = {0.5f, 0.5f, 1.f, 0.5f, 0.5f, 0.f};
+  memcpy(frame.ndc_basis_uvs, ndc_basis_uvs, sizeof(ndc_basis_uvs));
+  frame.light_estimate_state = AR_LIGHT_ESTIMATE_STATE_VALID;
+
+  for (int32_t point = 0; point < 32; ++point) {
+    const float angle = 0.2f * static_cast<float>(point + i);
+    frame.point_cloud.insert(frame.point_cloud.end(),
+                             {glm::cos(angle), -1.f, -2.f + glm::sin(angle),
+                              0.5f});
+  }
+
+  frame.depth_width = 8;
+  frame.depth_height = 6;
+  frame.depth.assign(frame.depth_width * frame.depth_height,
+                     static_cast<uint16_t>(1500 + cycle_frame));
+
+  if (cycle_frame >= 10) {
+    const float growth = static_cast<float>(std::min(cycle_frame, 150));
+    frame.planes.push_back(MakeFloorPlane(1, 0.f, 0.2f + 0.004f * growth));
+  }
+  if (cycle_frame >= 30) {
+    frame.planes.push_back(MakeFloorPlane(2, 1.2f, 0.3f));
+  }
+  if (cycle_frame >= 150 && cycle_frame < 250) {
+    frame.planes[1].subsumed_by_id = 1;
+  }
+  if (cycle_frame >= 250) {
+    for (LoggedPlane& plane : frame.planes) {
+      plane.tracking_state = AR_TRACKING_STATE_STOPPED;
+    }
+  }
+
+  // The plane centers are 0.93 of the way down the screen.
+  if (cycle_frame == 5 || cycle_frame == 60 || cycle_frame == 120 ||
+      cycle_frame == 200) {
+    LoggedTouch touch;
+    touch.x = 0.5f * kWidth;
+    touch.y = (cycle_frame == 5 ? 0.5f : 0.93f) * kHeight;
+    frame.touches.push_back(touch);
+    touch.x = 0.4f * kWidth;
+    frame.touches.push_back(touch);
+  }
+  return frame;
+}
+
+bool WriteLog(const std::string& path, int32_t count) {
+  FrameLogWriter writer;
+  if (!writer.Open(path.c_str())) {
+    return false;
+  }
+  for (int32_t i = 0; i < count; ++i) {
+    if (!writer.Write(MakeFrame(i))) {
+      return false;
+    }
+  }
+  writer.Close();
+  return true;
+}
+
+void HandleAndResidentCountsStayFlat() {
+  char path[] = "/tmp/replay_soak_XXXXXX";
+  const int fd = mkstemp(path);
+  EXPECT(fd >= 0);
+  if (fd < 0) {
+    return;
+  }
+  close(fd);
+  EXPECT(WriteLog(path, frame_count));
+  setenv(replay::kReplayLogEnvironmentVariable, path, 1);
+
+  host::PbufferContext context(kWidth, kHeight);
+  EXPECT(context.IsCurrent());
+  AAssetManager* asset_manager =
+      host::CreateAssetManager(HELLOAR_HOST_ASSET_DIRECTORY);
+  {
+    std::unique_ptr<HelloArApplication> application(
+        new HelloArApplication(asset_manager));
+    // A generous frame budget keeps the quality governor at the top level.
+    // Its level follows the host's frame times, and the lower levels drop
+    // GL state, which would show as resident set noise.
+    application->SetTargetFrameRate(5);
+    application->OnResume(nullptr, nullptr, nullptr);
+    application->OnSurfaceCreated();
+    application->OnDisplayGeometryChanged(0, kWidth, kHeight);
+
+    // Peaks after the warm-up, in the first and second half of the rest of
+    // the run. Peaks recur every cycle, so a leak shows as a higher second
+    // half.
+    const int32_t warm_up_frames = kWarmUpCycles * kCycleFrames;
+    const int32_t second_half_frame =
+        warm_up_frames + (frame_count - warm_up_frames) / 2;
+    int max_handles[2] = {0, 0};
+    long max_resident_bytes[2] = {0, 0};
+    for (int32_t i = 0; i < frame_count; ++i) {
+      // Live touches are ignored on replay, the logged ones are delivered
+      // instead, but they still go through the touch queue.
+      if (i % 7 == 0) {
+        application->OnTouched(0.5f * kWidth, 0.5f * kHeight);
+      }
+      application->OnDrawFrame(/*depthColorVisualizationEnabled=*/false,
+                               /*useDepthForOcclusion=*/i % 2 == 0);
+
+      if (i >= warm_up_frames) {
+        const int half = i < second_half_frame ? 0 : 1;
+        max_handles[half] =
+            std::max(max_handles[half], util::GetTotalLiveArHandleCount());
+        max_resident_bytes[half] =
+            std::max(max_resident_bytes[half], GetResidentBytes());
+      }
+    }
+    EXPECT(application->HasDetectedPlanes());
+    EXPECT(max_handles[0] > 0);
+    EXPECT(max_handles[1] == max_handles[0]);
+    EXPECT(max_resident_bytes[1] - max_resident_bytes[0] <=
+           kMaxResidentGrowthBytes);
+    printf("%d frames, at most %d live ARCore handles, peak resident set "
+           "%ld KiB then %ld KiB\n",
+           frame_count, max_handles[1], max_resident_bytes[0] / 1024,
+           max_resident_bytes[1] / 1024);
+  }
+  // Destroying the application releases every handle it held.
+  EXPECT(util::GetTotalLiveArHandleCount() == 0);
+  host::DestroyAssetManager(asset_manager);
+  unlink(path);
+}
+
+}  // namespace
+}  // namespace hello_ar
+
+int main(int argc, char** argv) {
+  using namespace hello_ar;
+  if (argc > 1) {
+    frame_count = std::max(atoi(argv[1]), (kWarmUpCycles + 1) * kCycleFrames);
+  }
+  host::UseSurfacelessEgl();
+  RUN_TEST(HandleAndResidentCountsStayFlat);
+  return TEST_EXIT_CODE();
+}
@@ -0,0 +1,48 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Host stand-in for the NDK's android/asset_manager.h. A host asset manager
+// reads the files under a directory, see HostAssetManager in host_shims.h.
+
+#ifndef C_ARCORE_SHIMS_ANDROID_ASSET_MANAGER_H_
+#define C_ARCORE_SHIMS_ANDROID_ASSET_MANAGER_H_
+
+#include <sys/types.h>
+
+#include <cstddef>
+
+struct AAssetManager;
+struct AAsset;
+
+enum {
+  AASSET_MODE_UNKNOWN = 0,
+  AASSET_MODE_RANDOM = 1,
+  AASSET_MODE_STREAMING = 2,
+  AASSET_MODE_BUFFER = 3,
+};
+
+extern "C" {
+AAsset* AAssetManager_open(AAssetManager* manager, const char* file_name,
+                           int mode);
+off_t AAsset_getLength(AAsset* asset);
+int AAsset_read(AAsset* asset, void* buffer, size_t count);
+int AAsset_openFileDescriptor(AAsset* asset, off_t* out_start,
+                              off_t* out_length);
+void AAsset_close(AAsset* asset);
+}
+
+#endif  // C_ARCORE_SHIMS_ANDROID_ASSET_MANAGER_H_
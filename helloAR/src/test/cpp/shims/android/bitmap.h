@@ -0,0 +1,53 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Host stand-in for the NDK's android/bitmap.h. There are no Java bitmaps on
+// the host, so every call fails.
+
+#ifndef C_ARCORE_SHIMS_ANDROID_BITMAP_H_
+#define C_ARCORE_SHIMS_ANDROID_BITMAP_H_
+
+#include <jni.h>
+
+#include <cstdint>
+
+enum AndroidBitmapFormat {
+  ANDROID_BITMAP_FORMAT_NONE = 0,
+  ANDROID_BITMAP_FORMAT_RGBA_8888 = 1,
+};
+
+enum {
+  ANDROID_BITMAP_RESULT_SUCCESS = 0,
+  ANDROID_BITMAP_RESULT_BAD_PARAMETER = -1,
+};
+
+struct AndroidBitmapInfo {
+  uint32_t width;
+  uint32_t height;
+  uint32_t stride;
+  int32_t format;
+  uint32_t flags;
+};
+
+extern "C" {
+int AndroidBitmap_getInfo(JNIEnv* env, jobject bitmap,
+                          AndroidBitmapInfo* out_info);
+int AndroidBitmap_lockPixels(JNIEnv* env, jobject bitmap, void** out_pixels);
+int AndroidBitmap_unlockPixels(JNIEnv* env, jobject bitmap);
+}
+
+#endif  // C_ARCORE_SHIMS_ANDROID_BITMAP_H_
@@ -0,0 +1,45 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Host stand-in for the NDK's android/log.h. Messages go to stderr.
+
+#ifndef C_ARCORE_SHIMS_ANDROID_LOG_H_
+#define C_ARCORE_SHIMS_ANDROID_LOG_H_
+
+#include <cstdarg>
+
+enum android_LogPriority {
+  ANDROID_LOG_UNKNOWN = 0,
+  ANDROID_LOG_DEFAULT,
+  ANDROID_LOG_VERBOSE,
+  ANDROID_LOG_DEBUG,
+  ANDROID_LOG_INFO,
+  ANDROID_LOG_WARN,
+  ANDROID_LOG_ERROR,
+  ANDROID_LOG_FATAL,
+  ANDROID_LOG_SILENT,
+};
+
+extern "C" {
+int __android_log_write(int priority, const char* tag, const char* text);
+int __android_log_print(int priority, const char* tag, const char* format,
+                        ...);
+int __android_log_vprint(int priority, const char* tag, const char* format,
+                         va_list args);
+}
+
+#endif  // C_ARCORE_SHIMS_ANDROID_LOG_H_
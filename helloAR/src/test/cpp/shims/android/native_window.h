@@ -0,0 +1,35 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Host stand-in for the NDK's android/native_window.h. A host window only
+// has a size and a reference count, see HostWindow in host_shims.h.
+
+#ifndef C_ARCORE_SHIMS_ANDROID_NATIVE_WINDOW_H_
+#define C_ARCORE_SHIMS_ANDROID_NATIVE_WINDOW_H_
+
+#include <cstdint>
+
+struct ANativeWindow;
+
+extern "C" {
+void ANativeWindow_acquire(ANativeWindow* window);
+void ANativeWindow_release(ANativeWindow* window);
+int32_t ANativeWindow_setBuffersGeometry(ANativeWindow* window, int32_t width,
+                                         int32_t height, int32_t format);
+}
+
+#endif  // C_ARCORE_SHIMS_ANDROID_NATIVE_WINDOW_H_
@@ -0,0 +1,34 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Forced into the sources that render to an ANativeWindow when they are
+// built for the host tests. Mesa's surfaceless platform has no windows, so
+// window surfaces are pbuffers the size of the window, and configs are
+// chosen for pbuffers.
+
+#ifndef C_ARCORE_SHIMS_EGL_WINDOW_SHIM_H_
+#define C_ARCORE_SHIMS_EGL_WINDOW_SHIM_H_
+
+#include <EGL/egl.h>
+
+#include "host_shims.h"
+
+#undef EGL_WINDOW_BIT
+#define EGL_WINDOW_BIT EGL_PBUFFER_BIT
+#define eglCreateWindowSurface hello_ar::host::CreateWindowSurface
+
+#endif  // C_ARCORE_SHIMS_EGL_WINDOW_SHIM_H_
@@ -0,0 +1,201 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "host_shims.h"
+
+#include <android/bitmap.h>
+#include <android/log.h>
+#include <jni.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+
+struct AAssetManager {
+  std::string root_directory;
+};
+
+struct AAsset {
+  FILE* file;
+  off_t length;
+};
+
+struct ANativeWindow {
+  int32_t width;
+  int32_t height;
+  std::atomic<int32_t> references;
+};
+
+namespace hello_ar {
+namespace host {
+namespace {
+std::atomic<int32_t> live_window_count(0);
+}  // namespace
+
+AAssetManager* CreateAssetManager(const std::string& root_directory) {
+  return new AAssetManager{root_directory};
+}
+
+void DestroyAssetManager(AAssetManager* asset_manager) {
+  delete asset_manager;
+}
+
+ANativeWindow* CreateWindow(int32_t width, int32_t height) {
+  ++live_window_count;
+  ANativeWindow* window = new ANativeWindow;
+  window->width = width;
+  window->height = height;
+  window->references = 1;
+  return window;
+}
+
+int32_t GetLiveWindowCount() { return live_window_count; }
+
+void UseSurfacelessEgl() { setenv("EGL_PLATFORM", "surfaceless", 0); }
+
+EGLSurface CreateWindowSurface(EGLDisplay display, EGLConfig config,
+                               EGLNativeWindowType native_window,
+                               const EGLint*) {
+  const ANativeWindow* window =
+      static_cast<const ANativeWindow*>(native_window);
+  const EGLint attributes[] = {EGL_WIDTH, window->width, EGL_HEIGHT,
+                               window->height, EGL_NONE};
+  return eglCreatePbufferSurface(display, config, attributes);
+}
+
+PbufferContext::PbufferContext(int32_t width, int32_t height) {
+  display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+  eglInitialize(display_, nullptr, nullptr);
+  const EGLint config_attributes[] = {EGL_RENDERABLE_TYPE,
+                                      EGL_OPENGL_ES2_BIT,
+                                      EGL_SURFACE_TYPE,
+                                      EGL_PBUFFER_BIT,
+                                      EGL_RED_SIZE,
+                                      8,
+                                      EGL_ALPHA_SIZE,
+                                      8,
+                                      EGL_DEPTH_SIZE,
+                                      16,
+                                      EGL_NONE};
+  EGLConfig config = nullptr;
+  EGLint config_count = 0;
+  eglChooseConfig(display_, config_attributes, &config, 1, &config_count);
+  const EGLint context_attributes[] = {EGL_CONTEXT_CLIENT_VERSION, 2,
+                                       EGL_NONE};
+  context_ =
+      eglCreateContext(display_, config, EGL_NO_CONTEXT, context_attributes);
+  const EGLint surface_attributes[] = {EGL_WIDTH, width, EGL_HEIGHT, height,
+                                       EGL_NONE};
+  surface_ = eglCreatePbufferSurface(display_, config, surface_attributes);
+  is_current_ = config_count == 1 &&
+                eglMakeCurrent(display_, surface_, surface_, context_);
+}
+
+PbufferContext::~PbufferContext() {
+  eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+  eglDestroySurface(display_, surface_);
+  eglDestroyContext(display_, context_);
+}
+
+}  // namespace host
+}  // namespace hello_ar
+
+extern "C" {
+
+int __android_log_write(int priority, const char* tag, const char* text) {
+  return fprintf(stderr, "%c/%s: %s\n", "??VDIWEFS"[priority & 7], tag, text);
+}
+
+int __android_log_vprint(int priority, const char* tag, const char* format,
+                         va_list args) {
+  char text[1024];
+  vsnprintf(text, sizeof(text), format, args);
+  return __android_log_write(priority, tag, text);
+}
+
+int __android_log_print(int priority, const char* tag, const char* format,
+                        ...) {
+  va_list args;
+  va_start(args, format);
+  const int result = __android_log_vprint(priority, tag, format, args);
+  va_end(args);
+  return result;
+}
+
+AAsset* AAssetManager_open(AAssetManager* manager, const char* file_name,
+                           int) {
+  const std::string path = manager->root_directory + "/" + file_name;
+  FILE* file = fopen(path.c_str(), "rb");
+  if (file == nullptr) {
+    return nullptr;
+  }
+  struct stat file_stat;
+  fstat(fileno(file), &file_stat);
+  return new AAsset{file, file_stat.st_size};
+}
+
+off_t AAsset_getLength(AAsset* asset) { return asset->length; }
+
+int AAsset_read(AAsset* asset, void* buffer, size_t count) {
+  return static_cast<int>(fread(buffer, 1, count, asset->file));
+}
+
+int AAsset_openFileDescriptor(AAsset* asset, off_t* out_start,
+                              off_t* out_length) {
+  *out_start = 0;
+  *out_length = asset->length;
+  return dup(fileno(asset->file));
+}
+
+void AAsset_close(AAsset* asset) {
+  fclose(asset->file);
+  delete asset;
+}
+
+int AndroidBitmap_getInfo(JNIEnv*, jobject, AndroidBitmapInfo*) {
+  return ANDROID_BITMAP_RESULT_BAD_PARAMETER;
+}
+
+int AndroidBitmap_lockPixels(JNIEnv*, jobject, void**) {
+  return ANDROID_BITMAP_RESULT_BAD_PARAMETER;
+}
+
+int AndroidBitmap_unlockPixels(JNIEnv*, jobject) {
+  return ANDROID_BITMAP_RESULT_BAD_PARAMETER;
+}
+
+void ANativeWindow_acquire(ANativeWindow* window) { ++window->references; }
+
+void ANativeWindow_release(ANativeWindow* window) {
+  if (--window->references == 0) {
+    delete window;
+    --hello_ar::host::live_window_count;
+  }
+}
+
+int32_t ANativeWindow_setBuffersGeometry(ANativeWindow*, int32_t, int32_t,
+                                         int32_t) {
+  return 0;
+}
+
+// native-lib.h. No Java VM runs on the host.
+JNIEnv* GetJniEnv() { return nullptr; }
+jclass FindClass(const char*) { return nullptr; }
+
+}  // extern "C"
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Host implementations of the Android platform calls made by the native
+// library, so that it can be built and driven on a desktop with Mesa's
+// EGL and GLES.
+
+#ifndef C_ARCORE_SHIMS_HOST_SHIMS_H_
+#define C_ARCORE_SHIMS_HOST_SHIMS_H_
+
+#include <EGL/egl.h>
+#include <android/asset_manager.h>
+#include <android/native_window.h>
+
+#include <cstdint>
+#include <string>
+
+namespace hello_ar {
+namespace host {
+
+// Returns an asset manager that opens the files under root_directory.
+AAssetManager* CreateAssetManager(const std::string& root_directory);
+void DestroyAssetManager(AAssetManager* asset_manager);
+
+// Returns a window of the given size, holding one reference that the caller
+// gives up with ANativeWindow_release. The window is freed with its last
+// reference.
+ANativeWindow* CreateWindow(int32_t width, int32_t height);
+
+// Number of windows created and not freed yet.
+int32_t GetLiveWindowCount();
+
+// Makes EGL use Mesa's surfaceless platform, which needs no display server,
+// unless EGL_PLATFORM is set already. Call before the first EGL call.
+void UseSurfacelessEgl();
+
+// Stands in for eglCreateWindowSurface, see egl_window_shim.h: a pbuffer
+// the size of the window.
+EGLSurface CreateWindowSurface(EGLDisplay display, EGLConfig config,
+                               EGLNativeWindowType window,
+                               const EGLint* attrib_list);
+
+// An ES 2 context made current on the constructing thread with a pbuffer
+// of the given size, standing in for the render thread's window.
+class PbufferContext {
+ public:
+  PbufferContext(int32_t width, int32_t height);
+  ~PbufferContext();
+
+  // Delete copy constructors.
+  PbufferContext(const PbufferContext&) = delete;
+  void operator=(const PbufferContext&) = delete;
+
+  bool IsCurrent() const { return is_current_; }
+
+ private:
+  EGLDisplay display_ = EGL_NO_DISPLAY;
+  EGLContext context_ = EGL_NO_CONTEXT;
+  EGLSurface surface_ = EGL_NO_SURFACE;
+  bool is_current_ = false;
+};
+
+}  // namespace host
+}  // namespace hello_ar
+
+#endif  // C_ARCORE_SHIMS_HOST_SHIMS_H_
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Host stand-in for the parts of the NDK's jni.h the native library uses.
+// There is no Java VM on the host: GetJniEnv returns nullptr and FindClass
+// finds nothing, so code paths that need Java are never taken.
+
+#ifndef C_ARCORE_SHIMS_JNI_H_
+#define C_ARCORE_SHIMS_JNI_H_
+
+#include <cstdint>
+
+typedef int32_t jint;
+typedef int64_t jlong;
+typedef uint8_t jboolean;
+typedef float jfloat;
+typedef int32_t jsize;
+
+class _jobject {};
+typedef _jobject* jobject;
+typedef jobject jclass;
+typedef jobject jstring;
+struct _jmethodID;
+typedef _jmethodID* jmethodID;
+
+#define JNI_FALSE 0
+#define JNI_TRUE 1
+
+struct _JNIEnv {
+  jobject NewGlobalRef(jobject object) { return object; }
+  void DeleteGlobalRef(jobject) {}
+  void DeleteLocalRef(jobject) {}
+  jmethodID GetStaticMethodID(jclass, const char*, const char*) {
+    return nullptr;
+  }
+  jobject CallStaticObjectMethod(jclass, jmethodID, ...) { return nullptr; }
+  void CallStaticVoidMethod(jclass, jmethodID, ...) {}
+  jstring NewStringUTF(const char*) { return nullptr; }
+};
+typedef _JNIEnv JNIEnv;
+
+#endif  // C_ARCORE_SHIMS_JNI_H_
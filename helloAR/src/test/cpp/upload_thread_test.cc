@@ -0,0 +1,147 @@
+/*
+ * Copyright 2017 Google LLC
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Runs UploadThread against Mesa's surfaceless EGL platform: textures made
+// on the upload thread are complete and readable on the render thread's
+// context once published.
+
+#include <EGL/egl.h>
+#include <GLES2/gl2.h>
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "host_shims.h"
+#include "host_test.h"
+#include "upload_thread.h"
+
+namespace hello_ar {
+namespace {
+
+constexpr int32_t kTextureCount = 8;
+constexpr int32_t kTextureSize = 256;
+
+// Red channel of the texels of texture i.
+uint8_t GetTextureRed(int32_t i) { return static_cast<uint8_t>(20 * i + 10); }
+
+// Creates texture i on the calling thread's context.
+void CreateTexture(int32_t i, GLuint* out_texture) {
+  std::vector<uint32_t> texels(kTextureSize * kTextureSize,
+                               0xff000000u | GetTextureRed(i));
+  glGenTextures(1, out_texture);
+  glBindTexture(GL_TEXTURE_2D, *out_texture);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, kTextureSize, kTextureSize, 0,
+               GL_RGBA, GL_UNSIGNED_BYTE, texels.data());
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+// Reads a texel of texture i back through a framebuffer.
+bool HasTextureContent(GLuint texture, int32_t i) {
+  GLuint framebuffer = 0;
+  glGenFramebuffers(1, &framebuffer);
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                         texture, 0);
+  uint8_t texel[4] = {0, 0, 0, 0};
+  glReadPixels(kTextureSize / 2, kTextureSize / 2, 1, 1, GL_RGBA,
+               GL_UNSIGNED_BYTE, texel);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteFramebuffers(1, &framebuffer);
+  return texel[0] == GetTextureRed(i) && texel[3] == 255;
+}
+
+void UploadsArePublishedComplete() {
+  host::PbufferContext render_context(1, 1);
+  EXPECT(render_context.IsCurrent());
+  UploadThread upload_thread;
+  // The render context may be recreated, which restarts the thread.
+  for (int32_t round = 0; round < 3; ++round) {
+    EXPECT(upload_thread.Start());
+    const std::thread::id render_thread_id = std::this_thread::get_id();
+    std::vector<GLuint> textures(kTextureCount, 0);
+    int32_t published = 0;
+    bool uploads_off_thread = true;
+    bool publishes_on_thread = true;
+    for (int32_t i = 0; i < kTextureCount; ++i) {
+      std::shared_ptr<GLuint> texture = std::make_shared<GLuint>(0);
+      upload_thread.Upload(
+          [texture, i, render_thread_id, &uploads_off_thread] {
+            uploads_off_thread &=
+                std::this_thread::get_id() != render_thread_id;
+            CreateTexture(i, texture.get());
+          },
+          [texture, i, render_thread_id, &textures, &published,
+           &publishes_on_thread] {
+            publishes_on_thread &=
+                std::this_thread::get_id() == render_thread_id;
+            textures[i] = *texture;
+            ++published;
+          });
+    }
+    // Frames go on while the uploads are under way.
+    for (int32_t frame = 0; frame < 10000 && published < kTextureCount;
+         ++frame) {
+      upload_thread.PublishCompleted();
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT(published == kTextureCount);
+    EXPECT(uploads_off_thread);
+    EXPECT(publishes_on_thread);
+    for (int32_t i = 0; i < kTextureCount; ++i) {
+      EXPECT(HasTextureContent(textures[i], i));
+    }
+    glDeleteTextures(kTextureCount, textures.data());
+  }
+  upload_thread.Stop();
+}
+
+void UploadsRunInlineWithoutThread() {
+  UploadThread upload_thread;
+  // No context is current, so there is nothing to share.
+  EXPECT(!upload_thread.Start());
+  bool uploaded = false;
+  bool published = false;
+  upload_thread.Upload([&uploaded] { uploaded = true; },
+                       [&published] { published = true; });
+  EXPECT(uploaded && published);
+
+  host::PbufferContext render_context(1, 1);
+  EXPECT(upload_thread.Start());
+  upload_thread.Stop();
+  GLuint texture = 0;
+  published = false;
+  upload_thread.Upload([&texture] { CreateTexture(3, &texture); },
+                       [&published] { published = true; });
+  EXPECT(published);
+  EXPECT(HasTextureContent(texture, 3));
+  glDeleteTextures(1, &texture);
+}
+
+}  // namespace
+}  // namespace hello_ar
+
+int main() {
+  using namespace hello_ar;
+  host::UseSurfacelessEgl();
+  RUN_TEST(UploadsArePublishedComplete);
+  RUN_TEST(UploadsRunInlineWithoutThread);
+  return TEST_EXIT_CODE();
+}